@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "erasure-code.h"
+#include "corelib/assert.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace vndn
+{
+
+namespace
+{
+
+/**
+ * \brief Log and antilog tables of GF(2^8) with generator polynomial 0x11d
+ */
+class GaloisField
+{
+public:
+    GaloisField()
+    {
+        unsigned int x = 1;
+        for (unsigned int i = 0; i < 255; i++) {
+            exp[i] = exp[i + 255] = x;
+            log[x] = i;
+            x <<= 1;
+            if (x & 0x100)
+                x ^= 0x11d;
+        }
+        log[0] = 0;
+    }
+
+    uint8_t mul(uint8_t a, uint8_t b) const
+    {
+        return (a == 0 || b == 0) ? 0 : exp[log[a] + log[b]];
+    }
+
+    uint8_t inv(uint8_t a) const
+    {
+        return exp[255 - log[a]];
+    }
+
+    /**
+     * \brief dst += c * src over length bytes
+     */
+    void mulAdd(uint8_t *dst, const uint8_t *src, uint8_t c, size_t length) const
+    {
+        if (c == 0)
+            return;
+        if (c == 1) {
+            for (size_t i = 0; i < length; i++)
+                dst[i] ^= src[i];
+            return;
+        }
+        const uint8_t *row = &exp[log[c]];
+        for (size_t i = 0; i < length; i++) {
+            if (src[i])
+                dst[i] ^= row[log[src[i]]];
+        }
+    }
+
+private:
+    uint8_t exp[510];
+    uint8_t log[256];
+};
+
+const GaloisField gf;
+
+}
+
+
+ErasureCode::ErasureCode(unsigned int dataSegments, unsigned int totalSegments)
+    : k(dataSegments)
+    , n(totalSegments)
+{
+    NS_ASSERT(k > 0 && k <= n && n <= maxSegments);
+}
+
+uint8_t ErasureCode::coefficient(unsigned int row, unsigned int column) const
+{
+    if (row < k)
+        return row == column ? 1 : 0;
+    // Cauchy matrix 1 / (x_row + y_column), with x_row = row and y_column = column:
+    // the two sets are disjoint, so every square submatrix is invertible
+    return gf.inv(row ^ column);
+}
+
+void ErasureCode::encode(const uint8_t * const data[], size_t length,
+                         unsigned int index, uint8_t *parity) const
+{
+    NS_ASSERT(index >= k && index < n);
+
+    std::memset(parity, 0, length);
+    for (unsigned int c = 0; c < k; c++)
+        gf.mulAdd(parity, data[c], coefficient(index, c), length);
+}
+
+bool ErasureCode::decode(const std::vector<unsigned int> &indexes,
+                         const std::vector<const uint8_t *> &segments,
+                         size_t length, uint8_t * const data[]) const
+{
+    if (indexes.size() != k || segments.size() != k)
+        return false;
+
+    std::vector<bool> seen(n, false);
+    for (unsigned int r = 0; r < k; r++) {
+        if (indexes[r] >= n || seen[indexes[r]])
+            return false;
+        seen[indexes[r]] = true;
+    }
+
+    // invert the rows of the encoding matrix matching the segments received,
+    // with Gauss-Jordan elimination on [A | I]
+    std::vector<uint8_t> a(k * k), inv(k * k, 0);
+    for (unsigned int r = 0; r < k; r++) {
+        for (unsigned int c = 0; c < k; c++)
+            a[r * k + c] = coefficient(indexes[r], c);
+        inv[r * k + r] = 1;
+    }
+    for (unsigned int c = 0; c < k; c++) {
+        unsigned int pivot = c;
+        while (a[pivot * k + c] == 0) {
+            if (++pivot == k)
+                return false;
+        }
+        if (pivot != c) {
+            std::swap_ranges(&a[pivot * k], &a[pivot * k] + k, &a[c * k]);
+            std::swap_ranges(&inv[pivot * k], &inv[pivot * k] + k, &inv[c * k]);
+        }
+        uint8_t scale = gf.inv(a[c * k + c]);
+        for (unsigned int j = 0; j < k; j++) {
+            a[c * k + j] = gf.mul(a[c * k + j], scale);
+            inv[c * k + j] = gf.mul(inv[c * k + j], scale);
+        }
+        for (unsigned int r = 0; r < k; r++) {
+            uint8_t factor = a[r * k + c];
+            if (r == c || factor == 0)
+                continue;
+            gf.mulAdd(&a[r * k], &a[c * k], factor, k);
+            gf.mulAdd(&inv[r * k], &inv[c * k], factor, k);
+        }
+    }
+
+    // data segment i is row i of the inverse times the segments received
+    for (unsigned int i = 0; i < k; i++) {
+        if (seen[i])
+            continue;
+        std::memset(data[i], 0, length);
+        for (unsigned int r = 0; r < k; r++)
+            gf.mulAdd(data[i], segments[r], inv[i * k + r], length);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef ERASURE_CODE_H_
+#define ERASURE_CODE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace vndn
+{
+
+/**
+ * \brief Systematic Reed-Solomon erasure code over GF(2^8)
+ *
+ * A block of K data segments of equal length is extended with N-K parity
+ * segments; segment i < K is data segment i itself, while parity segment
+ * i >= K is a linear combination of the data segments whose coefficients
+ * are the i-th row of a Cauchy matrix. Any K of the N segments are enough
+ * to reconstruct all the data segments.
+ */
+class ErasureCode
+{
+public:
+    /**
+     * \brief Maximum number of segments (data + parity) of a block
+     */
+    static const unsigned int maxSegments = 256;
+
+    /**
+     * \param dataSegments number of data segments (K)
+     * \param totalSegments number of data and parity segments (N),
+     *        with K <= N <= maxSegments
+     */
+    ErasureCode(unsigned int dataSegments, unsigned int totalSegments);
+
+    unsigned int getDataSegments() const { return k; }
+    unsigned int getTotalSegments() const { return n; }
+
+    /**
+     * \brief Computes a parity segment
+     *
+     * \param data the K data segments, each one length bytes long
+     * \param length length of each segment
+     * \param index index of the parity segment, in [K, N)
+     * \param parity buffer of length bytes where the parity segment is written
+     */
+    void encode(const uint8_t * const data[], size_t length,
+                unsigned int index, uint8_t *parity) const;
+
+    /**
+     * \brief Reconstructs the data segments from any K segments of the block
+     *
+     * \param indexes indexes of the K segments received
+     * \param segments the K segments received, each one length bytes long
+     * \param length length of each segment
+     * \param data the K buffers of length bytes where the data segments are
+     *        written; data[i] is left untouched when segment i was received
+     * \return false if indexes does not hold K distinct valid indexes
+     */
+    bool decode(const std::vector<unsigned int> &indexes,
+                const std::vector<const uint8_t *> &segments,
+                size_t length, uint8_t * const data[]) const;
+
+private:
+    /**
+     * \brief Coefficient of data segment column in segment row
+     */
+    uint8_t coefficient(unsigned int row, unsigned int column) const;
+
+    unsigned int k;
+    unsigned int n;
+};
+
+}
+
+#endif // ERASURE_CODE_H_
@@ -173,4 +173,39 @@ void NDNProducer::deregisterName(NameComponents &name, uint32_t face_fd)
     management_queue.send(oss.str().c_str(),oss.str().size(),0);
 }
 
+/**
+ * Sends the registration of the names in [begin, end), split among as many messages as needed
+ */
+static void sendRegistration(message_queue &management_queue, std::vector<NameComponents>::const_iterator begin,
+                             std::vector<NameComponents>::const_iterator end, uint32_t face_fd)
+{
+    ptree forwarding_entry;
+    forwarding_entry.put("ServiceType","ForwardingEntry");
+    forwarding_entry.put("Action","selfreg");
+    forwarding_entry.put("faceID",face_fd);
+    ptree prefixes;
+    for (std::vector<NameComponents>::const_iterator it = begin; it != end; ++it) {
+        std::stringstream prefix;
+        prefix << *it;
+        prefixes.push_back(std::make_pair("", ptree(prefix.str())));
+    }
+    forwarding_entry.add_child("Names",prefixes);
+    std::ostringstream oss;
+    write_json(oss,forwarding_entry);
+    // the names that do not fit in a message of the queue are split in halves, each one sent on its own
+    if (oss.str().size() > management_queue.get_max_msg_size() && end - begin > 1) {
+        std::vector<NameComponents>::const_iterator middle = begin + (end - begin) / 2;
+        sendRegistration(management_queue, begin, middle, face_fd);
+        sendRegistration(management_queue, middle, end, face_fd);
+        return;
+    }
+    management_queue.send(oss.str().c_str(),oss.str().size(),0);
+}
+
+void NDNProducer::registerNames(const std::vector<NameComponents> &names, uint32_t face_fd)
+{
+    message_queue management_queue(open_only,MANAGEMENT_QUEUE);
+    sendRegistration(management_queue, names.begin(), names.end(), face_fd);
+}
+
 } // namespace vndn
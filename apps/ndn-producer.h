@@ -24,6 +24,7 @@
 #define NDN_PRODUCER_H
 
 #include <list>
+#include <vector>
 
 #include "helper/monitorable.h"
 #include "helper/event-monitor.h"
@@ -68,6 +69,14 @@ public:
      */
     void deregisterName(NameComponents &name, uint32_t face_fd);
 
+    /**
+     * \brief Application tells ndnd that it can deal with all these names, with as few messages as possible
+     *
+     * The names are split among several messages when they do not fit in the maximum size of one.
+     * \param names nameComponents that producer wants to register to ndnd and file descriptor of the local face
+     */
+    void registerNames(const std::vector<NameComponents> &names, uint32_t face_fd);
+
 protected:
     int m_sock_fd;
 };
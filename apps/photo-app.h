@@ -30,12 +30,32 @@
 #define PHOTO_MINUTES_GRANULARITY 1
 
 
+/**
+ * Carried by the first content of a photo.
+ */
 struct PhotoHeader {
     uint32_t id;
-    uint32_t numberOfContents;
-    uint32_t size;
+    uint32_t numberOfContents;      // with PHOTO_CODED_FLAG if the photo is erasure-coded
+    uint32_t size;                  // photo size in bytes
+}__attribute__((packed));
+
+/**
+ * Set in PhotoHeader::numberOfContents by the producers of erasure-coded
+ * photos. Every content of such a photo carries a PhotoCodedHeader, followed by
+ * PHOTO_FEC_SEGMENT_SIZE bytes of a data or parity segment (the last data
+ * segment may be shorter).
+ */
+#define PHOTO_CODED_FLAG 0x80000000u
+
+struct PhotoCodedHeader {
+    PhotoHeader photo;              // numberOfContents counts the data and parity contents
+    uint32_t numberOfDataContents;  // any numberOfDataContents contents reconstruct the photo
 }__attribute__((packed));
 
+#define PHOTO_FEC_SEGMENT_SIZE (MAX_PHOTO_CONTENT_SIZE - sizeof(PhotoCodedHeader))
+/** interests kept in flight by the consumer for an erasure-coded photo */
+#define PHOTO_FEC_WINDOW 8
+
 
 /**
  * INTEREST
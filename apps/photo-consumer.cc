@@ -18,6 +18,7 @@
 
 #include "photo-app.h"
 #include "application-map.h"
+#include "erasure-code.h"
 #include "corelib/log.h"
 #include "corelib/ptr.h"
 #include "helper/event-monitor.h"
@@ -32,6 +33,9 @@
 #include <netinet/in.h>
 #include <syslog.h>
 #include <unistd.h>
+#include <vector>
+
+#include <boost/algorithm/string/join.hpp>
 
 using namespace vndn;
 
@@ -95,6 +99,73 @@ void getFileName(int photoCounter, std::string &fileName)
     fileName.append(".jpeg");
 }
 
+std::string joinName(const std::list<std::string> &name)
+{
+    return "/" + boost::algorithm::join(name, "/");
+}
+
+/**
+ * Expresses an interest for each chunk of the photo in chunks.
+ */
+int expressChunkInterests(const Ptr<NDNConsumer> &consumer, ApplicationMap &map, int carID,
+                          const std::vector<uint32_t> &chunks, time_t nowSecond, const std::string &positionInMap)
+{
+    std::list<std::string> name;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        buildInterestName(name, map, carID, chunks[i], nowSecond, positionInMap);
+        NameComponents nameCmp(name);
+        if (consumer->SendPacket(nameCmp) < 0) {
+            return -1;
+        }
+        NS_LOG_JSON(log::AppExpressedInterest, "name" << joinName(name));
+        NS_LOG_INFO("Interest sent out for '" << joinName(name) << "'");
+    }
+    return 0;
+}
+
+/**
+ * Reconstructs an erasure-coded photo from the first k contents received
+ * (with the photo header stripped) and writes its size bytes to photoFd.
+ */
+bool writeDecodedPhoto(int photoFd, std::vector<std::vector<uint8_t> > &segments,
+                       const std::vector<bool> &received, uint32_t k, uint32_t size)
+{
+    ErasureCode code(k, segments.size());
+    std::vector<std::vector<uint8_t> > data(k, std::vector<uint8_t>(PHOTO_FEC_SEGMENT_SIZE, 0));
+    std::vector<uint8_t *> out(k);
+    std::vector<unsigned int> indexes;
+    std::vector<const uint8_t *> in;
+
+    for (uint32_t i = 0; i < k; i++) {
+        out[i] = &data[i][0];
+    }
+    for (uint32_t i = 0; i < segments.size() && indexes.size() < k; i++) {
+        if (!received[i]) {
+            continue;
+        }
+        // the last data content may be shorter than the others
+        segments[i].resize(PHOTO_FEC_SEGMENT_SIZE, 0);
+        if (i < k) {
+            data[i] = segments[i];
+            out[i] = &data[i][0];
+        }
+        indexes.push_back(i);
+        in.push_back(&segments[i][0]);
+    }
+    if (!code.decode(indexes, in, PHOTO_FEC_SEGMENT_SIZE, &out[0])) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < k && size > 0; i++) {
+        size_t len = std::min<size_t>(PHOTO_FEC_SEGMENT_SIZE, size);
+        if (write(photoFd, out[i], len) != (ssize_t) len) {
+            return false;
+        }
+        size -= len;
+    }
+    return true;
+}
+
 void resetTimerNextDeadline(timeval * tt, int retransmissionDeadline) {
     tt->tv_sec = retransmissionDeadline;
     tt->tv_usec = 0;
@@ -161,9 +232,16 @@ int main(int argc, char **argv)
     memset(buffer, 0, 2000);
     bool sendAgain = true;
     std::list<std::string> interestComponentName;
-    uint32_t chunkNumber = 0;
-    uint32_t requiredChunk = -1;
+    uint32_t chunkNumber = 0;       // chunk currently requested (next chunk to request if erasure-coded)
+    uint32_t requiredChunk = -1;    // chunks of the photo
+    uint32_t dataChunk = -1;        // chunks needed to reconstruct the photo
+    uint32_t receivedChunk = 0;
+    uint32_t photoSize = 0;
     uint32_t carId = 0;
+    bool coded = false;
+    std::vector<std::vector<uint8_t> > segments;    // erasure-coded chunks received
+    std::vector<bool> segmentReceived;
+    std::vector<uint32_t> chunksToRequest;
     std::string listName;
     NameComponents interestNameCmp, contentNameCmp;
 
@@ -177,20 +255,20 @@ int main(int argc, char **argv)
         receivedPhotoCounter++;
         chunkNumber=0;
         requiredChunk=-1;
+        dataChunk=-1;
+        receivedChunk=0;
         carId=0;
+        coded=false;
+        segments.clear();
+        segmentReceived.clear();
         time_t nowSecond = time(NULL);
         sendAgain = true;
         std::string requestedPosition = buildInterestName(interestComponentName, map, carId, chunkNumber, nowSecond);
-        std::list<std::string>::iterator i;
-        listName="";
-        for(i=interestComponentName.begin(); i!=interestComponentName.end();i++) {
-            listName.append("/");
-            listName.append(*i);
-        }
+        listName = joinName(interestComponentName);
         resetTimerNextDeadline(&tvNextDeadline, retransmissionDeadline);
         gettimeofday(&tvSelectTime,NULL);
 
-        while (requiredChunk != chunkNumber) {
+        while (receivedChunk != dataChunk) {
             memset(buffer, 0, 2000);
 
             if (sendAgain) {
@@ -220,7 +298,29 @@ int main(int argc, char **argv)
             } else if (res == 0) {
                 // timer expired
                 NS_LOG_JSON(log::InterestTimedOut, "name" << listName);
-                NS_LOG_INFO("Timer expired, no content received, resending interest.");
+                if (coded) {
+                    // the contents in flight are lost: request new chunks while there
+                    // are any left, the missing ones otherwise
+                    chunksToRequest.clear();
+                    for (; chunkNumber < requiredChunk && chunksToRequest.size() < PHOTO_FEC_WINDOW; chunkNumber++) {
+                        chunksToRequest.push_back(chunkNumber);
+                    }
+                    if (chunksToRequest.empty()) {
+                        for (uint32_t i = 0; i < requiredChunk && chunksToRequest.size() < PHOTO_FEC_WINDOW; i++) {
+                            if (!segmentReceived[i]) {
+                                chunksToRequest.push_back(i);
+                            }
+                        }
+                    }
+                    NS_LOG_INFO("Timer expired, requesting " << chunksToRequest.size() << " chunks.");
+                    if (expressChunkInterests(consumer, map, carId, chunksToRequest, nowSecond, requestedPosition) < 0) {
+                        NS_LOG_ERROR("SendPacket() failed, exiting.");
+                        return -1;
+                    }
+                    sendAgain = false;
+                } else {
+                    NS_LOG_INFO("Timer expired, no content received, resending interest.");
+                }
                 gettimeofday(&tvSelectTime, NULL);
                 resetTimerNextDeadline(&tvNextDeadline, retransmissionDeadline);
             } else {
@@ -238,36 +338,95 @@ int main(int argc, char **argv)
                         continue;
                     }
 
-                    NS_LOG_JSON(log::InterestSatisfied, "name" << listName);
-                    NS_LOG_INFO("Received content for chunk #" << chunkNumber << " (size=" << res << ").");
+                    uint32_t segment = atoi(contentNameCmp.GetLastComponent().c_str());
+                    if (coded ? (segment >= requiredChunk || segmentReceived[segment]) : segment != chunkNumber) {
+                        // duplicate, or late content for a chunk we are not waiting for
+                        NS_LOG_DEBUG("Ignoring content for chunk #" << segment << ".");
+                        sendAgain = false;
+                        setTimerNextDeadline(&tvNextDeadline, tvSelectTime, retransmissionDeadline);
+                        continue;
+                    }
+
+                    NS_LOG_JSON(log::InterestSatisfied, "name" << joinName(contentNameCmp.GetComponents()));
+                    NS_LOG_INFO("Received content for chunk #" << segment << " (size=" << res << ").");
 
-                    // TODO store it
                     char *data = buffer;
                     int dataSize = res;
-                    if (chunkNumber==0) {
-                        //first content received
+                    if (coded || receivedChunk == 0) {
                         PhotoHeader *photoHdr = (PhotoHeader *) buffer;
-                        requiredChunk = ntohl(photoHdr->numberOfContents);
-                        carId = ntohl(photoHdr->id);
-                        NS_LOG_INFO("Photo from car " << carId<< ", number of chunk: " << requiredChunk);
-                        data = &(buffer[sizeof(PhotoHeader)]);
-                        dataSize -= sizeof(PhotoHeader);
+                        if (dataSize < (int) sizeof(PhotoHeader) ||
+                                ((coded || (ntohl(photoHdr->numberOfContents) & PHOTO_CODED_FLAG) != 0) &&
+                                 dataSize < (int) sizeof(PhotoCodedHeader))) {
+                            NS_LOG_WARN("Ignoring content for chunk #" << segment << " shorter than the photo header (size=" << dataSize << ").");
+                            sendAgain = false;
+                            setTimerNextDeadline(&tvNextDeadline, tvSelectTime, retransmissionDeadline);
+                            continue;
+                        }
+                        if (receivedChunk == 0) {
+                            //first content received
+                            requiredChunk = ntohl(photoHdr->numberOfContents);
+                            coded = (requiredChunk & PHOTO_CODED_FLAG) != 0;
+                            requiredChunk &= ~PHOTO_CODED_FLAG;
+                            dataChunk = requiredChunk;
+                            photoSize = ntohl(photoHdr->size);
+                            carId = ntohl(photoHdr->id);
+                            if (coded) {
+                                dataChunk = ntohl(((PhotoCodedHeader *) buffer)->numberOfDataContents);
+                                if (dataChunk == 0 || dataChunk > requiredChunk || requiredChunk > ErasureCode::maxSegments) {
+                                    NS_LOG_WARN("Ignoring invalid erasure-coded photo header: " << dataChunk << " of " << requiredChunk << " chunks needed.");
+                                    coded = false;
+                                    requiredChunk = -1;
+                                    dataChunk = -1;
+                                    sendAgain = false;
+                                    setTimerNextDeadline(&tvNextDeadline, tvSelectTime, retransmissionDeadline);
+                                    continue;
+                                }
+                            }
+                            NS_LOG_INFO("Photo from car " << carId << ", number of chunk: " << requiredChunk
+                                        << (coded ? ", erasure-coded, needed: " : ", needed: ") << dataChunk);
+                            if (coded) {
+                                segments.resize(requiredChunk);
+                                segmentReceived.resize(requiredChunk, false);
+                            }
+                        }
+                        const size_t hdrLen = coded ? sizeof(PhotoCodedHeader) : sizeof(PhotoHeader);
+                        data = &(buffer[hdrLen]);
+                        dataSize -= hdrLen;
+                    }
+                    receivedChunk++;
+                    if (segment == chunkNumber) {
+                        chunkNumber++;
                     }
-                    chunkNumber++;
-                    res = write(photoFd, data, dataSize);
-                    sendAgain=true;
-                    buildInterestName(interestComponentName, map, carId, chunkNumber, nowSecond, requestedPosition);
-                    std::list<std::string>::iterator i;
-                    listName="";
-                    for(i=interestComponentName.begin(); i!=interestComponentName.end();i++) {
-                        listName.append(*i);
-                        listName.append("/");
+                    if (coded) {
+                        segments[segment].assign(data, data + dataSize);
+                        segmentReceived[segment] = true;
+                        // keep PHOTO_FEC_WINDOW interests in flight: the parity chunks
+                        // make up for the contents lost, without waiting for a timeout
+                        chunksToRequest.clear();
+                        unsigned int window = receivedChunk == 1 ? PHOTO_FEC_WINDOW : 1;
+                        for (; receivedChunk < dataChunk && chunkNumber < requiredChunk &&
+                                chunksToRequest.size() < window; chunkNumber++) {
+                            chunksToRequest.push_back(chunkNumber);
+                        }
+                        if (expressChunkInterests(consumer, map, carId, chunksToRequest, nowSecond, requestedPosition) < 0) {
+                            NS_LOG_ERROR("SendPacket() failed, exiting.");
+                            return -1;
+                        }
+                        sendAgain = false;
+                    } else {
+                        res = write(photoFd, data, dataSize);
+                        sendAgain = true;
+                        buildInterestName(interestComponentName, map, carId, chunkNumber, nowSecond, requestedPosition);
+                        listName = joinName(interestComponentName);
                     }
                     gettimeofday(&tvSelectTime,NULL);
                     resetTimerNextDeadline(&tvNextDeadline, retransmissionDeadline);
                 }
             }
         }
+        if (coded && !writeDecodedPhoto(photoFd, segments, segmentReceived, dataChunk, photoSize)) {
+            NS_LOG_ERROR("Failed to reconstruct the erasure-coded photo.");
+        }
         close(photoFd);
 
         std::string fileName;
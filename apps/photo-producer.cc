@@ -18,6 +18,7 @@
 
 #include "photo-app.h"
 #include "application-map.h"
+#include "erasure-code.h"
 #include "corelib/log.h"
 #include "corelib/ptr.h"
 #include "helper/event-monitor.h"
@@ -28,6 +29,7 @@
 #include "utils/geo/gps-info.h"
 #include "utils/gpsd-util.h"
 
+#include <algorithm>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -37,6 +39,7 @@
 #include <unistd.h>
 #include <netinet/in.h>
 #include <syslog.h>
+#include <vector>
 
 #include <boost/algorithm/string/join.hpp>
 
@@ -72,17 +75,110 @@ public:
 };
 
 
+/**
+ * Reads the whole photo file into photo.
+ */
+static bool readPhoto(int fd, std::vector<uint8_t> &photo)
+{
+    uint8_t buffer[4096];
+    ssize_t res;
+    photo.clear();
+    while ((res = read(fd, buffer, sizeof(buffer))) > 0) {
+        photo.insert(photo.end(), buffer, buffer + res);
+    }
+    return res == 0;
+}
+
+/**
+ * Splits the photo in contents. If redundancy is not 0, the photo is
+ * erasure-coded: redundancy is the number of parity contents added, as a
+ * percentage of the data contents (rounded up), and every content carries
+ * the PhotoCodedHeader so that any numberOfDataContents of them are enough.
+ */
+static void splitPhoto(const std::vector<uint8_t> &photo, uint32_t carId, unsigned int redundancy, Photo &p)
+{
+    const size_t size = photo.size();
+    PhotoHeader hdr;
+    hdr.id = htonl(carId);
+    hdr.size = htonl(size);
+    p.contentSize = size;
+
+    if (redundancy > 0) {
+        uint32_t k = std::max<size_t>(1, (size + PHOTO_FEC_SEGMENT_SIZE - 1) / PHOTO_FEC_SEGMENT_SIZE);
+        uint32_t n = k + (k * redundancy + 99) / 100;
+        if (n <= ErasureCode::maxSegments) {
+            PhotoCodedHeader codedHdr;
+            codedHdr.photo = hdr;
+            codedHdr.photo.numberOfContents = htonl(n | PHOTO_CODED_FLAG);
+            codedHdr.numberOfDataContents = htonl(k);
+            p.numberOfPacket = n;
+            p.photoContent = new Content[n];
+
+            std::vector<uint8_t> padded(k * PHOTO_FEC_SEGMENT_SIZE, 0);
+            std::copy(photo.begin(), photo.end(), padded.begin());
+            std::vector<const uint8_t *> data(k);
+            for (uint32_t i = 0; i < k; i++) {
+                data[i] = &padded[i * PHOTO_FEC_SEGMENT_SIZE];
+            }
+
+            ErasureCode code(k, n);
+            for (uint32_t i = 0; i < n; i++) {
+                Content &c = p.photoContent[i];
+                memcpy(c.data, &codedHdr, sizeof(PhotoCodedHeader));
+                if (i < k) {
+                    size_t len = std::min(PHOTO_FEC_SEGMENT_SIZE, size - i * PHOTO_FEC_SEGMENT_SIZE);
+                    memcpy(&c.data[sizeof(PhotoCodedHeader)], data[i], len);
+                    c.size = sizeof(PhotoCodedHeader) + len;
+                } else {
+                    code.encode(&data[0], PHOTO_FEC_SEGMENT_SIZE, i, &c.data[sizeof(PhotoCodedHeader)]);
+                    c.size = MAX_PHOTO_CONTENT_SIZE;
+                }
+            }
+            NS_LOG_DEBUG("Photo erasure-coded in " << k << " data and " << n - k << " parity contents");
+            return;
+        }
+        NS_LOG_WARN("Photo too large to be erasure-coded (" << n << " contents), sending it uncoded.");
+    }
+
+    uint32_t n = 1;
+    if (size > MAX_PHOTO_CONTENT_SIZE - sizeof(PhotoHeader)) {
+        n += (size - (MAX_PHOTO_CONTENT_SIZE - sizeof(PhotoHeader)) + MAX_PHOTO_CONTENT_SIZE - 1) / MAX_PHOTO_CONTENT_SIZE;
+    }
+    hdr.numberOfContents = htonl(n);
+    p.numberOfPacket = n;
+    p.photoContent = new Content[n];
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        Content &c = p.photoContent[i];
+        size_t hdrLen = 0;
+        if (i == 0) {
+            memcpy(c.data, &hdr, sizeof(PhotoHeader));
+            hdrLen = sizeof(PhotoHeader);
+        }
+        size_t len = std::min<size_t>(MAX_PHOTO_CONTENT_SIZE - hdrLen, size - offset);
+        if (len > 0) {
+            memcpy(&c.data[hdrLen], &photo[offset], len);
+        }
+        offset += len;
+        c.size = hdrLen + len;
+    }
+}
+
+
 int main(int argc, char **argv)
 {
     bool first = true;
     if (argc < 4) {
-        std::cerr << "Invalid number of arguments. Specify: car id, gps port, webcam device path" << std::endl;
+        std::cerr << "Invalid number of arguments. Specify: car id, gps port, webcam device path"
+                  << " [, erasure coding redundancy in percent (0 to disable, default)]" << std::endl;
         return -1;
     }
 
     ::openlog("photo-producer", LOG_ODELAY | LOG_PID, LOG_LOCAL6);
 
     std::string carID = std::string(argv[1]);
+    unsigned int fecRedundancy = argc > 4 ? atoi(argv[4]) : 0;
 
     NDNAppSocket socketconnector;
     if (socketconnector.getSocketFD() < 0) {
@@ -199,7 +295,7 @@ int main(int argc, char **argv)
                         }
                         if (photoAlreadyProcessed) {
                             Photo *processedPhoto = &(*it);
-                            if (segmentNumber > processedPhoto->numberOfPacket) {
+                            if (segmentNumber >= processedPhoto->numberOfPacket) {
                                 NS_LOG_WARN("Wrong sequence number: " << segmentNumber);
                                 continue;
                             }
@@ -242,61 +338,20 @@ int main(int argc, char **argv)
                                     }
 
                                     //storing the photo in content storage
-                                    std::list<Content> contentList;
-                                    int photoSize=0;
-                                    int contentNumber=0;
-                                    bool photoEnd=false;
-                                    while(!photoEnd) {
-                                        Content c;
-                                        if(contentNumber==0) {
-                                            res = read(photoFd, buffer, MAX_PHOTO_CONTENT_SIZE - sizeof(PhotoHeader));
-                                        } else {
-                                            res = read(photoFd, buffer, MAX_PHOTO_CONTENT_SIZE);
-                                        }
-                                        if (res==0) {
-                                            //end of file
-                                            photoEnd = true;
-                                        } else if (res ==-1) {
-                                            NS_LOG_ERROR("Error reading photo file, discarding the photo.");
-                                            continue;
-                                        } else {
-                                            if(contentNumber==0) {
-                                                memcpy(&(c.data[sizeof(PhotoHeader)]), buffer, res);
-                                                res+=sizeof(PhotoHeader);
-                                            } else {
-                                                memcpy(c.data, buffer, res);
-                                            }
-                                            contentNumber++;
-                                            c.size=res;
-                                            photoSize+=res;
-                                            NS_LOG_DEBUG("partial size: " << res);
-                                            contentList.push_back(c);
-                                        }
+                                    std::vector<uint8_t> photoData;
+                                    bool readOk = readPhoto(photoFd, photoData);
+                                    close(photoFd);
+                                    if (!readOk) {
+                                        NS_LOG_ERROR("Error reading photo file, discarding the photo.");
+                                        continue;
                                     }
-                                    NS_LOG_DEBUG("photo size: " << photoSize);
-                                    Photo * newPhoto = new Photo();
+                                    NS_LOG_DEBUG("photo size: " << photoData.size());
+                                    photoStorage.push_back(Photo());
+                                    Photo *newPhoto = &photoStorage.back();
                                     newPhoto->id = interestId;
-                                    newPhoto->numberOfPacket = contentNumber;
-                                    newPhoto->photoContent = new Content[contentNumber];
+                                    splitPhoto(photoData, atoi(carID.c_str()), fecRedundancy, *newPhoto);
                                     NS_LOG_DEBUG("number of chunks: "<<newPhoto->numberOfPacket);
-                                    std::list<Content>::iterator it;
-                                    int index=0;
-                                    for (it=contentList.begin(); it!=contentList.end(); it++) {
-                                        newPhoto->photoContent[index]=*it;
-                                        newPhoto->contentSize+=(*it).size;
-                                        index++;
-                                    }
-                                    newPhoto->contentSize-=sizeof(PhotoHeader);
-                                    if (atoi(interestStringComponent[4].c_str())==0) { //it shouldn't be happen otherwise
-                                        PhotoHeader hdr;
-                                        hdr.id = htonl(atoi(carID.c_str()));
-                                        hdr.numberOfContents =htonl(newPhoto->numberOfPacket);
-                                        NS_LOG_DEBUG("number of content in hdr "<<ntohl(hdr.numberOfContents));
-                                        hdr.size=htonl(newPhoto->contentSize);
-                                        memcpy(newPhoto->photoContent[0].data, &hdr, sizeof(PhotoHeader));
-                                    }
-                                    photoStorage.push_back(*newPhoto);
-                                    if (segmentNumber > newPhoto->numberOfPacket) {
+                                    if (segmentNumber >= newPhoto->numberOfPacket) {
                                         NS_LOG_WARN("Wrong segment #" << segmentNumber << " was requested.");
                                         continue;
                                     }
@@ -321,7 +376,7 @@ int main(int argc, char **argv)
 
                         if (first) {
                             PhotoHeader *photoHdr = (PhotoHeader *) contentToSend->data;
-                            uint32_t requiredChunk = ntohl(photoHdr->numberOfContents);
+                            uint32_t requiredChunk = ntohl(photoHdr->numberOfContents) & ~PHOTO_CODED_FLAG;
                             uint32_t carId = ntohl(photoHdr->id);
                             NS_LOG_INFO("Sending photo header: car = " << carId << "; number of chunks = " << requiredChunk);
                             first = false;
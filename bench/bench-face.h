@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef BENCH_FACE_H_
+#define BENCH_FACE_H_
+
+#include "daemon/ndn-face.h"
+
+namespace vndn
+{
+
+/**
+ * \brief NDN face that does not perform any I/O, used by the benchmarks
+ *
+ * Sent packets are only counted. The face id is used in place of the file
+ * descriptor, so that faces with different ids compare as different.
+ */
+class BenchFace : public NDNFace
+{
+public:
+    explicit BenchFace(int id)
+        : m_sent(0)
+    {
+        m_app_fd = id;
+    }
+
+    virtual bool Send(const Ptr<const Packet> &)
+    {
+        m_sent++;
+        return true;
+    }
+
+    virtual std::ostream &Print(std::ostream &os) const
+    {
+        os << "dev=bench(" << m_app_fd << ")";
+        return os;
+    }
+
+    unsigned long GetSentCount() const { return m_sent; }
+
+private:
+    unsigned long m_sent;
+};
+
+} // namespace vndn
+
+#endif /* BENCH_FACE_H_ */
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+/*
+ * Forwarding loop benchmark.
+ *
+ * Drives NDNL3Protocol::Receive() directly with pre-encoded packets:
+ * every iteration injects an interest from a "consumer" face, which is
+ * forwarded via the FIB to a "producer" face, and then the matching data
+ * from the producer face, which satisfies the PIT entry and is cached in
+ * the content store. Faces do not perform any I/O, so the measured time
+ * is spent entirely inside the forwarding plane (including logging).
+ */
+
+#include "bench-face.h"
+#include "corelib/ptr.h"
+#include "corelib/singleton.h"
+#include "daemon/ndn-fib.h"
+#include "daemon/ndn-flooding-strategy.h"
+#include "daemon/ndn-l3-protocol.h"
+#include "network/ndn-content-packet.h"
+#include "network/ndn-interest-header.h"
+#include "network/ndn-name-components.h"
+#include "network/packet.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <time.h>
+#include <vector>
+
+using namespace vndn;
+using std::cerr;
+using std::cout;
+using std::endl;
+
+
+static double elapsed(const struct timespec &start, const struct timespec &end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void usage()
+{
+    cout << "Usage: ./forwardingBench [-n <iterations>] [-c <name components>]" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 100000;
+    int components = 4;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "-n" && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            components = atoi(argv[++i]);
+        } else {
+            usage();
+            return -1;
+        }
+    }
+    if (iterations <= 0 || components < 2) {
+        usage();
+        return -1;
+    }
+
+    NDNL3Protocol *protocol = Singleton<NDNL3Protocol>::Get();
+    protocol->SetForwardingStrategy(Create<NDNFloodingStrategy>());
+    Ptr<NDNFib> fib = Create<NDNFib>();
+    protocol->SetFib(fib);
+
+    Ptr<BenchFace> consumer = Create<BenchFace>(1000);
+    Ptr<BenchFace> producer = Create<BenchFace>(1001);
+    protocol->AddFace(consumer);
+    protocol->AddFace(producer);
+    fib->Add(NameComponents("/bench"), producer, 0);
+
+    // encode all the packets in advance, names are unique so that
+    // interests are never satisfied by the content store
+    std::vector<Ptr<const Packet> > interests;
+    std::vector<Ptr<const Packet> > data;
+    interests.reserve(iterations);
+    data.reserve(iterations);
+    const std::string payload(100, 'x');
+    for (int i = 0; i < iterations; i++) {
+        std::ostringstream uri;
+        uri << "/bench";
+        for (int c = 2; c < components; c++)
+            uri << "/c" << c;
+        uri << "/" << i;
+        Ptr<NameComponents> name = Create<NameComponents>(uri.str());
+
+        Ptr<InterestHeader> interestHeader = Create<InterestHeader>();
+        interestHeader->SetNonce(rand());
+        interestHeader->SetName(name);
+        Ptr<Packet> interest = Create<Packet>();
+        interest->AddHeader(interestHeader);
+        interests.push_back(interest);
+
+        data.push_back(Create<NDNContentPacket>(name,
+                                                (const uint8_t *)payload.data(),
+                                                payload.size()));
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        consumer->Receive(interests[i]);
+        producer->Receive(data[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (producer->GetSentCount() != (unsigned long)iterations || consumer->GetSentCount() != (unsigned long)iterations) {
+        cerr << "Error: " << producer->GetSentCount() << " interests and " << consumer->GetSentCount()
+             << " data forwarded, expected " << iterations << endl;
+        return 1;
+    }
+
+    const double secs = elapsed(start, end);
+    cout << "iterations:       " << iterations << endl
+         << "name components:  " << components << endl
+         << "total time (s):   " << secs << endl
+         << "ns per iteration: " << secs * 1e9 / iterations << endl
+         << "packets/s:        " << 2 * iterations / secs << endl;
+
+    return 0;
+}
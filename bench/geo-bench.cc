@@ -0,0 +1,719 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+/*
+ * Map matching benchmark.
+ *
+ * Times the nearest junction and nearest link queries of geo::Map, which run
+ * on its spatial index, at random positions inside the map, with the same
+ * research box used by LocationService. Every query is also answered by a
+ * linear scan of the whole map, which is timed on a subset of the positions
+ * and used to check the results of the index.
+ *
+ * Two maps are used: the one bundled in utils/geo/map and a synthetic
+ * city-scale grid of streets, written to a temporary directory. Each map is
+ * also converted to a binary map file, whose load time is reported and whose
+ * answers are compared with the ones of the text map.
+ *
+ * Finally, the elements at two hops from the closest link are visited, as
+ * geographic forwarding does, both by string ids and on the road graph, and
+ * the noisy fixes of a car driving on the map are matched both from scratch
+ * and incrementally by MapMatcher. The batch distance kernels are also
+ * compared with the scalar distances of Coordinate, for speed and accuracy,
+ * and GpsdParser is fed a gpsd stream both one report per read and in
+ * chunks of random size, which split and concatenate the reports.
+ */
+
+#include "latency-recorder.h"
+
+#include "corelib/log.h"
+#include "utils/geo/coordinate.h"
+#include "utils/geo/distance-kernels.h"
+#include "utils/geo/gps-info.h"
+#include "utils/geo/gpsd-parser.h"
+#include "utils/geo/junction.h"
+#include "utils/geo/link.h"
+#include "utils/geo/map.h"
+#include "utils/geo/map-file.h"
+#include "utils/geo/map-matcher.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace vndn;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+static const double RESEARCH_BOX = 0.001; // as in LocationService
+
+struct BenchConfig {
+    unsigned int queries;
+    unsigned int scanQueries;
+    unsigned int gridSide;
+    string nodesFile;
+    string edgesFile;
+};
+
+static double elapsed(const struct timespec &start, const struct timespec &end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static double RandomIn(double min, double max)
+{
+    return min + (max - min) * (rand() / (RAND_MAX + 1.0));
+}
+
+/**
+ * Writes a grid of side x side junctions, about 100 m apart, connected by
+ * horizontal and vertical links, in the format read by geo::Map. The
+ * coordinates have 7 decimals, as in OpenStreetMap.
+ */
+static void WriteGrid(unsigned int side, const string &nodesFile, const string &edgesFile)
+{
+    const double lat0 = 33.9, lon0 = -118.5, step = 0.0009;
+    std::ofstream nodes(nodesFile.c_str());
+    std::ofstream edges(edgesFile.c_str());
+    nodes << std::fixed << std::setprecision(7);
+    for (unsigned int i = 0; i < side; i++) {
+        for (unsigned int j = 0; j < side; j++) {
+            nodes << i * side + j << " " << lat0 + i * step + RandomIn(-step, step) / 4
+                  << " " << lon0 + j * step + RandomIn(-step, step) / 4 << "\n";
+            if (j + 1 < side)
+                edges << "h" << i << "_" << j << " " << i * side + j << " " << i * side + j + 1 << "\n";
+            if (i + 1 < side)
+                edges << "v" << i << "_" << j << " " << i * side + j << " " << (i + 1) * side + j << "\n";
+        }
+    }
+}
+
+static const geo::Junction *ScanJunctions(const geo::Map &map, const geo::Coordinate &c, double &minDistance)
+{
+    const geo::Junction *closest = NULL;
+    minDistance = -1;
+    const std::map<string, geo::Junction> &nodes = map.getNodeTable();
+    for (std::map<string, geo::Junction>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        const geo::Coordinate coord = it->second.getCoordinate();
+        if (std::fabs(coord.getLatitude() - c.getLatitude()) > RESEARCH_BOX ||
+                std::fabs(coord.getLongitude() - c.getLongitude()) > RESEARCH_BOX)
+            continue;
+        double distance = c.twoPointsDistance(coord);
+        if (minDistance == -1 || distance < minDistance) {
+            minDistance = distance;
+            closest = &it->second;
+        }
+    }
+    return closest;
+}
+
+static double LinkDistance(const geo::Map &map, const geo::Link &link, const geo::Coordinate &c,
+                           bool checkBox)
+{
+    const std::map<string, geo::Junction> &nodes = map.getNodeTable();
+    const geo::Coordinate start = nodes.find(link.getKeyNode1())->second.getCoordinate();
+    const geo::Coordinate end = nodes.find(link.getKeyNode2())->second.getCoordinate();
+    if (checkBox &&
+            (std::min(start.getLatitude(), end.getLatitude()) > c.getLatitude() + RESEARCH_BOX ||
+             std::max(start.getLatitude(), end.getLatitude()) < c.getLatitude() - RESEARCH_BOX ||
+             std::min(start.getLongitude(), end.getLongitude()) > c.getLongitude() + RESEARCH_BOX ||
+             std::max(start.getLongitude(), end.getLongitude()) < c.getLongitude() - RESEARCH_BOX))
+        return -1;
+    return c.pointToSegmentDistUTM(start, end);
+}
+
+static const geo::Link *ScanLinks(const geo::Map &map, const geo::Coordinate &c, double &minDistance)
+{
+    const geo::Link *closest = NULL;
+    minDistance = -1;
+    const std::map<string, geo::Junction> &nodes = map.getNodeTable();
+    for (std::map<string, geo::Junction>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        const std::list<geo::Link> &links = it->second.getLinks();
+        for (std::list<geo::Link>::const_iterator link = links.begin(); link != links.end(); ++link) {
+            double distance = LinkDistance(map, *link, c, true);
+            if (distance >= 0 && (minDistance == -1 || distance < minDistance)) {
+                minDistance = distance;
+                closest = &*link;
+            }
+        }
+    }
+    return closest;
+}
+
+/*
+ * Counts the elements at two hops from el that are closer to c than to the
+ * first junction of el, with string ids as done before the road graph.
+ */
+static unsigned int NeighboursByName(const geo::Map &map, const geo::MapElement *el, const geo::Coordinate &c,
+                                     const geo::Coordinate &me)
+{
+    unsigned int closer = 0;
+    std::list<string> connections;
+    el->getConnection(connections);
+    for (std::list<string>::const_iterator it = connections.begin(); it != connections.end(); ++it) {
+        std::list<string> next;
+        map.getMapSegmentById(*it)->getConnection(next);
+        for (std::list<string>::const_iterator n = next.begin(); n != next.end(); ++n) {
+            const geo::MapElement *element = map.getMapSegmentById(*n);
+            if (element->getDistance(c) <= element->getDistance(me))
+                closer++;
+        }
+    }
+    return closer;
+}
+
+/*
+ * As NeighboursByName, on the road graph.
+ */
+static unsigned int NeighboursById(const geo::RoadGraph &graph, geo::RoadGraph::ElementId el,
+                                   const geo::Coordinate &c, const geo::Coordinate &me)
+{
+    unsigned int closer = 0;
+    for (const geo::RoadGraph::ElementId *it = graph.neighboursBegin(el); it != graph.neighboursEnd(el); ++it)
+        for (const geo::RoadGraph::ElementId *n = graph.neighboursBegin(*it); n != graph.neighboursEnd(*it); ++n)
+            if (graph.getDistance(*n, c) <= graph.getDistance(*n, me))
+                closer++;
+    return closer;
+}
+
+static const double DRIVE_STEP = 10;   // meters between two fixes, 36 km/h at 1 Hz
+static const double GPS_NOISE = 5;     // meters, maximum error of a fix on each axis
+
+struct MatchingStats {
+    unsigned int fixes;
+    unsigned int globalFlaps, incrementalFlaps;        // A -> B -> A in three fixes
+    unsigned int globalOffRoute, incrementalOffRoute;  // neither the link driven on, nor one of its junctions
+    double incrementalRatio;
+    double meanConfidence;
+
+    MatchingStats() : fixes(0), globalFlaps(0), incrementalFlaps(0), globalOffRoute(0),
+                      incrementalOffRoute(0), incrementalRatio(0), meanConfidence(0) { }
+};
+
+static bool IsOnRoute(const geo::RoadGraph &graph, geo::RoadGraph::ElementId matched, geo::RoadGraph::ElementId link)
+{
+    return matched == link || matched == graph.getLinkStart(link) || matched == graph.getLinkEnd(link);
+}
+
+/*
+ * Drives a car at random on the links of the map, turning at random at every
+ * junction, and matches its noisy fixes both with a global search for each
+ * fix and incrementally.
+ */
+static MatchingStats BenchMatching(const BenchConfig &config, const geo::Map &map,
+                                   LatencyRecorder &global, LatencyRecorder &incremental)
+{
+    typedef geo::RoadGraph::ElementId ElementId;
+    const geo::RoadGraph &graph = map.getGraph();
+    MatchingStats stats;
+    if (graph.getLinkCount() == 0)
+        return stats;
+
+    ElementId link = graph.getJunctionCount() + rand() % graph.getLinkCount();
+    ElementId from = graph.getLinkStart(link), to = graph.getLinkEnd(link);
+    double offset = 0;
+    geo::MapMatcher matcher;
+    vector<ElementId> globalMatches, incrementalMatches;
+    double confidence = 0;
+    for (unsigned int i = 0; i < config.queries; i++) {
+        double dn = graph.getUTMNorthing(to) - graph.getUTMNorthing(from);
+        double de = graph.getUTMEasting(to) - graph.getUTMEasting(from);
+        double length = std::sqrt(dn * dn + de * de);
+        offset += DRIVE_STEP;
+        while (offset >= length) {
+            // turn at random, go back only at dead ends
+            offset -= length;
+            const ElementId *begin = graph.neighboursBegin(to), *end = graph.neighboursEnd(to);
+            ElementId next = begin[rand() % (end - begin)];
+            while (next == link && end - begin > 1)
+                next = begin[rand() % (end - begin)];
+            link = next;
+            from = to;
+            to = graph.getLinkStart(link) == from ? graph.getLinkEnd(link) : graph.getLinkStart(link);
+            dn = graph.getUTMNorthing(to) - graph.getUTMNorthing(from);
+            de = graph.getUTMEasting(to) - graph.getUTMEasting(from);
+            length = std::sqrt(dn * dn + de * de);
+        }
+        const double f = length > 0 ? offset / length : 0;
+        const double lat = graph.getLatitude(from) + f * (graph.getLatitude(to) - graph.getLatitude(from));
+        const double lon = graph.getLongitude(from) + f * (graph.getLongitude(to) - graph.getLongitude(from));
+        const geo::Coordinate fix(lat + RandomIn(-GPS_NOISE, GPS_NOISE) / 111320,
+                                  lon + RandomIn(-GPS_NOISE, GPS_NOISE) / (111320 * std::cos(lat * M_PI / 180)));
+        const double heading = std::atan2(de, dn) * 180 / M_PI;
+
+        global.Start();
+        globalMatches.push_back(geo::MapMatcher::matchGlobal(map, fix));
+        global.Stop();
+        incremental.Start();
+        incrementalMatches.push_back(matcher.match(map, fix, DRIVE_STEP, heading));
+        incremental.Stop();
+        confidence += matcher.getConfidence();
+
+        stats.globalOffRoute += !IsOnRoute(graph, globalMatches.back(), link);
+        stats.incrementalOffRoute += !IsOnRoute(graph, incrementalMatches.back(), link);
+        if (i >= 2) {
+            stats.globalFlaps += globalMatches[i] == globalMatches[i - 2] && globalMatches[i] != globalMatches[i - 1];
+            stats.incrementalFlaps += incrementalMatches[i] == incrementalMatches[i - 2] &&
+                                      incrementalMatches[i] != incrementalMatches[i - 1];
+        }
+    }
+    stats.fixes = config.queries;
+    stats.incrementalRatio = (double)matcher.getIncrementalMatches() / config.queries;
+    stats.meanConfidence = confidence / config.queries;
+    return stats;
+}
+
+static void BenchMap(const BenchConfig &config, const string &name, const string &nodesFile,
+                     const string &edgesFile, const string &binaryFile, log::JsonLogger &json)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    geo::Map map(nodesFile, edgesFile);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double loadTime = elapsed(start, end);
+
+    const geo::SpatialIndex &index = map.getIndex();
+    if (index.getJunctionCount() == 0) {
+        cerr << "Error: the map " << name << " is empty" << endl;
+        return;
+    }
+
+    // query positions, all inside the bounding box of the map
+    double minLat = 90, maxLat = -90, minLon = 180, maxLon = -180;
+    const std::map<string, geo::Junction> &nodes = map.getNodeTable();
+    for (std::map<string, geo::Junction>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        const geo::Coordinate coord = it->second.getCoordinate();
+        minLat = std::min(minLat, coord.getLatitude());
+        maxLat = std::max(maxLat, coord.getLatitude());
+        minLon = std::min(minLon, coord.getLongitude());
+        maxLon = std::max(maxLon, coord.getLongitude());
+    }
+    vector<geo::Coordinate> positions;
+    positions.reserve(config.queries);
+    for (unsigned int i = 0; i < config.queries; i++)
+        positions.push_back(geo::Coordinate(RandomIn(minLat, maxLat), RandomIn(minLon, maxLon)));
+
+    LatencyRecorder junction("junction_indexed", config.queries);
+    LatencyRecorder link("link_indexed", config.queries);
+    vector<const geo::Junction *> junctions(config.queries);
+    vector<const geo::Link *> links(config.queries);
+    for (unsigned int i = 0; i < config.queries; i++) {
+        junction.Start();
+        junctions[i] = map.findClosestJunction(positions[i], RESEARCH_BOX);
+        junction.Stop();
+        link.Start();
+        links[i] = map.findClosestLink(positions[i], RESEARCH_BOX);
+        link.Stop();
+    }
+
+    // neighbours of the closest link, as visited by geographic forwarding
+    const geo::RoadGraph &graph = map.getGraph();
+    LatencyRecorder neighboursByName("neighbours_by_name", config.queries);
+    LatencyRecorder neighboursById("neighbours_by_id", config.queries);
+    unsigned int neighbourMismatches = 0;
+    for (unsigned int i = 0; i < config.queries; i++) {
+        if (links[i] == NULL)
+            continue;
+        const geo::RoadGraph::ElementId id = map.getElementId(links[i]->printId());
+        const geo::Coordinate &destination = positions[(i + 1) % config.queries];
+        const geo::Coordinate me = nodes.find(links[i]->getKeyNode1())->second.getCoordinate();
+        neighboursByName.Start();
+        unsigned int byName = NeighboursByName(map, links[i], destination, me);
+        neighboursByName.Stop();
+        neighboursById.Start();
+        unsigned int byId = NeighboursById(graph, id, destination, me);
+        neighboursById.Stop();
+        if (byName != byId)
+            neighbourMismatches++;
+    }
+
+    LatencyRecorder matchGlobal("match_global", config.queries);
+    LatencyRecorder matchIncremental("match_incremental", config.queries);
+    const MatchingStats matching = BenchMatching(config, map, matchGlobal, matchIncremental);
+
+    // the scan is much slower, it is run only on the first positions
+    const unsigned int scanQueries = std::min(config.scanQueries, config.queries);
+    LatencyRecorder junctionScan("junction_scan", scanQueries);
+    LatencyRecorder linkScan("link_scan", scanQueries);
+    unsigned int mismatches = 0;
+    for (unsigned int i = 0; i < scanQueries; i++) {
+        double junctionDistance, linkDistance;
+        junctionScan.Start();
+        const geo::Junction *closestJunction = ScanJunctions(map, positions[i], junctionDistance);
+        junctionScan.Stop();
+        linkScan.Start();
+        const geo::Link *closestLink = ScanLinks(map, positions[i], linkDistance);
+        linkScan.Stop();
+
+        // different elements at the same distance are both correct
+        if ((closestJunction == NULL) != (junctions[i] == NULL) ||
+                (closestJunction != NULL &&
+                 positions[i].twoPointsDistance(junctions[i]->getCoordinate()) != junctionDistance))
+            mismatches++;
+        if ((closestLink == NULL) != (links[i] == NULL) ||
+                (closestLink != NULL && LinkDistance(map, *links[i], positions[i], false) != linkDistance))
+            mismatches++;
+    }
+
+    // the same map converted to a binary map file, it must give the same answers
+    double binaryLoadTime = 0;
+    unsigned int binaryMismatches = 0;
+    if (!geo::MapFile::write(binaryFile, index)) {
+        cerr << "Error: cannot write " << binaryFile << endl;
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        geo::Map binaryMap(binaryFile);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        binaryLoadTime = elapsed(start, end);
+        for (unsigned int i = 0; i < config.queries; i++) {
+            const geo::Junction *binaryJunction = binaryMap.findClosestJunction(positions[i], RESEARCH_BOX);
+            const geo::Link *binaryLink = binaryMap.findClosestLink(positions[i], RESEARCH_BOX);
+            if ((binaryJunction == NULL) != (junctions[i] == NULL) ||
+                    (binaryJunction != NULL && binaryJunction->printId() != junctions[i]->printId()))
+                binaryMismatches++;
+            if ((binaryLink == NULL) != (links[i] == NULL) ||
+                    (binaryLink != NULL && binaryLink->printId() != links[i]->printId()))
+                binaryMismatches++;
+        }
+        unlink(binaryFile.c_str());
+    }
+
+    json << log::JsonMapOpen
+         << "map" << name
+         << "junctions" << static_cast<unsigned int>(index.getJunctionCount())
+         << "links" << static_cast<unsigned int>(index.getLinkCount())
+         << "cells" << static_cast<unsigned int>(index.getCellCount())
+         << "cellSize" << index.getCellSize()
+         << "loadTime" << loadTime
+         << "binaryLoadTime" << binaryLoadTime
+         << "mismatches" << mismatches
+         << "binaryMismatches" << binaryMismatches
+         << "neighbourMismatches" << neighbourMismatches
+         << "matching" << log::JsonMapOpen
+         << "fixes" << matching.fixes
+         << "incrementalRatio" << matching.incrementalRatio
+         << "meanConfidence" << matching.meanConfidence
+         << "globalFlaps" << matching.globalFlaps
+         << "incrementalFlaps" << matching.incrementalFlaps
+         << "globalOffRoute" << matching.globalOffRoute
+         << "incrementalOffRoute" << matching.incrementalOffRoute
+         << log::JsonMapClose
+         << "results" << log::JsonArrayOpen;
+    junction.ToJson(json);
+    link.ToJson(json);
+    junctionScan.ToJson(json);
+    linkScan.ToJson(json);
+    neighboursByName.ToJson(json);
+    neighboursById.ToJson(json);
+    matchGlobal.ToJson(json);
+    matchIncremental.ToJson(json);
+    json << log::JsonArrayClose
+         << log::JsonMapClose;
+}
+
+static const size_t KERNEL_BATCH = 64;    // candidates per position, as in a dense research box
+
+/*
+ * Compares the batch distance kernels with the scalar code of Coordinate, on
+ * batches of random points and segments in a research box around random
+ * positions: time per distance and largest difference from the scalar code
+ * (relative to the haversine distance for the planar projection).
+ */
+static void BenchKernels(const BenchConfig &config, log::JsonLogger &json)
+{
+    const double lat0 = 33.9, lon0 = -118.5;
+    double lats[KERNEL_BATCH], lons[KERNEL_BATCH], x1[KERNEL_BATCH], y1[KERNEL_BATCH], x2[KERNEL_BATCH], y2[KERNEL_BATCH];
+    double scalar[KERNEL_BATCH], batch[KERNEL_BATCH];
+    double haversineError = 0, planarError = 0, segmentError = 0;
+    double scalarHaversineTime = 0, batchHaversineTime = 0, planarTime = 0, scalarSegmentTime = 0, batchSegmentTime = 0;
+    struct timespec start, end;
+    const unsigned int rounds = std::max(config.queries / 10, 1u);
+    for (unsigned int r = 0; r < rounds; r++) {
+        const geo::Coordinate c(lat0 + RandomIn(0, 0.05), lon0 + RandomIn(0, 0.05));
+        std::vector<geo::Coordinate> points;
+        for (size_t i = 0; i < KERNEL_BATCH; i++) {
+            lats[i] = c.getLatitude() + RandomIn(-RESEARCH_BOX, RESEARCH_BOX);
+            lons[i] = c.getLongitude() + RandomIn(-RESEARCH_BOX, RESEARCH_BOX);
+            points.push_back(geo::Coordinate(lats[i], lons[i]));
+        }
+        for (size_t i = 0; i < KERNEL_BATCH; i++) {
+            const geo::Coordinate &next = points[(i + 1) % KERNEL_BATCH];
+            x1[i] = points[i].getUTMEasting();
+            y1[i] = points[i].getUTMNorthing();
+            x2[i] = next.getUTMEasting();
+            y2[i] = next.getUTMNorthing();
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < KERNEL_BATCH; i++)
+            scalar[i] = c.getDistance(lats[i], lons[i]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        scalarHaversineTime += elapsed(start, end);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        geo::haversineDistances(c.getLatitude(), c.getLongitude(), lats, lons, KERNEL_BATCH, batch);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        batchHaversineTime += elapsed(start, end);
+        for (size_t i = 0; i < KERNEL_BATCH; i++)
+            haversineError = std::max(haversineError, std::fabs(batch[i] - scalar[i]));
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        const geo::LocalProjection projection(c.getLatitude(), c.getLongitude());
+        geo::planarDistances(projection, lats, lons, KERNEL_BATCH, batch);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        planarTime += elapsed(start, end);
+        for (size_t i = 0; i < KERNEL_BATCH; i++)
+            planarError = std::max(planarError, std::fabs(batch[i] - scalar[i]) / scalar[i]);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < KERNEL_BATCH; i++)
+            scalar[i] = c.pointToSegmentDistUTM(y1[i], x1[i], y2[i], x2[i]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        scalarSegmentTime += elapsed(start, end);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        geo::segmentDistances(c.getUTMEasting(), c.getUTMNorthing(), x1, y1, x2, y2, KERNEL_BATCH, batch);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        batchSegmentTime += elapsed(start, end);
+        for (size_t i = 0; i < KERNEL_BATCH; i++)
+            segmentError = std::max(segmentError, std::fabs(batch[i] - scalar[i]));
+    }
+
+    const double distances = (double)rounds * KERNEL_BATCH / 1e9;
+    json << "kernels" << log::JsonMapOpen
+         << "batch" << (unsigned int)KERNEL_BATCH
+         << "rounds" << rounds
+         << "nsPerDistance" << log::JsonMapOpen
+         << "haversine_scalar" << scalarHaversineTime / distances
+         << "haversine_batch" << batchHaversineTime / distances
+         << "planar_batch" << planarTime / distances
+         << "segment_scalar" << scalarSegmentTime / distances
+         << "segment_batch" << batchSegmentTime / distances
+         << log::JsonMapClose
+         << "maxError" << log::JsonMapOpen
+         << "haversineBatchMeters" << haversineError
+         << "planarRelative" << planarError
+         << "segmentBatchMeters" << segmentError
+         << log::JsonMapClose
+         << log::JsonMapClose;
+}
+
+static const size_t GPSD_MAX_CHUNK = 512;    // bytes, larger than a TPV report
+
+/*
+ * Writes a gpsd stream of TPV reports, each followed by a SKY report as gpsd
+ * does, and returns the offset of the end of each TPV report.
+ */
+static string WriteGpsdStream(unsigned int reports, vector<double> &lats, vector<double> &lons, vector<size_t> &ends)
+{
+    string stream = "{\"class\":\"VERSION\",\"release\":\"3.9\",\"rev\":\"3.9\",\"proto_major\":3,\"proto_minor\":8}\n";
+    char report[512];
+    for (unsigned int i = 0; i < reports; i++) {
+        // the parsed coordinates must be the ones of strtod
+        snprintf(report, sizeof(report), "%.9f %.9f", 34.0 + RandomIn(0, 0.1), -118.5 + RandomIn(0, 0.1));
+        char *lon;
+        lats.push_back(strtod(report, &lon));
+        lons.push_back(strtod(lon, NULL));
+        snprintf(report, sizeof(report),
+                 "{\"class\":\"TPV\",\"tag\":\"RMC\",\"device\":\"/dev/ttyUSB0\",\"mode\":3,"
+                 "\"time\":\"2013-06-01T10:00:%02u.000Z\",\"ept\":0.005,\"lat\":%.9f,\"lon\":%.9f,"
+                 "\"alt\":%.3f,\"epx\":%.3f,\"epy\":%.3f,\"epv\":20.240,\"track\":%.4f,\"speed\":%.3f,"
+                 "\"climb\":0.000,\"eps\":30.51,\"epc\":40.48}\n",
+                 i % 60, lats.back(), lons.back(), RandomIn(0, 100), RandomIn(2, 20), RandomIn(2, 20),
+                 RandomIn(0, 360), RandomIn(0, 30));
+        stream += report;
+        ends.push_back(stream.size());
+        stream += "{\"class\":\"SKY\",\"tag\":\"GSV\",\"device\":\"/dev/ttyUSB0\",\"xdop\":0.69,\"ydop\":0.79,"
+                  "\"satellites\":[{\"PRN\":23,\"el\":6,\"az\":84,\"ss\":0,\"used\":false},"
+                  "{\"PRN\":28,\"el\":7,\"az\":160,\"ss\":0,\"used\":false}]}\n";
+    }
+    return stream;
+}
+
+/*
+ * Parses a gpsd stream one report per read and in chunks of random size, and
+ * checks that after each read the position is the one of the last complete
+ * TPV report.
+ */
+static void BenchGpsd(const BenchConfig &config, log::JsonLogger &json)
+{
+    vector<double> lats, lons;
+    vector<size_t> ends;
+    const string stream = WriteGpsdStream(config.queries, lats, lons, ends);
+    const char *data = stream.data();
+
+    unsigned int mismatches = 0, positions = 0;
+    double lineTime = 0, chunkTime = 0;
+    struct timespec start, end;
+
+    // one read per line, as when gpsd is not falling behind
+    geo::GpsdParser lineParser;
+    geo::GpsInfo info;
+    size_t offset = 0, next = 0;
+    while (offset < stream.size()) {
+        const size_t size = stream.find('\n', offset) + 1 - offset;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        const int res = lineParser.parseData(data + offset, size, &info);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        lineTime += elapsed(start, end);
+        offset += size;
+        if (res == 1) {
+            positions++;
+            if (next >= ends.size() || ends[next] != offset || info.getLat() != lats[next] || info.getLon() != lons[next])
+                mismatches++;
+            next++;
+        } else if (res == -1 || (next < ends.size() && ends[next] == offset)) {
+            mismatches++;
+        }
+    }
+
+    // reads of random size, which split and concatenate the reports
+    geo::GpsdParser chunkParser;
+    offset = 0;
+    next = 0;
+    unsigned int chunks = 0;
+    while (offset < stream.size()) {
+        const size_t size = std::min((size_t) RandomIn(1, GPSD_MAX_CHUNK), stream.size() - offset);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        const int res = chunkParser.parseData(data + offset, size, &info);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        chunkTime += elapsed(start, end);
+        offset += size;
+        chunks++;
+        bool completed = false;
+        while (next < ends.size() && ends[next] <= offset) {
+            next++;
+            completed = true;
+        }
+        if (res == -1 || (res == 1) != completed ||
+            (completed && (info.getLat() != lats[next - 1] || info.getLon() != lons[next - 1])))
+            mismatches++;
+    }
+
+    json << "gpsd" << log::JsonMapOpen
+         << "reports" << config.queries
+         << "bytes" << (unsigned int) stream.size()
+         << "chunks" << chunks
+         << "positions" << positions
+         << "mismatches" << mismatches
+         << "nsPerReport" << log::JsonMapOpen
+         << "line_reads" << lineTime * 1e9 / config.queries
+         << "chunk_reads" << chunkTime * 1e9 / config.queries
+         << log::JsonMapClose
+         << log::JsonMapClose;
+}
+
+static void usage()
+{
+    cout << "Usage: ./geoBench [options]\n"
+         << "  -n <queries>      number of timed queries per map (default 100000)\n"
+         << "  -s <queries>      number of queries also answered by a linear scan (default 20)\n"
+         << "  -g <side>         side of the synthetic city grid, in junctions (default 300)\n"
+         << "  -m <nodes> <edges> bundled map (default utils/geo/map/nodes utils/geo/map/edges)\n"
+         << "  -o <file>         write the JSON results to file instead of stdout\n";
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig config;
+    config.queries = 100000;
+    config.scanQueries = 20;
+    config.gridSide = 300;
+    config.nodesFile = "utils/geo/map/nodes";
+    config.edgesFile = "utils/geo/map/edges";
+    string output;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage();
+            return -1;
+        }
+        if (arg == "-n") {
+            config.queries = atoi(argv[++i]);
+        } else if (arg == "-s") {
+            config.scanQueries = atoi(argv[++i]);
+        } else if (arg == "-g") {
+            config.gridSide = atoi(argv[++i]);
+        } else if (arg == "-m" && i + 2 < argc) {
+            config.nodesFile = argv[++i];
+            config.edgesFile = argv[++i];
+        } else if (arg == "-o") {
+            output = argv[++i];
+        } else {
+            usage();
+            return -1;
+        }
+    }
+    if (config.queries == 0 || config.gridSide < 2) {
+        usage();
+        return -1;
+    }
+
+    char dir[] = "/tmp/geoBench.XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        cerr << "Error: cannot create a temporary directory" << endl;
+        return 1;
+    }
+    const string gridNodes = string(dir) + "/nodes", gridEdges = string(dir) + "/edges";
+    WriteGrid(config.gridSide, gridNodes, gridEdges);
+
+    log::JsonLogger json;
+    json << log::JsonMapOpen
+         << "config" << log::JsonMapOpen
+         << "queries" << config.queries
+         << "scanQueries" << config.scanQueries
+         << "gridSide" << config.gridSide
+         << "researchBox" << RESEARCH_BOX
+         << log::JsonMapClose
+         << "maps" << log::JsonArrayOpen;
+    const string binaryFile = string(dir) + "/map.bin";
+    BenchMap(config, "bundled", config.nodesFile, config.edgesFile, binaryFile, json);
+    BenchMap(config, "grid", gridNodes, gridEdges, binaryFile, json);
+    json << log::JsonArrayClose;
+    BenchKernels(config, json);
+    BenchGpsd(config, json);
+    json << log::JsonMapClose;
+
+    unlink(gridNodes.c_str());
+    unlink(gridEdges.c_str());
+    rmdir(dir);
+
+    if (output.empty()) {
+        cout << json.ToString() << endl;
+    } else {
+        std::ofstream file(output.c_str());
+        if (!file) {
+            cerr << "Error: cannot open " << output << endl;
+            return 1;
+        }
+        file << json.ToString() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "latency-recorder.h"
+
+#include <algorithm>
+
+namespace vndn
+{
+
+LatencyRecorder::LatencyRecorder(const std::string &name, size_t expectedSamples)
+    : m_name(name)
+    , m_sorted(false)
+{
+    m_samples.reserve(expectedSamples);
+}
+
+void LatencyRecorder::Merge(const LatencyRecorder &other)
+{
+    m_samples.insert(m_samples.end(), other.m_samples.begin(), other.m_samples.end());
+    m_sorted = false;
+}
+
+double LatencyRecorder::GetOpsPerSecond() const
+{
+    int64_t total = 0;
+    for (std::vector<int64_t>::const_iterator it = m_samples.begin(); it != m_samples.end(); ++it)
+        total += *it;
+
+    return total > 0 ? m_samples.size() * 1e9 / total : 0.0;
+}
+
+double LatencyRecorder::GetPercentile(double p)
+{
+    if (m_samples.empty())
+        return 0.0;
+
+    if (!m_sorted) {
+        std::sort(m_samples.begin(), m_samples.end());
+        m_sorted = true;
+    }
+
+    size_t index = static_cast<size_t>(p / 100.0 * (m_samples.size() - 1) + 0.5);
+    return m_samples[std::min(index, m_samples.size() - 1)];
+}
+
+void LatencyRecorder::ToJson(log::JsonLogger &json)
+{
+    json << log::JsonMapOpen
+         << "name" << m_name
+         << "ops" << static_cast<unsigned int>(m_samples.size())
+         << "opsPerSec" << GetOpsPerSecond()
+         << "latencyNs" << log::JsonMapOpen
+         << "p50" << GetPercentile(50)
+         << "p90" << GetPercentile(90)
+         << "p99" << GetPercentile(99)
+         << "max" << GetPercentile(100)
+         << log::JsonMapClose
+         << log::JsonMapClose;
+}
+
+} // namespace vndn
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef LATENCY_RECORDER_H_
+#define LATENCY_RECORDER_H_
+
+#include "corelib/log.h"
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+namespace vndn
+{
+
+/**
+ * \brief Collects the latency of individual operations of a benchmark
+ *
+ * Typical usage:
+ * \code
+ * LatencyRecorder rec("pit_insert", n);
+ * for (...) {
+ *     rec.Start();
+ *     // operation
+ *     rec.Stop();
+ * }
+ * rec.ToJson(json);
+ * \endcode
+ */
+class LatencyRecorder
+{
+public:
+    LatencyRecorder(const std::string &name, size_t expectedSamples);
+
+    void Start()
+    {
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+
+    void Stop()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        m_samples.push_back((now.tv_sec - m_start.tv_sec) * 1000000000LL + (now.tv_nsec - m_start.tv_nsec));
+        m_sorted = false;
+    }
+
+    /**
+     * \brief Records a latency measured by the caller, in nanoseconds
+     */
+    void Add(int64_t latency)
+    {
+        m_samples.push_back(latency);
+        m_sorted = false;
+    }
+
+    /**
+     * \brief Appends all the samples collected by \c other
+     */
+    void Merge(const LatencyRecorder &other);
+
+    const std::string &GetName() const { return m_name; }
+    size_t GetCount() const { return m_samples.size(); }
+
+    /**
+     * \brief Number of operations per second, computed from the sum of all samples
+     */
+    double GetOpsPerSecond() const;
+
+    /**
+     * \brief Returns the given percentile (between 0 and 100) of the samples, in nanoseconds
+     */
+    double GetPercentile(double p);
+
+    /**
+     * \brief Appends the statistics as a JSON map to \c json
+     */
+    void ToJson(log::JsonLogger &json);
+
+private:
+    std::string m_name;
+    std::vector<int64_t> m_samples; ///< \brief latencies in nanoseconds
+    bool m_sorted;
+    struct timespec m_start;
+};
+
+} // namespace vndn
+
+#endif /* LATENCY_RECORDER_H_ */
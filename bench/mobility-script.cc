@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "mobility-script.h"
+
+#include "corelib/log.h"
+#include "utils/geo/coordinate.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE("MobilityScript");
+
+namespace vndn
+{
+
+bool MobilityScript::Load(const std::string &file)
+{
+    std::ifstream in(file.c_str());
+    if (!in) {
+        NS_LOG_ERROR("Cannot open " << file);
+        return false;
+    }
+
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream is(line);
+        double time, lat, lon;
+        unsigned int vehicle;
+        if (!(is >> time >> vehicle >> lat >> lon)) {
+            NS_LOG_ERROR(file << ":" << lineNumber << ": malformed waypoint");
+            return false;
+        }
+        AddWaypoint(vehicle, time, lat, lon);
+    }
+
+    return true;
+}
+
+void MobilityScript::AddWaypoint(unsigned int vehicle, double time, double lat, double lon)
+{
+    if (vehicle >= m_waypoints.size())
+        m_waypoints.resize(vehicle + 1);
+
+    Waypoint waypoint;
+    waypoint.time = time;
+    waypoint.lat = lat;
+    waypoint.lon = lon;
+
+    std::vector<Waypoint> &path = m_waypoints[vehicle];
+    path.insert(std::upper_bound(path.begin(), path.end(), waypoint), waypoint);
+}
+
+void MobilityScript::AddRoad(unsigned int vehicles, double lat1, double lon1, double lat2, double lon2,
+                             double speed, double duration)
+{
+    const double length = geo::Coordinate(lat1, lon1).getDistance(lat2, lon2);
+    const unsigned int first = m_waypoints.size();
+
+    for (unsigned int i = 0; i < vehicles; i++) {
+        // distance from the first end of the road, and driving direction
+        double offset = (i + 0.5) * length / vehicles;
+        bool forward = (i % 2 == 0);
+        double time = 0.0;
+
+        while (true) {
+            AddWaypoint(first + i, time, lat1 + (lat2 - lat1) * offset / length,
+                        lon1 + (lon2 - lon1) * offset / length);
+            if (speed <= 0.0 || time >= duration)
+                break;
+
+            time += (forward ? length - offset : offset) / speed;
+            offset = forward ? length : 0.0;
+            forward = !forward;
+        }
+    }
+}
+
+void MobilityScript::GetPosition(unsigned int vehicle, double time, double &lat, double &lon) const
+{
+    const std::vector<Waypoint> &path = m_waypoints.at(vehicle);
+    if (path.empty()) {
+        lat = lon = 0.0;
+        return;
+    }
+
+    Waypoint key;
+    key.time = time;
+    std::vector<Waypoint>::const_iterator next = std::upper_bound(path.begin(), path.end(), key);
+    if (next == path.begin()) {
+        lat = next->lat;
+        lon = next->lon;
+        return;
+    }
+    std::vector<Waypoint>::const_iterator prev = next - 1;
+    if (next == path.end() || next->time == prev->time) {
+        lat = prev->lat;
+        lon = prev->lon;
+        return;
+    }
+
+    const double fraction = (time - prev->time) / (next->time - prev->time);
+    lat = prev->lat + (next->lat - prev->lat) * fraction;
+    lon = prev->lon + (next->lon - prev->lon) * fraction;
+}
+
+} // namespace vndn
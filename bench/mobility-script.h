@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef MOBILITY_SCRIPT_H_
+#define MOBILITY_SCRIPT_H_
+
+#include <string>
+#include <vector>
+
+namespace vndn
+{
+
+/**
+ * \brief Scripted positions of the vehicles of the link-layer emulator
+ *
+ * Every vehicle follows a list of waypoints (time, latitude, longitude) and
+ * moves in a straight line at constant speed between two consecutive ones.
+ * Before the first waypoint and after the last one the vehicle stands still.
+ */
+class MobilityScript
+{
+public:
+    /**
+     * \brief Loads the waypoints from a text file
+     *
+     * Every line is "<time> <vehicle> <latitude> <longitude>", with the time in
+     * seconds from the start of the emulation and vehicles numbered from 0.
+     * Empty lines and lines starting with '#' are ignored.
+     *
+     * \return false if the file cannot be read or a line is malformed
+     */
+    bool Load(const std::string &file);
+
+    void AddWaypoint(unsigned int vehicle, double time, double lat, double lon);
+
+    /**
+     * \brief Adds vehicles driving back and forth on a straight road
+     *
+     * The vehicles are evenly spaced along the road, the even ones driving
+     * towards the second end and the odd ones towards the first end, and make
+     * a U-turn when they reach an end.
+     *
+     * \param vehicles number of vehicles to add
+     * \param speed in m/s
+     * \param duration waypoints are generated until this time (in seconds)
+     */
+    void AddRoad(unsigned int vehicles, double lat1, double lon1, double lat2, double lon2,
+                 double speed, double duration);
+
+    unsigned int GetVehicleCount() const { return m_waypoints.size(); }
+
+    /**
+     * \brief Computes the position of the vehicle at the given time (in seconds)
+     */
+    void GetPosition(unsigned int vehicle, double time, double &lat, double &lon) const;
+
+private:
+    struct Waypoint {
+        double time;
+        double lat;
+        double lon;
+
+        bool operator<(const Waypoint &other) const { return time < other.time; }
+    };
+
+    std::vector<std::vector<Waypoint> > m_waypoints;
+};
+
+} // namespace vndn
+
+#endif /* MOBILITY_SCRIPT_H_ */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "name-generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace vndn
+{
+
+NameGenerator::NameGenerator(const std::string &root, unsigned int components, unsigned int fanout,
+                             uint32_t catalogSize, double zipfExponent, unsigned int seed)
+    : m_root(root)
+    , m_components(std::max(components, 1u))
+    , m_fanout(std::max(fanout, 1u))
+    , m_seed(seed)
+{
+    // cap the catalog to the number of distinct names, which saturates at the largest uint32_t:
+    // the product stays below 2^64 since both factors are at most 2^32 - 1
+    const uint64_t maxCatalog = std::numeric_limits<uint32_t>::max();
+    uint64_t maxNames = 1;
+    for (unsigned int i = 1; i < m_components && maxNames < maxCatalog; i++)
+        maxNames *= m_fanout;
+    if (catalogSize == 0 || catalogSize > maxNames)
+        catalogSize = static_cast<uint32_t>(std::min(maxNames, maxCatalog));
+
+    m_cdf.resize(catalogSize);
+    double sum = 0.0;
+    for (uint32_t i = 0; i < catalogSize; i++) {
+        sum += 1.0 / std::pow(i + 1.0, zipfExponent);
+        m_cdf[i] = sum;
+    }
+    for (uint32_t i = 0; i < catalogSize; i++) {
+        m_cdf[i] /= sum;
+    }
+}
+
+uint32_t NameGenerator::NextRank()
+{
+    double r = static_cast<double>(rand_r(&m_seed)) / RAND_MAX;
+    std::vector<double>::const_iterator it = std::lower_bound(m_cdf.begin(), m_cdf.end(), r);
+    if (it == m_cdf.end())
+        return m_cdf.size() - 1;
+    return it - m_cdf.begin();
+}
+
+Ptr<NameComponents> NameGenerator::Next()
+{
+    return Get(NextRank());
+}
+
+Ptr<NameComponents> NameGenerator::Get(uint32_t rank) const
+{
+    return GetPrefix(rank, m_components);
+}
+
+Ptr<NameComponents> NameGenerator::GetPrefix(uint32_t rank, unsigned int length) const
+{
+    // the rank is written in base m_fanout, one digit per component,
+    // so that popular names share their first components
+    std::vector<uint32_t> digits(m_components - 1, 0);
+    for (unsigned int i = m_components - 1; i > 0 && rank > 0; i--) {
+        digits[i - 1] = rank % m_fanout;
+        rank /= m_fanout;
+    }
+
+    Ptr<NameComponents> name = Create<NameComponents>();
+    name->Add(m_root);
+    if (!m_location.empty())
+        name->Add(m_location);
+    for (unsigned int i = 1; i < std::min(length, m_components); i++) {
+        std::ostringstream os;
+        os << "c" << digits[i - 1];
+        name->Add(os.str());
+    }
+    return name;
+}
+
+} // namespace vndn
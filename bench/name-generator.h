@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef NAME_GENERATOR_H_
+#define NAME_GENERATOR_H_
+
+#include "corelib/ptr.h"
+#include "network/ndn-name-components.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace vndn
+{
+
+/**
+ * \brief Generates synthetic NDN names for benchmarks
+ *
+ * The generator defines a catalog of names shaped like a tree: every name
+ * starts with a fixed root component and has the same number of components,
+ * each of which can take one of \c fanout values. Names are identified by
+ * their rank in the catalog (0 is the most popular name) and are drawn
+ * according to a Zipf distribution with the given exponent (0 gives a
+ * uniform distribution).
+ */
+class NameGenerator
+{
+public:
+    /**
+     * \param root first component of every generated name
+     * \param components number of components of every name, including the root
+     * \param fanout number of distinct values that each component can take
+     * \param catalogSize number of distinct names, it is capped to fanout^(components-1)
+     * \param zipfExponent exponent of the Zipf popularity distribution
+     * \param seed seed of the pseudo-random number generator
+     */
+    NameGenerator(const std::string &root, unsigned int components, unsigned int fanout,
+                  uint32_t catalogSize, double zipfExponent, unsigned int seed = 1);
+
+    /**
+     * \brief Adds a fixed component after the root of every name, e.g. a position
+     */
+    void SetLocation(const std::string &location) { m_location = location; }
+
+    /**
+     * \brief Number of distinct names that can be generated
+     */
+    uint32_t GetCatalogSize() const { return m_cdf.size(); }
+
+    /**
+     * \brief Draws the rank of a name according to the popularity distribution
+     */
+    uint32_t NextRank();
+
+    /**
+     * \brief Draws a name according to the popularity distribution
+     */
+    Ptr<NameComponents> Next();
+
+    /**
+     * \brief Returns the name with the given rank
+     */
+    Ptr<NameComponents> Get(uint32_t rank) const;
+
+    /**
+     * \brief Returns the prefix of the name with the given rank, made of the first \c length components
+     */
+    Ptr<NameComponents> GetPrefix(uint32_t rank, unsigned int length) const;
+
+private:
+    std::string m_root;
+    std::string m_location;
+    unsigned int m_components;
+    unsigned int m_fanout;
+    std::vector<double> m_cdf; ///< \brief cumulative distribution of the name ranks
+    unsigned int m_seed;
+};
+
+} // namespace vndn
+
+#endif /* NAME_GENERATOR_H_ */
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+/*
+ * Microbenchmarks of the forwarding data structures, of the codec and of
+ * the timer wheel of the link layer.
+ *
+ * Every benchmark times each operation individually and reports the
+ * number of operations per second and the latency percentiles. The
+ * results are printed as a single JSON document, so that they can be
+ * stored and compared across revisions.
+ */
+
+#include "bench-face.h"
+#include "latency-recorder.h"
+#include "name-generator.h"
+
+#include "corelib/log.h"
+#include "corelib/ptr.h"
+#include "daemon/cs/content-store-impl.h"
+#include "daemon/ndn-fib.h"
+#include "daemon/pit/ndn-pit.h"
+#include "network/ndn-content-object-header.h"
+#include "network/ndn-content-packet.h"
+#include "network/mac/timer-wheel.h"
+#include "network/ndn-interest-header.h"
+#include "network/packet.h"
+#include "utils/lru-policy.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace vndn;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+struct BenchConfig {
+    unsigned int operations;
+    unsigned int components;
+    unsigned int fanout;
+    unsigned int catalogSize;
+    double zipfExponent;
+    unsigned int payloadSize;
+};
+
+/**
+ * Names, headers and packets shared by all the benchmarks, one per catalog rank.
+ */
+struct BenchData {
+    vector<Ptr<NameComponents> > names;
+    vector<Ptr<InterestHeader> > interests;
+    vector<Ptr<ContentObjectHeader> > contents;
+};
+
+
+static void BenchPit(const BenchConfig &config, NameGenerator &gen, const BenchData &data,
+                     vector<LatencyRecorder *> &results)
+{
+    const uint32_t catalog = gen.GetCatalogSize();
+
+    Ptr<NDNFib> fib = Create<NDNFib>();
+    Ptr<NDNPit> pit = Create<NDNPit>();
+    pit->SetFib(fib);
+
+    LatencyRecorder *insert = new LatencyRecorder("pit_insert", catalog);
+    for (uint32_t i = 0; i < catalog; i++) {
+        insert->Start();
+        pit->Lookup(*data.interests[i]);
+        insert->Stop();
+    }
+    results.push_back(insert);
+
+    LatencyRecorder *lookup = new LatencyRecorder("pit_lookup", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        const ContentObjectHeader &header = *data.contents[gen.NextRank()];
+        lookup->Start();
+        pit->Lookup(header);
+        lookup->Stop();
+    }
+    results.push_back(lookup);
+
+    LatencyRecorder *erase = new LatencyRecorder("pit_erase", catalog);
+    for (uint32_t i = 0; i < catalog; i++) {
+        const NDNPitEntry &entry = pit->Lookup(*data.contents[i]);
+        erase->Start();
+        pit->Remove(entry);
+        erase->Stop();
+    }
+    results.push_back(erase);
+}
+
+static void BenchFib(const BenchConfig &config, NameGenerator &gen, const BenchData &data,
+                     vector<LatencyRecorder *> &results)
+{
+    // one FIB entry for every distinct parent prefix of the catalog names
+    Ptr<NDNFib> fib = Create<NDNFib>();
+    Ptr<BenchFace> face = Create<BenchFace>(1);
+    std::set<string> prefixes;
+    for (uint32_t i = 0; i < gen.GetCatalogSize(); i++) {
+        Ptr<NameComponents> prefix = gen.GetPrefix(i, config.components - 1);
+        std::ostringstream os;
+        os << *prefix;
+        if (prefixes.insert(os.str()).second)
+            fib->Add(*prefix, face, 0);
+    }
+
+    LatencyRecorder *lpm = new LatencyRecorder("fib_lpm", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        const NameComponents &name = *data.names[gen.NextRank()];
+        lpm->Start();
+        fib->LongestPrefixMatch(name);
+        lpm->Stop();
+    }
+    results.push_back(lpm);
+}
+
+static void BenchContentStore(const BenchConfig &config, NameGenerator &gen, const BenchData &data,
+                              vector<LatencyRecorder *> &results)
+{
+    // the LRU policy keeps at most 100 entries, so a large
+    // catalog keeps the content store under constant eviction
+    Ptr<ContentStore> cs = Create<ContentStoreImpl<lru_policy_traits> >();
+    const string payload(config.payloadSize, 'x');
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddPayload(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+
+    LatencyRecorder *insert = new LatencyRecorder("cs_insert", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        Ptr<const ContentObjectHeader> header = data.contents[gen.NextRank()];
+        insert->Start();
+        cs->Add(header, packet);
+        insert->Stop();
+    }
+    results.push_back(insert);
+
+    LatencyRecorder *lookup = new LatencyRecorder("cs_lookup", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        Ptr<const InterestHeader> header = data.interests[gen.NextRank()];
+        lookup->Start();
+        cs->Lookup(header);
+        lookup->Stop();
+    }
+    results.push_back(lookup);
+}
+
+static void BenchCodec(const BenchConfig &config, NameGenerator &gen, const BenchData &data,
+                       vector<LatencyRecorder *> &results)
+{
+    const string payload(config.payloadSize, 'x');
+    const uint8_t *payloadPtr = reinterpret_cast<const uint8_t *>(payload.data());
+
+    // keep a bounded number of encoded packets around, each one takes BUFLEN bytes
+    const uint32_t count = std::min<uint32_t>(gen.GetCatalogSize(), 1000);
+    vector<Ptr<Packet> > interestPackets;
+    vector<Ptr<Packet> > dataPackets;
+
+    LatencyRecorder *interestEncode = new LatencyRecorder("interest_encode", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        Ptr<const InterestHeader> header = data.interests[i % count];
+        interestEncode->Start();
+        Ptr<Packet> packet = Create<Packet>();
+        packet->AddHeader(header);
+        interestEncode->Stop();
+        if (i < count)
+            interestPackets.push_back(packet);
+    }
+    results.push_back(interestEncode);
+
+    LatencyRecorder *interestDecode = new LatencyRecorder("interest_decode", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        const Packet &packet = *interestPackets[i % interestPackets.size()];
+        interestDecode->Start();
+        GetHeader<InterestHeader>(packet);
+        interestDecode->Stop();
+    }
+    results.push_back(interestDecode);
+
+    LatencyRecorder *dataEncode = new LatencyRecorder("data_encode", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        Ptr<NameComponents> name = data.names[i % count];
+        dataEncode->Start();
+        Ptr<Packet> packet = Create<NDNContentPacket>(name, payloadPtr, payload.size());
+        dataEncode->Stop();
+        if (i < count)
+            dataPackets.push_back(packet);
+    }
+    results.push_back(dataEncode);
+
+    LatencyRecorder *dataDecode = new LatencyRecorder("data_decode", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        const Packet &packet = *dataPackets[i % dataPackets.size()];
+        dataDecode->Start();
+        GetHeader<ContentObjectHeader>(packet);
+        dataDecode->Stop();
+    }
+    results.push_back(dataDecode);
+}
+
+/**
+ * Checks that a wheel asked for a later time (as a look-ahead does) still
+ * expires on time the entries scheduled afterwards.
+ */
+static bool CheckTimerWheel()
+{
+    const uint64_t t0 = 1000000;
+    TimerWheel wheel(t0);
+    TimerWheel::Entry late, early;
+    wheel.schedule(late, t0 + 5000);
+    if (wheel.popExpired(t0 + 1000) != NULL)
+        return false;
+    wheel.schedule(early, t0 + 300);
+    uint64_t next;
+    const bool onTime = wheel.getNextExpiry(next) && next == t0 + 300 &&
+                        wheel.popExpired(t0 + 300) == &early;
+    wheel.cancel(early);
+    wheel.cancel(late);
+    return onTime;
+}
+
+static void BenchTimerWheel(const BenchConfig &config, vector<LatencyRecorder *> &results)
+{
+    // one entry every 10 us, popped when due, as the link-layer (re)transmissions
+    const uint64_t start = 1000000;
+    const uint64_t step = 10;
+    TimerWheel wheel(start);
+    vector<TimerWheel::Entry> entries(config.operations);
+
+    LatencyRecorder *schedule = new LatencyRecorder("wheel_schedule", config.operations);
+    for (unsigned int i = 0; i < config.operations; i++) {
+        const uint64_t expiry = start + i * step + rand() % 100000;
+        schedule->Start();
+        wheel.schedule(entries[i], expiry);
+        schedule->Stop();
+    }
+    results.push_back(schedule);
+
+    LatencyRecorder *pop = new LatencyRecorder("wheel_pop", config.operations);
+    uint64_t now = start;
+    for (unsigned int popped = 0; popped < config.operations; now += step) {
+        while (true) {
+            pop->Start();
+            TimerWheel::Entry *entry = wheel.popExpired(now);
+            pop->Stop();
+            if (entry == NULL)
+                break;
+            popped++;
+        }
+    }
+    results.push_back(pop);
+}
+
+
+static void usage()
+{
+    cout << "Usage: ./ndnBench [options]\n"
+         << "  -n <operations>   number of timed operations per benchmark (default 100000)\n"
+         << "  -c <components>   number of name components, including the root (default 6)\n"
+         << "  -f <fanout>       distinct values of each name component (default 10)\n"
+         << "  -N <names>        size of the name catalog (default 100000)\n"
+         << "  -s <exponent>     exponent of the Zipf popularity distribution (default 0.8)\n"
+         << "  -p <bytes>        data payload size (default 100)\n"
+         << "  -o <file>         write the JSON results to file instead of stdout\n";
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig config;
+    config.operations = 100000;
+    config.components = 6;
+    config.fanout = 10;
+    config.catalogSize = 100000;
+    config.zipfExponent = 0.8;
+    config.payloadSize = 100;
+    string output;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage();
+            return -1;
+        }
+        if (arg == "-n") {
+            config.operations = atoi(argv[++i]);
+        } else if (arg == "-c") {
+            config.components = atoi(argv[++i]);
+        } else if (arg == "-f") {
+            config.fanout = atoi(argv[++i]);
+        } else if (arg == "-N") {
+            config.catalogSize = atoi(argv[++i]);
+        } else if (arg == "-s") {
+            config.zipfExponent = atof(argv[++i]);
+        } else if (arg == "-p") {
+            config.payloadSize = atoi(argv[++i]);
+        } else if (arg == "-o") {
+            output = argv[++i];
+        } else {
+            usage();
+            return -1;
+        }
+    }
+    if (config.operations == 0 || config.components < 2 || config.fanout == 0 ||
+            config.payloadSize + 200 > BUFLEN) {
+        usage();
+        return -1;
+    }
+
+    if (!CheckTimerWheel()) {
+        cerr << "Error: the timer wheel does not expire on time the entries scheduled after a look-ahead" << endl;
+        return 1;
+    }
+
+    NameGenerator gen("bench", config.components, config.fanout,
+                      config.catalogSize, config.zipfExponent);
+
+    BenchData data;
+    for (uint32_t i = 0; i < gen.GetCatalogSize(); i++) {
+        Ptr<NameComponents> name = gen.Get(i);
+        data.names.push_back(name);
+
+        Ptr<InterestHeader> interest = Create<InterestHeader>();
+        interest->SetNonce(rand());
+        interest->SetName(name);
+        data.interests.push_back(interest);
+
+        Ptr<ContentObjectHeader> content = Create<ContentObjectHeader>();
+        content->SetName(name);
+        data.contents.push_back(content);
+    }
+
+    vector<LatencyRecorder *> results;
+    BenchPit(config, gen, data, results);
+    BenchFib(config, gen, data, results);
+    BenchContentStore(config, gen, data, results);
+    BenchCodec(config, gen, data, results);
+    BenchTimerWheel(config, results);
+
+    log::JsonLogger json;
+    json << log::JsonMapOpen
+         << "config" << log::JsonMapOpen
+         << "operations" << config.operations
+         << "components" << config.components
+         << "fanout" << config.fanout
+         << "catalogSize" << static_cast<unsigned int>(gen.GetCatalogSize())
+         << "zipfExponent" << config.zipfExponent
+         << "payloadSize" << config.payloadSize
+         << log::JsonMapClose
+         << "results" << log::JsonArrayOpen;
+    for (vector<LatencyRecorder *>::iterator it = results.begin(); it != results.end(); ++it) {
+        (*it)->ToJson(json);
+        delete *it;
+    }
+    json << log::JsonArrayClose << log::JsonMapClose;
+
+    if (output.empty()) {
+        cout << json.ToString() << endl;
+    } else {
+        std::ofstream file(output.c_str());
+        if (!file) {
+            cerr << "Error: cannot open " << output << endl;
+            return 1;
+        }
+        file << json.ToString() << endl;
+    }
+
+    return 0;
+}
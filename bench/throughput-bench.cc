@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+/*
+ * End-to-end throughput benchmark.
+ *
+ * Runs the whole daemon (NDNL3Protocol, NDNLocalFace and EventMonitor)
+ * in-process. A consumer and a producer generator are connected to the
+ * daemon through socket pairs, so no root privileges, network devices or
+ * running ndnd are needed. At the end, the forwarding rate, the content
+ * store hit ratio and the end-to-end latency are printed as JSON.
+ *
+ * Before the measurement the producer registers a few thousand prefixes
+ * with NDNProducer::registerNames, through the management queue of the
+ * daemon, and the time until they are all in the FIB is reported too.
+ * The queue is system-wide, so ndnd must not be running at the same time.
+ */
+
+#include "traffic-generator.h"
+
+#include "corelib/log.h"
+#include "corelib/ptr.h"
+#include "corelib/singleton.h"
+#include "daemon/ndn-fib.h"
+#include "daemon/ndn-flooding-strategy.h"
+#include "daemon/ndn-l3-protocol.h"
+#include "daemon/ndn-local-face.h"
+#include "daemon/ndn-management.h"
+#include "apps/ndn-producer.h"
+#include "helper/event-monitor.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include <boost/ref.hpp>
+
+using namespace vndn;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+
+static void usage()
+{
+    cout << "Usage: ./throughputBench [options]\n"
+         << "  -d <seconds>      duration of the measurement (default 5)\n"
+         << "  -r <rate>         interests per second (default 10000)\n"
+         << "  -c <components>   number of name components, including the root (default 6)\n"
+         << "  -f <fanout>       distinct values of each name component (default 10)\n"
+         << "  -N <names>        size of the name catalog (default 100000)\n"
+         << "  -s <exponent>     exponent of the Zipf popularity distribution (default 0.8)\n"
+         << "  -p <bytes>        data payload size (default 100)\n"
+         << "  -u <ratio>        fraction of duplicate interests, between 0 and 1 (default 0)\n"
+         << "  -R <prefixes>     prefixes registered in bulk before the measurement, 0 for none (default 5000)\n"
+         << "  -o <file>         write the JSON results to file instead of stdout\n";
+}
+
+/**
+ * Creates a socket pair, the first socket is attached to a new NDNLocalFace
+ * and the second one is returned to be used by a traffic generator.
+ */
+static int ConnectLocalFace(NDNL3Protocol *protocol, EventMonitor &em, Ptr<NDNFace> &face)
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) {
+        cerr << "socketpair() failed: " << strerror(errno) << endl;
+        exit(1);
+    }
+
+    // the daemon and the generators share the same thread, a blocking
+    // send() would never return, it is better to count a loss instead
+    for (int i = 0; i < 2; i++) {
+        int bufSize = 4 * 1024 * 1024;
+        ::setsockopt(fds[i], SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+        if (::fcntl(fds[i], F_SETFL, O_NONBLOCK) < 0) {
+            cerr << "Could not set non-blocking flag: " << strerror(errno) << endl;
+            exit(1);
+        }
+    }
+
+    face = Create<NDNLocalFace>(fds[0]);
+    protocol->AddFace(face);
+    em.add(face);
+
+    return fds[1];
+}
+
+/**
+ * Registers count prefixes on the face with a single NDNProducer::registerNames,
+ * and applies the management commands until they are all in the FIB.
+ * \return the seconds taken, negative if some prefixes are missing after 30 s
+ */
+static double RegisterPrefixes(Ptr<NDNFib> fib, Ptr<NDNFace> face, int faceFd, unsigned int count, EventMonitor &em)
+{
+    Ptr<NDNManagementInterface> management = Create<NDNManagementInterface>();
+    std::vector<NameComponents> prefixes;
+    for (unsigned int i = 0; i < count; i++) {
+        // long enough that they do not fit in a single management message
+        std::ostringstream os;
+        os << "/registration/vehicle-" << i % 100 << "/service-" << i;
+        prefixes.push_back(NameComponents(os.str()));
+    }
+    const uint32_t expected = fib->GetNDNFibEntryCount() + count;
+
+    const int64_t start = MonotonicNow();
+    Create<NDNProducer>(faceFd)->registerNames(prefixes, face->getMonitorFd());
+    while (fib->GetNDNFibEntryCount() < expected) {
+        if (MonotonicNow() - start > 30000000000LL)
+            return -1;
+        management->readHandler(em);
+        usleep(100);
+    }
+    return (MonotonicNow() - start) / 1e9;
+}
+
+static void StopMonitor(int, short, void *arg)
+{
+    static_cast<EventMonitor *>(arg)->stop();
+}
+
+int main(int argc, char **argv)
+{
+    double duration = 5.0;
+    double rate = 10000.0;
+    unsigned int components = 6;
+    unsigned int fanout = 10;
+    unsigned int catalogSize = 100000;
+    double zipfExponent = 0.8;
+    unsigned int payloadSize = 100;
+    double duplicateRatio = 0.0;
+    unsigned int registrations = 5000;
+    string output;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage();
+            return -1;
+        }
+        if (arg == "-d") {
+            duration = atof(argv[++i]);
+        } else if (arg == "-r") {
+            rate = atof(argv[++i]);
+        } else if (arg == "-c") {
+            components = atoi(argv[++i]);
+        } else if (arg == "-f") {
+            fanout = atoi(argv[++i]);
+        } else if (arg == "-N") {
+            catalogSize = atoi(argv[++i]);
+        } else if (arg == "-s") {
+            zipfExponent = atof(argv[++i]);
+        } else if (arg == "-p") {
+            payloadSize = atoi(argv[++i]);
+        } else if (arg == "-u") {
+            duplicateRatio = atof(argv[++i]);
+        } else if (arg == "-R") {
+            registrations = atoi(argv[++i]);
+        } else if (arg == "-o") {
+            output = argv[++i];
+        } else {
+            usage();
+            return -1;
+        }
+    }
+    if (duration <= 0 || rate <= 0 || components < 2 || fanout == 0 ||
+            payloadSize + 200 > BUFLEN || duplicateRatio < 0 || duplicateRatio > 1) {
+        usage();
+        return -1;
+    }
+
+    NDNL3Protocol *protocol = Singleton<NDNL3Protocol>::Get();
+    protocol->SetForwardingStrategy(Create<NDNFloodingStrategy>());
+    Ptr<NDNFib> fib = Create<NDNFib>();
+    protocol->SetFib(fib);
+
+    EventMonitor em;
+    em.addTimer(&NDNL3Protocol::Reap, &em, &NDNL3Protocol::REAP_INTERVAL);
+
+    Ptr<NDNFace> consumerFace, producerFace;
+    int consumerFd = ConnectLocalFace(protocol, em, consumerFace);
+    int producerFd = ConnectLocalFace(protocol, em, producerFace);
+    fib->Add(NameComponents("/bench"), producerFace, 0);
+
+    double registrationTime = 0;
+    if (registrations > 0) {
+        registrationTime = RegisterPrefixes(fib, producerFace, producerFd, registrations, em);
+        if (registrationTime < 0) {
+            cerr << "Error: the " << registrations << " prefixes registered are not all in the FIB" << endl;
+            return 1;
+        }
+    }
+
+    NameGenerator names("bench", components, fanout, catalogSize, zipfExponent);
+    Ptr<ConsumerGenerator> consumer = Create<ConsumerGenerator>(consumerFd, boost::ref(names), rate, duplicateRatio);
+    Ptr<ProducerGenerator> producer = Create<ProducerGenerator>(producerFd, payloadSize);
+    em.add(consumer);
+    em.add(producer);
+
+    struct timeval stopTimeout;
+    stopTimeout.tv_sec = static_cast<long>(duration);
+    stopTimeout.tv_usec = static_cast<long>((duration - stopTimeout.tv_sec) * 1e6);
+    em.addTimer(&StopMonitor, &em, &stopTimeout);
+
+    const int64_t start = MonotonicNow();
+    consumer->Start(em);
+    em.monitor();
+    const double elapsed = (MonotonicNow() - start) / 1e9;
+
+    // every interest that reached the producer was forwarded by the daemon, and so was
+    // every data received by the consumer. Since the consumer never has two pending
+    // interests with the same name, data not coming from the producer came from the CS
+    const uint64_t forwarded = producer->GetInterestCount() + consumer->GetReceivedCount();
+    const uint64_t received = consumer->GetReceivedCount();
+    const uint64_t produced = producer->GetInterestCount();
+    const double hitRatio = received > produced ? static_cast<double>(received - produced) / received : 0.0;
+    LatencyRecorder &latency = consumer->GetLatency();
+
+    log::JsonLogger json;
+    json << log::JsonMapOpen
+         << "config" << log::JsonMapOpen
+         << "duration" << duration
+         << "rate" << rate
+         << "components" << components
+         << "fanout" << fanout
+         << "catalogSize" << static_cast<unsigned int>(names.GetCatalogSize())
+         << "zipfExponent" << zipfExponent
+         << "payloadSize" << payloadSize
+         << "duplicateRatio" << duplicateRatio
+         << "registrations" << registrations
+         << log::JsonMapClose
+         << "registrationTime" << registrationTime
+         << "elapsed" << elapsed
+         << "interestsSent" << static_cast<double>(consumer->GetSentCount())
+         << "duplicatesSent" << static_cast<double>(consumer->GetDuplicateCount())
+         << "namesSkipped" << static_cast<double>(consumer->GetSkippedCount())
+         << "interestsTimedOut" << static_cast<double>(consumer->GetTimedOutCount())
+         << "interestsPending" << static_cast<double>(consumer->GetPendingCount())
+         << "interestsAtProducer" << static_cast<double>(produced)
+         << "dataReceived" << static_cast<double>(received)
+         << "sendErrors" << static_cast<double>(consumer->GetErrorCount() + producer->GetErrorCount())
+         << "forwardedPerSec" << forwarded / elapsed
+         << "csHitRatio" << hitRatio
+         << "latencyNs" << log::JsonMapOpen
+         << "p50" << latency.GetPercentile(50)
+         << "p90" << latency.GetPercentile(90)
+         << "p99" << latency.GetPercentile(99)
+         << "max" << latency.GetPercentile(100)
+         << log::JsonMapClose
+         << log::JsonMapClose;
+
+    if (output.empty()) {
+        cout << json.ToString() << endl;
+    } else {
+        std::ofstream file(output.c_str());
+        if (!file) {
+            cerr << "Error: cannot open " << output << endl;
+            return 1;
+        }
+        file << json.ToString() << endl;
+    }
+
+    return 0;
+}
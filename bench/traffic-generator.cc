@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "traffic-generator.h"
+
+#include "corelib/log.h"
+#include "helper/event-monitor.h"
+#include "helper/ndn-header-helper.h"
+#include "network/ndn-content-object-header.h"
+#include "network/ndn-content-packet.h"
+#include "network/ndn-interest-header.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <time.h>
+
+NS_LOG_COMPONENT_DEFINE("TrafficGenerator");
+
+namespace vndn
+{
+
+const struct timeval ConsumerGenerator::TICK_INTERVAL = {0, 1000}; // 1 ms
+const int64_t ConsumerGenerator::PENDING_TIMEOUT = 4000000000LL;   // 4 s, the default interest lifetime
+const double ConsumerGenerator::MAX_BURST = 0.01;                   // 10 ms worth of interests
+
+int64_t MonotonicNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static std::string NameToString(const NameComponents &name)
+{
+    std::ostringstream os;
+    os << name;
+    return os.str();
+}
+
+
+ConsumerGenerator::ConsumerGenerator(int fd, NameGenerator &names, double rate, double duplicateRatio)
+    : m_fd(fd)
+    , m_names(names)
+    , m_rate(rate)
+    , m_duplicateRatio(duplicateRatio)
+    , m_credit(0.0)
+    , m_lastTick(0)
+    , m_em(0)
+    , m_seed(fd)
+    , m_sent(0)
+    , m_duplicates(0)
+    , m_skipped(0)
+    , m_timedOut(0)
+    , m_received(0)
+    , m_errors(0)
+    , m_latency("end_to_end", 1024)
+{
+}
+
+void ConsumerGenerator::Start(EventMonitor &em)
+{
+    m_em = &em;
+    m_lastTick = MonotonicNow();
+    em.addTimer(&ConsumerGenerator::OnTick, this, &TICK_INTERVAL);
+}
+
+void ConsumerGenerator::OnTick(int, short, void *arg)
+{
+    ConsumerGenerator *self = static_cast<ConsumerGenerator *>(arg);
+
+    // ticks can be late, so the number of interests is
+    // computed from the time actually elapsed since the last one
+    const int64_t now = MonotonicNow();
+    self->m_credit += self->m_rate * (now - self->m_lastTick) / 1e9;
+    self->m_lastTick = now;
+    // when the daemon cannot keep up, do not accumulate a huge burst,
+    // but always allow one interest, or low rates would never send any
+    self->m_credit = std::min(self->m_credit, std::max(1.0, self->m_rate * MAX_BURST));
+    unsigned int count = static_cast<unsigned int>(self->m_credit);
+    self->m_credit -= count;
+    self->SendInterests(count);
+
+    self->m_em->addTimer(&ConsumerGenerator::OnTick, self, &TICK_INTERVAL);
+}
+
+void ConsumerGenerator::SendInterests(unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        const int64_t now = MonotonicNow();
+
+        if (m_lastInterest != 0 && m_pending.count(m_lastName) &&
+                static_cast<double>(rand_r(&m_seed)) / RAND_MAX < m_duplicateRatio) {
+            if (Send(m_lastInterest))
+                m_duplicates++;
+            continue;
+        }
+
+        Ptr<NameComponents> name = m_names.Next();
+        std::string key = NameToString(*name);
+        boost::unordered_map<std::string, int64_t>::iterator pending = m_pending.find(key);
+        if (pending != m_pending.end()) {
+            if (now - pending->second < PENDING_TIMEOUT) {
+                m_skipped++;
+                continue;
+            }
+            m_timedOut++;
+            m_pending.erase(pending);
+        }
+
+        Ptr<InterestHeader> header = Create<InterestHeader>();
+        header->SetNonce(rand_r(&m_seed));
+        header->SetName(name);
+        Ptr<Packet> interest = Create<Packet>();
+        interest->AddHeader(header);
+
+        if (Send(interest)) {
+            m_sent++;
+            m_pending[key] = now;
+            m_lastName = key;
+            m_lastInterest = interest;
+        }
+    }
+}
+
+bool ConsumerGenerator::Send(const Ptr<const Packet> &packet)
+{
+    if (::send(m_fd, packet->GetRawBuffer(), packet->GetSize(), 0) < 0) {
+        NS_LOG_WARN("send() failed: " << strerror(errno));
+        m_errors++;
+        return false;
+    }
+    return true;
+}
+
+void ConsumerGenerator::readHandler(EventMonitor &)
+{
+    uint8_t buf[BUFLEN];
+    ssize_t len;
+
+    while ((len = ::recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        const int64_t now = MonotonicNow();
+        Ptr<Packet> packet = Packet::InitFromBuffer(buf, len);
+
+        try {
+            if (packet->GetHeaderType() != NDNHeaderHelper::CONTENT_OBJECT) {
+                NS_LOG_DEBUG("Ignoring a packet that is not a content object");
+                continue;
+            }
+        } catch (NDNUnknownHeaderException) {
+            NS_LOG_WARN("Received a packet with an unknown header type");
+            continue;
+        }
+
+        Ptr<ContentObjectHeader> header = GetHeader<ContentObjectHeader>(*packet);
+        boost::unordered_map<std::string, int64_t>::iterator pending = m_pending.find(NameToString(*header->GetName()));
+        if (pending == m_pending.end()) {
+            NS_LOG_DEBUG("Received unsolicited data " << *header->GetName());
+            continue;
+        }
+
+        m_latency.Add(now - pending->second);
+        m_pending.erase(pending);
+        m_received++;
+    }
+}
+
+
+ProducerGenerator::ProducerGenerator(int fd, unsigned int payloadSize)
+    : m_fd(fd)
+    , m_payload(payloadSize, 'x')
+    , m_interests(0)
+    , m_errors(0)
+{
+}
+
+void ProducerGenerator::readHandler(EventMonitor &)
+{
+    uint8_t buf[BUFLEN];
+    ssize_t len;
+
+    while ((len = ::recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        Ptr<Packet> packet = Packet::InitFromBuffer(buf, len);
+
+        try {
+            if (packet->GetHeaderType() != NDNHeaderHelper::INTEREST) {
+                NS_LOG_DEBUG("Ignoring a packet that is not an interest");
+                continue;
+            }
+        } catch (NDNUnknownHeaderException) {
+            NS_LOG_WARN("Received a packet with an unknown header type");
+            continue;
+        }
+
+        Ptr<InterestHeader> header = GetHeader<InterestHeader>(*packet);
+        if (header->GetNack() != InterestHeader::NORMAL_INTEREST)
+            continue;
+
+        m_interests++;
+        Ptr<NDNContentPacket> data = Create<NDNContentPacket>(Create<NameComponents>(*header->GetName()),
+                                                              reinterpret_cast<const uint8_t *>(m_payload.data()),
+                                                              m_payload.size());
+        if (::send(m_fd, data->GetRawBuffer(), data->GetSize(), 0) < 0) {
+            NS_LOG_WARN("send() failed: " << strerror(errno));
+            m_errors++;
+        }
+    }
+}
+
+} // namespace vndn
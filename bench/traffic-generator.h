@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef TRAFFIC_GENERATOR_H_
+#define TRAFFIC_GENERATOR_H_
+
+#include "latency-recorder.h"
+#include "name-generator.h"
+
+#include "corelib/ptr.h"
+#include "helper/monitorable.h"
+#include "network/packet.h"
+
+#include <stdint.h>
+#include <string>
+#include <boost/unordered_map.hpp>
+
+namespace vndn
+{
+
+class EventMonitor;
+
+/**
+ * \brief Application-side traffic source used by the throughput benchmark
+ *
+ * The consumer is attached to one end of a socket pair whose other end is
+ * an NDNLocalFace of the daemon. It expresses interests at a constant rate,
+ * choosing their names with a NameGenerator, and measures the time until
+ * the corresponding data comes back.
+ *
+ * A name is never requested again while an interest for it is pending, so
+ * that every data received without the producer having seen the interest
+ * can be attributed to the content store. A fraction of the transmissions
+ * can be replaced by exact duplicates (same name and nonce) of a pending
+ * interest, which the daemon is expected to suppress.
+ */
+class ConsumerGenerator : public Monitorable
+{
+public:
+    /**
+     * \param fd application end of the socket pair
+     * \param names generator of the interest names
+     * \param rate interests per second
+     * \param duplicateRatio fraction of the transmissions that are duplicates (0 to 1)
+     */
+    ConsumerGenerator(int fd, NameGenerator &names, double rate, double duplicateRatio);
+
+    /**
+     * \brief Starts sending interests, must be called before EventMonitor::monitor()
+     */
+    void Start(EventMonitor &em);
+
+    virtual void readHandler(EventMonitor &em);
+    virtual int getMonitorFd() const { return m_fd; }
+
+    uint64_t GetSentCount() const { return m_sent; }
+    uint64_t GetDuplicateCount() const { return m_duplicates; }
+    uint64_t GetSkippedCount() const { return m_skipped; }
+    uint64_t GetTimedOutCount() const { return m_timedOut; }
+    uint64_t GetReceivedCount() const { return m_received; }
+    uint64_t GetErrorCount() const { return m_errors; }
+    size_t GetPendingCount() const { return m_pending.size(); }
+    LatencyRecorder &GetLatency() { return m_latency; }
+
+private:
+    static void OnTick(int fd, short events, void *arg);
+    void SendInterests(unsigned int count);
+    bool Send(const Ptr<const Packet> &packet);
+
+    static const struct timeval TICK_INTERVAL;
+    static const int64_t PENDING_TIMEOUT; ///< \brief nanoseconds after which a pending interest is given up
+    static const double MAX_BURST;        ///< \brief seconds of traffic that can be sent in a single tick
+
+    int m_fd;
+    NameGenerator &m_names;
+    double m_rate;
+    double m_duplicateRatio;
+    double m_credit;              ///< \brief interests that should have been sent but were not yet
+    int64_t m_lastTick;           ///< \brief time of the last tick, in nanoseconds
+    EventMonitor *m_em;
+
+    /// \brief pending interests, indexed by name, with their transmission time
+    boost::unordered_map<std::string, int64_t> m_pending;
+    std::string m_lastName;       ///< \brief name of the last interest sent
+    Ptr<Packet> m_lastInterest;   ///< \brief last interest sent, reused for duplicates
+    unsigned int m_seed;
+
+    uint64_t m_sent;
+    uint64_t m_duplicates;
+    uint64_t m_skipped;
+    uint64_t m_timedOut;
+    uint64_t m_received;
+    uint64_t m_errors;
+    LatencyRecorder m_latency;
+};
+
+/**
+ * \brief Application-side data source used by the throughput benchmark
+ *
+ * Replies to every interest it receives with a data packet of the configured size.
+ */
+class ProducerGenerator : public Monitorable
+{
+public:
+    ProducerGenerator(int fd, unsigned int payloadSize);
+
+    virtual void readHandler(EventMonitor &em);
+    virtual int getMonitorFd() const { return m_fd; }
+
+    uint64_t GetInterestCount() const { return m_interests; }
+    uint64_t GetErrorCount() const { return m_errors; }
+
+private:
+    int m_fd;
+    std::string m_payload;
+
+    uint64_t m_interests;
+    uint64_t m_errors;
+};
+
+/**
+ * \brief Returns the value of the monotonic clock in nanoseconds
+ */
+int64_t MonotonicNow();
+
+} // namespace vndn
+
+#endif /* TRAFFIC_GENERATOR_H_ */
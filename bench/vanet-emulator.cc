@@ -0,0 +1,591 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+/*
+ * Multi-vehicle link-layer emulator.
+ *
+ * Every vehicle runs a complete daemon (NDNL3Protocol with an ad-hoc face and
+ * the NDN-LAL NDNDeviceAdapter, with LLNomPolicy, implicit acks and
+ * retransmissions) in its own threads of this process. The ad-hoc faces are
+ * connected by an NdnEmulatedMedium instead of a wireless interface, and the
+ * vehicle positions come from a MobilityScript, fed to the adapters as gpsd
+ * reports and to the medium to decide who can hear whom.
+ *
+ * Vehicle 0 runs a producer, the following ones run consumers, which request
+ * names of the traffic application, /traffic/<lat>,<lon>/..., with the initial
+ * position of the producer. The vehicles use either the flooding or the
+ * geo-directional forwarding strategy. At the end,
+ * the satisfaction ratio, the end-to-end latency and the frames transmitted
+ * on the medium are printed as JSON.
+ *
+ * The adapters load the map from utils/geo/map, so the emulator must be
+ * started from the top-level source directory.
+ */
+
+#include "mobility-script.h"
+#include "traffic-generator.h"
+
+#include "corelib/log.h"
+#include "corelib/ptr.h"
+#include "daemon/ndn-adhoc-net-device-face.h"
+#include "daemon/ndn-fib.h"
+#include "daemon/ndn-flooding-strategy.h"
+#include "daemon/ndn-geo-strategy.h"
+#include "daemon/ndn-l3-protocol.h"
+#include "daemon/ndn-local-face.h"
+#include "helper/event-monitor.h"
+#include "network/mac/ll-nom-policy.h"
+#include "network/mac/ndn-device-adapter.h"
+#include "network/mac/ndnsock/ndn-emulated-medium.h"
+#include "network/mac/ndnsock/ndn-emulated-socket.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include <boost/ref.hpp>
+
+using namespace vndn;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+// default road, between two points used by fakeGps (about 2.2 km)
+static const double ROAD_START_LAT = 34.030007;
+static const double ROAD_START_LON = -118.485188;
+static const double ROAD_END_LAT = 34.043983;
+static const double ROAD_END_LON = -118.467293;
+
+// the medium sees the new positions every 100 ms, the adapters once per second like with gpsd
+static const struct timespec POSITION_UPDATE_INTERVAL = {0, 100000000};
+static const unsigned int GPS_REPORT_PERIOD = 10;
+
+
+struct EmulatorConfig {
+    unsigned int vehicles;
+    double duration;
+    string mobilityFile;
+    double speed;
+    NdnEmulatedMedium::Config medium;
+    double rate;
+    unsigned int consumers;
+    unsigned int catalogSize;
+    unsigned int payloadSize;
+    LLHeaderFormat headerFormat;
+    bool aggregation;
+    bool unicast;
+    bool compression;
+    LALContention::Parameters timers;
+    bool geoStrategy;
+    string location;   ///< \brief destination of the interests, the initial position of the producer
+};
+
+/**
+ * Everything that belongs to one vehicle. The generators are accessed by the
+ * main thread only after the vehicle thread has terminated.
+ */
+struct Vehicle {
+    unsigned int id;
+    const EmulatorConfig *config;
+    NdnEmulatedMedium *medium;
+    pthread_barrier_t *startBarrier;
+    int gpsFds[2];  ///< \brief [0] is read by the adapter, [1] is written by the emulator
+    bool ok;
+
+    NameGenerator *names;
+    Ptr<ConsumerGenerator> consumer;
+    Ptr<ProducerGenerator> producer;
+    Ptr<NDNGeoStrategy> geoStrategy;
+};
+
+
+static void usage()
+{
+    cout << "Usage: ./vanetEmulator [options]\n"
+         << "  -n <vehicles>     number of vehicles on the default road (default 20)\n"
+         << "  -d <seconds>      duration of the emulation (default 30)\n"
+         << "  -m <file>         mobility script, lines of \"<time> <vehicle> <lat> <lon>\",\n"
+         << "                    instead of the default road\n"
+         << "  -v <m/s>          speed of the vehicles on the default road (default 10)\n"
+         << "  -r <meters>       transmission range (default 150)\n"
+         << "  -l <ratio>        loss probability of every reception, between 0 and 1 (default 0)\n"
+         << "  -D <usec>         propagation and processing delay (default 100)\n"
+         << "  -b <Mbit/s>       channel bit rate (default 6)\n"
+         << "  -B <Mbit/s>       bit rate of the unicast frames (default: same as -b)\n"
+         << "  -i <rate>         interests per second of every consumer (default 1)\n"
+         << "  -c <consumers>    number of consumer vehicles (default: all but the producer)\n"
+         << "  -N <names>        size of the name catalog (default 1000)\n"
+         << "  -p <bytes>        data payload size (default 100)\n"
+         << "  -H <format>       NDN-LAL header format, binary or ascii (default binary)\n"
+         << "  -A <on|off>       aggregation of the packets due together in one frame (default on)\n"
+         << "  -U <on|off>       unicast of the data requested by a single neighbor (default on)\n"
+         << "  -C <on|off>       compression of the name prefixes already sent (default on)\n"
+         << "  -T <spec>         collision avoidance timers, <name>=<value>,... (default: adaptive=on,maxTca=2000,\n"
+         << "                    referenceNeighbors=7,minWindow=500,maxWindow=20000,Tdist=5000,Dmax=150,\n"
+         << "                    duplicateWeight=1,retransmissionWeight=0.5)\n"
+         << "  -S <strategy>     forwarding strategy, flooding or geo (default flooding)\n"
+         << "  -o <file>         write the JSON results to file instead of stdout\n";
+}
+
+static double Elapsed(int64_t start)
+{
+    return (MonotonicNow() - start) / 1e9;
+}
+
+static void SendGpsReport(int fd, double lat, double lon)
+{
+    // the subset of a gpsd TPV report used by GpsdParser
+    char report[256];
+    int len = snprintf(report, sizeof(report),
+                       "{\"class\":\"TPV\",\"time\":%ld.000,\"lat\":%.7f,\"lon\":%.7f,\"speed\":0.000}\n",
+                       static_cast<long>(time(NULL)), lat, lon);
+    if (::send(fd, report, len, MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+        cerr << "Warning: cannot send the position to the adapter: " << strerror(errno) << endl;
+}
+
+static void StopMonitor(int, short, void *arg)
+{
+    static_cast<EventMonitor *>(arg)->stop();
+}
+
+/**
+ * Attaches a new NDNLocalFace to one end of a socket pair and returns the other end.
+ */
+static int ConnectLocalFace(NDNL3Protocol *protocol, EventMonitor &em)
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0)
+        return -1;
+    for (int i = 0; i < 2; i++)
+        ::fcntl(fds[i], F_SETFL, O_NONBLOCK);
+
+    Ptr<NDNFace> face = Create<NDNLocalFace>(fds[0]);
+    protocol->AddFace(face);
+    em.add(face);
+    return fds[1];
+}
+
+/**
+ * Body of the thread of a vehicle: the equivalent of ndnd with an ad-hoc face
+ * and the application of the vehicle.
+ */
+static void *RunVehicle(void *arg)
+{
+    Vehicle *vehicle = static_cast<Vehicle *>(arg);
+    const EmulatorConfig &config = *vehicle->config;
+
+    // the stack is never deleted, faces and timers may still refer to it
+    NDNL3Protocol *protocol = new NDNL3Protocol;
+    NDNL3Protocol::SetThreadInstance(protocol);
+    if (config.geoStrategy) {
+        vehicle->geoStrategy = Create<NDNGeoStrategy>();
+        protocol->SetForwardingStrategy(vehicle->geoStrategy);
+    } else {
+        protocol->SetForwardingStrategy(Create<NDNFloodingStrategy>());
+    }
+    protocol->SetFib(Create<NDNFib>());
+
+    EventMonitor em;
+    em.addTimer(&NDNL3Protocol::Reap, &em, &NDNL3Protocol::REAP_INTERVAL);
+
+    std::ostringstream deviceName;
+    deviceName << "emu" << vehicle->id;
+    try {
+        NDNDeviceAdapter *adapter = new NDNDeviceAdapter(new NdnEmulatedSocket(*vehicle->medium, vehicle->id, deviceName.str()),
+                                                         vehicle->gpsFds[0]);
+        Ptr<NDNFace> face = Create<NDNAdhocNetDeviceFace>(adapter);
+        protocol->AddFace(face);
+        em.add(face);
+        vehicle->ok = true;
+    } catch (NDNLinkLayerCommunication e) {
+        cerr << "Error: vehicle " << vehicle->id << ": " << e.error() << endl;
+    } catch (const char *e) {
+        cerr << "Error: vehicle " << vehicle->id << ": " << e << endl;
+    }
+
+    if (vehicle->ok && (vehicle->id == 0 || vehicle->id <= config.consumers)) {
+        int fd = ConnectLocalFace(protocol, em);
+        if (fd < 0) {
+            cerr << "Error: vehicle " << vehicle->id << ": socketpair() failed: " << strerror(errno) << endl;
+            vehicle->ok = false;
+        } else if (vehicle->id == 0) {
+            vehicle->producer = Create<ProducerGenerator>(fd, config.payloadSize);
+            em.add(vehicle->producer);
+        } else {
+            vehicle->names = new NameGenerator("traffic", 4, 10, config.catalogSize, 0.8, vehicle->id);
+            vehicle->names->SetLocation(config.location);
+            vehicle->consumer = Create<ConsumerGenerator>(fd, boost::ref(*vehicle->names), config.rate, 0.0);
+            em.add(vehicle->consumer);
+        }
+    }
+
+    // all the vehicles start the traffic at the same time
+    pthread_barrier_wait(vehicle->startBarrier);
+    if (!vehicle->ok)
+        return 0;
+
+    struct timeval stopTimeout;
+    stopTimeout.tv_sec = static_cast<long>(config.duration);
+    stopTimeout.tv_usec = static_cast<long>((config.duration - stopTimeout.tv_sec) * 1e6);
+    em.addTimer(&StopMonitor, &em, &stopTimeout);
+    if (vehicle->consumer != 0)
+        vehicle->consumer->Start(em);
+    em.monitor();
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    EmulatorConfig config;
+    config.vehicles = 20;
+    config.duration = 30.0;
+    config.speed = 10.0;
+    config.rate = 1.0;
+    config.consumers = 0;
+    config.catalogSize = 1000;
+    config.payloadSize = 100;
+    config.headerFormat = LL_HEADER_BINARY;
+    config.aggregation = true;
+    config.unicast = true;
+    config.compression = true;
+    config.geoStrategy = false;
+    bool consumersSet = false;
+    string output;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage();
+            return -1;
+        }
+        if (arg == "-n") {
+            config.vehicles = atoi(argv[++i]);
+        } else if (arg == "-d") {
+            config.duration = atof(argv[++i]);
+        } else if (arg == "-m") {
+            config.mobilityFile = argv[++i];
+        } else if (arg == "-v") {
+            config.speed = atof(argv[++i]);
+        } else if (arg == "-r") {
+            config.medium.range = atof(argv[++i]);
+        } else if (arg == "-l") {
+            config.medium.lossRate = atof(argv[++i]);
+        } else if (arg == "-D") {
+            config.medium.delay = atoll(argv[++i]) * 1000;
+        } else if (arg == "-b") {
+            config.medium.bitrate = atof(argv[++i]) * 1e6;
+        } else if (arg == "-B") {
+            config.medium.unicastBitrate = atof(argv[++i]) * 1e6;
+        } else if (arg == "-i") {
+            config.rate = atof(argv[++i]);
+        } else if (arg == "-c") {
+            config.consumers = atoi(argv[++i]);
+            consumersSet = true;
+        } else if (arg == "-N") {
+            config.catalogSize = atoi(argv[++i]);
+        } else if (arg == "-p") {
+            config.payloadSize = atoi(argv[++i]);
+        } else if (arg == "-H") {
+            string format(argv[++i]);
+            if (format == "ascii") {
+                config.headerFormat = LL_HEADER_ASCII;
+            } else if (format == "binary") {
+                config.headerFormat = LL_HEADER_BINARY;
+            } else {
+                usage();
+                return -1;
+            }
+        } else if (arg == "-A") {
+            string aggregation(argv[++i]);
+            if (aggregation == "on") {
+                config.aggregation = true;
+            } else if (aggregation == "off") {
+                config.aggregation = false;
+            } else {
+                usage();
+                return -1;
+            }
+        } else if (arg == "-U") {
+            string unicast(argv[++i]);
+            if (unicast == "on") {
+                config.unicast = true;
+            } else if (unicast == "off") {
+                config.unicast = false;
+            } else {
+                usage();
+                return -1;
+            }
+        } else if (arg == "-C") {
+            string compression(argv[++i]);
+            if (compression == "on") {
+                config.compression = true;
+            } else if (compression == "off") {
+                config.compression = false;
+            } else {
+                usage();
+                return -1;
+            }
+        } else if (arg == "-T") {
+            if (!LALContention::parse(argv[++i], config.timers)) {
+                usage();
+                return -1;
+            }
+        } else if (arg == "-S") {
+            string strategy(argv[++i]);
+            if (strategy == "geo") {
+                config.geoStrategy = true;
+            } else if (strategy == "flooding") {
+                config.geoStrategy = false;
+            } else {
+                usage();
+                return -1;
+            }
+        } else if (arg == "-o") {
+            output = argv[++i];
+        } else {
+            usage();
+            return -1;
+        }
+    }
+
+    MobilityScript mobility;
+    if (config.mobilityFile.empty()) {
+        mobility.AddRoad(config.vehicles, ROAD_START_LAT, ROAD_START_LON, ROAD_END_LAT, ROAD_END_LON,
+                         config.speed, config.duration);
+    } else if (!mobility.Load(config.mobilityFile)) {
+        cerr << "Error: cannot load the mobility script " << config.mobilityFile << endl;
+        return 1;
+    }
+    config.vehicles = mobility.GetVehicleCount();
+    if (!consumersSet)
+        config.consumers = config.vehicles - 1;
+    if (config.vehicles > 0) {
+        double lat, lon;
+        mobility.GetPosition(0, 0.0, lat, lon);
+        std::ostringstream location;
+        location << std::setprecision(15) << lat << "," << lon;
+        config.location = location.str();
+    }
+
+    if (config.vehicles < 2 || config.duration <= 0 || config.rate <= 0 ||
+            config.consumers >= config.vehicles || config.medium.range <= 0 ||
+            config.medium.lossRate < 0 || config.medium.lossRate > 1 ||
+            config.medium.bitrate <= 0 || config.medium.unicastBitrate < 0 || config.medium.delay < 0 || config.payloadSize + 200 > BUFLEN) {
+        usage();
+        return -1;
+    }
+
+    // each vehicle needs about 10 fds, 200 vehicles exceed the usual soft limit
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    LLNomPolicy::setHeaderFormat(config.headerFormat);
+    LLNomPolicy::setAggregation(config.aggregation);
+    LLNomPolicy::setUnicast(config.unicast);
+    LLNomPolicy::setPrefixCompression(config.compression);
+    LLNomPolicy::setContention(config.timers);
+    NdnEmulatedMedium medium(config.vehicles, config.medium);
+    std::vector<Vehicle> vehicles(config.vehicles);
+    std::vector<pthread_t> threads(config.vehicles);
+    pthread_barrier_t startBarrier;
+    pthread_barrier_init(&startBarrier, NULL, config.vehicles + 1);
+
+    for (unsigned int i = 0; i < config.vehicles; i++) {
+        Vehicle &vehicle = vehicles[i];
+        vehicle.id = i;
+        vehicle.config = &config;
+        vehicle.medium = &medium;
+        vehicle.startBarrier = &startBarrier;
+        vehicle.ok = false;
+        vehicle.names = 0;
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, vehicle.gpsFds) < 0) {
+            cerr << "Error: socketpair() failed: " << strerror(errno) << endl;
+            return 1;
+        }
+
+        // the first position is already available when the adapter starts
+        double lat, lon;
+        mobility.GetPosition(i, 0.0, lat, lon);
+        medium.setPosition(i, lat, lon);
+        SendGpsReport(vehicle.gpsFds[1], lat, lon);
+
+        if (pthread_create(&threads[i], NULL, &RunVehicle, &vehicle) != 0) {
+            cerr << "Error: cannot create the thread of vehicle " << i << endl;
+            return 1;
+        }
+    }
+
+    pthread_barrier_wait(&startBarrier);
+    const int64_t start = MonotonicNow();
+
+    // move the vehicles until the end of the emulation
+    for (unsigned int tick = 1; Elapsed(start) < config.duration; tick++) {
+        nanosleep(&POSITION_UPDATE_INTERVAL, NULL);
+        const double now = Elapsed(start);
+        for (unsigned int i = 0; i < config.vehicles; i++) {
+            double lat, lon;
+            mobility.GetPosition(i, now, lat, lon);
+            medium.setPosition(i, lat, lon);
+            if (tick % GPS_REPORT_PERIOD == 0)
+                SendGpsReport(vehicles[i].gpsFds[1], lat, lon);
+        }
+    }
+    for (unsigned int i = 0; i < config.vehicles; i++)
+        pthread_join(threads[i], NULL);
+    const double elapsed = Elapsed(start);
+
+    uint64_t sent = 0, received = 0, timedOut = 0, pending = 0, produced = 0;
+    uint64_t geoForwarded = 0, geoSuppressed = 0, geoFlooded = 0;
+    LatencyRecorder latency("end_to_end", 1024);
+    NdnEmulatedMedium::NodeStatistics total;
+    memset(&total, 0, sizeof(total));
+    unsigned int failed = 0;
+
+    log::JsonLogger json;
+    json << log::JsonMapOpen
+         << "config" << log::JsonMapOpen
+         << "vehicles" << config.vehicles
+         << "duration" << config.duration
+         << "mobility" << (config.mobilityFile.empty() ? string("road") : config.mobilityFile)
+         << "speed" << config.speed
+         << "range" << config.medium.range
+         << "lossRate" << config.medium.lossRate
+         << "delayUs" << static_cast<double>(config.medium.delay / 1000)
+         << "bitrate" << config.medium.bitrate
+         << "unicastBitrate" << (config.medium.unicastBitrate > 0 ? config.medium.unicastBitrate : config.medium.bitrate)
+         << "rate" << config.rate
+         << "consumers" << config.consumers
+         << "catalogSize" << config.catalogSize
+         << "payloadSize" << config.payloadSize
+         << "headerFormat" << (config.headerFormat == LL_HEADER_ASCII ? "ascii" : "binary")
+         << "aggregation" << config.aggregation
+         << "unicast" << config.unicast
+         << "compression" << config.compression
+         << "adaptiveTimers" << config.timers.adaptive
+         << "maxTca" << config.timers.maxTca
+         << "strategy" << (config.geoStrategy ? "geo" : "flooding")
+         << log::JsonMapClose
+         << "vehicles" << log::JsonArrayOpen;
+
+    for (unsigned int i = 0; i < config.vehicles; i++) {
+        const Vehicle &vehicle = vehicles[i];
+        NdnEmulatedMedium::NodeStatistics stats = medium.getStatistics(i);
+        total.txFrames += stats.txFrames;
+        total.txBytes += stats.txBytes;
+        total.retries += stats.retries;
+        total.rxFrames += stats.rxFrames;
+        total.lost += stats.lost;
+        total.collisions += stats.collisions;
+        total.dropped += stats.dropped;
+        total.deferTime += stats.deferTime;
+        if (!vehicle.ok)
+            failed++;
+
+        json << log::JsonMapOpen
+             << "id" << i
+             << "txFrames" << static_cast<double>(stats.txFrames)
+             << "retries" << static_cast<double>(stats.retries)
+             << "rxFrames" << static_cast<double>(stats.rxFrames)
+             << "lost" << static_cast<double>(stats.lost)
+             << "collisions" << static_cast<double>(stats.collisions)
+             << "dropped" << static_cast<double>(stats.dropped)
+             << "deferMs" << stats.deferTime / 1e6;
+        if (vehicle.consumer != 0) {
+            sent += vehicle.consumer->GetSentCount();
+            received += vehicle.consumer->GetReceivedCount();
+            timedOut += vehicle.consumer->GetTimedOutCount();
+            pending += vehicle.consumer->GetPendingCount();
+            latency.Merge(vehicle.consumer->GetLatency());
+            json << "interestsSent" << static_cast<double>(vehicle.consumer->GetSentCount())
+                 << "dataReceived" << static_cast<double>(vehicle.consumer->GetReceivedCount());
+        }
+        if (vehicle.producer != 0) {
+            produced += vehicle.producer->GetInterestCount();
+            json << "interestsAtProducer" << static_cast<double>(vehicle.producer->GetInterestCount());
+        }
+        if (vehicle.geoStrategy != 0) {
+            geoForwarded += vehicle.geoStrategy->GetForwardedCount();
+            geoSuppressed += vehicle.geoStrategy->GetSuppressedCount();
+            geoFlooded += vehicle.geoStrategy->GetFloodedCount();
+        }
+        json << log::JsonMapClose;
+    }
+
+    json << log::JsonArrayClose
+         << "elapsed" << elapsed
+         << "failedVehicles" << failed
+         << "interestsSent" << static_cast<double>(sent)
+         << "interestsTimedOut" << static_cast<double>(timedOut)
+         << "interestsPending" << static_cast<double>(pending)
+         << "interestsAtProducer" << static_cast<double>(produced)
+         << "dataReceived" << static_cast<double>(received)
+         << "satisfactionRatio" << (sent > 0 ? static_cast<double>(received) / sent : 0.0)
+         << "framesOnAir" << static_cast<double>(total.txFrames)
+         << "framesRetried" << static_cast<double>(total.retries)
+         << "bytesOnAir" << static_cast<double>(total.txBytes)
+         << "framesPerInterest" << (sent > 0 ? static_cast<double>(total.txFrames) / sent : 0.0)
+         << "framesDelivered" << static_cast<double>(total.rxFrames)
+         << "framesLost" << static_cast<double>(total.lost)
+         << "framesCollided" << static_cast<double>(total.collisions)
+         << "framesDropped" << static_cast<double>(total.dropped)
+         << "geoForwarded" << static_cast<double>(geoForwarded)
+         << "geoSuppressed" << static_cast<double>(geoSuppressed)
+         << "geoFlooded" << static_cast<double>(geoFlooded)
+         << "latencyNs" << log::JsonMapOpen
+         << "p50" << latency.GetPercentile(50)
+         << "p90" << latency.GetPercentile(90)
+         << "p99" << latency.GetPercentile(99)
+         << "max" << latency.GetPercentile(100)
+         << log::JsonMapClose
+         << log::JsonMapClose;
+
+    if (output.empty()) {
+        cout << json.ToString() << endl;
+    } else {
+        std::ofstream file(output.c_str());
+        if (!file) {
+            cerr << "Error: cannot open " << output << endl;
+            _exit(1);
+        }
+        file << json.ToString() << endl;
+    }
+
+    // the adapter threads never terminate, and they use objects that
+    // would be destroyed by a normal exit: leave without cleaning up
+    cout.flush();
+    _exit(0);
+}
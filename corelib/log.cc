@@ -42,6 +42,7 @@ namespace log
 
 TimePrinter g_logTimePrinter = 0;
 NodePrinter g_logNodePrinter = 0;
+int32_t g_logEnabledLevels = 0;
 
 typedef std::list<std::pair <std::string, LogComponent *> > ComponentList;
 typedef std::list<std::pair <std::string, LogComponent *> >::iterator ComponentListI;
@@ -192,11 +193,6 @@ void LogComponent::ParseEnvVar()
     }
 }
 
-bool LogComponent::IsEnabled(LogLevel level) const
-{
-    return (m_levels & level) ? true : false;
-}
-
 bool LogComponent::IsNoneEnabled() const
 {
     return !IsEnabled(NDN_LOG_LEVEL_ANY);
@@ -205,11 +201,21 @@ bool LogComponent::IsNoneEnabled() const
 void LogComponent::Enable(LogLevel level)
 {
     m_levels |= level;
+    g_logEnabledLevels |= (level & NDN_LOG_LEVEL_ANY);
 }
 
 void LogComponent::Disable(LogLevel level)
 {
     m_levels &= ~level;
+
+    // recompute the global flag from scratch, other components
+    // could still have some of the disabled levels enabled
+    int32_t levels = 0;
+    ComponentList *components = GetComponentList();
+    for (ComponentListI i = components->begin(); i != components->end(); ++i) {
+        levels |= (i->second->m_levels & NDN_LOG_LEVEL_ANY);
+    }
+    g_logEnabledLevels = levels;
 }
 
 
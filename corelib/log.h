@@ -67,11 +67,21 @@ enum LogLevel {
 };
 
 
+/**
+ * \ingroup logging
+ *
+ * Union of the log levels (NDN_LOG_LEVEL_ANY bits only) that are
+ * currently enabled in at least one log component. The NS_LOG macros
+ * test this flag before querying their own component, so that a
+ * disabled log statement costs a single, well-predicted branch.
+ */
+extern int32_t g_logEnabledLevels;
+
 class LogComponent
 {
 public:
     LogComponent(char const *name);
-    bool IsEnabled(enum LogLevel level) const;
+    bool IsEnabled(enum LogLevel level) const { return (m_levels & level) ? true : false; }
     bool IsNoneEnabled() const;
     void Enable(enum LogLevel level);
     void Disable(enum LogLevel level);
@@ -221,6 +231,35 @@ void LogComponentDisableAll(enum LogLevel level);
     static vndn::log::LogComponent g_log = vndn::log::LogComponent(name)
 
 
+/**
+ * \ingroup logging
+ *
+ * Least severe log level that is compiled into the binaries.
+ * Log statements of a lower severity (DEBUG is lower than INFO,
+ * FUNCTION is the lowest) are discarded at compile time and cannot
+ * be re-enabled through VNDN_LOG. Use the --with-log-level option
+ * of configure to change it. By default every level is compiled in.
+ */
+#ifndef NDN_LOG_LEVEL_FLOOR
+#define NDN_LOG_LEVEL_FLOOR 0x00000020 // NDN_LOG_FUNCTION
+#endif
+
+#define NS_LOG_UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+/**
+ * \ingroup logging
+ * \param level the log level
+ *
+ * Evaluates to true if messages of the given level must be printed
+ * by the log component of the current file. The first test is a
+ * compile-time constant, the second one checks the cached global flag.
+ */
+#define NS_LOG_IS_ENABLED(level)                                    \
+  ((level) <= NDN_LOG_LEVEL_FLOOR &&                                \
+   NS_LOG_UNLIKELY(vndn::log::g_logEnabledLevels & (level)) &&      \
+   g_log.IsEnabled(level))
+
+
 #ifdef NDN_LOG_ENABLE
 
 /**
@@ -269,7 +308,7 @@ void LogComponentDisableAll(enum LogLevel level);
 #define NS_LOG(level, msg)                                          \
   do                                                                \
   {                                                                 \
-      if (g_log.IsEnabled(level))                                   \
+      if (NS_LOG_IS_ENABLED(level))                                 \
       {                                                             \
           std::ostringstream ss;                                    \
           ss << vndn::log::TimeInfo                                 \
@@ -337,7 +376,7 @@ void LogComponentDisableAll(enum LogLevel level);
 #define NS_LOG_FUNCTION_NOARGS()                                \
   do                                                            \
   {                                                             \
-      if (g_log.IsEnabled(vndn::log::NDN_LOG_FUNCTION))         \
+      if (NS_LOG_IS_ENABLED(vndn::log::NDN_LOG_FUNCTION))       \
       {                                                         \
           std::ostringstream ss;                                \
           ss << vndn::log::TimeInfo                             \
@@ -370,7 +409,7 @@ void LogComponentDisableAll(enum LogLevel level);
 #define NS_LOG_FUNCTION(parameters)                             \
   do                                                            \
   {                                                             \
-      if (g_log.IsEnabled(vndn::log::NDN_LOG_FUNCTION))         \
+      if (NS_LOG_IS_ENABLED(vndn::log::NDN_LOG_FUNCTION))       \
       {                                                         \
           std::ostringstream ss;                                \
           ss << vndn::log::TimeInfo                             \
@@ -396,7 +435,7 @@ void LogComponentDisableAll(enum LogLevel level);
 #define NS_LOG_JSON(type, msg)                                  \
   do                                                            \
   {                                                             \
-      if (g_log.IsEnabled(vndn::log::NDN_LOG_NOTICE))           \
+      if (NS_LOG_IS_ENABLED(vndn::log::NDN_LOG_NOTICE))         \
       {                                                         \
           vndn::log::JsonLogger json;                           \
           json << vndn::log::JsonMapOpen                        \
@@ -421,7 +460,7 @@ void LogComponentDisableAll(enum LogLevel level);
 #define NS_LOG_DEBUG(msg)
 #define NS_LOG_FUNCTION_NOARGS()
 #define NS_LOG_FUNCTION(msg)
-#define NS_LOG_JSON(msg)
+#define NS_LOG_JSON(type, msg)
 
 #endif /* NDN_LOG_ENABLE */
 
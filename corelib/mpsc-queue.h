@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef MPSC_QUEUE_H_
+#define MPSC_QUEUE_H_
+
+namespace vndn
+{
+
+/**
+ * \ingroup core
+ * \brief Unbounded lock-free queue with many producers and a single consumer
+ *
+ * Push() can be called concurrently by any number of threads, without locks:
+ * a producer only swaps the head pointer and then links the previous head to
+ * its node. Pop() and IsEmpty() must always be called by the same thread.
+ *
+ * This is the queue described by Dmitry Vyukov: the consumer always holds a
+ * "stub" node whose value has already been consumed. A producer that has been
+ * preempted between the swap and the link makes Pop() report an empty queue
+ * until it resumes, which is fine for a consumer woken by an event.
+ *
+ * \tparam T copyable type of the elements, usually a pointer
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+    {
+        Node *stub = new Node;
+        stub->next = 0;
+        m_head = stub;
+        m_tail = stub;
+    }
+
+    /**
+     * \brief Destroys the queue, the elements still in it are discarded
+     */
+    ~MpscQueue()
+    {
+        T value;
+        while (Pop(value))
+            ;
+        delete m_tail;
+    }
+
+    /**
+     * \brief Appends an element, can be called by any thread
+     */
+    void Push(const T &value)
+    {
+        Node *node = new Node;
+        node->value = value;
+        node->next = 0;
+        // the node must be complete before it becomes reachable by the consumer
+        __sync_synchronize();
+        Node *prev = __sync_lock_test_and_set(&m_head, node);
+        prev->next = node;
+    }
+
+    /**
+     * \brief Removes the oldest element, consumer thread only
+     * \return false if the queue is empty
+     */
+    bool Pop(T &value)
+    {
+        Node *tail = m_tail;
+        Node *next = tail->next;
+        if (next == 0)
+            return false;
+        __sync_synchronize();
+
+        value = next->value;
+        next->value = T();
+        m_tail = next;
+        delete tail;
+        return true;
+    }
+
+    /**
+     * \brief Consumer thread only
+     */
+    bool IsEmpty() const
+    {
+        return m_tail->next == 0;
+    }
+
+private:
+    MpscQueue(const MpscQueue &);
+    MpscQueue &operator=(const MpscQueue &);
+
+    struct Node {
+        Node *volatile next;
+        T value;
+    };
+
+    Node *volatile m_head; ///< \brief last pushed node, shared by the producers
+    char m_pad[64];        ///< \brief keeps the producers' cache line away from the consumer's
+    Node *m_tail;          ///< \brief stub node, owned by the consumer
+};
+
+} // namespace vndn
+
+#endif /* MPSC_QUEUE_H_ */
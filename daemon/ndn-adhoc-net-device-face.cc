@@ -26,6 +26,14 @@ namespace vndn
 
 void *startDeviceThread(void *param)
 {
+    NDNDeviceAdapter *adapter = ((NDNDeviceAdapter::NDNDeviceParams *)param)->adapter;
+    if (adapter != NULL) {
+        //the adapter has been built by the owner of the face, we cannot create a new one
+        adapter->start((NDNDeviceAdapter::NDNDeviceParams * )param);
+        NS_LOG_ERROR("NDNDeviceAdapter for device " << ((NDNDeviceAdapter::NDNDeviceParams *)param)->deviceName << " died.");
+        return 0;
+    }
+
     try {
         while (true) {
             NDNDeviceAdapter ndnDeviceAdapt(((NDNDeviceAdapter::NDNDeviceParams *)param)->deviceName);
@@ -42,6 +50,31 @@ void *startDeviceThread(void *param)
 
 NDNAdhocNetDeviceFace::NDNAdhocNetDeviceFace(std::string deviceNameP)
     : NDNFace()
+{
+    Init(deviceNameP, NULL);
+
+    sleep(2); //is not the best way to do it, but for now it works. we wait a while to see if ndnDeviceAdatper is still on
+
+    int ret = pthread_kill(NDNDeviceAdapterT, 0);
+    if (ret == ESRCH) {
+        void *res;
+        pthread_join(NDNDeviceAdapterT, &res);
+        throw NDNLinkLayerCommunication("NDNAdhocNetDeviceFace thread died");
+    }
+
+    NS_LOG_DEBUG("eventfd: " << m_app_fd);
+}
+
+NDNAdhocNetDeviceFace::NDNAdhocNetDeviceFace(NDNDeviceAdapter *adapter)
+    : NDNFace()
+{
+    //the adapter already exists, there is no risk that its creation fails in the new thread
+    Init(adapter->getDeviceName(), adapter);
+
+    NS_LOG_DEBUG("eventfd: " << m_app_fd);
+}
+
+void NDNAdhocNetDeviceFace::Init(std::string deviceNameP, NDNDeviceAdapter *adapter)
 {
     deviceName = deviceNameP;
     m_app_fd = ::eventfd(0, EFD_SEMAPHORE);
@@ -60,6 +93,7 @@ NDNAdhocNetDeviceFace::NDNAdhocNetDeviceFace(std::string deviceNameP)
 
     param.outgoingEventFd = outgoingPktTrigger;
     param.deviceName = deviceName;
+    param.adapter = adapter;
     param.numEl = LLUpperLayerCommunicationService::NDNDevicePktExchangeSize;
     //TODO check is NDNPktSharedWithDeviceAdapter is already initialize
     param.incomingSharedMemoryPtr = &NDNIncomingPktSharedWithDeviceAdapter[0];
@@ -75,6 +109,8 @@ NDNAdhocNetDeviceFace::NDNAdhocNetDeviceFace(std::string deviceNameP)
             err += strerror(errno);
             throw NDNLinkLayerCommunication(err);
         }
+        NDNOutgoingPktSharedWithDeviceAdapter[i].used = false;
+        NDNIncomingPktSharedWithDeviceAdapter[i].used = false;
     }
     incomingPktSharedMemoryIndex = 0;
     outgoingPktSharedMemoryIndex = 0;
@@ -87,17 +123,6 @@ NDNAdhocNetDeviceFace::NDNAdhocNetDeviceFace(std::string deviceNameP)
         err += strerror(errno);
         throw NDNLinkLayerCommunication(err);
     }
-
-    sleep(2); //is not the best way to do it, but for now it works. we wait a while to see if ndnDeviceAdatper is still on
-
-    int ret = pthread_kill(NDNDeviceAdapterT, 0);
-    if (ret == ESRCH) {
-        void *res;
-        pthread_join(NDNDeviceAdapterT, &res);
-        throw NDNLinkLayerCommunication("NDNAdhocNetDeviceFace thread died");
-    }
-
-    NS_LOG_DEBUG("eventfd: " << m_app_fd);
 }
 
 
@@ -118,6 +143,7 @@ bool NDNAdhocNetDeviceFace::Send(const Ptr<const Packet> &p)
             void *res;
             pthread_join(NDNDeviceAdapterT, &res);
         }
+        sem_post(&NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].mutex);
         return false;
     }
 
@@ -134,18 +160,26 @@ bool NDNAdhocNetDeviceFace::Send(const Ptr<const Packet> &p)
     } else {
         NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].metadata = NULL;
     }
-    *(p->llmetadata) = NULL;
     memcpy(NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].data, p->GetRawBuffer(), p->GetSize());
 
-    //release lock
-    sem_post(&NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].mutex);
-    outgoingPktSharedMemoryIndex = (outgoingPktSharedMemoryIndex + 1) % LLUpperLayerCommunicationService::NDNDevicePktExchangeSize;
+    //the adapter waits for the lock before taking the packet, so it is still ours until sem_post
     uint64_t u = 1;
     sent = write(outgoingPktTrigger, &u, sizeof(uint64_t));
     if (sent == -1) {
         NS_LOG_ERROR("Failed to send a trigger to NDNDeviceAdapter: " << strerror(errno));
+        //the slot is free again, and the metadata still belongs to the packet
+        NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].used = false;
+        NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].metadata = NULL;
+        sem_post(&NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].mutex);
         return false;
     }
+    //record it before the metadata is handed over to the adapter
+    TraceOutgoing(p);
+    *(p->llmetadata) = NULL;
+
+    //release lock
+    sem_post(&NDNOutgoingPktSharedWithDeviceAdapter[outgoingPktSharedMemoryIndex].mutex);
+    outgoingPktSharedMemoryIndex = (outgoingPktSharedMemoryIndex + 1) % LLUpperLayerCommunicationService::NDNDevicePktExchangeSize;
 
     NS_LOG_DEBUG("Packet sent to NDNDeviceAdapter");
     return true;
@@ -77,6 +77,16 @@ public:
     * */
     NDNAdhocNetDeviceFace(std::string deviceNameP);
 
+    /**
+     * /brief Creates a NDNAdhocNetDeviceFace on top of an already built NDNDeviceAdapter
+     *
+     * The adapter (e.g. running on an emulated NdnSocket) is run by a new thread, exactly as the one
+     * created by the other constructor, and it's never deleted. The face is named after the adapter device.
+     *
+     * \param adapter NDNDeviceAdapter that has to run the NDN-LAL for this face
+     * */
+    NDNAdhocNetDeviceFace(NDNDeviceAdapter *adapter);
+
     /**
      * \brief Read data from NDN-LAL, using the incoming shared memory
      *
@@ -98,6 +108,11 @@ public:
     virtual std::ostream &Print(std::ostream &os) const;
 
 private:
+    /**
+     * \brief Creates the eventfds and the shared memory, then starts the NDNDeviceAdapter thread
+     * */
+    void Init(std::string deviceNameP, NDNDeviceAdapter *adapter);
+
     /**Trigger (eventfd) used by netDeviceFace to signal to NDNDeviceAdapter that there is something ready stored in the shared memory */
     int outgoingPktTrigger;
     /**Name of the network interface associate to this ndn-face*/
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef NDN_BACK_REFERENCE_H
+#define NDN_BACK_REFERENCE_H
+
+#include <algorithm>
+#include <vector>
+#include <boost/intrusive/list.hpp>
+
+namespace vndn
+{
+
+typedef boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink> > NDNBackReferenceHook;
+
+/**
+ * \ingroup ndn
+ * \brief Intrusive link from a record (e.g. a PIT in/out record) back to the table entry that owns it
+ *
+ * The record embeds the link, which is put in the NDNBackReferenceList of the
+ * object the record refers to (e.g. the face). The link removes itself from
+ * the list when the record is destroyed, so the lists never need to be
+ * updated when the tables erase records or whole entries.
+ *
+ * A copy is never linked: the records are copied only when they are inserted
+ * in their containers, the copy is linked afterwards.
+ */
+template <typename Entry>
+class NDNBackReference : public NDNBackReferenceHook
+{
+public:
+    NDNBackReference()
+        : m_entry(0)
+    { }
+
+    NDNBackReference(const NDNBackReference &)
+        : NDNBackReferenceHook()
+        , m_entry(0)
+    { }
+
+    NDNBackReference &operator=(const NDNBackReference &)
+    {
+        return *this;
+    }
+
+    const Entry *GetEntry() const {
+        return m_entry;
+    }
+
+private:
+    template <typename> friend class NDNBackReferenceList;
+
+    const Entry *m_entry;
+};
+
+/**
+ * \ingroup ndn
+ * \brief List of the table entries that hold a reference to an object
+ *
+ * Linking and unlinking are O(1). A copy of the list is always empty.
+ */
+template <typename Entry>
+class NDNBackReferenceList
+{
+public:
+    NDNBackReferenceList() { }
+
+    NDNBackReferenceList(const NDNBackReferenceList &)
+    { }
+
+    NDNBackReferenceList &operator=(const NDNBackReferenceList &)
+    {
+        return *this;
+    }
+
+    /**
+     * \brief Links \p reference, embedded in a record owned by \p entry
+     */
+    void Link(NDNBackReference<Entry> &reference, const Entry *entry)
+    {
+        reference.unlink();
+        reference.m_entry = entry;
+        m_list.push_back(reference);
+    }
+
+    bool IsEmpty() const {
+        return m_list.empty();
+    }
+
+    /**
+     * \brief Returns the entries without duplicates, they can be modified or erased afterwards
+     */
+    std::vector<const Entry *> GetEntries() const
+    {
+        std::vector<const Entry *> entries;
+        for (typename List::const_iterator it = m_list.begin(); it != m_list.end(); ++it)
+            entries.push_back(it->GetEntry());
+        std::sort(entries.begin(), entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+        return entries;
+    }
+
+private:
+    typedef boost::intrusive::list<NDNBackReference<Entry>, boost::intrusive::constant_time_size<false> > List;
+
+    List m_list;
+};
+
+} // namespace vndn
+
+#endif /* NDN_BACK_REFERENCE_H */
@@ -27,6 +27,7 @@
 #include "corelib/assert.h"
 #include "corelib/singleton.h"
 #include "daemon/ndn-l3-protocol.h"
+#include "daemon/ndn-trace.h"
 #include "helper/event-monitor.h"
 #include "network/packet.h"
 
@@ -89,6 +90,7 @@ bool NDNFace::Send(const Ptr<const Packet> &p)
         return false;
     } else {
         NS_LOG_INFO("Sent " << sent << " bytes through fd " << m_app_fd);
+        TraceOutgoing(p);
         return true;
     }
 }
@@ -102,14 +104,24 @@ bool NDNFace::Receive(const Ptr<const Packet> &packet)
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    /// \todo Implement tracing, if requested
+    NDNL3Protocol *protocol = Singleton<NDNL3Protocol>::Get();
+    NDNTraceWriter *trace = protocol->GetTraceWriter();
+    if (trace != NULL)
+        trace->Write(NDNTraceRecord::INCOMING, getMonitorFd(), packet);
 
-    Singleton<NDNL3Protocol>::Get()->Receive(this, packet);
+    protocol->Receive(this, packet);
     //m_protocolHandler (this, packet);
 
     return true;
 }
 
+void NDNFace::TraceOutgoing(const Ptr<const Packet> &p)
+{
+    NDNTraceWriter *trace = Singleton<NDNL3Protocol>::Get()->GetTraceWriter();
+    if (trace != NULL)
+        trace->Write(NDNTraceRecord::OUTGOING, getMonitorFd(), p);
+}
+
 void NDNFace::LeakBucket()
 {
     if (m_lastLeakTime == not_a_date_time) {
@@ -187,7 +199,7 @@ void NDNFace::readHandler(EventMonitor &daemon)
         Singleton<NDNL3Protocol>::Get()->RemoveFace(this);
     } else {
         NS_LOG_INFO("Got a packet of size " << newPacket->GetSize());
-        Singleton<NDNL3Protocol>::Get()->Receive(this, newPacket);
+        Receive(newPacket);
     }
 }
 
@@ -29,12 +29,15 @@
 #include "corelib/ptr.h"
 #include "helper/monitorable.h"
 #include "network/request-source-info.h"
+#include "ndn-back-reference.h"
 
 
 namespace vndn
 {
 
 class EventMonitor;
+class NDNFibEntry;
+class NDNPitEntry;
 class Packet;
 
 /**
@@ -99,7 +102,7 @@ public:
     /**
      * \brief Receive packet from application or another node and forward it to the NDN stack
      *
-     * \todo The only reason for this call is to handle tracing, if requested
+     * The packet is recorded in the trace, if tracing is enabled in NDNL3Protocol.
      */
     virtual bool Receive(const Ptr<const Packet> &p);
 
@@ -151,12 +154,33 @@ public:
      */
     bool operator<(const NDNFace &face) const;
 
+    /**
+     * \brief PIT entries with an incoming or outgoing record for this face
+     */
+    NDNBackReferenceList<NDNPitEntry> &GetPitEntries() {
+        return m_pitEntries;
+    }
+
+    /**
+     * \brief FIB entries with this face as next hop
+     */
+    NDNBackReferenceList<NDNFibEntry> &GetFibEntries() {
+        return m_fibEntries;
+    }
 
 private:
     NDNFace(const NDNFace &); ///< \brief Disabled copy constructor
     NDNFace &operator=(const NDNFace &); ///< \brief Disabled copy operator
 
 protected:
+    /**
+     * \brief Records a packet sent by this face, if tracing is enabled in NDNL3Protocol
+     *
+     * The subclasses that override Send() must call it after a successful transmission.
+     * Received packets are recorded by Receive().
+     */
+    void TraceOutgoing(const Ptr<const Packet> &p);
+
     int m_app_fd;
     // uint16_t m_metric; ///< \brief Routing/forwarding metric
     double m_bucket;     ///< \brief Value representing current size of the Interest allowance for this face
@@ -166,6 +190,9 @@ protected:
 private:
     boost::posix_time::ptime m_lastLeakTime;
     uint32_t m_metric; ///< \brief metric of the face
+
+    NDNBackReferenceList<NDNPitEntry> m_pitEntries; ///< \brief lets RemoveFace() touch only the entries that reference the face
+    NDNBackReferenceList<NDNFibEntry> m_fibEntries;
 };
 
 std::ostream &operator<<(std::ostream &os, const NDNFace &face);
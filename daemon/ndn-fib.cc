@@ -78,7 +78,8 @@ void NDNFibEntry::AddOrUpdateRoutingMetric(Ptr<NDNFace> face, int32_t metric)
 
     NDNFibFaceMetricByFace::type::iterator record = m_faces.get<i_face> ().find (face);
     if (record == m_faces.get<i_face> ().end()) {
-        m_faces.insert (NDNFibFaceMetric (face, metric));
+        record = m_faces.insert (NDNFibFaceMetric (face, metric)).first;
+        face->GetFibEntries().Link(record->m_faceReference, this);
     } else {
         m_faces.modify(record, (&ll::_1)->* &NDNFibFaceMetric::m_routingCost = metric);
     }
@@ -186,8 +187,10 @@ void NDNFib::RemoveFromAll(Ptr<NDNFace> face)
 {
     NS_LOG_FUNCTION(*face);
 
-    for_each (m_fib.begin (), m_fib.end (),
-              ll::bind (&NDNFib::Remove, this, ll::_1, face));
+    // the list is copied, Remove() unlinks the records and can erase the entries
+    BOOST_FOREACH(const NDNFibEntry *entry, face->GetFibEntries().GetEntries()) {
+        Remove(*entry, face);
+    }
 }
 
 /**
@@ -103,6 +103,8 @@ private:
 
     int32_t m_routingCost;  ///< \brief routing protocol cost (interpretation of the value depends on the underlying routing protocol)
 
+    mutable NDNBackReference<NDNFibEntry> m_faceReference; ///< \brief link in the FIB entries list of m_face
+
     boost::posix_time::time_duration m_sRtt;   ///< \brief smoothed round-trip time
     boost::posix_time::time_duration m_rttVar; ///< \brief round-trip time variation
 };
@@ -202,6 +204,7 @@ private:
     Ptr<NameComponents> m_prefix;               ///< \brief Prefix of the FIB entry
 public: // FIXME
     NDNFibFaceMetricContainer::type m_faces;    ///< \brief Indexed list of faces
+    mutable NDNBackReferenceList<NDNPitEntry> m_pitEntries; ///< \brief PIT entries created with this FIB entry
 
 private:
     bool m_needsProbing;      ///< \brief flag indicating that probing should be performed
@@ -284,6 +287,8 @@ public:
     /**
      * @brief Remove all references to a face from FIB.  If for some enty that face was the only element,
      * this FIB entry will be removed.
+     *
+     * Only the entries in the FIB list of the face are visited.
      */
     void RemoveFromAll(Ptr<NDNFace> face);
 
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "ndn-geo-strategy.h"
+#include "ndn-adhoc-net-device-face.h"
+#include "ndn-l3-protocol.h"
+#include "network/ndn-interest-header.h"
+#include "network/ndn-name-components.h"
+#include "network/mac/ll-header.h"
+#include "network/mac/ll-metadata-80211-adhoc.h"
+#include "pit/ndn-pit.h"
+#include "pit/ndn-pit-entry.h"
+#include "utils/geo/distance-kernels.h"
+#include "corelib/log.h"
+#include "corelib/singleton.h"
+
+#include <cstdlib>
+#include <list>
+#include <string>
+
+#include <boost/foreach.hpp>
+#include <boost/lambda/lambda.hpp>
+#include <boost/lambda/bind.hpp>
+
+namespace ll = boost::lambda;
+
+NS_LOG_COMPONENT_DEFINE("NDNGeoStrategy");
+
+namespace vndn
+{
+
+using namespace __ndn_private;
+
+// types of service whose second component is the destination, as in apps/traffic-app.h and apps/photo-app.h
+static const char *const GEO_SERVICES[] = {"traffic", "photo-traffic"};
+
+static bool IsValid(const GeoStorage &position)
+{
+    return position.getLat() != DEFAULT_COORDINATE_DOUBLE && position.getLongitude() != DEFAULT_COORDINATE_DOUBLE;
+}
+
+static bool IsAdhoc(const Ptr<NDNFace> &face)
+{
+    return dynamic_cast<NDNAdhocNetDeviceFace *>(PeekPointer(face)) != NULL;
+}
+
+NDNGeoStrategy::NDNGeoStrategy()
+    : m_forwarded(0)
+    , m_suppressed(0)
+    , m_flooded(0)
+{
+}
+
+bool NDNGeoStrategy::GetDestination(const NameComponents &name, double &lat, double &lon)
+{
+    const std::list<std::string> &components = name.GetComponents();
+    if (components.size() < 2)
+        return false;
+    std::list<std::string>::const_iterator it = components.begin();
+    bool geoService = false;
+    for (size_t i = 0; i < sizeof(GEO_SERVICES) / sizeof(GEO_SERVICES[0]); i++)
+        geoService = geoService || *it == GEO_SERVICES[i];
+    if (!geoService)
+        return false;
+
+    // "<lat>,<lon>", as written by Coordinate::toString
+    const char *position = (++it)->c_str();
+    char *end;
+    lat = strtod(position, &end);
+    if (end == position || *end != ',')
+        return false;
+    position = end + 1;
+    lon = strtod(position, &end);
+    if (end == position || *end != '\0')
+        return false;
+    return lat >= -90 && lat <= 90 && lon >= -180 && lon <= 180;
+}
+
+bool NDNGeoStrategy::PropagateInterest(const NDNPitEntry  &pitEntry,
+                                       const Ptr<NDNFace> &incomingFace,
+                                       const Ptr<const InterestHeader> &header,
+                                       const Ptr<const Packet> &packet)
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    // only the interests received from an ad-hoc face carry the positions
+    LLMetadata80211AdHoc *metadata = NULL;
+    if (packet->llmetadataptr != NULL && packet->llmetadataptr->getRequestSourceInfoType() == OVER_ADHOC)
+        metadata = static_cast<LLMetadata80211AdHoc *>(packet->llmetadataptr);
+
+    bool rebroadcast = true;
+    double lat, lon;
+    if (metadata != NULL) {
+        const GeoStorage &previousHop = metadata->getPreviousHopInfo();
+        const GeoStorage &local = metadata->getLocalInfo();
+        if (GetDestination(*header->GetName(), lat, lon) && IsValid(previousHop) && IsValid(local)) {
+            const double lats[2] = {previousHop.getLat(), local.getLat()};
+            const double lons[2] = {previousHop.getLongitude(), local.getLongitude()};
+            double distances[2];
+            geo::haversineDistances(lat, lon, lats, lons, 2, distances);
+            const double progress = distances[0] - distances[1];
+            NS_LOG_DEBUG("Distance from the destination: previous hop " << distances[0] << ", local node " << distances[1]);
+            if (progress > 0) {
+                metadata->setProgress(progress);
+                m_forwarded++;
+            } else {
+                NS_LOG_INFO("Not closer to the destination than the previous hop, the interest is not rebroadcast.");
+                rebroadcast = false;
+                m_suppressed++;
+            }
+        } else {
+            m_flooded++;
+        }
+    }
+
+    // Try to work out with just green faces
+    if (rebroadcast && PropagateInterestViaGreen(pitEntry, incomingFace, header, packet))
+        return true;
+
+    std::list<Ptr<NDNFace> > faces;
+    if (pitEntry.m_fibEntry) {
+        BOOST_FOREACH(const NDNFibFaceMetric & metricFace, pitEntry.m_fibEntry->m_faces.get<i_metric>()) {
+            if (metricFace.GetStatus() != NDNFibFaceMetric::NDN_FIB_RED)
+                faces.push_back(metricFace.GetFace());
+        }
+    } else {
+        const std::vector<Ptr<NDNFace> > &allFaces = Singleton<NDNL3Protocol>::Get()->GetAllFaces();
+        for (std::vector<Ptr<NDNFace> >::const_iterator it = allFaces.begin(); it != allFaces.end(); ++it)
+            faces.push_back(*it);
+    }
+
+    int propagatedCount = 0;
+    for (std::list<Ptr<NDNFace> >::iterator face = faces.begin(); face != faces.end(); ++face) {
+        if (!rebroadcast && IsAdhoc(*face))
+            continue;
+        if (!(*face)->IsBelowLimit())
+            continue;
+
+        m_pit->modify(m_pit->iterator_to(pitEntry), ll::bind(&NDNPitEntry::AddOutgoing, ll::_1, *face));
+        (*face)->Send(packet);
+        propagatedCount++;
+    }
+
+    if (!rebroadcast && *(packet->llmetadata) != NULL) {
+        // no ad-hoc face has taken the metadata over
+        delete *(packet->llmetadata);
+        *(packet->llmetadata) = NULL;
+    }
+
+    NS_LOG_INFO("Propagated to " << propagatedCount << " faces.");
+    return propagatedCount > 0;
+}
+
+} //namespace vndn
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef NDN_GEO_STRATEGY_H
+#define NDN_GEO_STRATEGY_H
+
+#include "ndn-forwarding-strategy.h"
+
+#include <stdint.h>
+
+namespace vndn
+{
+
+class NDNFace;
+class InterestHeader;
+class NameComponents;
+
+/**
+ * \ingroup ndn
+ * \brief Geo-directional forwarding strategy
+ *
+ * The traffic and photo applications put the position they are interested in
+ * after the type of service: /traffic/<lat>,<lon>/... and /photo-traffic/<lat>,<lon>/...
+ * When such an interest is received from an ad-hoc face, it is rebroadcast
+ * only if the local node is closer to that destination than the previous hop,
+ * whose position is in the LLMetadata80211AdHoc of the packet together with
+ * the one of the local node. The progress towards the destination is passed
+ * to the link layer, which transmits sooner the larger it is, so that the
+ * node that makes the most progress usually goes first and its transmission
+ * acks the pending copies of the other ones.
+ *
+ * The local faces always receive the interest. The interests without
+ * a destination, or without valid positions, are flooded as by NDNFloodingStrategy.
+ */
+class NDNGeoStrategy : public NDNForwardingStrategy
+{
+public:
+
+    /**
+     * @brief Default constructor
+     */
+    NDNGeoStrategy ();
+
+    // inherited from  NDNForwardingStrategy
+    virtual bool
+    PropagateInterest (const NDNPitEntry  &pitEntry,
+                       const Ptr<NDNFace> &incomingFace,
+                       const Ptr<const InterestHeader> &header,
+                       const Ptr<const Packet> &packet);
+
+    /**
+     * @brief Extracts the destination from a /traffic/ or /photo-traffic/ name
+     *
+     * @return false if the name has no destination
+     */
+    static bool
+    GetDestination (const NameComponents &name, double &lat, double &lon);
+
+    /**
+     * @brief Number of interests rebroadcast because the local node is closer to the destination
+     */
+    uint64_t GetForwardedCount () const { return m_forwarded; }
+
+    /**
+     * @brief Number of interests not rebroadcast because the local node is not closer to the destination
+     */
+    uint64_t GetSuppressedCount () const { return m_suppressed; }
+
+    /**
+     * @brief Number of interests flooded because the destination or the positions are unknown
+     */
+    uint64_t GetFloodedCount () const { return m_flooded; }
+
+private:
+    uint64_t m_forwarded;
+    uint64_t m_suppressed;
+    uint64_t m_flooded;
+};
+
+} //namespace vndn
+
+#endif /* NDN_GEO_STRATEGY_H */
@@ -100,6 +100,7 @@ bool NDNHubOverIPDeviceFace::Send(const Ptr<const Packet> &p, RequestSourceInfo
         NS_LOG_INFO("Sent a packet over IP, length = " << sent << ", dest = " << addr);
     }
 
+    TraceOutgoing(p);
     return true;
 }
 
@@ -30,6 +30,7 @@
 #include "ndn-face.h"
 #include "ndn-forwarding-strategy.h"
 #include "ndn-net-device-face.h"
+#include "ndn-trace.h"
 #include "helper/ndn-header-helper.h"
 #include "helper/event-monitor.h"
 #include "network/packet.h"
@@ -56,6 +57,23 @@ namespace vndn
 const uint16_t NDNL3Protocol::ETHERNET_FRAME_TYPE = 0x7777;
 const struct timeval NDNL3Protocol::REAP_INTERVAL = {10, 0}; // Reap expired interests every 10 seconds
 
+static __thread NDNL3Protocol *g_threadInstance = 0;
+
+template <>
+NDNL3Protocol *Singleton<NDNL3Protocol>::Get(void)
+{
+    if (g_threadInstance != 0)
+        return g_threadInstance;
+
+    static NDNL3Protocol object;
+    return &object;
+}
+
+void NDNL3Protocol::SetThreadInstance(NDNL3Protocol *protocol)
+{
+    g_threadInstance = protocol;
+}
+
 NDNL3Protocol::NDNL3Protocol()
     : m_cacheUnsolicitedData(true)
     , m_nacksEnabled(false)
@@ -68,6 +86,11 @@ NDNL3Protocol::NDNL3Protocol()
     m_pit->SetFib(m_fib);
 }
 
+void NDNL3Protocol::SetTraceWriter(Ptr<NDNTraceWriter> writer)
+{
+    m_traceWriter = writer;
+}
+
 NDNL3Protocol::~NDNL3Protocol()
 {
     NS_LOG_FUNCTION_NOARGS();
@@ -95,22 +118,24 @@ uint32_t NDNL3Protocol::AddFace(const Ptr<NDNFace> &face)
 
 void NDNL3Protocol::TrimPitEntriesAssociatedWithFace(Ptr<NDNFace> face)
 {
-    std::list<boost::reference_wrapper<const NDNPitEntry> > entriesToRemoves;
-    BOOST_FOREACH(const NDNPitEntry & pitEntry, *m_pit) {
-        m_pit->modify(m_pit->iterator_to(pitEntry),
+    // only the entries that reference the face are visited, not the whole PIT
+    BOOST_FOREACH(const NDNPitEntry *pitEntry, face->GetPitEntries().GetEntries()) {
+        m_pit->modify(m_pit->iterator_to(*pitEntry),
                       ll::bind(&NDNPitEntry::RemoveAllReferencesToFace, ll::_1, face));
+    }
 
-        // If this face is the only for the associated FIB entry, then FIB entry will be removed.
-        // Thus, we have to remove the whole PIT entry
-        if (pitEntry.m_fibEntry &&
-                pitEntry.m_fibEntry->m_faces.size() == 1 &&
-                pitEntry.m_fibEntry->m_faces.begin()->GetFace() == face) {
-            entriesToRemoves.push_back(boost::cref(pitEntry));
+    // If this face is the only for the associated FIB entry, then FIB entry will be removed.
+    // Thus, we have to remove the whole PIT entry
+    std::vector<const NDNPitEntry *> entriesToRemove;
+    BOOST_FOREACH(const NDNFibEntry *fibEntry, face->GetFibEntries().GetEntries()) {
+        if (fibEntry->m_faces.size() == 1) {
+            std::vector<const NDNPitEntry *> pitEntries = fibEntry->m_pitEntries.GetEntries();
+            entriesToRemove.insert(entriesToRemove.end(), pitEntries.begin(), pitEntries.end());
         }
     }
 
-    BOOST_FOREACH(const NDNPitEntry & removedEntry, entriesToRemoves) {
-        m_pit->erase(m_pit->iterator_to(removedEntry));
+    BOOST_FOREACH(const NDNPitEntry *removedEntry, entriesToRemove) {
+        m_pit->erase(m_pit->iterator_to(*removedEntry));
     }
 }
 
@@ -541,6 +566,10 @@ void NDNL3Protocol::Reap(int fd, short events, void *args)
     //NS_LOG_DEBUG("-------------PIT after reaping---------------");
     //pit->Print();
 
+    // do not keep the tail of the trace in memory when there is little traffic
+    if (protocol->m_traceWriter != 0)
+        protocol->m_traceWriter->Flush();
+
     // schedule next Reap timer
     EventMonitor *em = (EventMonitor *)args;
     em->addTimer(&NDNL3Protocol::Reap, em, &NDNL3Protocol::REAP_INTERVAL);
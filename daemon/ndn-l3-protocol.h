@@ -24,6 +24,7 @@
 
 #include "corelib/ptr.h"
 #include "corelib/simple-ref-count.h"
+#include "corelib/singleton.h"
 
 #include <stdint.h>
 #include <vector>
@@ -40,6 +41,7 @@ class NDNFibEntry;
 class NDNFib;
 class NDNPitEntry;
 class NDNPit;
+class NDNTraceWriter;
 class NDNFace;
 class NDNForwardingStrategy;
 class Packet;
@@ -77,6 +79,16 @@ public:
      */
     static void Reap(int fd, short events, void *args);
 
+    /**
+     * \brief Binds a stack to the calling thread
+     *
+     * From then on Singleton<NDNL3Protocol>::Get() returns \p protocol when called
+     * from this thread, which allows several independent daemons to run in the same
+     * process, one per thread (see the link-layer emulator). Passing NULL restores
+     * the process-wide instance.
+     */
+    static void SetThreadInstance(NDNL3Protocol *protocol);
+
     /**
      * \brief Returns the fib
      */
@@ -90,6 +102,16 @@ public:
     Ptr<NDNForwardingStrategy> GetForwardingStrategy() const;
     void SetForwardingStrategy(Ptr<NDNForwardingStrategy> forwardingStrategy);
 
+    /**
+     * \brief Returns the writer that captures the packets of all faces, or NULL if tracing is disabled
+     */
+    NDNTraceWriter *GetTraceWriter() const { return PeekPointer(m_traceWriter); }
+
+    /**
+     * \brief Enables packet capture (or disables it, if \p writer is null)
+     */
+    void SetTraceWriter(Ptr<NDNTraceWriter> writer);
+
     uint32_t AddFace(const Ptr<NDNFace> &face);
     void RemoveFace(Ptr<NDNFace> face);
     Ptr<NDNFace> GetFace(uint32_t face) const;
@@ -192,11 +214,19 @@ private:
     Ptr<NDNPit> m_pit;                ///< \brief PIT (pending interest table)
     Ptr<NDNFib> m_fib;                ///< \brief FIB
     Ptr<ContentStore> m_contentStore; ///< \brief Content store (for caching purposes only)
+    Ptr<NDNTraceWriter> m_traceWriter; ///< \brief packet capture, null when disabled
 
     bool m_cacheUnsolicitedData;
     bool m_nacksEnabled;
 };
 
+/**
+ * \brief Returns the stack bound to the calling thread by NDNL3Protocol::SetThreadInstance(),
+ *        or the process-wide one if there is none
+ */
+template <>
+NDNL3Protocol *Singleton<NDNL3Protocol>::Get(void);
+
 }
 
 #endif /* NDN_L3_PROTOCOL_H */
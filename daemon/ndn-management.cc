@@ -21,8 +21,13 @@
 #include "ndn-l3-protocol.h"
 #include "ndn-fib.h"
 #include "ndn-management.h"
-#include "network/buffer.h"
 
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <boost/foreach.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/scoped_ptr.hpp>
 
@@ -39,10 +44,21 @@ NS_LOG_COMPONENT_DEFINE ("NDNManagementInterface");
 namespace vndn
 {
 
+const size_t NDNManagementInterface::MAX_MESSAGE_SIZE = 64 * 1024;
+const unsigned int NDNManagementInterface::MAX_BATCH = 1024;
+
 NDNManagementInterface::NDNManagementInterface()
+    : m_current(NULL)
+    , m_wakeupPending(0)
 {
+    m_eventFd = ::eventfd(0, EFD_NONBLOCK);
+    if (m_eventFd == -1) {
+        NS_LOG_ERROR("Failed to create eventfd for the management commands: " << strerror(errno));
+        throw "eventfd error";
+    }
+
     message_queue::remove(MANAGEMENT_QUEUE);
-    management_queue.reset(new message_queue(create_only,MANAGEMENT_QUEUE,MANAGEMENT_QUEUE_SIZE,BUFLEN)); //instance message_queue trought boost scoped pointers
+    management_queue.reset(new message_queue(create_only,MANAGEMENT_QUEUE,MANAGEMENT_QUEUE_SIZE,MAX_MESSAGE_SIZE)); //instance message_queue trought boost scoped pointers
     StartInternalThread();
     NS_LOG_INFO("Management Thread Started");
 }
@@ -51,10 +67,17 @@ NDNManagementInterface::~NDNManagementInterface()
 {
     try {
         pthread_cancel(_thread);
+        pthread_join(_thread, NULL);
         message_queue::remove(MANAGEMENT_QUEUE);
     } catch(boost::interprocess::interprocess_exception) {
         NS_LOG_ERROR("Failed to stop thread and/or remove message_queue");
     }
+
+    delete m_current;
+    Command *command;
+    while (m_commands.Pop(command))
+        delete command;
+    ::close(m_eventFd);
     NS_LOG_INFO("Management Thread Stopped");
 }
 
@@ -69,43 +92,136 @@ bool NDNManagementInterface::StartInternalThread()
     return (pthread_create(&_thread, NULL, InternalThreadEntryFunc, this) == 0);
 }
 
-void NDNManagementInterface::prefixRegistration(ptree forwarding_entry)
+int NDNManagementInterface::getMonitorFd() const
 {
-    Ptr<NDNFib> m_fib = Singleton<NDNL3Protocol>::Get()->GetFib();
-    Ptr<NDNFace> m_face = Singleton<NDNL3Protocol>::Get()->GetFace(forwarding_entry.get<uint32_t>("faceID"));
-    NameComponents prefix(forwarding_entry.get<std::string>("Name"));
-    if (m_face == 0) {
-        NS_LOG_ERROR(forwarding_entry.get<uint32_t>("faceID") << "not found");
-    }
+    return m_eventFd;
+}
+
+NDNManagementInterface::Command *NDNManagementInterface::prefixRegistration(const ptree &forwarding_entry)
+{
+    // all the fields are parsed before the command is allocated: a ptree_error leaves nothing behind
+    const std::string action = forwarding_entry.get<std::string>("Action");
+    const uint32_t faceId = forwarding_entry.get<uint32_t>("faceID");
+    Command::Action type;
     //for now selfreg and prefixreg are the same as we only register prefixes on the local face
-    if (forwarding_entry.get<std::string>("Action") == "selfreg" || forwarding_entry.get<std::string>("Action") == "prefixreg") {
-        m_fib->Add(prefix,m_face,LOCAL_FACE_METRIC);
-    } else if (forwarding_entry.get<std::string>("Action") == "unreg") {
-        if (m_fib->RemovePrefix(prefix,m_face) < 0) {
-            NS_LOG_ERROR(prefix << " is not a registered prefix in the ndn daemon");
+    if (action == "selfreg" || action == "prefixreg") {
+        type = Command::REGISTER;
+    } else if (action == "unreg") {
+        type = Command::UNREGISTER;
+    } else {
+        NS_LOG_WARN("Unsupported Action " << action << " for " << forwarding_entry.get<std::string>("ServiceType"));
+        return NULL;
+    }
+
+    // the names are parsed here, the forwarding thread only has to update the FIB
+    std::vector<NameComponents> prefixes;
+    boost::optional<const ptree &> names = forwarding_entry.get_child_optional("Names");
+    if (names) {
+        prefixes.reserve(names->size());
+        BOOST_FOREACH(const ptree::value_type &name, *names) {
+            prefixes.push_back(NameComponents(name.second.data()));
         }
     } else {
-        NS_LOG_WARN("Unsupported Action " << forwarding_entry.get<std::string>("Action") << " for " << forwarding_entry.get<std::string>("ServiceType"));
+        prefixes.push_back(NameComponents(forwarding_entry.get<std::string>("Name")));
+    }
+
+    Command *command = new Command;
+    command->action = type;
+    command->faceId = faceId;
+    command->prefixes.swap(prefixes);
+    command->applied = 0;
+    return command;
+}
+
+void NDNManagementInterface::post(Command *command)
+{
+    m_commands.Push(command);
+
+    // a single wakeup is enough for any number of commands posted before the loop runs
+    if (__sync_bool_compare_and_swap(&m_wakeupPending, 0, 1)) {
+        uint64_t u = 1;
+        if (::write(m_eventFd, &u, sizeof(u)) < 0)
+            NS_LOG_ERROR("Failed to wake up the forwarding thread: " << strerror(errno));
+    }
+}
+
+size_t NDNManagementInterface::apply(Command &command, size_t budget)
+{
+    NDNL3Protocol *protocol = Singleton<NDNL3Protocol>::Get();
+    Ptr<NDNFib> fib = protocol->GetFib();
+    Ptr<NDNFace> face = protocol->GetFace(command.faceId);
+    if (face == 0) {
+        NS_LOG_ERROR(command.faceId << " not found");
+        command.applied = command.prefixes.size();
+        return 0;
+    }
+
+    size_t count = 0;
+    for (; command.applied < command.prefixes.size() && count < budget; command.applied++, count++) {
+        const NameComponents &prefix = command.prefixes[command.applied];
+        if (command.action == Command::REGISTER) {
+            fib->Add(prefix, face, LOCAL_FACE_METRIC);
+        } else if (fib->RemovePrefix(prefix, face) < 0) {
+            NS_LOG_ERROR(prefix << " is not a registered prefix in the ndn daemon");
+        }
+    }
+    return count;
+}
+
+void NDNManagementInterface::readHandler(EventMonitor &)
+{
+    uint64_t u;
+    if (::read(m_eventFd, &u, sizeof(u)) < 0 && errno != EAGAIN)
+        NS_LOG_ERROR("Failed to read the management eventfd: " << strerror(errno));
+    // from now on, new commands must wake us up again
+    __sync_lock_release(&m_wakeupPending);
+    __sync_synchronize();
+
+    // apply a bounded batch, so that a huge registration does not stall forwarding
+    size_t budget = MAX_BATCH;
+    while (budget > 0) {
+        if (m_current == NULL && !m_commands.Pop(m_current))
+            break;
+        budget -= apply(*m_current, budget);
+        if (m_current->applied < m_current->prefixes.size())
+            break;
+        delete m_current;
+        m_current = NULL;
+    }
+    NS_LOG_INFO("Applied " << MAX_BATCH - budget << " management updates");
+
+    // there is more work: come back at the next loop iteration
+    if ((m_current != NULL || !m_commands.IsEmpty()) && __sync_bool_compare_and_swap(&m_wakeupPending, 0, 1)) {
+        u = 1;
+        if (::write(m_eventFd, &u, sizeof(u)) < 0)
+            NS_LOG_ERROR("Failed to reschedule the management commands: " << strerror(errno));
     }
 }
 
 void NDNManagementInterface::InternalThreadEntry()
 {
+    std::vector<char> buffer(MAX_MESSAGE_SIZE);
     for(;;) {
-        char buffer[BUFLEN];
         message_queue::size_type recvd_size;
         unsigned int priority;
-        management_queue->receive(buffer, BUFLEN, recvd_size, priority);
+        management_queue->receive(&buffer[0], buffer.size(), recvd_size, priority);
         NS_LOG_INFO("Message received from Management Thread");
 
-        std::istringstream is(buffer);
-        ptree container;
-        read_json(is, container);
-
-        if (container.get<std::string>("ServiceType") == "ForwardingEntry") {
-            prefixRegistration(container);
-        } else {
-            NS_LOG_WARN("Unsupported Action " << container.get<std::string>("Action") << " for " << container.get<std::string>("ServiceType"));
+        // a malformed message must not kill the thread (and the daemon)
+        try {
+            std::istringstream is(std::string(&buffer[0], recvd_size));
+            ptree container;
+            read_json(is, container);
+
+            if (container.get<std::string>("ServiceType") == "ForwardingEntry") {
+                Command *command = prefixRegistration(container);
+                if (command != NULL)
+                    post(command);
+            } else {
+                NS_LOG_WARN("Unsupported Action " << container.get<std::string>("Action") << " for " << container.get<std::string>("ServiceType"));
+            }
+        } catch (const boost::property_tree::ptree_error &e) {
+            NS_LOG_ERROR("Invalid management message: " << e.what());
         }
     }
 }
@@ -15,11 +15,19 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#ifndef NDN_MANAGEMENT_H
+#define NDN_MANAGEMENT_H
+
 #include <pthread.h>
+#include <vector>
 #include <boost/scoped_ptr.hpp>
 #include <boost/interprocess/ipc/message_queue.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include "corelib/mpsc-queue.h"
+#include "helper/monitorable.h"
+#include "network/ndn-name-components.h"
+
 
 using boost::property_tree::ptree;
 using namespace boost::interprocess;
@@ -33,14 +41,22 @@ namespace vndn
  *
  * - This class when instanced spawn a thread and wait for json messages using boost message queue
  * - The ServiceType field in the json message identify the type of service that need to be served, just add an if in the InternalThreadEntry loop with the new Service. Other fields are service specific
+ * - The thread only decodes the messages: the resulting commands are posted through a lock-free queue
+ *   to the EventMonitor loop, which applies them in batches (see readHandler()), so that the FIB and the
+ *   faces are only ever touched by the forwarding thread
  *
  * \see http://www.boost.org/doc/libs/1_48_0/doc/html/interprocess/synchronization_mechanisms.html#interprocess.synchronization_mechanisms.message_queue  for more information on Boost.Interprocess library
  */
-class NDNManagementInterface
+class NDNManagementInterface : public Monitorable
 {
 public:
+    static const size_t MAX_MESSAGE_SIZE;    ///< \brief maximum size of a json message, NDNProducer::registerNames splits the bigger registrations
+    static const unsigned int MAX_BATCH;     ///< \brief maximum number of prefixes applied per event loop iteration
+
     /**
      * \brief Public contructor spawn a posix thread and create the message_queue
+     *
+     * The object must be added to the EventMonitor of the daemon, or the commands are never applied.
      * */
     NDNManagementInterface();
     /**
@@ -48,8 +64,29 @@ public:
      */
     virtual ~NDNManagementInterface();
 
+    /**
+     * \brief Applies the pending commands, called by EventMonitor when the thread posts new ones
+     */
+    virtual void readHandler(EventMonitor &em);
+    virtual int getMonitorFd() const;
 
 private:
+    /**
+     * \brief A decoded management message, created by the management thread and applied by the forwarding one
+     */
+    struct Command
+    {
+        enum Action {
+            REGISTER,
+            UNREGISTER
+        };
+
+        Action action;
+        uint32_t faceId;
+        std::vector<NameComponents> prefixes;
+        size_t applied; ///< \brief number of prefixes already applied, a big command can span several batches
+    };
+
     /**
      * \brief utility method used for starting the pthread nicely
      * */
@@ -60,10 +97,22 @@ private:
      * json message structure for PrefixRegistration:
      * - Action: identify if it's needed to delete or register a prefix, maintained the CCNx names for actions
      * - Name: is the prefix name that we want to modify
+     * - Names: alternatively, an array of prefixes registered or unregistered with a single message (bulk registration)
      * - FaceID: is the face that need to serve Interest for the Name prefix (generally the LocalFace of the producer)
      * \param boost property tree result of the parsing of the json message
+     * \return the command to post, or NULL if the message is not valid
      * */
-    void prefixRegistration(ptree forwarding_entry);
+    Command *prefixRegistration(const ptree &forwarding_entry);
+
+    /**
+     * \brief Applies up to \p budget prefixes of the command, returns the number of prefixes applied
+     */
+    size_t apply(Command &command, size_t budget);
+
+    /**
+     * \brief Posts a command to the forwarding thread, called by the management thread
+     */
+    void post(Command *command);
 
     /**
      * \brief Function run in the thread, infinite loop that waits for messages
@@ -77,6 +126,13 @@ private:
 
     pthread_t _thread;
     boost::scoped_ptr<message_queue> management_queue;
+
+    MpscQueue<Command *> m_commands;
+    Command *m_current;         ///< \brief command partially applied by the last batch
+    int m_eventFd;              ///< \brief wakes up the EventMonitor loop when there are new commands
+    volatile int m_wakeupPending;
 };
 
 }
+
+#endif /* NDN_MANAGEMENT_H */
@@ -80,6 +80,7 @@ bool NDNNetDeviceFace::Send(const Ptr<const Packet> &p)
 
     std::string addr = std::string(inet_ntoa(m_si_other.sin_addr));
     NS_LOG_INFO("Sent a packet over IP, length = " << sent << ", dest = " << addr);
+    TraceOutgoing(p);
     return true;
 }
 
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+/*
+ * Replays a trace captured by "ndnd ... trace <file>".
+ *
+ * The packets received by the faces of the original daemon are fed, with
+ * their link-layer metadata, into a fresh NDNL3Protocol configured like ndnd,
+ * whose faces only count what the stack sends through them. The timing of the
+ * trace is reproduced at the original speed, at a multiple of it, or as fast
+ * as possible. At the end the packets sent on every face are compared with
+ * the ones recorded in the trace.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include "corelib/log.h"
+#include "corelib/singleton.h"
+#include "helper/event-monitor.h"
+#include "network/packet.h"
+#include "ndn-face.h"
+#include "ndn-fib.h"
+#include "ndn-flooding-strategy.h"
+#include "ndn-geo-strategy.h"
+#include "ndn-l3-protocol.h"
+#include "ndn-trace.h"
+
+using namespace vndn;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+
+static void usage()
+{
+    cout << "Usage: ./ndnReplay [-s <speed>] [-S <strategy>] [-o <file>] <trace>...\n"
+         << "  -s <speed>   replay speed: 1 is the original one (default), 10 is ten times\n"
+         << "               faster, 0 is as fast as possible\n"
+         << "  -S <name>    forwarding strategy, as in ndnd: flooding (default) or geo\n"
+         << "  -o <file>    write the JSON results to file instead of stdout\n"
+         << "The traces must be given from the oldest to the newest one, e.g.\n"
+         << "  ./ndnReplay ndnd.trace.3 ndnd.trace.2 ndnd.trace.1 ndnd.trace\n";
+}
+
+static int64_t MonotonicNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+
+/**
+ * \brief Face that stands for a face of the traced daemon, and counts the packets sent through it
+ */
+class ReplayFace : public NDNFace
+{
+public:
+    explicit ReplayFace(uint32_t id)
+        : m_recordedIn(0)
+        , m_recordedOut(0)
+        , m_replayedOut(0)
+        , m_replayedOutBytes(0)
+    {
+        m_app_fd = id;
+    }
+
+    virtual bool Send(const Ptr<const Packet> &p)
+    {
+        m_replayedOut++;
+        m_replayedOutBytes += p->GetSize();
+        return true;
+    }
+
+    virtual std::ostream &Print(std::ostream &os) const
+    {
+        os << "dev=replay(" << getMonitorFd() << ")";
+        return os;
+    }
+
+    uint64_t m_recordedIn;
+    uint64_t m_recordedOut;
+    uint64_t m_replayedOut;
+    uint64_t m_replayedOutBytes;
+};
+
+
+/**
+ * \brief Feeds the records of the traces to the stack, driven by EventMonitor timers
+ */
+class Replayer
+{
+public:
+    Replayer(const std::vector<string> &files, double speed, std::map<uint32_t, Ptr<ReplayFace> > &faces)
+        : m_files(files)
+        , m_nextFile(0)
+        , m_reader(NULL)
+        , m_speed(speed)
+        , m_faces(faces)
+        , m_haveRecord(false)
+        , m_traceStart(0)
+        , m_lastTimestamp(0)
+        , m_replayStart(0)
+        , m_em(0)
+        , m_records(0)
+        , m_injected(0)
+    {
+    }
+
+    ~Replayer()
+    {
+        delete m_reader;
+    }
+
+    void Start(EventMonitor &em)
+    {
+        m_em = &em;
+        m_haveRecord = ReadNext();
+        if (m_haveRecord)
+            m_traceStart = m_lastTimestamp = m_record.timestamp;
+        m_replayStart = MonotonicNow();
+        Schedule(0);
+    }
+
+    uint64_t GetRecordCount() const { return m_records; }
+    uint64_t GetInjectedCount() const { return m_injected; }
+    double GetTraceDuration() const { return (m_lastTimestamp - m_traceStart) / 1e9; }
+
+private:
+    static const unsigned int MAX_BATCH = 1000;
+
+    static void OnTimer(int, short, void *arg)
+    {
+        static_cast<Replayer *>(arg)->Run();
+    }
+
+    void Run()
+    {
+        const int64_t elapsed = MonotonicNow() - m_replayStart;
+        unsigned int batch = 0;
+
+        while (m_haveRecord) {
+            const int64_t due = Due(m_record.timestamp);
+            if (due > elapsed) {
+                Schedule(due - elapsed);
+                return;
+            }
+            Inject();
+            m_haveRecord = ReadNext();
+
+            // as fast as possible: give the Reap timer a chance every now and then
+            if (++batch == MAX_BATCH) {
+                Schedule(0);
+                return;
+            }
+        }
+
+        m_em->stop();
+    }
+
+    int64_t Due(int64_t timestamp) const
+    {
+        if (m_speed <= 0)
+            return 0;
+        return static_cast<int64_t>((timestamp - m_traceStart) / m_speed);
+    }
+
+    void Schedule(int64_t delay)
+    {
+        struct timeval timeout;
+        timeout.tv_sec = delay / 1000000000LL;
+        timeout.tv_usec = (delay % 1000000000LL) / 1000;
+        m_em->addTimer(&Replayer::OnTimer, this, &timeout);
+    }
+
+    void Inject()
+    {
+        Ptr<ReplayFace> face = m_faces[m_record.face];
+        m_lastTimestamp = m_record.timestamp;
+        if (m_record.direction == NDNTraceRecord::OUTGOING) {
+            face->m_recordedOut++;
+            return;
+        }
+
+        face->m_recordedIn++;
+        if (m_record.packet.empty())
+            return;
+        Ptr<Packet> packet = Packet::InitFromBuffer(&m_record.packet[0], m_record.packet.size());
+        packet->llmetadataptr = m_record.CreateMetadata();
+        packet->llmetadata = &(packet->llmetadataptr);
+        face->Receive(packet);
+        m_injected++;
+    }
+
+    bool ReadNext()
+    {
+        while (true) {
+            if (m_reader != NULL && m_reader->Next(m_record)) {
+                m_records++;
+                return true;
+            }
+            delete m_reader;
+            m_reader = NULL;
+            if (m_nextFile == m_files.size())
+                return false;
+            m_reader = new NDNTraceReader(m_files[m_nextFile++]);
+        }
+    }
+
+    std::vector<string> m_files;
+    size_t m_nextFile;
+    NDNTraceReader *m_reader;
+    double m_speed;
+    std::map<uint32_t, Ptr<ReplayFace> > &m_faces;
+
+    NDNTraceRecord m_record;
+    bool m_haveRecord;
+    int64_t m_traceStart;
+    int64_t m_lastTimestamp;
+    int64_t m_replayStart;
+    EventMonitor *m_em;
+
+    uint64_t m_records;
+    uint64_t m_injected;
+};
+
+
+int main(int argc, char **argv)
+{
+    double speed = 1.0;
+    string strategy("flooding");
+    string output;
+    std::vector<string> files;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "-s" && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        } else if (arg == "-S" && i + 1 < argc) {
+            strategy = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg.empty() || arg[0] == '-') {
+            usage();
+            return -1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty() || speed < 0 || (strategy != "flooding" && strategy != "geo")) {
+        usage();
+        return -1;
+    }
+
+    // the faces must exist before the first packet, as in the traced daemon
+    std::map<uint32_t, Ptr<ReplayFace> > faces;
+    try {
+        NDNTraceRecord record;
+        for (size_t i = 0; i < files.size(); i++) {
+            NDNTraceReader reader(files[i]);
+            while (reader.Next(record)) {
+                if (faces.find(record.face) == faces.end())
+                    faces[record.face] = Create<ReplayFace>(record.face);
+            }
+        }
+    } catch (const char *e) {
+        cerr << "Error: " << e << endl;
+        return 1;
+    }
+
+    NDNL3Protocol *protocol = Singleton<NDNL3Protocol>::Get();
+    if (strategy == "geo")
+        protocol->SetForwardingStrategy(Create<NDNGeoStrategy>());
+    else
+        protocol->SetForwardingStrategy(Create<NDNFloodingStrategy>());
+    protocol->SetFib(Create<NDNFib>());
+    for (std::map<uint32_t, Ptr<ReplayFace> >::iterator it = faces.begin(); it != faces.end(); ++it)
+        protocol->AddFace(it->second);
+
+    EventMonitor em;
+    em.addTimer(&NDNL3Protocol::Reap, &em, &NDNL3Protocol::REAP_INTERVAL);
+
+    Replayer replayer(files, speed, faces);
+    const int64_t start = MonotonicNow();
+    try {
+        replayer.Start(em);
+        em.monitor();
+    } catch (const char *e) {
+        cerr << "Error: " << e << endl;
+        return 1;
+    }
+    const double elapsed = (MonotonicNow() - start) / 1e9;
+
+    log::JsonLogger json;
+    json << log::JsonMapOpen
+         << "records" << static_cast<double>(replayer.GetRecordCount())
+         << "packetsInjected" << static_cast<double>(replayer.GetInjectedCount())
+         << "traceDuration" << replayer.GetTraceDuration()
+         << "replayDuration" << elapsed
+         << "packetsPerSecond" << (elapsed > 0 ? replayer.GetInjectedCount() / elapsed : 0.0)
+         << "faces" << log::JsonArrayOpen;
+    for (std::map<uint32_t, Ptr<ReplayFace> >::iterator it = faces.begin(); it != faces.end(); ++it) {
+        const ReplayFace &face = *it->second;
+        json << log::JsonMapOpen
+             << "id" << it->first
+             << "recordedIn" << static_cast<double>(face.m_recordedIn)
+             << "recordedOut" << static_cast<double>(face.m_recordedOut)
+             << "replayedOut" << static_cast<double>(face.m_replayedOut)
+             << "replayedOutBytes" << static_cast<double>(face.m_replayedOutBytes)
+             << log::JsonMapClose;
+    }
+    json << log::JsonArrayClose
+         << log::JsonMapClose;
+
+    if (output.empty()) {
+        cout << json.ToString() << endl;
+    } else {
+        std::ofstream file(output.c_str());
+        if (!file) {
+            cerr << "Error: cannot open " << output << endl;
+            return 1;
+        }
+        file << json.ToString() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "ndn-trace.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <time.h>
+
+#include "corelib/log.h"
+#include "network/mac/geo-storage.h"
+#include "network/mac/ll-metadata-80211-adhoc.h"
+#include "network/mac/ll-metadata-over-ip.h"
+#include "network/packet.h"
+
+NS_LOG_COMPONENT_DEFINE("NDNTrace");
+
+namespace vndn
+{
+
+const uint64_t NDNTraceWriter::DEFAULT_MAX_FILE_SIZE = 64 * 1024 * 1024;
+const unsigned int NDNTraceWriter::DEFAULT_MAX_FILES = 4;
+
+static const char TRACE_MAGIC[4] = {'V', 'N', 'D', 'T'};
+static const uint16_t TRACE_VERSION = 2;
+static const uint16_t TRACE_BYTE_ORDER = 0x0102;
+static const size_t FILE_HEADER_SIZE = 8;
+static const size_t RECORD_HEADER_SIZE = 24;
+static const size_t ADHOC_METADATA_SIZE = 5 * sizeof(double);
+static const size_t IP_METADATA_SIZE = 8;
+static const size_t MAX_METADATA_SIZE = ADHOC_METADATA_SIZE;
+static const int64_t FLUSH_INTERVAL = 1000000000LL; // 1 s
+static const size_t WRITE_BUFFER_SIZE = 64 * 1024;
+
+static int64_t Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+template <typename T>
+static uint8_t *Put(uint8_t *p, T value)
+{
+    memcpy(p, &value, sizeof(T));
+    return p + sizeof(T);
+}
+
+template <typename T>
+static const uint8_t *Get(const uint8_t *p, T &value)
+{
+    memcpy(&value, p, sizeof(T));
+    return p + sizeof(T);
+}
+
+
+LLMetadata *NDNTraceRecord::CreateMetadata() const
+{
+    switch (metadataType) {
+    case ADHOC_METADATA: {
+        GeoStorage previousHop(lat, lon, heading);
+        LLMetadata80211AdHoc *metadata = new LLMetadata80211AdHoc(previousHop);
+        metadata->setLocalInfo(GeoStorage(localLat, localLon));
+        return metadata;
+    }
+    case IP_METADATA:
+        return new LLMetadataOverIP(ipAddress, port);
+    default:
+        return NULL;
+    }
+}
+
+
+NDNTraceWriter::NDNTraceWriter(const std::string &path, uint64_t maxFileSize, unsigned int maxFiles)
+    : m_path(path)
+    , m_maxFileSize(maxFileSize)
+    , m_maxFiles(maxFiles > 0 ? maxFiles : 1)
+    , m_file(NULL)
+    , m_fileSize(0)
+    , m_lastFlush(Now())
+    , m_records(0)
+{
+    Open();
+}
+
+NDNTraceWriter::~NDNTraceWriter()
+{
+    if (m_file != NULL)
+        fclose(m_file);
+}
+
+void NDNTraceWriter::Open()
+{
+    m_file = fopen(m_path.c_str(), "wb");
+    if (m_file == NULL) {
+        NS_LOG_ERROR("Cannot create trace file " << m_path << ": " << strerror(errno));
+        throw "cannot create trace file";
+    }
+    setvbuf(m_file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+    uint8_t header[FILE_HEADER_SIZE];
+    memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    uint8_t *p = header + sizeof(TRACE_MAGIC);
+    p = Put(p, TRACE_VERSION);
+    Put(p, TRACE_BYTE_ORDER);
+    fwrite(header, 1, sizeof(header), m_file);
+    m_fileSize = sizeof(header);
+
+    NS_LOG_INFO("Tracing packets to " << m_path);
+}
+
+void NDNTraceWriter::Rotate()
+{
+    fclose(m_file);
+    m_file = NULL;
+
+    // path.(n-2) -> path.(n-1), ..., path -> path.1
+    for (unsigned int i = m_maxFiles - 1; i > 0; i--) {
+        std::ostringstream from, to;
+        from << m_path;
+        if (i > 1)
+            from << "." << i - 1;
+        to << m_path << "." << i;
+        rename(from.str().c_str(), to.str().c_str());
+    }
+
+    try {
+        Open();
+    } catch (const char *) {
+        // keep forwarding without trace
+    }
+}
+
+void NDNTraceWriter::Write(NDNTraceRecord::Direction direction, uint32_t face, const Ptr<const Packet> &packet)
+{
+    if (m_file == NULL)
+        return;
+
+    const int64_t now = Now();
+    const uint32_t packetLength = packet->GetSize();
+
+    uint8_t metadata[MAX_METADATA_SIZE];
+    uint16_t metadataLength = 0;
+    uint8_t metadataType = NDNTraceRecord::NO_METADATA;
+    LLMetadata *ll = packet->llmetadataptr;
+    if (ll != NULL && ll->getRequestSourceInfoType() == OVER_ADHOC) {
+        LLMetadata80211AdHoc *adhoc = static_cast<LLMetadata80211AdHoc *>(ll);
+        GeoStorage *previousHop = adhoc->getPreviousHopInfoAddr();
+        GeoStorage local = adhoc->getLocalInfo();
+        uint8_t *p = Put(metadata, previousHop->getLat());
+        p = Put(p, previousHop->getLongitude());
+        p = Put(p, previousHop->getHeading());
+        p = Put(p, local.getLat());
+        Put(p, local.getLongitude());
+        metadataType = NDNTraceRecord::ADHOC_METADATA;
+        metadataLength = ADHOC_METADATA_SIZE;
+    } else if (ll != NULL && ll->getRequestSourceInfoType() == OVER_IP) {
+        LLMetadataOverIP *ip = static_cast<LLMetadataOverIP *>(ll);
+        uint8_t *p = Put(metadata, static_cast<uint32_t>(ip->getIpAddr()));
+        p = Put(p, static_cast<uint16_t>(ip->getPort()));
+        Put(p, static_cast<uint16_t>(0));
+        metadataType = NDNTraceRecord::IP_METADATA;
+        metadataLength = IP_METADATA_SIZE;
+    }
+
+    const uint64_t recordSize = RECORD_HEADER_SIZE + metadataLength + packetLength;
+    if (m_fileSize + recordSize > m_maxFileSize && m_fileSize > FILE_HEADER_SIZE) {
+        Rotate();
+        if (m_file == NULL)
+            return;
+    }
+
+    uint8_t header[RECORD_HEADER_SIZE];
+    uint8_t *p = Put(header, now);
+    p = Put(p, face);
+    p = Put(p, static_cast<uint8_t>(direction));
+    p = Put(p, metadataType);
+    p = Put(p, metadataLength);
+    p = Put(p, packetLength);
+    Put(p, static_cast<uint32_t>(0));
+
+    fwrite(header, 1, sizeof(header), m_file);
+    fwrite(metadata, 1, metadataLength, m_file);
+    fwrite(packet->GetRawBuffer(), 1, packetLength, m_file);
+    m_fileSize += recordSize;
+    m_records++;
+
+    if (now - m_lastFlush >= FLUSH_INTERVAL) {
+        Flush();
+        m_lastFlush = now;
+    }
+}
+
+void NDNTraceWriter::Flush()
+{
+    if (m_file != NULL && fflush(m_file) != 0)
+        NS_LOG_WARN("Cannot write the trace file: " << strerror(errno));
+}
+
+
+NDNTraceReader::NDNTraceReader(const std::string &path)
+{
+    m_file = fopen(path.c_str(), "rb");
+    if (m_file == NULL)
+        throw "cannot open trace file";
+
+    uint8_t header[FILE_HEADER_SIZE];
+    uint16_t version, byteOrder;
+    if (fread(header, 1, sizeof(header), m_file) != sizeof(header) ||
+            memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+        fclose(m_file);
+        throw "not a trace file";
+    }
+    Get(Get(header + sizeof(TRACE_MAGIC), version), byteOrder);
+    if (version != TRACE_VERSION || byteOrder != TRACE_BYTE_ORDER) {
+        fclose(m_file);
+        throw "unsupported trace version or byte order";
+    }
+}
+
+NDNTraceReader::~NDNTraceReader()
+{
+    fclose(m_file);
+}
+
+bool NDNTraceReader::Next(NDNTraceRecord &record)
+{
+    uint8_t header[RECORD_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), m_file) != sizeof(header))
+        return false;
+
+    uint8_t direction, metadataType;
+    uint16_t metadataLength;
+    uint32_t packetLength;
+    const uint8_t *p = Get(header, record.timestamp);
+    p = Get(p, record.face);
+    p = Get(p, direction);
+    p = Get(p, metadataType);
+    p = Get(p, metadataLength);
+    Get(p, packetLength);
+    record.direction = static_cast<NDNTraceRecord::Direction>(direction);
+    record.metadataType = NDNTraceRecord::NO_METADATA;
+
+    uint8_t metadata[MAX_METADATA_SIZE];
+    if (metadataLength > sizeof(metadata)) {
+        NS_LOG_WARN("Unknown metadata of " << metadataLength << " bytes, skipping it");
+        if (fseek(m_file, metadataLength, SEEK_CUR) != 0)
+            return false;
+    } else if (fread(metadata, 1, metadataLength, m_file) != metadataLength) {
+        return false;
+    } else if (metadataType == NDNTraceRecord::ADHOC_METADATA && metadataLength == ADHOC_METADATA_SIZE) {
+        Get(Get(Get(Get(Get(metadata, record.lat), record.lon), record.heading), record.localLat), record.localLon);
+        record.metadataType = NDNTraceRecord::ADHOC_METADATA;
+    } else if (metadataType == NDNTraceRecord::IP_METADATA && metadataLength == IP_METADATA_SIZE) {
+        Get(Get(metadata, record.ipAddress), record.port);
+        record.metadataType = NDNTraceRecord::IP_METADATA;
+    }
+
+    record.packet.resize(packetLength);
+    if (packetLength > 0 && fread(&record.packet[0], 1, packetLength, m_file) != packetLength) {
+        NS_LOG_WARN("Truncated record at the end of the trace");
+        return false;
+    }
+    return true;
+}
+
+} // namespace vndn
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef NDN_TRACE_H_
+#define NDN_TRACE_H_
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "corelib/ptr.h"
+#include "corelib/simple-ref-count.h"
+
+namespace vndn
+{
+
+class LLMetadata;
+class Packet;
+
+/**
+ * \brief A packet captured by NDNTraceWriter
+ *
+ * On disk a trace file starts with an 8-byte header ("VNDT", version, byte
+ * order mark) followed by the records. Every record is a fixed 24-byte header
+ * (timestamp, face, direction, metadata type and length, packet length),
+ * the link-layer metadata and the raw packet bytes. Numbers are stored in the
+ * byte order of the machine that wrote the trace.
+ */
+struct NDNTraceRecord
+{
+    enum Direction {
+        INCOMING = 0,   ///< \brief received by a face and passed to NDNL3Protocol
+        OUTGOING = 1    ///< \brief sent by NDNL3Protocol through a face
+    };
+
+    enum MetadataType {
+        NO_METADATA = 0,
+        ADHOC_METADATA = 1, ///< \brief position of the previous hop (latitude, longitude, heading) and of the local node (latitude, longitude)
+        IP_METADATA = 2     ///< \brief source address and port (network byte order)
+    };
+
+    int64_t timestamp;  ///< \brief nanoseconds since the epoch
+    uint32_t face;      ///< \brief file descriptor of the face, which identifies it in NDNL3Protocol
+    Direction direction;
+    MetadataType metadataType;
+
+    double lat;         ///< \brief ADHOC_METADATA only
+    double lon;         ///< \brief ADHOC_METADATA only
+    double heading;     ///< \brief ADHOC_METADATA only
+    double localLat;    ///< \brief ADHOC_METADATA only, DEFAULT_COORDINATE_DOUBLE if the position was not valid
+    double localLon;    ///< \brief ADHOC_METADATA only, DEFAULT_COORDINATE_DOUBLE if the position was not valid
+    uint32_t ipAddress; ///< \brief IP_METADATA only
+    uint16_t port;      ///< \brief IP_METADATA only
+
+    std::vector<uint8_t> packet;
+
+    /**
+     * \brief Creates a new LLMetadata equivalent to the captured one, or returns NULL
+     *
+     * The caller owns the returned object, exactly as if it had been created by the face.
+     */
+    LLMetadata *CreateMetadata() const;
+};
+
+/**
+ * \brief Writes the packets received and sent by the faces to rotating trace files
+ *
+ * The current file is \p path; when it grows beyond the maximum size it is
+ * renamed to path.1 (path.1 to path.2 and so on, the oldest one is deleted)
+ * and a new file is started. Writes are buffered and flushed at least once
+ * per second, so a crash loses at most the last second of traffic.
+ */
+class NDNTraceWriter : public SimpleRefCount<NDNTraceWriter>
+{
+public:
+    static const uint64_t DEFAULT_MAX_FILE_SIZE;
+    static const unsigned int DEFAULT_MAX_FILES;
+
+    /**
+     * \param path name of the current trace file
+     * \param maxFileSize size in bytes that triggers a rotation
+     * \param maxFiles number of files kept, including the current one
+     *
+     * \throws const char * if the file cannot be created
+     */
+    NDNTraceWriter(const std::string &path,
+                   uint64_t maxFileSize = DEFAULT_MAX_FILE_SIZE,
+                   unsigned int maxFiles = DEFAULT_MAX_FILES);
+    ~NDNTraceWriter();
+
+    void Write(NDNTraceRecord::Direction direction, uint32_t face, const Ptr<const Packet> &packet);
+    void Flush();
+
+    uint64_t GetRecordCount() const { return m_records; }
+
+private:
+    NDNTraceWriter(const NDNTraceWriter &);
+    NDNTraceWriter &operator=(const NDNTraceWriter &);
+
+    void Open();
+    void Rotate();
+
+    std::string m_path;
+    uint64_t m_maxFileSize;
+    unsigned int m_maxFiles;
+    FILE *m_file;
+    uint64_t m_fileSize;
+    int64_t m_lastFlush;
+    uint64_t m_records;
+};
+
+/**
+ * \brief Reads the records of a trace file written by NDNTraceWriter
+ */
+class NDNTraceReader
+{
+public:
+    /**
+     * \throws const char * if the file cannot be opened or it is not a valid trace
+     */
+    explicit NDNTraceReader(const std::string &path);
+    ~NDNTraceReader();
+
+    /**
+     * \brief Reads the next record
+     * \return false at the end of the file, or if the last record is truncated
+     */
+    bool Next(NDNTraceRecord &record);
+
+private:
+    NDNTraceReader(const NDNTraceReader &);
+    NDNTraceReader &operator=(const NDNTraceReader &);
+
+    FILE *m_file;
+};
+
+} // namespace vndn
+
+#endif /* NDN_TRACE_H_ */
@@ -16,32 +16,48 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <syslog.h>
+#include <vector>
 
+#include "corelib/log.h"
 #include "corelib/singleton.h"
 #include "helper/event-monitor.h"
 #include "app-connector.h"
 #include "ndn-l3-protocol.h"
 #include "ndn-fib.h"
 #include "ndn-flooding-strategy.h"
+#include "ndn-geo-strategy.h"
 #include "ndn-adhoc-net-device-face.h"
 #include "ndn-hub-over-ip-device-face.h"
 #include "ndn-net-device-face.h"
 #include "ndn-management.h"
+#include "ndn-trace.h"
+#include "network/mac/ll-nom-policy.h"
 
 using namespace vndn;
 using std::cerr;
 using std::cout;
 using std::endl;
 using std::string;
+using std::vector;
 
 
 static void usage()
 {
-    cout << "Usage: ./ndnd <type-of-face> <interface-name or ip-address>\n"
+    cout << "Usage: ./ndnd <type-of-face> <interface-name or ip-address> [trace <file>] [llheader <format>] [llaggregation <on|off>] [llunicast <on|off>] [llcompression <on|off>] [lltimers <spec>] [llstats <seconds>] [strategy <name>]\n"
          << "Available interface types: hub (local ip), adhoc (device name), net (local ip and hub ip)\n"
+         << "trace <file> records every packet received and sent by the faces in <file>, see ndnReplay\n"
+         << "llheader ascii sends the link-layer header of the adhoc faces in the old ASCII format (default: binary)\n"
+         << "llaggregation off sends every packet of the adhoc faces in its own frame (default: on, the packets due together share a frame)\n"
+         << "llunicast off broadcasts also the data requested by a single neighbor (default: on, they are unicast to it)\n"
+         << "llcompression off sends the full names in the adhoc frames (default: on, the name prefixes already sent are referred to by id)\n"
+         << "lltimers <name>=<value>,... sets the collision avoidance timers of the adhoc faces, e.g. adaptive=off,maxTca=2000\n"
+         << "  (names: adaptive, maxTca, referenceNeighbors, minWindow, maxWindow, Tdist, Dmax, duplicateWeight, retransmissionWeight)\n"
+         << "llstats <seconds> logs the link-layer statistics of the adhoc faces to syslog every <seconds>, 0 disables them (default: every 10 s, if LALStatistic is enabled in VNDN_LOG)\n"
+         << "strategy geo rebroadcasts the /traffic/ and /photo-traffic/ interests only towards their position (default: flooding)\n"
          << "Example: ./ndnd adhoc wlan0 hub 10.0.0.1\n";
 }
 
@@ -72,13 +88,136 @@ int main(int argc, char **argv)
     Ptr<NDNFib> fib = Create<NDNFib>();
     protocol->SetFib(fib);
 
-    NDNManagementInterface manager;
-
     EventMonitor em;
     em.add(appConn);
+    // the management thread hands the prefix registrations over to this loop
+    em.add(Create<NDNManagementInterface>());
     em.addTimer(&NDNL3Protocol::Reap, &em, &NDNL3Protocol::REAP_INTERVAL);
 
+    // the adhoc faces start their adapter thread as soon as they are created, so all the options
+    // they read are set first, and the faces are created afterwards in the order they are given
+    vector<int> faceArgs;
     for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg.compare("hub") == 0 || arg.compare("adhoc") == 0) {
+            faceArgs.push_back(i);
+            i++; // skip the local ip or the device name
+            continue;
+        } else if (arg.compare("net") == 0) {
+            faceArgs.push_back(i);
+            i += 2; // skip the local ip and the hub ip
+            continue;
+        } else if (arg.compare("trace") == 0) {
+            i++; // consume one more argument (trace file)
+            string file(argv[i]);
+            cout << "Tracing packets to " << file << endl;
+            try {
+                protocol->SetTraceWriter(Create<NDNTraceWriter>(file));
+            } catch (const char *e) {
+                cerr << "Failed to create the trace: " << e << endl;
+            }
+            continue;
+        } else if (arg.compare("strategy") == 0) {
+            i++; // consume one more argument (strategy name)
+            string strategy(argv[i]);
+            if (strategy.compare("geo") == 0) {
+                protocol->SetForwardingStrategy(Create<NDNGeoStrategy>());
+            } else if (strategy.compare("flooding") == 0) {
+                protocol->SetForwardingStrategy(Create<NDNFloodingStrategy>());
+            } else {
+                cerr << "Error: unknown forwarding strategy '" << strategy << "'" << endl;
+                usage();
+                return -1;
+            }
+            continue;
+        } else if (arg.compare("llheader") == 0) {
+            i++; // consume one more argument (header format)
+            string format(argv[i]);
+            if (format.compare("ascii") == 0) {
+                LLNomPolicy::setHeaderFormat(LL_HEADER_ASCII);
+            } else if (format.compare("binary") == 0) {
+                LLNomPolicy::setHeaderFormat(LL_HEADER_BINARY);
+            } else {
+                cerr << "Error: unknown link-layer header format '" << format << "'" << endl;
+                usage();
+                return -1;
+            }
+            continue;
+        } else if (arg.compare("llaggregation") == 0) {
+            i++; // consume one more argument (on or off)
+            string aggregation(argv[i]);
+            if (aggregation.compare("on") == 0) {
+                LLNomPolicy::setAggregation(true);
+            } else if (aggregation.compare("off") == 0) {
+                LLNomPolicy::setAggregation(false);
+            } else {
+                cerr << "Error: invalid link-layer aggregation '" << aggregation << "'" << endl;
+                usage();
+                return -1;
+            }
+            continue;
+        } else if (arg.compare("llunicast") == 0) {
+            i++; // consume one more argument (on or off)
+            string unicast(argv[i]);
+            if (unicast.compare("on") == 0) {
+                LLNomPolicy::setUnicast(true);
+            } else if (unicast.compare("off") == 0) {
+                LLNomPolicy::setUnicast(false);
+            } else {
+                cerr << "Error: invalid link-layer unicast '" << unicast << "'" << endl;
+                usage();
+                return -1;
+            }
+            continue;
+        } else if (arg.compare("llcompression") == 0) {
+            i++; // consume one more argument (on or off)
+            string compression(argv[i]);
+            if (compression.compare("on") == 0) {
+                LLNomPolicy::setPrefixCompression(true);
+            } else if (compression.compare("off") == 0) {
+                LLNomPolicy::setPrefixCompression(false);
+            } else {
+                cerr << "Error: invalid link-layer compression '" << compression << "'" << endl;
+                usage();
+                return -1;
+            }
+            continue;
+        } else if (arg.compare("lltimers") == 0) {
+            i++; // consume one more argument (timer parameters)
+            string timers(argv[i]);
+            LALContention::Parameters parameters = LLNomPolicy::getContention();
+            if (!LALContention::parse(timers, parameters)) {
+                cerr << "Error: invalid link-layer timers '" << timers << "'" << endl;
+                usage();
+                return -1;
+            }
+            LLNomPolicy::setContention(parameters);
+            continue;
+        } else if (arg.compare("llstats") == 0) {
+            i++; // consume one more argument (interval)
+            string interval(argv[i]);
+            char *end;
+            const long seconds = strtol(interval.c_str(), &end, 10);
+            if (interval.empty() || *end != '\0' || seconds < 0) {
+                cerr << "Error: invalid link-layer statistics interval '" << interval << "'" << endl;
+                usage();
+                return -1;
+            }
+            NDNDeviceAdapter::setStatisticsInterval(seconds);
+            if (seconds > 0) {
+                vndn::log::LogComponentEnable("LALStatistic", static_cast<vndn::log::LogLevel>(vndn::log::NDN_LOG_NOTICE |
+                                                                                             vndn::log::NDN_LOG_TO_SYSLOG));
+            }
+            continue;
+        } else {
+            cerr << "Error: unknown argument '" << arg << "'" << endl;
+            usage();
+            return -1;
+        }
+    }
+
+    for (vector<int>::const_iterator it = faceArgs.begin(); it != faceArgs.end(); ++it) {
+        int i = *it;
         Ptr<NDNFace> face;
         string arg(argv[i]);
         if (arg.compare("hub") == 0) {
@@ -113,10 +252,6 @@ int main(int argc, char **argv)
                 cerr << "Failed to create NDNNetDeviceFace: " << e << endl;
                 continue;
             }
-        } else {
-            cerr << "Error: unknown argument '" << arg << "'" << endl;
-            usage();
-            return -1;
         }
         protocol->AddFace(face);
         em.add(face);
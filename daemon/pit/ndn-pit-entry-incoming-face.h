@@ -26,6 +26,8 @@
 namespace vndn
 {
 
+class NDNPitEntry;
+
 /**
  * \ingroup ndn
  * \brief PIT state component for each incoming interest (not including duplicates)
@@ -35,6 +37,8 @@ struct NDNPitEntryIncomingFace
     Ptr<NDNFace> m_face;                    ///< \brief face of the incoming Interest
     boost::posix_time::ptime m_arrivalTime; ///< \brief arrival time of the incoming Interest
 
+    mutable NDNBackReference<NDNPitEntry> m_faceReference; ///< \brief link in the PIT entries list of m_face
+
 public:
     /**
      * \brief Constructor
@@ -26,6 +26,8 @@
 namespace vndn
 {
 
+class NDNPitEntry;
+
 /**
  * \ingroup ndn
  * \brief PIT state component for each outgoing interest
@@ -39,6 +41,8 @@ struct NDNPitEntryOutgoingFace
     uint32_t m_retxCount;     ///< \brief number of retransmission
     bool m_waitingInVain;     ///< \brief when flag is set, we do not expect data for this interest, only a small hope that it will happen
 
+    mutable NDNBackReference<NDNPitEntry> m_faceReference; ///< \brief link in the PIT entries list of m_face
+
 public:
     NDNPitEntryOutgoingFace(Ptr<NDNFace> face);
 
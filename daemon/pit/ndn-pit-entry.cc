@@ -68,6 +68,8 @@ NDNPitEntryIncomingFaceContainer::type::iterator NDNPitEntry::AddIncoming(Ptr<ND
 
     if (!ret.second)
         NS_LOG_WARN("Something is wrong.");
+    else
+        face->GetPitEntries().Link(ret.first->m_faceReference, this);
 
     return ret.first;
 }
@@ -88,6 +90,8 @@ NDNPitEntryOutgoingFaceContainer::type::iterator NDNPitEntry::AddOutgoing(Ptr<ND
     if (!ret.second) {
         // outgoing face already exists
         m_outgoing.modify (ret.first, ll::bind(&NDNPitEntryOutgoingFace::UpdateOnRetransmit, ll::_1));
+    } else {
+        face->GetPitEntries().Link(ret.first->m_faceReference, this);
     }
 
     return ret.first;
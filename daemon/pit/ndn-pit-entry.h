@@ -270,6 +270,8 @@ public:
      * \brief info about the node that sent or generated the interest
      */
     RequestSourceInfo *sourceMetadata;
+
+    mutable NDNBackReference<NDNPitEntry> m_fibReference; ///< \brief link in the PIT entries list of m_fibEntry
 };
 
 } // namespace vndn
@@ -113,6 +113,8 @@ boost::tuple<const NDNPitEntry &, bool, bool, bool> NDNPit::Lookup(const Interes
         time_duration lifetime = header.GetInterestLifetime() == seconds(0) ? m_PitEntryDefaultLifetime : header.GetInterestLifetime();
 
         entry = insert(end(), NDNPitEntry(name, lifetime, fibEntry));
+        if (fibEntry)
+            fibEntry->m_pitEntries.Link(entry->m_fibReference, &*entry);
     } else {
         isNew = false;
         isDuplicate = entry->IsNonceSeen(header.GetNonce());
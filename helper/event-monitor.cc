@@ -76,6 +76,11 @@ void EventMonitor::erase(Ptr<Monitorable> &pMon)
     free(state); // 1 memory alloc
 }
 
+void EventMonitor::stop()
+{
+    event_base_loopexit(m_base, NULL);
+}
+
 void EventMonitor::monitor()
 {
     event_base_dispatch(m_base);
@@ -47,6 +47,7 @@ public:
     void add(Ptr<Monitorable> pMonitorable); // monitor file descriptor objects
     void erase(Ptr<Monitorable> &pMon);
     void monitor();
+    void stop(); // make monitor() return after the current events have been processed
 
 private:
     static void do_read(evutil_socket_t fd, short events, void *arg);
@@ -17,17 +17,21 @@
 
 #include "ack-info.h"
 
+#include <algorithm>
+
 namespace vndn
 {
 
 AckInfo::AckInfo()
 {
     receivedAckNum = 0;
+    previousHop = 0;
 }
     
 AckInfo::AckInfo(int tosP)
 {
     receivedAckNum = 0;
+    previousHop = 0;
     tos = tosP;
 }
 
@@ -42,6 +46,22 @@ int AckInfo::getNumberOfAck()
 }
 
 
+bool AckInfo::addAck(const unsigned char mac[ETH_ALEN])
+{
+    const uint64_t key = macKey(mac);
+    if (key == previousHop || std::find(forwarders.begin(), forwarders.end(), key) != forwarders.end()) {
+        return false;
+    }
+    forwarders.push_back(key);
+    receivedAckNum++;
+    return true;
+}
+
+void AckInfo::setPreviousHop(const unsigned char mac[ETH_ALEN])
+{
+    previousHop = macKey(mac);
+}
+
 int AckInfo::getTos()
 {
     return tos;
@@ -19,6 +19,11 @@
 #define ACKINFO_H_
 
 #include "geo-storage.h"
+#include "ll-header.h"
+
+#include <linux/if_ether.h>
+#include <stdint.h>
+#include <vector>
 
 namespace vndn
 {
@@ -36,6 +41,20 @@ public:
      * */
     int getNumberOfAck();
 
+    /**
+     * \brief a partial ack has been received from the neighbor mac
+     *
+     * Only the distinct forwarders count: the previous hop (see setPreviousHop) and the neighbors
+     * already counted are ignored, their retransmissions mean they heard nobody forward the packet
+     * \return true if the ack has been counted
+     * */
+    bool addAck(const unsigned char mac[ETH_ALEN]);
+
+    /**
+     * \brief Sets the neighbor the packet has been received from, it never acks the packet
+     * */
+    void setPreviousHop(const unsigned char mac[ETH_ALEN]);
+
     /**
      * \brief get the number of ack that has to be received to consider the packet acked
      * */
@@ -48,6 +67,12 @@ protected:
      * */
     int receivedAckNum;
 
+    /**
+     * MAC address of the previous hop (0 if the packet has been generated locally) and of the neighbors that acked the packet
+     * */
+    uint64_t previousHop;
+    std::vector<uint64_t> forwarders;
+
     /**
      * TOS; index of number of ack that has to be received (0-100): 100 = all possible ack.
      * */
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "duplicate-filter.h"
+
+namespace vndn
+{
+
+DuplicateFilter::DuplicateFilter()
+    : nextRotation(0)
+{
+}
+
+uint64_t DuplicateFilter::fingerprint(const PacketStorage::packetKey &key, uint32_t nonce)
+{
+    //the nonce is spread over the 64 bits, so that close nonces do not cancel close hashes
+    return (key.nameHash ^ ((uint64_t) nonce * 0x9e3779b97f4a7c15ULL)) + key.type;
+}
+
+bool DuplicateFilter::insert(const PacketStorage::packetKey &key, uint32_t nonce, uint64_t now)
+{
+    if (now >= nextRotation) {
+        //after a long silence both generations are stale
+        if (now >= nextRotation + window) {
+            previous.clear();
+        } else {
+            previous.swap(current);
+        }
+        current.clear();
+        nextRotation = now + window;
+    }
+    const uint64_t f = fingerprint(key, nonce);
+    if (!current.insert(f).second) {
+        return false;
+    }
+    //a packet of the previous generation is still recent, it has just moved to the current one
+    return previous.find(f) == previous.end();
+}
+
+} /* namespace vndn */
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef DUPLICATE_FILTER_H_
+#define DUPLICATE_FILTER_H_
+
+#include "packet-storage.h"
+
+#include <boost/unordered_set.hpp>
+#include <stdint.h>
+
+namespace vndn
+{
+
+/**
+ * \brief Remembers the packets recently sent up to NDN, to drop the copies rebroadcast by the other neighbors
+ *
+ * A packet is identified by the hash of its type and name (see PacketStorage::makeKey) and by its nonce
+ * (-1 for the contents), folded in a 64 bit fingerprint. The fingerprints are kept in two generations
+ * that are rotated every window, so a packet is remembered for at least window and at most twice that,
+ * without any per-packet timer.
+ * Times are microseconds of CLOCK_MONOTONIC (see TimerWheel::now).
+ * */
+class DuplicateFilter
+{
+public:
+    /** Minimum time a packet is remembered (microseconds) */
+    static const uint64_t window = 1000000;
+
+    DuplicateFilter();
+
+    /**
+     * \brief Records a packet sent to NDN or received from it
+     *
+     * \return false if the same packet has already been recorded in the last window: NDN knows it already
+     * */
+    bool insert(const PacketStorage::packetKey &key, uint32_t nonce, uint64_t now);
+
+    /** Number of packets remembered */
+    size_t size() const { return current.size() + previous.size(); }
+
+private:
+    static uint64_t fingerprint(const PacketStorage::packetKey &key, uint32_t nonce);
+
+    boost::unordered_set<uint64_t> current;
+    boost::unordered_set<uint64_t> previous;
+    /** Time of the next rotation of the generations */
+    uint64_t nextRotation;
+};
+
+} /* namespace vndn */
+
+#endif /* DUPLICATE_FILTER_H_ */
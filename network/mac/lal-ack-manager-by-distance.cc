@@ -29,12 +29,15 @@ LALAckManagerByDistance::LALAckManagerByDistance() {}
 
 LALAckManagerByDistance::~LALAckManagerByDistance() {}
 
-AckInfo *LALAckManagerByDistance::createAckInfo(const LocationService & locationService, GeoStorage *previousHop, llHeader &hdr)
+AckInfo *LALAckManagerByDistance::createAckInfo(const LocationService & locationService, GeoStorage *previousHop, const unsigned char *previousHopMac, const LLHeaderInfo &hdr)
 {
     if (previousHop != NULL) {
         try{
             Coordinate c (previousHop->getLat(), previousHop->getLongitude());
             AckInfoByCoordinate * ackInfo = new AckInfoByCoordinate(c);
+            if (previousHopMac != NULL) {
+                ackInfo->setPreviousHop(previousHopMac);
+            }
             return ackInfo;
         } catch (CoordinateException e){
             NS_LOG_WARN("Impossible to create the required AckInfo. Exception while creating the coordinate: "<< e.what());
@@ -44,6 +47,9 @@ AckInfo *LALAckManagerByDistance::createAckInfo(const LocationService & location
         try{
             Coordinate c (locationService.getLatitude(), locationService.getLongitude());
             AckInfoByCoordinate * ackInfo = new AckInfoByCoordinate(c);
+            if (previousHopMac != NULL) {
+                ackInfo->setPreviousHop(previousHopMac);
+            }
             return ackInfo;
         } catch(CoordinateException e){
             NS_LOG_WARN("Impossible to create the required AckInfo. Exception while getting local coordinate: "<< e.what());
@@ -52,14 +58,14 @@ AckInfo *LALAckManagerByDistance::createAckInfo(const LocationService & location
     }
 }
 
-std::pair<bool, int> LALAckManagerByDistance::receivedRetransmission(llHeader *receivedHdr, const PacketStorage::linkLayerPktElement *storedElement, const LocationService & locationService)
+std::pair<bool, int> LALAckManagerByDistance::receivedRetransmission(const LLHeaderInfo &receivedHdr, const unsigned char sender[ETH_ALEN], const PacketStorage::linkLayerPktElement *storedElement, const LocationService & locationService)
 {
     std::pair<bool, int> result;
     AckInfoByCoordinate *ack =(AckInfoByCoordinate*) storedElement->ackInfo;
     
     Coordinate packetCoordinate;
     try {
-        packetCoordinate = Coordinate(atof(receivedHdr->lat), atof(receivedHdr->longitude));
+        packetCoordinate = Coordinate(receivedHdr.lat, receivedHdr.longitude);
     } catch (CoordinateException e) {
         NS_LOG_WARN("some problem with coordinates: "<<e.what()<<", considering the pkt as a non-ack");
         result.first = false;
@@ -77,6 +83,8 @@ std::pair<bool, int> LALAckManagerByDistance::receivedRetransmission(llHeader *r
         result.second = 0;
     } else {
         NS_LOG_DEBUG("Packet NOT acked. distanceBetweenPreviousHopAndPacket = "<< distanceBetweenPreviousHopAndPacket << ", distanceBetweenMeAndPreviousHop: "<< distanceBetweenMeAndPreviousHop);
+        //another neighbor forwarded the packet, unless it is the previous hop or a neighbor that retransmits it
+        ack->addAck(sender);
         result.first = false;
         result.second = 1;
     }
@@ -33,9 +33,9 @@ public:
     LALAckManagerByDistance();
     virtual ~LALAckManagerByDistance();
 
-    AckInfo *createAckInfo(const geo::LocationService & locationService, GeoStorage *previousHop, llHeader &hdr);
+    AckInfo *createAckInfo(const geo::LocationService & locationService, GeoStorage *previousHop, const unsigned char *previousHopMac, const LLHeaderInfo &hdr);
     
-    std::pair<bool, int> receivedRetransmission( llHeader *receivedHdr, const PacketStorage::linkLayerPktElement *storedElement, const geo::LocationService & locationService);
+    std::pair<bool, int> receivedRetransmission(const LLHeaderInfo &receivedHdr, const unsigned char sender[ETH_ALEN], const PacketStorage::linkLayerPktElement *storedElement, const geo::LocationService & locationService);
 };
     
 }
@@ -41,15 +41,17 @@ public:
     /**
      * \brief it creates and set properly the ack struct used to manage the acknowledgment process of a outgoing packet
      *
+     * \param previousHopMac MAC address of the neighbor the packet has been received from, NULL if generated locally
      * */
-    virtual AckInfo *createAckInfo(const geo::LocationService & locationService, GeoStorage *previousHop, llHeader &hdr) = 0;
+    virtual AckInfo *createAckInfo(const geo::LocationService & locationService, GeoStorage *previousHop, const unsigned char *previousHopMac, const LLHeaderInfo &hdr) = 0;
 
     /**
      * \brief a retransmission of a pending packet has been heard. Check for push progress, if needed add the ack to the list
      *
+     * \param sender MAC address of the neighbor that sent the retransmission
      * \return pair of < is the received packet an ack? , number of ack still required (0 if the pending packet is completly acked>
      * */
-    virtual std::pair<bool, int> receivedRetransmission(llHeader *receivedHdr, const  PacketStorage::linkLayerPktElement *storedElement, const geo::LocationService & locationService) = 0;
+    virtual std::pair<bool, int> receivedRetransmission(const LLHeaderInfo &receivedHdr, const unsigned char sender[ETH_ALEN], const  PacketStorage::linkLayerPktElement *storedElement, const geo::LocationService & locationService) = 0;
 
 protected:
     bool isAPushProgress(geo::GpsInfo *localNode, geo::GpsInfo &receivedPosition, const GeoStorage &previousHop );  //has in LLNomPolicy   it can be implemented in this class!
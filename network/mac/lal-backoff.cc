@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "lal-backoff.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace vndn
+{
+
+const double LALBackoff::maxBusy = 0.9;
+
+// gains of the estimators, as in RFC 6298 (and for the load, the weight of a 100 ms window)
+static const double LATENCY_GAIN = 1.0 / 8;
+static const double VARIATION_GAIN = 1.0 / 4;
+static const double BUSY_GAIN = 1.0 / 4;
+
+LALBackoff::LALBackoff(uint64_t initialTimeout)
+    : ackTimeout(initialTimeout), smoothedLatency(0), latencyVariation(0), latencyMeasured(false)
+    , windowStart(0), windowAirtime(0), busy(0)
+{
+}
+
+void LALBackoff::updateWindow(uint64_t now)
+{
+    if (windowStart == 0) {
+        windowStart = now;
+        return;
+    }
+    if (now < windowStart + channelWindow) {
+        return;
+    }
+    const uint64_t windows = (now - windowStart) / channelWindow;
+    busy += BUSY_GAIN * (std::min(1.0, (double) windowAirtime / channelWindow) - busy);
+    // the windows after it, without any frame, were idle
+    for (uint64_t i = 1; i < windows && busy > 0.001; i++) {
+        busy -= BUSY_GAIN * busy;
+    }
+    windowStart += windows * channelWindow;
+    windowAirtime = 0;
+}
+
+void LALBackoff::frameReceived(uint64_t now, unsigned int size)
+{
+    updateWindow(now);
+    windowAirtime += frameOverhead + size * 8 / channelBitrate;
+}
+
+void LALBackoff::ackReceived(uint64_t latency)
+{
+    if (!latencyMeasured) {
+        smoothedLatency = latency;
+        latencyVariation = latency / 2.0;
+        latencyMeasured = true;
+    } else {
+        latencyVariation += VARIATION_GAIN * (std::fabs(smoothedLatency - latency) - latencyVariation);
+        smoothedLatency += LATENCY_GAIN * (latency - smoothedLatency);
+    }
+    ackTimeout = std::max((double) minTimeout, std::min((double) maxTimeout, smoothedLatency + 4 * latencyVariation));
+}
+
+uint64_t LALBackoff::getTimeout(uint64_t now, unsigned int retransmission)
+{
+    updateWindow(now);
+    const unsigned int exponent = retransmission > 1 ? std::min(retransmission - 1, 8u) : 0;
+    double timeout = ackTimeout * (1 << exponent) / (1 - std::min(busy, maxBusy));
+    timeout *= 0.75 + 0.5 * rand() / ((double) RAND_MAX + 1);
+    return (uint64_t) std::max((double) minTimeout, std::min((double) maxTimeout, timeout));
+}
+
+} /* namespace vndn */
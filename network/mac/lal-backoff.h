@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef LAL_BACKOFF_H_
+#define LAL_BACKOFF_H_
+
+#include <stdint.h>
+
+namespace vndn
+{
+
+/**
+ * \brief Adaptive retransmission timeout of the NDN-LAL
+ *
+ * It estimates, from the traffic heard in the neighborhood:
+ * - the latency of the implicit acks (time from a transmission to the forwarding heard from a farther node),
+ *   smoothed as the TCP round-trip time (RFC 6298)
+ * - the fraction of time the channel is busy, from the airtime of the frames received
+ *
+ * The timeout of the n-th retransmission is the ack timeout (smoothed latency + 4 * its variation),
+ * doubled at each retransmission, stretched by 1 / (1 - busy fraction) and jittered by +/-25%,
+ * to avoid that the nodes that missed the same ack retransmit together.
+ * */
+class LALBackoff
+{
+public:
+    /** Bounds of the timeout (microseconds) */
+    static const uint64_t minTimeout = 20000;
+    static const uint64_t maxTimeout = 4000000;
+
+    /** Length of the window used to measure the channel load (microseconds) */
+    static const uint64_t channelWindow = 100000;
+    /** Bitrate assumed for the airtime of the frames (Mbit/s, default rate of 802.11p) */
+    static const unsigned int channelBitrate = 6;
+    /** Airtime of a frame besides its payload: preamble, inter-frame space, contention (microseconds) */
+    static const unsigned int frameOverhead = 100;
+    /** The busy fraction is capped, so that the timeout is stretched at most 10 times */
+    static const double maxBusy;
+
+    /**
+     * \param initialTimeout timeout used until the first ack latency is measured (microseconds)
+     * */
+    explicit LALBackoff(uint64_t initialTimeout);
+
+    /**
+     * \brief A frame of size bytes has been received at now (microseconds, see TimerWheel::now)
+     * */
+    void frameReceived(uint64_t now, unsigned int size);
+
+    /**
+     * \brief An implicit ack has been received latency microseconds after the transmission of the packet
+     * */
+    void ackReceived(uint64_t latency);
+
+    /**
+     * \brief Delay of the next retransmission of a packet (microseconds)
+     * \param now current time (microseconds, see TimerWheel::now)
+     * \param retransmission number of transmissions of the packet so far (1 after the first one)
+     * */
+    uint64_t getTimeout(uint64_t now, unsigned int retransmission);
+
+    /** Smoothed ack latency (microseconds), 0 if not measured yet */
+    uint64_t getAckLatency() const { return (uint64_t) smoothedLatency; }
+
+    /** Estimated fraction of time the channel is busy (0-1) */
+    double getChannelBusy() const { return busy; }
+
+private:
+    /**
+     * \brief Closes the load window(s) ended before now
+     * */
+    void updateWindow(uint64_t now);
+
+    /** Ack timeout before the backoff (microseconds) */
+    double ackTimeout;
+    double smoothedLatency;
+    double latencyVariation;
+    bool latencyMeasured;
+
+    uint64_t windowStart;
+    /** Airtime of the frames received in the current window (microseconds) */
+    uint64_t windowAirtime;
+    double busy;
+};
+
+} /* namespace vndn */
+
+#endif /* LAL_BACKOFF_H_ */
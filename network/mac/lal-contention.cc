@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "lal-contention.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace vndn
+{
+
+// weight of the last packet in the smoothed rates, about the last 16 packets count
+static const double RATE_GAIN = 1.0 / 16;
+
+LALContention::Parameters::Parameters()
+    : adaptive(true), maxTca(2000), referenceNeighbors(7), minWindow(500), maxWindow(20000)
+    , Tdist(5000), Dmax(150), duplicateWeight(1.0), retransmissionWeight(0.5)
+{
+}
+
+template <typename T>
+static bool parseValue(const std::string &text, T &value)
+{
+    //the unsigned values would wrap
+    if (text.empty() || text[0] == '-') {
+        return false;
+    }
+    std::istringstream in(text);
+    T parsed;
+    if (!(in >> parsed) || !in.eof()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool LALContention::parse(const std::string &spec, Parameters &parameters)
+{
+    std::istringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const size_t equal = item.find('=');
+        if (equal == std::string::npos) {
+            return false;
+        }
+        const std::string name = item.substr(0, equal);
+        const std::string value = item.substr(equal + 1);
+        bool ok;
+        if (name == "adaptive") {
+            ok = value == "on" || value == "off";
+            parameters.adaptive = value == "on";
+        } else if (name == "maxTca") {
+            ok = parseValue(value, parameters.maxTca) && parameters.maxTca > 0;
+        } else if (name == "referenceNeighbors") {
+            ok = parseValue(value, parameters.referenceNeighbors);
+        } else if (name == "minWindow") {
+            ok = parseValue(value, parameters.minWindow) && parameters.minWindow > 0;
+        } else if (name == "maxWindow") {
+            ok = parseValue(value, parameters.maxWindow) && parameters.maxWindow > 0;
+        } else if (name == "Tdist") {
+            ok = parseValue(value, parameters.Tdist);
+        } else if (name == "Dmax") {
+            ok = parseValue(value, parameters.Dmax) && parameters.Dmax > 0;
+        } else if (name == "duplicateWeight") {
+            ok = parseValue(value, parameters.duplicateWeight);
+        } else if (name == "retransmissionWeight") {
+            ok = parseValue(value, parameters.retransmissionWeight);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return parameters.minWindow <= parameters.maxWindow;
+}
+
+LALContention::LALContention(const Parameters &parameters)
+    : parameters(parameters), duplicateRate(0), retransmissionRate(0)
+{
+}
+
+void LALContention::interestHeard(bool duplicate)
+{
+    duplicateRate += RATE_GAIN * ((duplicate ? 1.0 : 0.0) - duplicateRate);
+}
+
+void LALContention::packetSent(bool retransmission)
+{
+    retransmissionRate += RATE_GAIN * ((retransmission ? 1.0 : 0.0) - retransmissionRate);
+}
+
+unsigned int LALContention::getWindow(size_t neighbors) const
+{
+    if (!parameters.adaptive) {
+        return parameters.maxTca;
+    }
+    //the neighbors and the node itself contend for the channel
+    double window = (double) parameters.maxTca * (neighbors + 1) / (parameters.referenceNeighbors + 1);
+    window *= 1 + parameters.duplicateWeight * duplicateRate + parameters.retransmissionWeight * retransmissionRate;
+    return (unsigned int) std::max((double) parameters.minWindow, std::min((double) parameters.maxWindow, window));
+}
+
+uint64_t LALContention::getDeferral(size_t neighbors, double distance) const
+{
+    const unsigned int window = getWindow(neighbors);
+    uint64_t Tca = rand() % window;
+    uint64_t Tgap = 0;
+    if (distance >= 0) {
+        const unsigned int Dmax = parameters.Dmax;
+        //with fewer neighbors the farther node needs a smaller lead to ack the others
+        const double scale = std::min(1.0, (double) window / parameters.maxTca);
+        Tgap = (uint64_t) (scale * parameters.Tdist * (Dmax - std::min((double) Dmax, distance)) / Dmax);
+    }
+    return Tca + Tgap;
+}
+
+} /* namespace vndn */
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef LAL_CONTENTION_H_
+#define LAL_CONTENTION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace vndn
+{
+
+/**
+ * \brief Collision avoidance timers of the NDN-LAL, adapted to the number of contending neighbors
+ *
+ * The first transmission of a packet is deferred by Tca + Tgap (see the NOM paper):
+ * - Tca is uniform in [0, window), so that the neighbors that got the same packet do not transmit together
+ * - Tgap is in inverse proportion to the distance from the previous hop, so that the farther node goes first
+ *   and its transmission acks the packet of the nearer ones
+ *
+ * The window grows with the number of neighbors heard (see NeighborTable): it is maxTca with referenceNeighbors,
+ * in proportion with the others. It is stretched by the fraction of interests heard again (redundant
+ * rebroadcasts) and of transmissions that had to be repeated (collided or lost), smoothed over the last packets.
+ * Tgap shrinks with the window when the neighbors are fewer than referenceNeighbors.
+ * All the times are microseconds.
+ * */
+class LALContention
+{
+public:
+    /**
+     * \brief Constants of the timers, they can be changed at any time (see LLNomPolicy::setContention)
+     * */
+    struct Parameters {
+        /** The window follows the neighbors and the rates; if false it is always maxTca, as in the NOM paper */
+        bool adaptive;
+        /** Window of Tca with referenceNeighbors, or when not adaptive */
+        unsigned int maxTca;
+        /** Number of neighbors maxTca has been chosen for */
+        unsigned int referenceNeighbors;
+        /** Bounds of the adaptive window */
+        unsigned int minWindow;
+        unsigned int maxWindow;
+        /** Tgap of a node next to the previous hop */
+        unsigned int Tdist;
+        /** Maximum range of the wireless transmissions (meters), Tgap is 0 beyond it */
+        unsigned int Dmax;
+        /** How much the window is stretched by the fraction of duplicate interests heard */
+        double duplicateWeight;
+        /** How much the window is stretched by the fraction of retransmissions */
+        double retransmissionWeight;
+
+        /** The defaults: the constants of the NOM paper, with 7 neighbors */
+        Parameters();
+    };
+
+    /**
+     * \brief Parses a comma separated list of name=value, such as "adaptive=off,maxTca=3000"
+     *
+     * The names are the fields of Parameters, adaptive takes on or off.
+     * \param parameters the function will change the fields listed in spec
+     * \return false if spec has an unknown name or an invalid value, parameters may be partially changed
+     * */
+    static bool parse(const std::string &spec, Parameters &parameters);
+
+    /**
+     * \param parameters the constants, read at every call: they are referenced, not copied
+     * */
+    explicit LALContention(const Parameters &parameters);
+
+    /**
+     * \brief An interest has been received, duplicate if it had already been heard or sent
+     * */
+    void interestHeard(bool duplicate);
+
+    /**
+     * \brief A packet has been transmitted, retransmission if it is not its first transmission
+     * */
+    void packetSent(bool retransmission);
+
+    /**
+     * \brief Window of Tca with the given number of neighbors
+     * */
+    unsigned int getWindow(size_t neighbors) const;
+
+    /**
+     * \brief Delay of the first transmission of a packet, Tca + Tgap
+     *
+     * \param neighbors number of neighbors heard recently
+     * \param distance distance from the previous hop, or progress towards the destination (meters);
+     * negative for a packet generated locally, that has no Tgap
+     * */
+    uint64_t getDeferral(size_t neighbors, double distance) const;
+
+    /** Smoothed fraction of the interests heard that were duplicates (0-1) */
+    double getDuplicateRate() const { return duplicateRate; }
+
+    /** Smoothed fraction of the transmissions that were retransmissions (0-1) */
+    double getRetransmissionRate() const { return retransmissionRate; }
+
+private:
+    const Parameters &parameters;
+    double duplicateRate;
+    double retransmissionRate;
+};
+
+} /* namespace vndn */
+
+#endif /* LAL_CONTENTION_H_ */
@@ -17,60 +17,150 @@
  */
 
 #include "lal-stats.h"
+#include "timer-wheel.h"
 #include "corelib/log.h"
 
+#include <cstdio>
+#include <cstring>
+
 NS_LOG_COMPONENT_DEFINE("LALStatistic");
 
 
 namespace vndn
 {
 
-LALStatistic::LALStatistic()
+const char *const LALStatistic::names[COUNTER_COUNT] = {
+    "interestPktsSent",
+    "contentPktsSent",
+    "interestSendRequests",
+    "contentSendRequests",
+    "interestPktsRecv",
+    "contentPktsRecv",
+    "interestBytesRecv",
+    "contentBytesRecv",
+    "interestPktsAccepted",
+    "contentPktsAccepted",
+    "interestTransmissions",
+    "contentTransmissions",
+    "interestBytesTransmitted",
+    "contentBytesTransmitted",
+    "framesSent",
+    "bytesSent",
+    "framesRecv",
+    "bytesRecv",
+    "invalidFrames",
+    "ackCount",
+    "retxCount",
+    "satisfiedInterests",
+    "givenUpCount",
+    "aggregatedFrames",
+    "aggregatedPkts",
+    "unicastPkts",
+    "compressedPkts",
+    "compressionSavedBytes",
+    "prefixMisses",
+    "suppressedDuplicates",
+    "ringDrops"
+};
+
+// counters whose rate per second is reported
+static const LALStatistic::Counter rateCounters[] = {
+    LALStatistic::FRAMES_SENT,
+    LALStatistic::BYTES_SENT,
+    LALStatistic::FRAMES_RECEIVED,
+    LALStatistic::BYTES_RECEIVED,
+    LALStatistic::INTEREST_TRANSMISSIONS,
+    LALStatistic::CONTENT_TRANSMISSIONS,
+    LALStatistic::RETRANSMISSIONS,
+    LALStatistic::ACKED,
+    LALStatistic::GIVEN_UP,
+    LALStatistic::RING_DROPS
+};
+
+/**
+ * The parts of the LinkLayerStats message written by a loop, NS_LOG_JSON takes a single expression
+ */
+struct CountersJson {
+    const char *const *names;
+    const uint64_t *delta;
+    double interval;
+    bool rates;
+};
+
+struct NeighborsJson {
+    const std::vector<NeighborTable::Neighbor> *neighbors;
+    uint64_t now;
+};
+
+static log::JsonLogger &operator<<(log::JsonLogger &json, const CountersJson &counters)
 {
-    resetStats();
+    json << log::JsonMapOpen;
+    if (counters.rates) {
+        for (size_t i = 0; i < sizeof(rateCounters) / sizeof(rateCounters[0]); i++) {
+            const LALStatistic::Counter c = rateCounters[i];
+            json << counters.names[c] << (counters.interval > 0 ? counters.delta[c] / counters.interval : 0.0);
+        }
+    } else {
+        for (int i = 0; i < LALStatistic::COUNTER_COUNT; i++) {
+            json << counters.names[i] << (double) counters.delta[i];
+        }
+        const uint64_t *d = counters.delta;
+        json << "totalPktsSent"     << (double) (d[LALStatistic::INTEREST_SENT] + d[LALStatistic::CONTENT_SENT])
+             << "totalSendRequests" << (double) (d[LALStatistic::INTEREST_SEND_REQUESTS] + d[LALStatistic::CONTENT_SEND_REQUESTS])
+             << "totalPktsRecv"     << (double) (d[LALStatistic::INTEREST_RECEIVED] + d[LALStatistic::CONTENT_RECEIVED])
+             << "totalPktsAccepted" << (double) (d[LALStatistic::INTEREST_ACCEPTED] + d[LALStatistic::CONTENT_ACCEPTED]);
+    }
+    return json << log::JsonMapClose;
 }
 
-void LALStatistic::sendToLog()
+static log::JsonLogger &operator<<(log::JsonLogger &json, const NeighborsJson &table)
 {
-    NS_LOG_JSON(log::LinkLayerStats,
-                "stats"                 << log::JsonMapOpen <<
-                "interestPktsSent"      << interestSent <<
-                "contentPktsSent"       << contentSent <<
-                "totalPktsSent"         << pktSent <<
-                "interestSendRequests"  << sendingOutInterestRequest <<
-                "contentSendRequests"   << sendingOutContentRequest <<
-                "totalSendRequests"     << sendingOutRequest <<
-                "interestPktsRecv"      << receivedInterest <<
-                "contentPktsRecv"       << receivedContent <<
-                "totalPktsRecv"         << receivedPacket <<
-                "interestPktsAccepted"  << receivedInterestGoingUp <<
-                "contentPktsAccepted"   << receivedContentGoingUp <<
-                "totalPktsAccepted"     << receivedPacketGoingUp <<
-                "ackCount"              << ackedPacket <<
-                "retxCount"             << numberOfRetransmission <<
-                "satisfiedInterests"    << interestAckedByContent <<
-                log::JsonMapClose);
-
-    resetStats();
+    json << log::JsonArrayOpen;
+    for (size_t i = 0; i < table.neighbors->size(); i++) {
+        const NeighborTable::Neighbor &neighbor = (*table.neighbors)[i];
+        char mac[18];
+        snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x", neighbor.mac[0], neighbor.mac[1],
+                 neighbor.mac[2], neighbor.mac[3], neighbor.mac[4], neighbor.mac[5]);
+        json << log::JsonMapOpen
+             << "mac" << mac
+             << "frames" << neighbor.frames
+             << "bytes" << (double) neighbor.bytes
+             << "lastSeenMs" << (table.now > neighbor.lastSeen ? (table.now - neighbor.lastSeen) / 1e3 : 0.0)
+             << log::JsonMapClose;
+    }
+    return json << log::JsonArrayClose;
 }
 
-void LALStatistic::resetStats()
+LALStatistic::LALStatistic()
+    : loggedTime(TimerWheel::now()), queuePeak(0)
+{
+    memset(totals, 0, sizeof(totals));
+    memset(logged, 0, sizeof(logged));
+}
+
+void LALStatistic::sendToLog(uint64_t now, size_t queueDepth, const std::vector<NeighborTable::Neighbor> &neighbors)
 {
-    pktSent = 0;
-    interestSent = 0;
-    contentSent = 0;
-    sendingOutRequest = 0;
-    sendingOutContentRequest = 0;
-    sendingOutInterestRequest = 0;
-    receivedPacket = 0;
-    receivedContent = 0;
-    receivedInterest = 0;
-    receivedPacketGoingUp = 0;
-    receivedContentGoingUp = 0;
-    receivedInterestGoingUp = 0;
-    ackedPacket = 0;
-    numberOfRetransmission = 0;
-    interestAckedByContent = 0;
+    uint64_t delta[COUNTER_COUNT];
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        delta[i] = totals[i] - logged[i];
+    }
+    const double interval = now > loggedTime ? (now - loggedTime) / 1e6 : 0;
+    queuePeak = std::max(queuePeak, queueDepth);
+    const CountersJson stats = { names, delta, interval, false };
+    const CountersJson rates = { names, delta, interval, true };
+    const NeighborsJson table = { &neighbors, now };
+
+    NS_LOG_JSON(log::LinkLayerStats,
+                "intervalSec"   << interval <<
+                "stats"         << stats <<
+                "rates"         << rates <<
+                "queueDepth"    << (unsigned int) queueDepth <<
+                "queuePeak"     << (unsigned int) queuePeak <<
+                "neighbors"     << table);
+
+    memcpy(logged, totals, sizeof(logged));
+    loggedTime = now;
+    queuePeak = queueDepth;
 }
 
 }
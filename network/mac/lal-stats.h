@@ -19,8 +19,6 @@
 #ifndef LAL_STATISTIC_H_
 #define LAL_STATISTIC_H_
 
-#define LAL_STATISTICS
-
 /**
 
 #define STATISTIC-MONITORING
@@ -33,97 +31,134 @@
 * It's possible to get the delay statistic using the log
 */
 
+#include "neighbor-table.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
 
 namespace vndn
 {
 
+/**
+ * \brief Counters of the NDN-LAL
+ *
+ * The counters are 64 bit and never reset, so they are cheap to update and can be read at any time
+ * (see getTotal). sendToLog reports what happened since its previous call: the counts, their rate
+ * per second, the depth of the pending packet table and the neighbors heard.
+ * */
 class LALStatistic
 {
 public:
+    enum Counter {
+        /** Packets to send out (in addOutgoingPkt, if they are not present in packetStorage) */
+        INTEREST_SENT,
+        CONTENT_SENT,
+        /** Packets NDN asked to send out, also the ones already pending */
+        INTEREST_SEND_REQUESTS,
+        CONTENT_SEND_REQUESTS,
+        /** Packets received, whether they are retransmissions, discarded or sent up to NDN, and their size (bytes) */
+        INTEREST_RECEIVED,
+        CONTENT_RECEIVED,
+        INTEREST_BYTES_RECEIVED,
+        CONTENT_BYTES_RECEIVED,
+        /** Packets received that have been sent up to NDN */
+        INTEREST_ACCEPTED,
+        CONTENT_ACCEPTED,
+        /** Transmissions of the packets, retransmissions included, and the size of the packets stored (bytes) */
+        INTEREST_TRANSMISSIONS,
+        CONTENT_TRANSMISSIONS,
+        INTEREST_BYTES_TRANSMITTED,
+        CONTENT_BYTES_TRANSMITTED,
+        /** Frames sent and received, and their size with the NDN-LAL header (bytes) */
+        FRAMES_SENT,
+        BYTES_SENT,
+        FRAMES_RECEIVED,
+        BYTES_RECEIVED,
+        /** Frames received with an invalid or unknown NDN-LAL header */
+        INVALID_FRAMES,
+        /** Pending packets acked by a farther node (implicit acks) */
+        ACKED,
+        /** Transmissions of the packets after the first one */
+        RETRANSMISSIONS,
+        /** Pending interests acked by a content */
+        SATISFIED_INTERESTS,
+        /** Packets not retransmitted any more because enough partial acks have been heard */
+        GIVEN_UP,
+        /** Frames that carried several packets, and number of packets they carried */
+        AGGREGATED_FRAMES,
+        AGGREGATED_PACKETS,
+        /** Contents sent only to the neighbor that requested them */
+        UNICAST_PACKETS,
+        /** Packets sent with a reference to their name prefix, and bytes saved */
+        COMPRESSED_PACKETS,
+        COMPRESSION_SAVED_BYTES,
+        /** Packets received whose name prefix was unknown */
+        PREFIX_MISSES,
+        /** Packets received not sent up to NDN because it had exchanged them recently */
+        SUPPRESSED_DUPLICATES,
+        /** Packets received that could not be sent up to NDN, the shared memory with the face was full */
+        RING_DROPS,
+        COUNTER_COUNT
+    };
+
     LALStatistic();
     virtual ~LALStatistic() {}
 
     /**
-     * \brief Sends all the statistic information to the log
+     * \brief Sends the statistics since the previous call to the log, as a LinkLayerStats JSON message
+     *
+     * \param now current time (microseconds, see TimerWheel::now)
+     * \param queueDepth number of packets pending
+     * \param neighbors the neighbors heard recently
      * */
-    void sendToLog();
-
-    void increaseInterestSent() {interestSent++; pktSent++;}
-    void increaseContentSent() {contentSent++; pktSent++;}
-    void increaseSendingOutContentRequest() {sendingOutContentRequest++; sendingOutRequest++;}
-    void increaseSendingOutInterestRequest() {sendingOutInterestRequest++; sendingOutRequest++;}
-    void increaseReceivedContent() {receivedContent++; receivedPacket++;}
-    void increaseReceivedInterest() {receivedInterest++; receivedPacket++;}
-    void increaseReceivedContentGoingUp() {receivedContentGoingUp++; receivedPacketGoingUp++;}
-    void increaseReceivedInterestGoingUp() {receivedInterestGoingUp++; receivedPacketGoingUp++;}
-    void increaseAckedPacket() {ackedPacket++;}
-    void increaseNumberOfRetransmission() {numberOfRetransmission++;}
-    void increaseInterestAckedByContent() {interestAckedByContent++;}
-
-protected:
-    /**
-     * \brief Set all variables to their initial values.
-     */
-    void resetStats();
-
-    /**
-     * \brief Number of packets sent out (effecively sent out)
-     *     (in addOutoingPkt if is not present in packetStorage)
-     */
-    unsigned int pktSent;   //derived data: interestSent+contentSent;
-
-    /**
-     * \brief Number of interests sent out (effecively sent out)
-     *     (in addOutoingPkt if is not present in packetStorage)
-     */
-    unsigned int interestSent;
-
-    /**
-     * \brief Number of contents sent out (effecively sent out)
-     *     (in addOutoingPkt if is not present in packetStorage)
-     */
-    unsigned int contentSent;
+    void sendToLog(uint64_t now, size_t queueDepth, const std::vector<NeighborTable::Neighbor> &neighbors);
+
+    /** Value of a counter since the creation */
+    uint64_t getTotal(Counter counter) const { return totals[counter]; }
+
+    void increaseInterestSent() {totals[INTEREST_SENT]++;}
+    void increaseContentSent() {totals[CONTENT_SENT]++;}
+    void increaseSendingOutContentRequest() {totals[CONTENT_SEND_REQUESTS]++;}
+    void increaseSendingOutInterestRequest() {totals[INTEREST_SEND_REQUESTS]++;}
+    void increaseReceivedContent(unsigned int size) {totals[CONTENT_RECEIVED]++; totals[CONTENT_BYTES_RECEIVED] += size;}
+    void increaseReceivedInterest(unsigned int size) {totals[INTEREST_RECEIVED]++; totals[INTEREST_BYTES_RECEIVED] += size;}
+    void increaseReceivedContentGoingUp() {totals[CONTENT_ACCEPTED]++;}
+    void increaseReceivedInterestGoingUp() {totals[INTEREST_ACCEPTED]++;}
+    void increaseContentTransmission(unsigned int size) {totals[CONTENT_TRANSMISSIONS]++; totals[CONTENT_BYTES_TRANSMITTED] += size;}
+    void increaseInterestTransmission(unsigned int size) {totals[INTEREST_TRANSMISSIONS]++; totals[INTEREST_BYTES_TRANSMITTED] += size;}
+    void increaseFrameSent(unsigned int size) {totals[FRAMES_SENT]++; totals[BYTES_SENT] += size;}
+    void increaseFrameReceived(unsigned int size) {totals[FRAMES_RECEIVED]++; totals[BYTES_RECEIVED] += size;}
+    void increaseInvalidFrame() {totals[INVALID_FRAMES]++;}
+    void increaseAckedPacket() {totals[ACKED]++;}
+    void increaseNumberOfRetransmission() {totals[RETRANSMISSIONS]++;}
+    void increaseInterestAckedByContent() {totals[SATISFIED_INTERESTS]++;}
+    void increaseGivenUpPacket() {totals[GIVEN_UP]++;}
+    void increaseAggregatedFrame(unsigned int packets) {totals[AGGREGATED_FRAMES]++; totals[AGGREGATED_PACKETS] += packets;}
+    void increaseUnicastPacket() {totals[UNICAST_PACKETS]++;}
+    void increaseCompressedPacket(unsigned int savedBytes) {totals[COMPRESSED_PACKETS]++; totals[COMPRESSION_SAVED_BYTES] += savedBytes;}
+    void increasePrefixMiss() {totals[PREFIX_MISSES]++;}
+    void increaseSuppressedDuplicate() {totals[SUPPRESSED_DUPLICATES]++;}
+    void increaseRingDrop() {totals[RING_DROPS]++;}
 
     /**
-     * \brief Number of packet NDN requests to send out
-     * It counts also the packet that NDN-LAL doesn't send out because already pending
-     * (in addOutoingPk, whenever is present or not in packetStorage)
-     */
-    unsigned int sendingOutRequest;  // sendingOutContentRequest + sendingOutInterestRequest
-    unsigned int sendingOutContentRequest;
-    unsigned int sendingOutInterestRequest;
-
-    /**
-     * \brief Number of received packet
-     * It counts all the received packet, no matter if it's a retransmission, if the pkt is discarded or if it's transmitted up to NDN
-     */
-    unsigned int receivedPacket;  //receivedContent + receivedInterest
-    unsigned int receivedContent;
-    unsigned int receivedInterest;
+     * \brief The pending packet table holds depth packets, its peak is reported by sendToLog
+     * */
+    void updateQueueDepth(size_t depth) {queuePeak = std::max(queuePeak, depth);}
 
-    /**
-     * \brief number or received packets that LAL sends up to NDN
-     */
-    unsigned int receivedPacketGoingUp; //receivedContentGoingUp + receivedInterestGoingUp
-    unsigned int receivedContentGoingUp;
-    unsigned int receivedInterestGoingUp;
+protected:
+    /** Name of each counter in the JSON messages */
+    static const char *const names[COUNTER_COUNT];
 
-    /**
-     * \brief Number of acked packet
-     */
-    unsigned int ackedPacket;
+    uint64_t totals[COUNTER_COUNT];
 
-    /**
-     * \brief Total number of retransmission
-     * It counts the total number of retransmission of the packets send out and acked successfully
-     * The counter will be reset every time the statistic will be transmitted
-     */
-    unsigned int numberOfRetransmission;
+    /** Counters and time at the previous sendToLog */
+    uint64_t logged[COUNTER_COUNT];
+    uint64_t loggedTime;
 
-    /**
-     * \brief Number of interests acked by a content
-     */
-    unsigned int interestAckedByContent;
+    /** Highest depth of the pending packet table since the previous sendToLog */
+    size_t queuePeak;
 };
 
 }
@@ -27,6 +27,6 @@
 #define MAXNETWORKPKTSIZE 1500
 
 /** Specifies the max size of a packet that can be managed by the link layer (it's less than the max size supported by the network interface because the NDN-link layer has to add its header */
-static const int MAXLLSIZE = MAXNETWORKPKTSIZE - sizeof(struct vndn::llHeader);
+static const int MAXLLSIZE = MAXNETWORKPKTSIZE - vndn::LL_HEADER_MAX_SIZE;
 
 #endif /* LINKLAYER_H_ */
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "ll-header.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace vndn {
+
+static const double MICRODEGREES = 1e6;
+
+LLHeaderInfo::LLHeaderInfo()
+    : lat(DEFAULT_COORDINATE_DOUBLE), longitude(DEFAULT_COORDINATE_DOUBLE)
+    , heading(0), speed(0), timestamp(0), tos(0), flags(0), format(LL_HEADER_BINARY)
+{
+}
+
+/**
+ * \brief Parses a coordinate of the ASCII header, which is not always null-terminated
+ */
+static double parseCoordinate(const char field[GPS_STRING_SIZE])
+{
+    char s[GPS_STRING_SIZE + 1];
+    memcpy(s, field, GPS_STRING_SIZE);
+    s[GPS_STRING_SIZE] = '\0';
+    return strtod(s, NULL);
+}
+
+static void formatCoordinate(char field[GPS_STRING_SIZE], double value)
+{
+    char s[32];
+    memset(s, 0, sizeof(s));
+    snprintf(s, sizeof(s), "%.6f", value);
+    memcpy(field, s, GPS_STRING_SIZE);
+}
+
+size_t writeLLHeader(uint8_t *buffer, LLHeaderFormat format, const LLHeaderInfo &info)
+{
+    const bool positionValid = (info.flags & LL_HEADER_POSITION_VALID) != 0;
+    if (format == LL_HEADER_ASCII) {
+        llHeader hdr;
+        if (positionValid) {
+            formatCoordinate(hdr.lat, info.lat);
+            formatCoordinate(hdr.longitude, info.longitude);
+        } else {
+            strncpy(hdr.lat, DEFAULT_COORDINATE_CHAR, GPS_STRING_SIZE);
+            strncpy(hdr.longitude, DEFAULT_COORDINATE_CHAR, GPS_STRING_SIZE);
+        }
+        hdr.tos = htonl(info.tos);
+        memcpy(buffer, &hdr, sizeof(hdr));
+        return sizeof(hdr);
+    }
+
+    llHeaderBinary hdr;
+    hdr.version = LL_HEADER_BINARY_VERSION;
+    hdr.flags = info.flags;
+    hdr.tos = info.tos;
+    hdr.reserved = 0;
+    hdr.lat = htonl(positionValid ? (int32_t) lround(info.lat * MICRODEGREES) : 0);
+    hdr.longitude = htonl(positionValid ? (int32_t) lround(info.longitude * MICRODEGREES) : 0);
+    double heading = std::fmod(info.heading, 360.0);
+    if (heading < 0)
+        heading += 360;
+    hdr.heading = htons((uint16_t) std::min(lround(heading * 100), 35999L));
+    hdr.speed = htons((uint16_t) std::max(0L, std::min(lround(info.speed * 100), 65535L)));
+    hdr.timestamp = htonl(info.timestamp);
+    memcpy(buffer, &hdr, sizeof(hdr));
+    return sizeof(hdr);
+}
+
+int readLLHeader(const uint8_t *buffer, size_t len, LLHeaderInfo &info)
+{
+    if (len < 1)
+        return -1;
+
+    if ((buffer[0] & 0x80) == 0) {
+        // ASCII header, starts with the latitude
+        if (len < sizeof(llHeader))
+            return -1;
+        const llHeader *hdr = (const llHeader *) buffer;
+        info.format = LL_HEADER_ASCII;
+        info.lat = parseCoordinate(hdr->lat);
+        info.longitude = parseCoordinate(hdr->longitude);
+        info.heading = 0;
+        info.speed = 0;
+        info.timestamp = 0;
+        info.tos = ntohl(hdr->tos);
+        info.flags = info.lat == DEFAULT_COORDINATE_DOUBLE || info.longitude == DEFAULT_COORDINATE_DOUBLE ? 0 : LL_HEADER_POSITION_VALID;
+        return sizeof(llHeader);
+    }
+
+    if (buffer[0] != LL_HEADER_BINARY_VERSION || len < sizeof(llHeaderBinary))
+        return -1;
+    llHeaderBinary hdr;
+    memcpy(&hdr, buffer, sizeof(hdr));
+    info.format = LL_HEADER_BINARY;
+    info.flags = hdr.flags;
+    if (hdr.flags & LL_HEADER_POSITION_VALID) {
+        info.lat = (int32_t) ntohl(hdr.lat) / MICRODEGREES;
+        info.longitude = (int32_t) ntohl(hdr.longitude) / MICRODEGREES;
+    } else {
+        info.lat = DEFAULT_COORDINATE_DOUBLE;
+        info.longitude = DEFAULT_COORDINATE_DOUBLE;
+    }
+    if (hdr.flags & LL_HEADER_MOTION_VALID) {
+        info.heading = ntohs(hdr.heading) / 100.0;
+        info.speed = ntohs(hdr.speed) / 100.0;
+    } else {
+        info.heading = 0;
+        info.speed = 0;
+    }
+    info.timestamp = ntohl(hdr.timestamp);
+    info.tos = hdr.tos;
+    return sizeof(llHeaderBinary);
+}
+
+size_t writeLLAggregateRecord(uint8_t *buffer, int tos, size_t length)
+{
+    llAggregateRecord record;
+    record.tos = tos;
+    record.length = htons(length);
+    memcpy(buffer, &record, sizeof(record));
+    return sizeof(record);
+}
+
+int readLLAggregateRecord(const uint8_t *buffer, size_t len, int &tos, size_t &length)
+{
+    if (len < sizeof(llAggregateRecord))
+        return -1;
+    llAggregateRecord record;
+    memcpy(&record, buffer, sizeof(record));
+    tos = record.tos;
+    length = ntohs(record.length);
+    if (length == 0 || length > len - sizeof(record))
+        return -1;
+    return sizeof(llAggregateRecord);
+}
+
+size_t writeLLPrefixRecord(uint8_t *buffer, uint8_t mode, uint8_t id, size_t offset, uint16_t value)
+{
+    if (mode == LL_PREFIX_NONE) {
+        buffer[0] = mode;
+        return 1;
+    }
+    llPrefixRecord record;
+    record.mode = mode;
+    record.id = id;
+    record.offset = htons(offset);
+    record.value = htons(value);
+    memcpy(buffer, &record, sizeof(record));
+    return sizeof(record);
+}
+
+int readLLPrefixRecord(const uint8_t *buffer, size_t len, uint8_t &mode, uint8_t &id, size_t &offset, uint16_t &value)
+{
+    if (len < 1)
+        return -1;
+    mode = buffer[0];
+    if (mode == LL_PREFIX_NONE)
+        return 1;
+    if ((mode != LL_PREFIX_DEFINE && mode != LL_PREFIX_REFERENCE) || len < sizeof(llPrefixRecord))
+        return -1;
+    llPrefixRecord record;
+    memcpy(&record, buffer, sizeof(record));
+    id = record.id;
+    offset = ntohs(record.offset);
+    value = ntohs(record.value);
+    return sizeof(llPrefixRecord);
+}
+
+}
@@ -18,7 +18,10 @@
 #ifndef LL_HEADER_H_
 #define LL_HEADER_H_
 
+#include <linux/if_ether.h>
 #include <string>
+#include <stddef.h>
+#include <stdint.h>
 
 /** Defines the number of character used to define a coordinate (latitude or longitude) */
 #define GPS_STRING_SIZE 12  //+ or - , 3 for integer part, . , 6 decimals: -123.456789
@@ -30,11 +33,15 @@
 namespace vndn {
 
 /**
- * \brief Defines the "ndn link layer header".
+ * \brief Defines the "ndn link layer header" in the original ASCII format.
  *
  * It encapsulates the ndn packet and is encapsulated by 802.11 header.
  * The header carries the following information: gps coordinates (in decimal
  * degree format), tos (type of service), heading of the node.
+ *
+ * This format is still understood by every node, and sent if the binary
+ * format is disabled (see LLNomPolicy::setHeaderFormat), so that nodes can
+ * be upgraded one at a time.
  */
 struct llHeader {
     /**
@@ -56,6 +63,185 @@ struct llHeader {
 
 } __attribute__((packed));
 
+/**
+ * \brief Defines the "ndn link layer header" in the binary format, all the fields are in network byte order
+ *
+ * The first byte is the version of the format, which has the most significant
+ * bit set: an ASCII header starts with the sign or the first digit of the
+ * latitude, so the receiver tells the two formats apart from the first byte.
+ */
+struct llHeaderBinary {
+    /** LL_HEADER_BINARY_VERSION */
+    uint8_t version;
+
+    /** LL_HEADER_POSITION_VALID, LL_HEADER_MOTION_VALID, LL_HEADER_AGGREGATE and LL_HEADER_PREFIX_COMPRESSION */
+    uint8_t flags;
+
+    /** as llHeader::tos */
+    uint8_t tos;
+
+    uint8_t reserved;
+
+    /** Latitude of the node, in microdegrees */
+    int32_t lat;
+
+    /** Longitude of the node, in microdegrees */
+    int32_t longitude;
+
+    /** Heading of the node, in hundredths of degree clockwise from north */
+    uint16_t heading;
+
+    /** Speed of the node, in cm/s */
+    uint16_t speed;
+
+    /** Time of transmission, in milliseconds since the epoch modulo 2^32 */
+    uint32_t timestamp;
+
+} __attribute__((packed));
+
+static const uint8_t LL_HEADER_BINARY_VERSION = 0x81;
+
+/** The coordinates are valid (the node has a gps fix) */
+static const uint8_t LL_HEADER_POSITION_VALID = 0x01;
+/** The speed and the heading are valid */
+static const uint8_t LL_HEADER_MOTION_VALID = 0x02;
+/** The frame carries several NDN packets, each one preceded by a llAggregateRecord */
+static const uint8_t LL_HEADER_AGGREGATE = 0x04;
+/** Every NDN packet of the frame is preceded by a llPrefixRecord (after its llAggregateRecord, if any) */
+static const uint8_t LL_HEADER_PREFIX_COMPRESSION = 0x08;
+
+/** Size of the biggest header, to be reserved in every frame */
+static const size_t LL_HEADER_MAX_SIZE = sizeof(llHeader) > sizeof(llHeaderBinary) ? sizeof(llHeader) : sizeof(llHeaderBinary);
+
+/**
+ * \brief Sub-header of every NDN packet of an aggregated frame (see LL_HEADER_AGGREGATE), in network byte order
+ *
+ * Only the binary header can be aggregated. The header of the frame describes the sender,
+ * which is the same for all the packets, the records carry what is specific to each packet.
+ */
+struct llAggregateRecord {
+    /** as llHeader::tos, for this packet */
+    uint8_t tos;
+
+    /** Size of the NDN packet that follows the record */
+    uint16_t length;
+
+} __attribute__((packed));
+
+/**
+ * \brief Sub-header of an NDN packet whose name prefix may be compressed (see LL_HEADER_PREFIX_COMPRESSION),
+ * in network byte order
+ *
+ * Each sender numbers the name prefixes it sends. A LL_PREFIX_DEFINE record tells the receivers that
+ * the length bytes of the packet starting at offset are the prefix id; a LL_PREFIX_REFERENCE record tells
+ * that prefix id has been removed from the packet at offset, check being a hash of the prefix that lets the
+ * receivers detect a stale dictionary. A LL_PREFIX_NONE record is made only of its mode.
+ */
+struct llPrefixRecord {
+    /** LL_PREFIX_NONE, LL_PREFIX_DEFINE or LL_PREFIX_REFERENCE */
+    uint8_t mode;
+
+    uint8_t id;
+
+    /** Position of the prefix in the NDN packet */
+    uint16_t offset;
+
+    /** Length of the prefix (LL_PREFIX_DEFINE) or its check (LL_PREFIX_REFERENCE) */
+    uint16_t value;
+
+} __attribute__((packed));
+
+static const uint8_t LL_PREFIX_NONE = 0;
+static const uint8_t LL_PREFIX_DEFINE = 1;
+static const uint8_t LL_PREFIX_REFERENCE = 2;
+
+/**
+ * \brief Format of the header sent by a node
+ */
+enum LLHeaderFormat {
+    LL_HEADER_ASCII,
+    LL_HEADER_BINARY
+};
+
+/**
+ * \brief Content of a NDN-LAL header, independent of its format
+ */
+struct LLHeaderInfo {
+    /** Latitude and longitude in decimal degrees, DEFAULT_COORDINATE_DOUBLE if not valid */
+    double lat;
+    double longitude;
+    /** Heading in degrees and speed in m/s, 0 if not known */
+    double heading;
+    double speed;
+    /** Time of transmission, in milliseconds modulo 2^32 (0 in the ASCII format) */
+    uint32_t timestamp;
+    int tos;
+    /** LL_HEADER_POSITION_VALID, LL_HEADER_MOTION_VALID, LL_HEADER_AGGREGATE and LL_HEADER_PREFIX_COMPRESSION */
+    uint8_t flags;
+    LLHeaderFormat format;
+
+    LLHeaderInfo();
+};
+
+/**
+ * \brief Writes the header described by info in buffer, in the given format
+ *
+ * \param buffer must have room for LL_HEADER_MAX_SIZE bytes
+ * \return size of the header
+ */
+size_t writeLLHeader(uint8_t *buffer, LLHeaderFormat format, const LLHeaderInfo &info);
+
+/**
+ * \brief Reads the header at the beginning of a frame, in either format
+ *
+ * \param len size of the frame
+ * \return size of the header, or -1 if the frame is too short or its version is unknown
+ */
+int readLLHeader(const uint8_t *buffer, size_t len, LLHeaderInfo &info);
+
+/**
+ * \brief Writes the record of a packet of an aggregated frame
+ *
+ * \return size of the record
+ */
+size_t writeLLAggregateRecord(uint8_t *buffer, int tos, size_t length);
+
+/**
+ * \brief Reads the record of the next packet of an aggregated frame
+ *
+ * \param len bytes left in the frame
+ * \param length it will store the size of the packet that follows the record
+ * \return size of the record, or -1 if the record or its packet exceed the frame
+ */
+int readLLAggregateRecord(const uint8_t *buffer, size_t len, int &tos, size_t &length);
+
+/**
+ * \brief Writes the prefix record of a packet
+ *
+ * \return size of the record, 1 for LL_PREFIX_NONE and sizeof(llPrefixRecord) otherwise
+ */
+size_t writeLLPrefixRecord(uint8_t *buffer, uint8_t mode, uint8_t id, size_t offset, uint16_t value);
+
+/**
+ * \brief Reads the prefix record at the beginning of a packet
+ *
+ * \param len size of the packet, record included
+ * \return size of the record, or -1 if it is too short or its mode is unknown
+ */
+int readLLPrefixRecord(const uint8_t *buffer, size_t len, uint8_t &mode, uint8_t &id, size_t &offset, uint16_t &value);
+
+/**
+ * \brief Packs a MAC address in an integer, to key the tables of the neighbors
+ */
+inline uint64_t macKey(const unsigned char mac[ETH_ALEN])
+{
+    uint64_t key = 0;
+    for (int i = 0; i < ETH_ALEN; i++) {
+        key = (key << 8) | mac[i];
+    }
+    return key;
+}
+
 }
 
 #endif // LL_HEADER_H_
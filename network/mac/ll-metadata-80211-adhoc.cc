@@ -16,11 +16,18 @@
  */
 
 #include "ll-metadata-80211-adhoc.h"
+#include "ll-header.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace vndn
 {
 
 LLMetadata80211AdHoc::LLMetadata80211AdHoc()
+    : previousHopMacKnown(false)
+    , localInfo(DEFAULT_COORDINATE_DOUBLE, DEFAULT_COORDINATE_DOUBLE)
+    , progress(-1)
 {
     TOS = 0;
     requestSourceInfoType = OVER_ADHOC;
@@ -31,6 +38,9 @@ LLMetadata80211AdHoc::~LLMetadata80211AdHoc()
 }
 
 LLMetadata80211AdHoc::LLMetadata80211AdHoc(GeoStorage &gs)
+    : previousHopMacKnown(false)
+    , localInfo(DEFAULT_COORDINATE_DOUBLE, DEFAULT_COORDINATE_DOUBLE)
+    , progress(-1)
 {
     requestSourceInfoType = OVER_ADHOC;
     previousHopInfo = gs;
@@ -52,6 +62,42 @@ void LLMetadata80211AdHoc::setPreviousHopInfo(const GeoStorage &previousHopInfo)
     this->previousHopInfo = previousHopInfo;
 }
 
+void LLMetadata80211AdHoc::setPreviousHopMac(const unsigned char mac[ETH_ALEN])
+{
+    memcpy(previousHopMac, mac, ETH_ALEN);
+    previousHopMacKnown = true;
+}
+
+const unsigned char *LLMetadata80211AdHoc::getPreviousHopMac() const
+{
+    return previousHopMacKnown ? previousHopMac : NULL;
+}
+
+const GeoStorage &LLMetadata80211AdHoc::getLocalInfo() const
+{
+    return localInfo;
+}
+
+void LLMetadata80211AdHoc::setLocalInfo(const GeoStorage &localInfo)
+{
+    this->localInfo = localInfo;
+}
+
+void LLMetadata80211AdHoc::setProgress(double meters)
+{
+    progress = std::max(0.0, meters);
+}
+
+bool LLMetadata80211AdHoc::hasProgress() const
+{
+    return progress >= 0;
+}
+
+double LLMetadata80211AdHoc::getProgress() const
+{
+    return progress;
+}
+
 void LLMetadata80211AdHoc::setTos(int value)
 {
     if (0 <= value && value <= 100)
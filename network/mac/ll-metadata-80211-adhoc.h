@@ -21,6 +21,8 @@
 #include "ll-metadata.h"
 #include "geo-storage.h"
 
+#include <linux/if_ether.h>
+
 namespace vndn
 {
 
@@ -68,6 +70,48 @@ public:
      * */
     void setPreviousHopInfo(const GeoStorage &previousHopInfo);
 
+    /**
+     * \brief Set the MAC address of the previous hop
+     * */
+    void setPreviousHopMac(const unsigned char mac[ETH_ALEN]);
+
+    /**
+     * \brief Get the MAC address of the previous hop
+     * \return NULL if it is not known (e.g. the packet is generated locally)
+     * */
+    const unsigned char *getPreviousHopMac() const;
+
+    /**
+     * \brief Get the position of the local node when the packet was received
+     * \return the GeoStorage of the local node, with DEFAULT_COORDINATE_DOUBLE coordinates if they were not valid
+     * */
+    const GeoStorage &getLocalInfo() const;
+
+    /**
+     * \brief Set the position of the local node when the packet was received
+     * \param localInfo GeoStorage relative to the local node
+     * */
+    void setLocalInfo(const GeoStorage &localInfo);
+
+    /**
+     * \brief Set the progress of the local node towards the destination of the packet
+     *
+     * It's set by the forwarding strategy when the packet is forwarded, the link layer
+     * uses it instead of the distance from the previous hop to schedule the transmission
+     * \param meters how much closer to the destination the local node is, with respect to the previous hop
+     * */
+    void setProgress(double meters);
+
+    /**
+     * \brief Whether the forwarding strategy has set the progress towards the destination
+     * */
+    bool hasProgress() const;
+
+    /**
+     * \brief Get the progress towards the destination (in meters), see setProgress
+     * */
+    double getProgress() const;
+
     /**
      * \brief Set the value of TOS
      * \param value desired TOS value
@@ -88,6 +132,22 @@ protected:
      * */
     GeoStorage previousHopInfo;
 
+    /**
+     * MAC address of the previous hop, valid if previousHopMacKnown
+     * */
+    unsigned char previousHopMac[ETH_ALEN];
+    bool previousHopMacKnown;
+
+    /**
+     * Position of the local node when the packet has been received from the network
+     * */
+    GeoStorage localInfo;
+
+    /**
+     * Progress towards the destination of the packet (in meters), negative if unknown
+     * */
+    double progress;
+
     /**
      * Index (0-100) of desired reliability (100: the pkt has to go in every available path, 0 only one path is necessary)
      * */
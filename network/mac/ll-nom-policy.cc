@@ -34,7 +34,17 @@ using namespace geo;
 // TODO: Would the policy store the entire pkt (with LL header) or only the payload? the header (the position) should be recreated at every retransmission
 
 
+LLHeaderFormat LLNomPolicy::headerFormat = LL_HEADER_BINARY;
+bool LLNomPolicy::aggregation = true;
+bool LLNomPolicy::unicast = true;
+bool LLNomPolicy::prefixCompression = true;
+LALContention::Parameters LLNomPolicy::contentionParameters;
+
+static const unsigned char broadcastAddr[ETH_ALEN] = { 0xff , 0xff , 0xff , 0xff , 0xff , 0xff };
+
 LLNomPolicy::LLNomPolicy()
+    : backoff((uint64_t) secFirstRetransmission * 1000000 + usecFirstRetransmission)
+    , contention(contentionParameters)
 {
     srand(time(NULL));
     ackManager = new LALAckManagerByDistance();
@@ -49,55 +59,43 @@ LLNomPolicy::~LLNomPolicy()
 int LLNomPolicy::addOutgoingPkt(uint8_t pkt[], int *len, LLMetadata80211AdHoc *metadata, const LocationService & locationService)
 {
     NS_LOG_DEBUG("LLNomPolicy::addOutgoingPkt pkt len: " << *len);
-    std::string name;
+    PacketStorage::packetKey key;
     Ptr<const NameComponents> components;
     uint32_t nonce;
-#ifdef LAL_STATISTICS
+    unsigned char requester[ETH_ALEN];
+    const unsigned char *destination = NULL;
     bool packetSentIsAContent;
-#endif
     const Ptr<Packet> p =  Packet::InitFromBuffer((const uint8_t *)pkt, *len);
     try {
         NDNHeaderHelper::Type type = NDNHeaderHelper::GetNDNHeaderType (p);
         switch (type) {
         case NDNHeaderHelper::INTEREST: {
-#ifdef LAL_STATISTICS
             statistics.increaseSendingOutInterestRequest();
             packetSentIsAContent=false;
-#endif
             Ptr<InterestHeader> header = GetHeader<InterestHeader> (*p);
             components = header->GetName();
-            name.append(interestKey);
+            key = PacketStorage::makeKey(PacketStorage::INTEREST_PACKET, *components);
             NS_LOG_DEBUG("NAME " << * header->GetName());;
             nonce = header->GetNonce();
             NS_LOG_DEBUG("NONCE: " << nonce);
-            std::list<std::string> headerCmp = header->GetName()->GetComponents();
-            std::list<std::string>::iterator i;
-            for (i = headerCmp.begin(); i != headerCmp.end(); i++) {
-                name.append(*i);
-                name.append("/");
-            }
             NS_LOG_INFO("Received a pkt from NDND: type: INTEREST, name: "<< * header->GetName()<<" lenght: "<< *len<< " nonce: "<< nonce);
             break;
         }
         case NDNHeaderHelper::CONTENT_OBJECT: {
-#ifdef LAL_STATISTICS
             statistics.increaseSendingOutContentRequest();
             packetSentIsAContent=true;
-#endif
             Ptr<ContentObjectHeader> header = GetHeader<ContentObjectHeader> (*p);
             components = header->GetName();
-            name.append(dataKey);
-            std::string ndnName;
+            key = PacketStorage::makeKey(PacketStorage::CONTENT_PACKET, *components);
             nonce = -1; //content object doesn't have a nonce
-            std::list<std::string> headerCmp = header->GetName()->GetComponents();
             NS_LOG_DEBUG("NAME " << header->GetName());
-            std::list<std::string>::iterator i;
-            for (i = headerCmp.begin(); i != headerCmp.end(); ++i) {
-                ndnName.append(*i);
-                ndnName.append("/");
-            }
-            name.append(ndnName);
             NS_LOG_INFO("Received a pkt from NDND: type: CONTENT, name: "<< * header->GetName()<<" lenght: "<< *len);
+
+            //a big content requested by a single neighbor is sent only to it
+            if (unicast && neighbors.getRequester(*components, requester, TimerWheel::now()) && *len > unicastMinSize) {
+                NS_LOG_INFO("The content is sent to the neighbor that requested it: " << PRINTABLE_MAC_ADDRESS(requester));
+                destination = requester;
+            }
             
             /**we need to check if there is a pending interest for this content (the content could arrive from an other interface) */
             std::list<const PacketStorage::linkLayerPktElement *> matchingElements;
@@ -108,8 +106,8 @@ int LLNomPolicy::addOutgoingPkt(uint8_t pkt[], int *len, LLMetadata80211AdHoc *m
             } else {
                 while(matchIt!=matchingElements.end()){
                     const PacketStorage::linkLayerPktElement *el = *matchIt;
-                    NS_LOG_INFO("The content "<< * header->GetName() <<" satisfies the pending interest: " << el->name);
-                    if (storage.deletePktByKey(el->name) == -1) {
+                    NS_LOG_INFO("The content "<< * header->GetName() <<" satisfies the pending interest: " << *el->components);
+                    if (storage.deletePktByKey(el->key) == -1) {
                         NS_LOG_WARN("WARNING delete from storage failed. The pkt will be discarded anyway");
                     }
                     matchIt++;
@@ -132,15 +130,18 @@ int LLNomPolicy::addOutgoingPkt(uint8_t pkt[], int *len, LLMetadata80211AdHoc *m
         NS_LOG_WARN("Receiving a packet from NDND caused CcnbDecodingException");
         return DISCARD;
     }
+    //the copies of the packet that the neighbors will rebroadcast are not sent back up to NDND
+    duplicates.insert(key, nonce, TimerWheel::now());
+
     //Add link layer header at the pkt
-    uint8_t data[(*len) + sizeof(llHeader)];
-    llHeader llhdr;
+    uint8_t data[(*len) + LL_HEADER_MAX_SIZE];
+    LLHeaderInfo llhdr;
 
-    *len = setLLHeader(&llhdr, data, pkt, *len, locationService);
+    *len = setLLHeader(llhdr, data, pkt, *len, locationService);
     memcpy(pkt, data, *len);
 
-    std::pair <unsigned int, unsigned int> time;
-    //calculateNextTimer(0,maxRetransmissionNumber,&(time.first), &(time.second));
+    uint64_t deadline;
+    const int retransmissionNumber = destination != NULL ? unicastTransmissionNumber : maxRetransmissionNumber;
 
     //TODO pkt geo info has to be stored separately from data
     //header will be added, but only in the data that goes back to LLDaemon. The packetStorage stores only data
@@ -148,23 +149,24 @@ int LLNomPolicy::addOutgoingPkt(uint8_t pkt[], int *len, LLMetadata80211AdHoc *m
     if (metadata == NULL) { //pkt generated locally.
         NS_LOG_INFO("the packet received from NDND is generated locally, there is no metadata attached");
         GeoStorage geoS (locationService.getLatitude(), locationService.getLongitude());
-        calculateFirstTransmission(NULL, locationService, &(time.first), &(time.second));
-        AckInfo *ackInfo = ackManager->createAckInfo(locationService, NULL, llhdr);
-        res = storage.insertPkt(data, *len, maxRetransmissionNumber, name,components, nonce, time, geoS, ackInfo);
+        deadline = calculateFirstTransmission(NULL, locationService);
+        AckInfo *ackInfo = ackManager->createAckInfo(locationService, NULL, NULL, llhdr);
+        res = storage.insertPkt(data, *len, retransmissionNumber, key, components, nonce, deadline, geoS, ackInfo, destination);
 
     } else { //pkt has been forwarded, so we're keeping the position information about the previous hop
         if ((DEFAULT_COORDINATE_DOUBLE == metadata->getPreviousHopInfo().getLat()) || (DEFAULT_COORDINATE_DOUBLE == metadata->getPreviousHopInfo().getLongitude())) {
             NS_LOG_INFO("the packet received from NDND has been forwarded, but there is no valid gps info attached");
             //the source node hadn't valid gps coordinates. The packet should be considered as a locally generated packet (expect for TOS)
             GeoStorage geoS (locationService.getLatitude(), locationService.getLongitude());
-            calculateFirstTransmission(NULL, locationService, &(time.first), &(time.second));
-            AckInfo *ackInfo = ackManager->createAckInfo(locationService, NULL, llhdr);
-            res = storage.insertPkt(data, *len, maxRetransmissionNumber, name, components,nonce, time, geoS, ackInfo);
+            deadline = calculateFirstTransmission(NULL, locationService);
+            AckInfo *ackInfo = ackManager->createAckInfo(locationService, NULL, metadata->getPreviousHopMac(), llhdr);
+            res = storage.insertPkt(data, *len, retransmissionNumber, key, components, nonce, deadline, geoS, ackInfo, destination);
         } else {
             NS_LOG_INFO("the packet received from NDND has been forwarded from latitude: "<<metadata->getPreviousHopInfoAddr()->getLat()<<", longitude: "<<metadata->getPreviousHopInfoAddr()->getLongitude());
-            calculateFirstTransmission(metadata->getPreviousHopInfoAddr(), locationService, &(time.first), &(time.second));
-            AckInfo *ackInfo = ackManager->createAckInfo(locationService, metadata->getPreviousHopInfoAddr(), llhdr);
-            res = storage.insertPkt(data, *len, maxRetransmissionNumber, name,components, nonce, time, metadata->getPreviousHopInfo(), ackInfo);
+            deadline = calculateFirstTransmission(metadata->getPreviousHopInfoAddr(), locationService,
+                                                  metadata->hasProgress() ? metadata->getProgress() : -1);
+            AckInfo *ackInfo = ackManager->createAckInfo(locationService, metadata->getPreviousHopInfoAddr(), metadata->getPreviousHopMac(), llhdr);
+            res = storage.insertPkt(data, *len, retransmissionNumber, key, components, nonce, deadline, metadata->getPreviousHopInfo(), ackInfo, destination);
         }
         delete metadata;
 
@@ -173,13 +175,15 @@ int LLNomPolicy::addOutgoingPkt(uint8_t pkt[], int *len, LLMetadata80211AdHoc *m
         NS_LOG_ERROR("Insertion in the storage failed");
         return -1;
     } else {
-#ifdef LAL_STATISTICS
+        statistics.updateQueueDepth(storage.size());
         if (packetSentIsAContent) {
             statistics.increaseContentSent();
+            if (destination != NULL) {
+                statistics.increaseUnicastPacket();
+            }
         } else {
             statistics.increaseInterestSent();
         }
-#endif
     }
     return DISCARD; //GOTONETWORK;
 }
@@ -189,71 +193,119 @@ int LLNomPolicy::pktFromNetwork(uint8_t pkt[], int *len, void *&dataWithoutLLHea
     NdnSocket::ndnSocketMetaData *ndnSocketInfo = (NdnSocket::ndnSocketMetaData *) pkt;
     NS_LOG_DEBUG("received pkt from : " << PRINTABLE_MAC_ADDRESS(ndnSocketInfo->sourceMacAddress));
     //TODO give ndnSocketInfo to a hypothetic neighbouring services (if it exist)
-    llHeader *llhdr = (llHeader *) &pkt[sizeof(NdnSocket::ndnSocketMetaData)];
     *len = *len - sizeof(NdnSocket::ndnSocketMetaData);
-    *len = (*len) - sizeof(llHeader);
     if (*len <= 0) {
         return DISCARD;
     }
-    GeoStorage sourceGeoS (atof(llhdr->lat), atof(llhdr->longitude) );
-    //TODO get the TOS
+    //every frame heard keeps the channel busy, whatever it is
+    const uint64_t now = TimerWheel::now();
+    backoff.frameReceived(now, *len);
+    statistics.increaseFrameReceived(*len);
+    LLHeaderInfo llhdr;
+    const int llhdrSize = readLLHeader(&pkt[sizeof(NdnSocket::ndnSocketMetaData)], *len, llhdr);
+    if (llhdrSize == -1) {
+        NS_LOG_WARN("Received a packet with an invalid or unknown NDN-LAL header");
+        statistics.increaseInvalidFrame();
+        return DISCARD;
+    }
+    neighbors.frameReceived(ndnSocketInfo->sourceMacAddress, llhdr, *len, now);
+    *len = (*len) - llhdrSize;
+    if (*len <= 0) {
+        return DISCARD;
+    }
 #ifdef TEST_GPS_MOVING
+    GeoStorage sourceGeoS (llhdr.lat, llhdr.longitude);
     if (!isReachable(sourceGeoS, locationService)) //node to far, pkt not received
         return DISCARD;
 #endif
 
-    dataWithoutLLHeader = &(pkt[sizeof(llHeader) + sizeof(NdnSocket::ndnSocketMetaData)]);
-    std::string name;
+    dataWithoutLLHeader = &(pkt[llhdrSize + sizeof(NdnSocket::ndnSocketMetaData)]);
+    if ((llhdr.flags & LL_HEADER_AGGREGATE) == 0) {
+        return expandPktFromNetwork((uint8_t *) dataWithoutLLHeader, *len, llhdr, ndnSocketInfo, now, locationService);
+    }
+    //the packets of an aggregated frame are processed one by one, as if they had been received in separate frames
+    uint8_t *data = (uint8_t *) dataWithoutLLHeader;
+    size_t left = *len;
+    while (left > 0) {
+        int tos;
+        size_t pktLen;
+        const int recordSize = readLLAggregateRecord(data, left, tos, pktLen);
+        if (recordSize == -1) {
+            NS_LOG_WARN("Received an aggregated frame with an invalid record, " << left << " bytes discarded");
+            return DISCARD;
+        }
+        llhdr.tos = tos;
+        if (expandPktFromNetwork(data + recordSize, pktLen, llhdr, ndnSocketInfo, now, locationService) == -1) {
+            return -1;
+        }
+        data += recordSize + pktLen;
+        left -= recordSize + pktLen;
+    }
+    return DISCARD;
+}
+
+int LLNomPolicy::expandPktFromNetwork(uint8_t *data, int len, const LLHeaderInfo &llhdr,
+                                      const NdnSocket::ndnSocketMetaData *ndnSocketInfo, uint64_t now,
+                                      const LocationService &locationService)
+{
+    if ((llhdr.flags & LL_HEADER_PREFIX_COMPRESSION) == 0) {
+        return processPktFromNetwork(data, len, llhdr, ndnSocketInfo, now, locationService);
+    }
+    uint8_t expanded[len + PrefixCompression::maxPrefixSize];
+    const int expandedLen = prefixes.expand(ndnSocketInfo->sourceMacAddress, data, len, now, expanded);
+    if (expandedLen == -1 || expandedLen > MAXLLSIZE) {
+        //the retransmissions of the packet will define its prefix
+        NS_LOG_INFO("Received a packet with an invalid prefix record or an unknown name prefix from " <<
+                    PRINTABLE_MAC_ADDRESS(ndnSocketInfo->sourceMacAddress));
+        statistics.increasePrefixMiss();
+        return DISCARD;
+    }
+    return processPktFromNetwork(expanded, expandedLen, llhdr, ndnSocketInfo, now, locationService);
+}
+
+int LLNomPolicy::processPktFromNetwork(uint8_t *data, int len, const LLHeaderInfo &llhdr,
+                                       const NdnSocket::ndnSocketMetaData *ndnSocketInfo, uint64_t now,
+                                       const LocationService &locationService)
+{
+    GeoStorage sourceGeoS (llhdr.lat, llhdr.longitude);
+    PacketStorage::packetKey key;
     uint32_t nonce;
     int returnCommand;
     try {
-        const Ptr<Packet> p = Packet::InitFromBuffer((const uint8_t *)dataWithoutLLHeader, *len);
+        const Ptr<Packet> p = Packet::InitFromBuffer(data, len);
         NDNHeaderHelper::Type type = NDNHeaderHelper::GetNDNHeaderType (p);
 
         const PacketStorage::linkLayerPktElement *el = NULL;
         switch (type) {
         case NDNHeaderHelper::INTEREST: {
-#ifdef LAL_STATISTICS
-            statistics.increaseReceivedInterest();
-#endif
+            statistics.increaseReceivedInterest(len);
             Ptr<InterestHeader> header = GetHeader<InterestHeader> (*p);
             nonce = header->GetNonce();
-            name.append(interestKey);
-            std::list<std::string> headerCmp = header->GetName()->GetComponents();
-            std::list<std::string>::iterator i;
-            for (i = headerCmp.begin(); i != headerCmp.end(); ++i) {
-                name.append(*i);
-                name.append("/");
-            }
-            NS_LOG_INFO("Received data from network. Position: lat:" << llhdr->lat << ", long: " << llhdr->longitude <<
+            key = PacketStorage::makeKey(PacketStorage::INTEREST_PACKET, *header->GetName());
+            NS_LOG_INFO("Received data from network. Position: lat:" << llhdr.lat << ", long: " << llhdr.longitude <<
                         ", previous hop MAC address: "<< PRINTABLE_MAC_ADDRESS(ndnSocketInfo->sourceMacAddress) <<
-                        ", type: INTEREST, name: "<< * header->GetName() <<", length: "<< *len<<", nonce: "<<header->GetNonce());
+                        ", type: INTEREST, name: "<< * header->GetName() <<", length: "<< len<<", nonce: "<<header->GetNonce());
             
-            if (storage.getPktByKey(name, el) == -1) {
-                NS_LOG_DEBUG("LLNomPolicy-pktFromNetwork: pkt " << name << " NOT found in storage");
+            if (storage.getPktByKey(key, el) == -1) {
+                NS_LOG_DEBUG("LLNomPolicy-pktFromNetwork: pkt " << * header->GetName() << " NOT found in storage");
                 returnCommand = GOUPLAYER;
-#ifdef LAL_STATISTICS
-                statistics.increaseReceivedInterestGoingUp();
-#endif
             } else {
                 if (el->nonce != nonce) { //same interest but different nonce. it means that the source of the packets are different
                     NS_LOG_INFO("Interest received from network with name "<< * header->GetName()<<
                                 "match a pending interest, but they have a different nonce: "<< header->GetNonce() <<
                                 " (received), "<<el->nonce<<" (pending interest)");
                     returnCommand = GOUPLAYER;
-#ifdef LAL_STATISTICS
-                    statistics.increaseReceivedInterestGoingUp();
-#endif
                 } else {
-                    std::pair<bool, int> ackResponse = ackManager->receivedRetransmission(llhdr, el, locationService);
+                    std::pair<bool, int> ackResponse = ackManager->receivedRetransmission(llhdr, ndnSocketInfo->sourceMacAddress, el, locationService);
                     if (ackResponse.first && ackResponse.second == 0) {
                         NS_LOG_INFO("Interest received from network with name "<< * header->GetName()<<
                                     " acked a pending interest (nonce "<<el->nonce <<"). Statistics: retransmission: "<<el->retransmission<<
                                     ", number of ack received: "<<el->ackInfo->getNumberOfAck());
-#ifdef LAL_STATISTICS
                         statistics.increaseAckedPacket();
-#endif
-                        if (storage.deletePktByKey(name) == -1) {
+                        if (el->lastTransmission != 0) {
+                            backoff.ackReceived(now - el->lastTransmission);
+                        }
+                        if (storage.deletePktByKey(key) == -1) {
                             NS_LOG_WARN("WARNING LLNomPolicy-pktFromNetwork: delete from storage failed. The pkt will be discarded anyway");
                         }
                         returnCommand = DISCARD;
@@ -261,9 +313,6 @@ int LLNomPolicy::pktFromNetwork(uint8_t pkt[], int *len, void *&dataWithoutLLHea
                         NS_LOG_INFO("Interest received from network with name "<< * header->GetName()<<
                                     " is a partial ack for a pending interest. Statistics: retransmission: "<<el->retransmission<< ", number of ack received: "<<el->ackInfo->getNumberOfAck()<<
                                     "is the packet a push progress? "<<ackResponse.first);
-#ifdef LAL_STATISTICS
-                        statistics.increaseReceivedInterestGoingUp();
-#endif
                         returnCommand = GOUPLAYER;
                     }
                 }
@@ -271,39 +320,29 @@ int LLNomPolicy::pktFromNetwork(uint8_t pkt[], int *len, void *&dataWithoutLLHea
             break;
         }
         case NDNHeaderHelper::CONTENT_OBJECT: {
-#ifdef LAL_STATISTICS
-            statistics.increaseReceivedContent();
-#endif
+            statistics.increaseReceivedContent(len);
             Ptr<ContentObjectHeader> header = GetHeader<ContentObjectHeader> (*p);
             nonce = -1;
-            name.append(dataKey);
-            std::list<std::string> headerCmp = header->GetName()->GetComponents();
-            std::list<std::string>::iterator i;
-            for (i = headerCmp.begin(); i != headerCmp.end(); ++i) {
-                name.append(*i);
-                name.append("/");
-            }
-            NS_LOG_INFO("Received data from network. Position: lat:" << llhdr->lat << ", long: " << llhdr->longitude <<
+            key = PacketStorage::makeKey(PacketStorage::CONTENT_PACKET, *header->GetName());
+            NS_LOG_INFO("Received data from network. Position: lat:" << llhdr.lat << ", long: " << llhdr.longitude <<
                         "previous hop MAC address: "<< PRINTABLE_MAC_ADDRESS(ndnSocketInfo->sourceMacAddress) <<
-                        "type: CONTENT, name: "<< * header->GetName() <<", length: "<< *len);
+                        "type: CONTENT, name: "<< * header->GetName() <<", length: "<< len);
             
-            if (storage.getPktByKey(name, el) == -1) {
-                NS_LOG_DEBUG("LLNomPolicy-pktFromNetwork: pkt " << name << " NOT found in storage");
+            if (storage.getPktByKey(key, el) == -1) {
+                NS_LOG_DEBUG("LLNomPolicy-pktFromNetwork: pkt " << * header->GetName() << " NOT found in storage");
                 returnCommand = GOUPLAYER;
-#ifdef LAL_STATISTICS
-                statistics.increaseReceivedContentGoingUp();
-#endif
             } else {
-                NS_LOG_DEBUG("LLNomPolicy-pktFromNetwork: pkt " << name << " found in storage");
-                std::pair<bool, int> ackResponse = ackManager->receivedRetransmission(llhdr, el, locationService);
+                NS_LOG_DEBUG("LLNomPolicy-pktFromNetwork: pkt " << * header->GetName() << " found in storage");
+                std::pair<bool, int> ackResponse = ackManager->receivedRetransmission(llhdr, ndnSocketInfo->sourceMacAddress, el, locationService);
                 if (ackResponse.first && ackResponse.second == 0) {
                     NS_LOG_INFO("Content received from network with name "<< * header->GetName()<<
                                 " acked a pending content. Statistics: retransmission: "<<el->retransmission<<
                                 ", number of ack received: "<<el->ackInfo->getNumberOfAck());
-#ifdef LAL_STATISTICS
                     statistics.increaseAckedPacket();
-#endif
-                    if (storage.deletePktByKey(name) == -1) {
+                    if (el->lastTransmission != 0) {
+                        backoff.ackReceived(now - el->lastTransmission);
+                    }
+                    if (storage.deletePktByKey(key) == -1) {
                         NS_LOG_WARN("WARNING LLNomPolicy-pktFromNetwork: delete from storage failed. The pkt will be discarded anyway");
                     }
                     returnCommand = DISCARD;
@@ -312,9 +351,6 @@ int LLNomPolicy::pktFromNetwork(uint8_t pkt[], int *len, void *&dataWithoutLLHea
                                 " is a partial ack for a pending content. Statistics: retransmission: "<<el->retransmission<<
                                 ", number of ack received: "<<el->ackInfo->getNumberOfAck()<<
                                 "is the packet a push progress? "<<ackResponse.first);
-#ifdef LAL_STATISTICS
-                    statistics.increaseReceivedContentGoingUp();
-#endif
                     returnCommand = GOUPLAYER;
                 }
             }
@@ -325,15 +361,13 @@ int LLNomPolicy::pktFromNetwork(uint8_t pkt[], int *len, void *&dataWithoutLLHea
             if (matchIt==matchingElements.end()) {
                 /**there is no pending interest for that content*/
             } else {
-                const PacketStorage::linkLayerPktElement *el = *matchIt;
                 while(matchIt!=matchingElements.end()){
+                    const PacketStorage::linkLayerPktElement *el = *matchIt;
                     NS_LOG_INFO("Content received from network with name "<< * header->GetName()<<
-                                " acked the pending interest: " << el->name<<". Statistics: retransmission: "<<el->retransmission<<
+                                " acked the pending interest: " << *el->components<<". Statistics: retransmission: "<<el->retransmission<<
                                 ", number of ack received: "<<el->ackInfo->getNumberOfAck());
-#ifdef LAL_STATISTICS
                     statistics.increaseInterestAckedByContent();
-#endif
-                    if (storage.deletePktByKey(el->name) == -1) {
+                    if (storage.deletePktByKey(el->key) == -1) {
                         NS_LOG_WARN("WARNING delete from storage failed. The pkt will be discarded anyway");
                     }
                     matchIt++;
@@ -357,11 +391,37 @@ int LLNomPolicy::pktFromNetwork(uint8_t pkt[], int *len, void *&dataWithoutLLHea
         return DISCARD;
     }
     if (returnCommand == GOUPLAYER) {
+        if (key.type == PacketStorage::INTEREST_PACKET) {
+            //the content that satisfies it could be sent only to this neighbor
+            neighbors.interestReceived(ndnSocketInfo->sourceMacAddress, key, now);
+        }
+        //the copies rebroadcast by the other neighbors would only be dropped by NDND
+        const bool duplicate = key.type == PacketStorage::INTEREST_PACKET && !duplicates.insert(key, nonce, now);
+        if (key.type == PacketStorage::INTEREST_PACKET) {
+            contention.interestHeard(duplicate);
+        }
+        if (duplicate) {
+            NS_LOG_DEBUG("The packet has already been exchanged with NDND, duplicate discarded");
+            statistics.increaseSuppressedDuplicate();
+            return DISCARD;
+        }
+        if (key.type == PacketStorage::INTEREST_PACKET) {
+            statistics.increaseReceivedInterestGoingUp();
+        } else {
+            statistics.increaseReceivedContentGoingUp();
+        }
         LLMetadata80211AdHoc *metaData = new LLMetadata80211AdHoc(sourceGeoS);
-        metaData->setTos(ntohl(llhdr->tos));
-        int res = communicationService->writeMessageToNDN(dataWithoutLLHeader, *len, metaData);
+        metaData->setTos(llhdr.tos);
+        //its retransmissions are not acks of our forwarding
+        metaData->setPreviousHopMac(ndnSocketInfo->sourceMacAddress);
+        if (locationService.hasValidPosition()) {
+            //the forwarding strategy compares it with the position of the previous hop
+            metaData->setLocalInfo(GeoStorage(locationService.getLatitude(), locationService.getLongitude()));
+        }
+        int res = communicationService->writeMessageToNDN(data, len, metaData);
         if (res == -1) {
             NS_LOG_ERROR("ERROR LLNomPolicy send pkt to NDN layer failed " << strerror(errno));
+            statistics.increaseRingDrop();
             return -1;
             //TODO exception + thread management ?
         } else {
@@ -372,92 +432,188 @@ int LLNomPolicy::pktFromNetwork(uint8_t pkt[], int *len, void *&dataWithoutLLHea
     return returnCommand;
 }
 
-int LLNomPolicy::getNextDeadline(long int *sec, long int *usec)
+int LLNomPolicy::getNextDeadline(struct timespec *deadline)
 {
-    NS_LOG_DEBUG("LLNomPolicy::getNextDeadline");
-    const PacketStorage::linkLayerPktElement *el;
-    if (storage.getFirstDeadline(el) == -1) {
+    uint64_t next;
+    if (storage.getNextDeadline(next) == -1) {
         NS_LOG_DEBUG("LLNomPolicy::getNextDeadline, storage is empty");
         //the storage is empty
         return NOTIMER;
     }
-    *sec = el->timer.first;
-    *usec = el->timer.second;
-    NS_LOG_DEBUG("LLNomPolicy::getNextDeadline: " << *sec << "sec, " << *usec << " usec");
+    deadline->tv_sec = next / 1000000;
+    deadline->tv_nsec = (next % 1000000) * 1000;
+    NS_LOG_DEBUG("LLNomPolicy::getNextDeadline: " << deadline->tv_sec << "sec, " << deadline->tv_nsec / 1000 << " usec");
     return 1;
 }
 
-int LLNomPolicy::getPktForRetransmission(uint8_t ptrData[], const LocationService &locationService)
+int LLNomPolicy::getPktForRetransmission(uint8_t ptrData[], unsigned char destination[ETH_ALEN], const LocationService &locationService)
 {
-    const PacketStorage::linkLayerPktElement *el = NULL;
-    if (storage.getFirstDeadline(el) == -1) {
-        //the storage is empty
+    const uint64_t now = TimerWheel::now();
+    const PacketStorage::linkLayerPktElement *el = getPktToSend(now, now);
+    if (el == NULL) {
+        //no packet is due
+        return 0;
+    }
+    memcpy(destination, el->unicast ? el->destination : broadcastAddr, ETH_ALEN);
+    //room taken by the records of a packet in the frame
+    const size_t recordsSize = sizeof(llAggregateRecord) + (prefixCompression ? sizeof(llPrefixRecord) : 0);
+    if (headerFormat != LL_HEADER_BINARY || el->size + recordsSize > MAXNETWORKPKTSIZE) {
+        NS_LOG_DEBUG("size of pkt being retransmitted: " << el->size);
+        int newSize = el->size;//setLLHeader(&llhdr, ptrData, el->data, el->size); //TODO restore this when the storage will not store the header
+        memcpy(ptrData, el->data, newSize);
+        updateLLHeaderCoordinates(ptrData, newSize, locationService);
+        statistics.increaseFrameSent(newSize);
+        return pktSent(el, now) == -1 ? -1 : newSize;
+    }
+
+    //the packets due within aggregationDelay share the frame, as long as they fit in it:
+    //a single header describes the position of the node, a record precedes every packet
+    LLHeaderInfo info = getLocalHeaderInfo(locationService);
+    info.flags |= LL_HEADER_AGGREGATE;
+    if (prefixCompression) {
+        info.flags |= LL_HEADER_PREFIX_COMPRESSION;
+    }
+    const bool broadcast = memcmp(destination, broadcastAddr, ETH_ALEN) == 0;
+    const size_t hdrSize = writeLLHeader(ptrData, LL_HEADER_BINARY, info);
+    size_t size = hdrSize;
+    unsigned int count = 0;
+    int firstTos = info.tos;
+    //the packets for other destinations are scheduled again once the frame is complete
+    std::vector<const PacketStorage::linkLayerPktElement *> otherDestinations;
+    while (el != NULL) {
+        LLHeaderInfo stored;
+        const int storedHdrSize = readLLHeader(el->data, el->size, stored);
+        if (memcmp(destination, el->unicast ? el->destination : broadcastAddr, ETH_ALEN) != 0) {
+            otherDestinations.push_back(el);
+        } else if (storedHdrSize == -1) {
+            NS_LOG_WARN("Invalid NDN-LAL header in a pending packet, not sent");
+            storage.deletePktByKey(el->key);
+        } else {
+            const size_t pktLen = el->size - storedHdrSize;
+            if (size + recordsSize + pktLen > MAXNETWORKPKTSIZE) {
+                //it will go in the next frame
+                storage.setNewTimer(el->key, el->getDeadline());
+                break;
+            }
+            uint8_t *record = &ptrData[size];
+            size += sizeof(llAggregateRecord);
+            size_t written = pktLen;
+            if (prefixCompression) {
+                //a retransmission defines the prefix again, for the neighbors that missed its definition
+                written = prefixes.compress(&el->data[storedHdrSize], pktLen, broadcast, el->retransmission > 1, now, &ptrData[size]);
+                if (written < pktLen) {
+                    statistics.increaseCompressedPacket(pktLen - written);
+                }
+            } else {
+                memcpy(&ptrData[size], &el->data[storedHdrSize], pktLen);
+            }
+            writeLLAggregateRecord(record, stored.tos, written);
+            size += written;
+            if (count++ == 0) {
+                firstTos = stored.tos;
+            }
+            pktSent(el, now);
+        }
+        el = aggregation ? getPktToSend(now, now + aggregationDelay) : NULL;
+    }
+    for (size_t i = 0; i < otherDestinations.size(); i++) {
+        storage.setNewTimer(otherDestinations[i]->key, otherDestinations[i]->getDeadline());
+    }
+    if (count == 0) {
         return -1;
     }
-    NS_LOG_DEBUG("size of pkt being retransmitted: " << el->size);
-    int newSize = el->size;//setLLHeader(&llhdr, ptrData, el->data, el->size); //TODO restore this when the storage will not store the header
-    //TODO the header haa to be updated (gps information)
-    memcpy(ptrData, el->data, newSize);
-    struct llHeader *hdr = (llHeader *)ptrData;
-    updateLLHeaderCoordinates(hdr, locationService);
-
-#ifdef LAL_STATISTICS
+    if (count == 1) {
+        //a plain frame is smaller, and understood by the nodes that do not aggregate
+        const size_t pktLen = size - hdrSize - sizeof(llAggregateRecord);
+        info.flags &= ~LL_HEADER_AGGREGATE;
+        info.tos = firstTos;
+        writeLLHeader(ptrData, LL_HEADER_BINARY, info);
+        memmove(&ptrData[hdrSize], &ptrData[hdrSize + sizeof(llAggregateRecord)], pktLen);
+        statistics.increaseFrameSent(hdrSize + pktLen);
+        return hdrSize + pktLen;
+    }
+    statistics.increaseFrameSent(size);
+    statistics.increaseAggregatedFrame(count);
+    NS_LOG_INFO("Sending " << count << " packets in a frame of " << size << " bytes");
+    return size;
+}
+
+const PacketStorage::linkLayerPktElement *LLNomPolicy::getPktToSend(uint64_t now, uint64_t due)
+{
+    const PacketStorage::linkLayerPktElement *el = NULL;
+    while (true) {
+        if (storage.getExpiredPkt(now, due, el) == -1) {
+            return NULL;
+        }
+        //enough neighbors forwarded the packet after our transmission, even if none of them was farther
+        if (el->lastTransmission == 0 || el->ackInfo == NULL || el->ackInfo->getNumberOfAck() < earlyGiveUpAcks) {
+            return el;
+        }
+        NS_LOG_INFO("Giving up the packet: name: " << *el->components << ", transmitted " << el->retransmission - 1 <<
+                    " times, number of received ack: " << el->ackInfo->getNumberOfAck());
+        statistics.increaseGivenUpPacket();
+        if (storage.deletePktByKey(el->key) == -1) {
+            NS_LOG_WARN("WARNING LLNomPolicy-getPktToSend: delete from storage failed. The pkt will be discarded anyway");
+        }
+    }
+}
+
+int LLNomPolicy::pktSent(const PacketStorage::linkLayerPktElement *el, uint64_t now)
+{
+    el->lastTransmission = now;
+    contention.packetSent(el->retransmission != 1);
+
+    if (el->key.type == PacketStorage::INTEREST_PACKET) {
+        statistics.increaseInterestTransmission(el->size);
+    } else {
+        statistics.increaseContentTransmission(el->size);
+    }
     if (el->retransmission != 1) {
         statistics.increaseNumberOfRetransmission();
     }
-#endif
 
     if (el->retransmission >= (el->retransmissionLimit)) {
-        NS_LOG_INFO("Last retransmission for the packet: type+name: " << el->name<< ", size: "<< el->size<<
+        NS_LOG_INFO("Last retransmission for the packet: name: " << *el->components<< ", size: "<< el->size<<
                     ", the pkt is being transmitted for the "<<el->retransmission<<" times, number of received ack: "<<
                     el->ackInfo->getNumberOfAck());
-        //check section BE AWARE at the beginning of the file if you have to change this function
-        if (storage.deleteFirstPkt(el->name) == -1) {
-            NS_LOG_WARN("WARNING LLNomPolicy-getPktForRetransmission: delete from storage failed. The pkt will be discarded anyway");
+        if (storage.deletePktByKey(el->key) == -1) {
+            NS_LOG_WARN("WARNING LLNomPolicy-pktSent: delete from storage failed. The pkt will be discarded anyway");
         }
     } else {
-        std::pair <unsigned int, unsigned int> newTime;
-        calculateNextTimer(el->retransmission, el->retransmissionLimit, &(newTime.first), &(newTime.second));
-        if (storage.increaseRetransmissionCounterAndSetNewTimer(el->name, newTime ) == -1) {
-            NS_LOG_WARN("WARNING LLNomPolicy-getPktForRetransmission: increaseRetransmissionCounterAndSetNewTimer failed");
-            //deleting the packet to avoid infinite loop (retransmission number never incremented)
-            if (storage.deleteFirstPkt(el->name) == -1) {
-                NS_LOG_WARN("WARNING LLNomPolicy-getPktForRetransmission: delete from storage failed. The pkt will be discarded anyway");
+        const uint64_t deadline = calculateNextTimer(el->retransmission, el->retransmissionLimit, now);
+        if (storage.increaseRetransmissionCounterAndSetNewTimer(el->key, deadline) == -1) {
+            NS_LOG_WARN("WARNING LLNomPolicy-pktSent: increaseRetransmissionCounterAndSetNewTimer failed");
+            //deleting the packet, it's no longer scheduled
+            if (storage.deletePktByKey(el->key) == -1) {
+                NS_LOG_WARN("WARNING LLNomPolicy-pktSent: delete from storage failed. The pkt will be discarded anyway");
             }
             return -1;
         }
-        NS_LOG_INFO("Sending a packet out: type+name: " << el->name<< ", size: "<< el->size<<
+        NS_LOG_INFO("Sending a packet out: name: " << *el->components<< ", size: "<< el->size<<
                     ", the pkt is being transmitted for the "<<el->retransmission<<" times, number of received ack: "<<
                     el->ackInfo->getNumberOfAck());
     }
-    return newSize;
+    return 1;
 }
 
 
-void LLNomPolicy::calculateNextTimer(int numberOfRetransmission, int maxNumberOfRetransmission, unsigned int *sec, unsigned int *usec)
+uint64_t LLNomPolicy::calculateNextTimer(int numberOfRetransmission, int maxNumberOfRetransmission, uint64_t now)
 {
-    //TODO this is just a temporary nextTimer calculation
-    struct timeval tt;
-    gettimeofday(&tt, NULL);
-    *usec = (usecFirstRetransmission + tt.tv_usec) % 1000000;
-    *sec =  secFirstRetransmission + tt.tv_sec + (usecFirstRetransmission + tt.tv_usec) / 1000000;
+    return now + backoff.getTimeout(now, numberOfRetransmission);
 }
 
 
-void LLNomPolicy::calculateFirstTransmission(GeoStorage *geoStorage, const LocationService &locationService, unsigned int *sec, unsigned int *usec)
+uint64_t LLNomPolicy::calculateFirstTransmission(GeoStorage *geoStorage, const LocationService &locationService, double progress)
 {
-    struct timeval tt;
-    gettimeofday(&tt, NULL);
-    int Tgap = 0;
-    int Tca = rand() % maxTca;
+    double distance = -1;
     if (geoStorage != NULL) { //the pkt that needs to be transmitted is not generated locally
-        double distance = locationService.getDistance(geoStorage->getLat(), geoStorage->getLongitude());
-        /*Tgap is microsecond, so it has no sense to use a double, we can just get the integer part*/
-        Tgap = (int) Tdist * (Dmax - std::min((double)Dmax * 1.0, distance)) / Dmax;
+        //the node that makes more progress towards the destination goes first, when the destination is known
+        distance = progress >= 0 ? progress : locationService.getDistance(geoStorage->getLat(), geoStorage->getLongitude());
     }
-    NS_LOG_INFO("Timer for first transmission: Tgap: "<< Tgap << ", Tca" << Tca);
-    *usec = (tt.tv_usec + Tca + (Tgap)) % 1000000;
-    *sec =  tt.tv_sec + (tt.tv_usec + Tca + (Tgap)) / 1000000;
+    const uint64_t deferral = contention.getDeferral(neighbors.size(), distance);
+    NS_LOG_INFO("Timer for first transmission: " << deferral << " usec, distance: " << distance <<
+                ", neighbors: " << neighbors.size() << ", Tca window: " << contention.getWindow(neighbors.size()));
+    return TimerWheel::now() + deferral;
 }
 
 int LLNomPolicy::getNDNHeader(const Ptr<const Packet> &p, Ptr<Header> header)
@@ -492,20 +648,42 @@ void LLNomPolicy::setLLupperLayerCommunication(LLUpperLayerCommunicationService
     communicationService = upperLayerComServ;
 }
 
-int LLNomPolicy::setLLHeader(llHeader *llhdr, uint8_t *buffer, const uint8_t *data, int len, const LocationService &locationService)
+LLHeaderInfo LLNomPolicy::getLocalHeaderInfo(const LocationService &locationService) const
+{
+    LLHeaderInfo info;
+    info.tos = 75; //TODO just temporary. NDND or application should determinate this value
+    if (locationService.hasValidPosition()) {
+        info.lat = locationService.getLatitude();
+        info.longitude = locationService.getLongitude();
+        info.heading = locationService.getHeading();
+        info.speed = locationService.getSpeed();
+        info.flags = LL_HEADER_POSITION_VALID | LL_HEADER_MOTION_VALID;
+    }
+    struct timeval tt;
+    gettimeofday(&tt, NULL);
+    info.timestamp = (uint32_t) ((uint64_t) tt.tv_sec * 1000 + tt.tv_usec / 1000);
+    return info;
+}
+
+int LLNomPolicy::setLLHeader(LLHeaderInfo &llhdr, uint8_t *buffer, const uint8_t *data, int len, const LocationService &locationService)
 {
-    llhdr->tos = htonl(75); //TODO just temporary. NDND or application should determinate this value
-    memcpy(llhdr->lat, locationService.getLatChar(), GPS_STRING_SIZE);
-    memcpy(llhdr->longitude, locationService.getLonChar(), GPS_STRING_SIZE);
-    memcpy(buffer, llhdr, sizeof(llHeader));
-    memcpy(&(buffer[sizeof(llHeader)]), data, len); //now the LLDaemon can free the pkt area when it will send the pkt
-    return len + sizeof(llHeader);
+    llhdr = getLocalHeaderInfo(locationService);
+    llhdr.format = headerFormat;
+    size_t hdrSize = writeLLHeader(buffer, headerFormat, llhdr);
+    memcpy(&(buffer[hdrSize]), data, len); //now the LLDaemon can free the pkt area when it will send the pkt
+    return len + hdrSize;
 }
 
-void LLNomPolicy::updateLLHeaderCoordinates(llHeader *llhdr, const LocationService &locationService)
+void LLNomPolicy::updateLLHeaderCoordinates(uint8_t *buffer, int len, const LocationService &locationService)
 {
-    memcpy(llhdr->lat, locationService.getLatChar(), GPS_STRING_SIZE);
-    memcpy(llhdr->longitude, locationService.getLonChar(), GPS_STRING_SIZE);
+    LLHeaderInfo stored;
+    if (readLLHeader(buffer, len, stored) == -1) {
+        NS_LOG_WARN("Invalid NDN-LAL header in a pending packet, not updated");
+        return;
+    }
+    LLHeaderInfo info = getLocalHeaderInfo(locationService);
+    info.tos = stored.tos;
+    writeLLHeader(buffer, stored.format, info);
 }
 
 #ifdef TEST_GPS_MOVING
@@ -520,9 +698,10 @@ bool LLNomPolicy::isReachable(GeoStorage &position, const LocationService &locat
 
 void LLNomPolicy::printStatistic() 
 {
-#ifdef LAL_STATISTICS
-    statistics.sendToLog();
-#endif
+    const uint64_t now = TimerWheel::now();
+    std::vector<NeighborTable::Neighbor> heard;
+    neighbors.getNeighbors(now, heard);
+    statistics.sendToLog(now, storage.size(), heard);
 }
 
 }
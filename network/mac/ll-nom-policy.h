@@ -19,7 +19,6 @@
 #define LLNOMPOLICY_H_
 
 //#define TEST_GPS_MOVING
-#define LAL_STATISTICS
 
 #include "ll-policy.h"
 #include "ll-metadata-80211-adhoc.h"
@@ -28,8 +27,13 @@
 #include "ndnsock/ndn-socket-exception.h"
 
 #include "lal-ack-manager-by-distance.h"
+#include "lal-backoff.h"
+#include "lal-contention.h"
 #include "lal-stats.h"
 #include "geo-storage.h"
+#include "duplicate-filter.h"
+#include "neighbor-table.h"
+#include "prefix-compression.h"
 
 #include "helper/ccnb-parser/ccnb-parser-common.h"
 #include "helper/ndn-header-helper.h"
@@ -61,33 +65,27 @@ class LLNomPolicy : public LLPolicy
 {
 public:
 
-#define interestKey "INTEREST"
-#define dataKey "DATAOBJECT"
-
     //policy configuration (as specified in nom paper: Rapid Trafﬁc Information Dissemination Using Named Data - L. Wang, A. Afanasyev, R. Kuntz, R. Vuyyuru, R. Wakikawa, L. Zhang)
 
     /**max number of retransmission of a packet*/
     static const int maxRetransmissionNumber = 8;
-    /**Delay for second retransmission (seconds)*/
+    /**Delay for second retransmission until the latency of the acks is known (seconds), see LALBackoff*/
     static const unsigned int secFirstRetransmission = 0;
-    /**Delay for second retransmission (micro seconds)*/
+    /**Delay for second retransmission until the latency of the acks is known (micro seconds), see LALBackoff*/
     static const unsigned int usecFirstRetransmission = 500000;//50000; //50 ms
+    /**A packet already transmitted is not retransmitted any more after this number of partial acks, i.e. distinct neighbors other than the previous hop that forwarded it (see AckInfo::addAck)*/
+    static const int earlyGiveUpAcks = 2;
+    /**Transmissions of a unicast packet: its destination acks it at the MAC layer, which retransmits it when needed*/
+    static const int unicastTransmissionNumber = 1;
+    /**Only the contents bigger than this (bytes) are unicast: the small ones gain little from the rate adaptation,
+     * and are better overheard, and cached, by all the neighbors*/
+    static const int unicastMinSize = 500;
 
 
     /**
-     * Tca has an uniform distribution between 0 and maxTca
+     * A frame carries the packets due within this delay after the first one (microseconds), see setAggregation
      */
-    static const unsigned int maxTca = 2000;
-
-    /**
-     * Minimum delay for a node that is next to the previous hop (microseconds)
-     * */
-    static const unsigned int Tdist = 5000;
-
-    /**
-     * maximum range for wireless transmission (meters)
-     * */
-    static const unsigned int Dmax = 150;
+    static const unsigned int aggregationDelay = 1000;
 
     /**
      * \brief Creates a LLPolicy that implements the Nom paper policy
@@ -123,25 +121,27 @@ public:
 
 
     /**
-     * \brief  Tells when the next packet has to be retransmitted
+     * \brief  Tells when the next packet has to be (re)transmitted
      *
-     * The values that tell when a packet has to be retransmitted are in the same form of a timeval (second and microseconds)
-     * \param sec the function will store when the next packet has to be retransmitted ( seconds)
-     * \param usec the function will store when the next packet has to be retransmitted (micro seconds)
-     * \return 1 if there is at least a packet that has to be retransmitted. NOTIMER otherwise
+     * \param deadline the function will store when the next packet has to be transmitted (absolute time of CLOCK_MONOTONIC)
+     * \return 1 if there is at least a packet that has to be transmitted. NOTIMER otherwise
      * */
-    int getNextDeadline(long int *sec, long int *usec);
+    int getNextDeadline(struct timespec *deadline);
 
 
     /**
-     * \brief Get the next packet that has to be retransmitted
+     * \brief Get a packet whose (re)transmission is due
      *
-     * It gets the next packet scheduled for a retransmission
-     * If the packet is at the last retransmission, the entry in the pending table will be deleted
+     * It gets one of the packets whose deadline has expired, and schedules its next retransmission.
+     * If the packet is at the last retransmission, the entry in the pending table will be deleted.
+     * With the aggregation, the frame carries also the other packets due within aggregationDelay that fit in it
+     * and have the same destination. With the prefix compression, the names of the packets refer to the prefixes
+     * already sent (see PrefixCompression)
      * \param ptrData the function will store the packet scheduled for the retransmission
-     * \return size of the packet (it can't be greater than MAXNETWORKPKTSIZE)
+     * \param destination the function will store the destination MAC address of the packet (broadcast or a neighbor)
+     * \return size of the packet (it can't be greater than MAXNETWORKPKTSIZE), 0 if no other packet is due
      * */
-    int getPktForRetransmission(uint8_t ptrData[], const LocationService &locationService);
+    int getPktForRetransmission(uint8_t ptrData[], unsigned char destination[ETH_ALEN], const LocationService &locationService);
 
     /**
      * \brief Give to LLNomPolicy the reference to the LLUpperLayerCommunicationService that can be used to communicate with NDN layer (through NDNNetDeviceFace)
@@ -150,33 +150,124 @@ public:
      * */
     void setLLupperLayerCommunication(LLUpperLayerCommunicationService *upperLayerComServ);
 
+    /**
+     * \brief Sends the statistics since the previous call to the log, with the pending packets and the neighbors (see LALStatistic)
+     * */
     void printStatistic();
 
+    /** Counters since the creation of the policy */
+    const LALStatistic &getStatistics() const {return statistics;}
+
+    /**
+     * \brief Selects the format of the NDN-LAL header sent by every LLNomPolicy of the process
+     *
+     * The binary format is the default. Both formats are always understood on reception,
+     * LL_HEADER_ASCII is only needed to talk to nodes that predate the binary format.
+     * */
+    static void setHeaderFormat(LLHeaderFormat format) {headerFormat = format;}
+    static LLHeaderFormat getHeaderFormat() {return headerFormat;}
+
+    /**
+     * \brief Enables the aggregation of the packets due at the same time in a single frame
+     *
+     * It is enabled by default, and used only with the binary header: each frame pays the
+     * contention of the channel and the NDN-LAL header once for all the packets it carries.
+     * Aggregated frames are always understood on reception.
+     * */
+    static void setAggregation(bool enabled) {aggregation = enabled;}
+    static bool getAggregation() {return aggregation;}
+
+    /**
+     * \brief Enables the unicast of the contents requested by a single neighbor
+     *
+     * It is enabled by default: the content bigger than unicastMinSize that satisfies the interests received
+     * from a single neighbor (see NeighborTable) is sent only to it, and gets the rate adaptation and the
+     * retransmissions of the MAC layer. The others are broadcast.
+     * */
+    static void setUnicast(bool enabled) {unicast = enabled;}
+    static bool getUnicast() {return unicast;}
+
+    /**
+     * \brief Enables the compression of the name prefixes already sent
+     *
+     * It is enabled by default, and used only with the binary header: the packets whose name
+     * shares the prefix of the previous ones carry a reference instead of it (see PrefixCompression).
+     * Compressed frames are always understood on reception.
+     * */
+    static void setPrefixCompression(bool enabled) {prefixCompression = enabled;}
+    static bool getPrefixCompression() {return prefixCompression;}
+
+    /**
+     * \brief Sets the constants of the collision avoidance timers of every LLNomPolicy of the process
+     *
+     * By default the window of Tca adapts to the number of neighbors and to the duplicates and
+     * retransmissions observed (see LALContention). Like the other settings above, it is read by the
+     * adapter thread without locking, so it has to be set before the NDNAdhocNetDeviceFace is created.
+     * */
+    static void setContention(const LALContention::Parameters &parameters) {contentionParameters = parameters;}
+    static const LALContention::Parameters &getContention() {return contentionParameters;}
+
 protected:
+    /**
+     * \brief Processes a NDN packet received from the network, alone or in an aggregated frame
+     *
+     * \param llhdr NDN-LAL header of the frame, with the tos of the packet
+     * \return DISCARD, or -1 if the packet could not be sent up to NDN
+     * */
+    int processPktFromNetwork(uint8_t *data, int len, const LLHeaderInfo &llhdr,
+                              const NdnSocket::ndnSocketMetaData *ndnSocketInfo, uint64_t now,
+                              const LocationService &locationService);
+
+    /**
+     * \brief Restores the name prefix of a packet of a compressed frame, then processes it (see processPktFromNetwork)
+     *
+     * \return DISCARD, or -1 if the packet could not be sent up to NDN
+     * */
+    int expandPktFromNetwork(uint8_t *data, int len, const LLHeaderInfo &llhdr,
+                             const NdnSocket::ndnSocketMetaData *ndnSocketInfo, uint64_t now,
+                             const LocationService &locationService);
+
+    /**
+     * \brief Gets a packet whose deadline is not later than due, giving up the ones that have been acked enough
+     *
+     * The packet is no longer scheduled, pktSent has to be called once it has been put in a frame
+     * \param now current time: the packets expired at now come first
+     * \param due latest deadline accepted, later than now to look ahead for the aggregation
+     * \return the packet, NULL if no packet is due
+     * */
+    const PacketStorage::linkLayerPktElement *getPktToSend(uint64_t now, uint64_t due);
+
+    /**
+     * \brief Schedules the next retransmission of a packet just sent, or deletes it after the last one
+     *
+     * \return 1 if everything is ok, -1 if the packet could not be scheduled (it is deleted)
+     * */
+    int pktSent(const PacketStorage::linkLayerPktElement *el, uint64_t now);
+
     /**
      * \brief It calculates the deadline for the next retransmission of the pkt (Tretx)
      *
-     * This version of LLNomPolicy used a fixed value as Trext, no matter how many retransmission has been already completed.
-     * After simulation phase, this would be probably changed
+     * Trext adapts to the latency of the acks and to the load of the channel, with an exponential backoff (see LALBackoff)
      * \param numberOfRetrasmission indicates how many time the pck has been retransmitted
      * \param maxNumberOfRetrasmission max number of retransmission allowed
-     * \param sec it will store the next deadline (seconds)
-     * \param usec it will store the next deadline (micro seconds)
+     * \param now current time (microseconds, see TimerWheel::now)
+     * \return the next deadline (microseconds, see TimerWheel::now)
      * */
-    void calculateNextTimer(int numberOfRetrasmission, int maxNumberOfRetrasmission, unsigned int *sec, unsigned int *usec);
+    uint64_t calculateNextTimer(int numberOfRetrasmission, int maxNumberOfRetrasmission, uint64_t now);
 
 
     /**
      * \brief Calculates how much the pkt has to be delayed before the first transmission
      *
-     * It calculate the Tca (random timer for collision avoidance) and Tgap (in inverse proportion to previous hop distance)
+     * It calculate the Tca (random timer for collision avoidance) and Tgap (in inverse proportion to previous hop distance),
+     * scaled by the number of neighbors (see LALContention)
      * Check Rapid Traffic Information Dissemination Using Named Data paper (NOM) for further information about the timer
      *
      *\param geoStorage it stores the position of the previous hop (if the node is forwarding the node). It's null if the node itself generated the pkt
-     *\param sec it will store the next deadline (seconds)
-     *\param usec it will store the next deadline (micro seconds)
+     *\param progress progress towards the destination set by the forwarding strategy (meters), used instead of the distance from the previous hop; negative if unknown
+     *\return the deadline of the first transmission (microseconds, see TimerWheel::now)
      * */
-    void calculateFirstTransmission(GeoStorage *geoStorage, const LocationService & locationService, unsigned int *sec, unsigned int *usec);
+    uint64_t calculateFirstTransmission(GeoStorage *geoStorage, const LocationService & locationService, double progress = -1);
 
     /**
      * \brief Extract useful information from NDN packet
@@ -188,42 +279,73 @@ protected:
     int getNDNHeader(const Ptr<const Packet> &p, Ptr<Header> header);
 
 
+    /**
+     * \brief Describes the local node in a NDN-LAL header
+     * */
+    LLHeaderInfo getLocalHeaderInfo(const LocationService &locationService) const;
+
     /**
      * \brief Set the NDN-LAL header
      *
-     * It stores the NDN-Link Adaptation Layer header in the packet
-     * \param llhdr NDN-LAL header that will be stored in the packet
-     * \param buffer address where NDN-LAL header and NDN packet will be stored
+     * It stores the NDN-Link Adaptation Layer header in the packet, in the format selected with setHeaderFormat
+     * \param llhdr it will store the content of the NDN-LAL header
+     * \param buffer address where NDN-LAL header and NDN packet will be stored (LL_HEADER_MAX_SIZE + len bytes)
      * \param data NDN packet address
      * \param len size of NDN packet
      * \return size of the new packet stored in buffer (NDN size + NDN-LAL header size)
      * */
-    int setLLHeader(llHeader *llhdr, uint8_t *buffer, const uint8_t *data, int len, const LocationService &locationService );
+    int setLLHeader(LLHeaderInfo &llhdr, uint8_t *buffer, const uint8_t *data, int len, const LocationService &locationService );
 
     /**
      * \brief Update coordinates on NDN-LAL header with the current local node position
      *
      * At this moment, when a packet is stored in the pending table, LLNomPolicy stores everything, NDN data and NDN-LAL header (in the future should be only NDN data)
      * Anyway, right now when a packet has to be retransmitted, the information about coordinates node carried in the header could be old, so they need to be uptaded
+     * The header keeps its format, so the size of the packet does not change
      *
-     *\param llhdr pointer to the NDN-LAL header that has to be updated
+     *\param buffer pointer to the packet whose NDN-LAL header has to be updated
      * */
-    void updateLLHeaderCoordinates(llHeader *llhdr, const LocationService &locationService);
-
-#ifdef LAL_STATISTICS
-    void printStatistics();
-#endif
+    void updateLLHeaderCoordinates(uint8_t *buffer, int len, const LocationService &locationService);
     
 #ifdef TEST_GPS_MOVING
     bool isReachable(GeoStorage &position, const LocationService &locationService);
 #endif
 
+    /** Format of the headers sent, see setHeaderFormat */
+    static LLHeaderFormat headerFormat;
+
+    /** Whether the packets due together share a frame, see setAggregation */
+    static bool aggregation;
+
+    /** Whether the contents requested by a single neighbor are unicast, see setUnicast */
+    static bool unicast;
+
+    /** Whether the name prefixes already sent are compressed, see setPrefixCompression */
+    static bool prefixCompression;
+
+    /** Constants of the collision avoidance timers, see setContention */
+    static LALContention::Parameters contentionParameters;
+
     /** It stores the pending packet table*/
     PacketStorage storage;
 
-#ifdef LAL_STATISTICS
+    /** Retransmission timeout, estimated from the traffic received */
+    LALBackoff backoff;
+
+    /** Collision avoidance timers, estimated from the traffic received and sent */
+    LALContention contention;
+
+    /** Neighbors heard, and the interests they sent */
+    NeighborTable neighbors;
+
+    /** Name prefixes sent and received */
+    PrefixCompression prefixes;
+
+    /** Packets recently exchanged with NDND */
+    DuplicateFilter duplicates;
+
+    /** Counters of the frames and packets handled */
     LALStatistic statistics;
-#endif
 };
 
 } /* namespace vndn */
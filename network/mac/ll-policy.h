@@ -25,6 +25,8 @@
 #include "ll-metadata-80211-adhoc.h"
 #include "lal-ack-manager.h"
 
+#include <time.h>
+
 #include "utils/geo/location-service.h"
 #include "utils/geo/gps-info.h"
 
@@ -89,24 +91,24 @@ public:
 
 
     /**
-     * \brief Tells when the next packet has to be retransmitted
+     * \brief Tells when the next packet has to be (re)transmitted
      *
-     * The values that tell when a packet has to be retransmitted are in the same form of a timeval (second and microseconds)
-     * \param sec the function will store when the next packet has to be retransmitted ( seconds)
-     * \param usec the function will store when the next packet has to be retransmitted (micro seconds)
-     * \return 1 if there is at least a packet that has to be retransmitted. NOTIMER otherwise
+     * \param deadline the function will store when the next packet has to be transmitted, as an absolute time of CLOCK_MONOTONIC
+     * (it can be given as it is to a timerfd with TFD_TIMER_ABSTIME)
+     * \return 1 if there is at least a packet that has to be transmitted. NOTIMER otherwise
      * */
-    virtual int getNextDeadline(long int *sec, long int *usec) = 0;
+    virtual int getNextDeadline(struct timespec *deadline) = 0;
 
 
     /**
-     * \brief Get the next packet that has to be retransmitted
+     * \brief Get a packet whose (re)transmission is due
      *
-     * It gets the next packet scheduled for a retransmission
+     * Once the deadline is reached, it has to be called until it returns 0, to send all the packets due in a single wakeup
      * \param ptrData the function will store the packet scheduled for the retransmission
-     * \return size of the packet (it can't be greater than MAXNETWORKPKTSIZE)
+     * \param destination the function will store the destination MAC address of the packet (broadcast or a neighbor)
+     * \return size of the packet (it can't be greater than MAXNETWORKPKTSIZE), 0 if no other packet is due, -1 in case of error
      * */
-    virtual int getPktForRetransmission(uint8_t ptrData[], const geo::LocationService & locationService) = 0;
+    virtual int getPktForRetransmission(uint8_t ptrData[], unsigned char destination[ETH_ALEN], const geo::LocationService & locationService) = 0;
 
     /**
      * \brief Give to LLPolicy the reference to the LLUpperLayerCommunicationService that can be used to communicate with NDN layer (through NDNNetDeviceFace)
@@ -115,6 +117,9 @@ public:
      * */
     virtual void setLLupperLayerCommunication(LLUpperLayerCommunicationService *upperLayerComServ) = 0;
 
+    /**
+     * \brief Sends the link-layer statistics to the log (a LinkLayerStats JSON message), called periodically by NDNDeviceAdapter
+     * */
     virtual void printStatistic()= 0;
 
 
@@ -116,6 +116,7 @@ int LLUpperLayerCommunicationService::writeMessageToNDN(void *buf, int size, LLM
         //the NDNDeviceAdapter has not processed the object yet
         NS_LOG_WARN("NDNDeviceAdapter::writeMessageFromNDN, the NDNDeviceFace has not processed the object yet");
         //TODO is return -1 enough??
+        sem_post(&incomingSharedMemoryPtr[incomingSharedIndex].mutex);
         return -1;
     }
     incomingSharedMemoryPtr[incomingSharedIndex].size = size;
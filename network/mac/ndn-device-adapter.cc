@@ -17,53 +17,96 @@
  */
 
 #include "ndn-device-adapter.h"
+#include "timer-wheel.h"
 #include "corelib/log.h"
 
-#define STATISTIC_FREQUENCY_UPDATE 10 //how many seconds between one update and the next one. LAL_STATISTICS has to be defined to enable statistics
-
 NS_LOG_COMPONENT_DEFINE("NDNDeviceAdapter");
 
 
 namespace vndn
 {
 
+// position of each file descriptor in the array given to poll
+enum { SOCKET_POLL_INDEX = 0, TRIGGER_POLL_INDEX, GPSD_POLL_INDEX, TIMER_POLL_INDEX, POLL_FD_COUNT };
+
+unsigned int NDNDeviceAdapter::statisticsInterval = 10;
+
+/**
+ * \brief Waits until one of the fds is readable or the timeout (NULL means forever) expires
+ *
+ * \return same as select: number of ready fds, 0 on timeout, -1 on error
+ * */
+static int waitForEvents(struct pollfd fds[POLL_FD_COUNT], const struct timeval *timeout)
+{
+    if (timeout == NULL) {
+        return ppoll(fds, POLL_FD_COUNT, NULL, NULL);
+    }
+    struct timespec ts;
+    ts.tv_sec = timeout->tv_sec;
+    ts.tv_nsec = timeout->tv_usec * 1000;
+    return ppoll(fds, POLL_FD_COUNT, &ts, NULL);
+}
+
+static bool isReadable(const struct pollfd &fd)
+{
+    return fd.fd >= 0 && (fd.revents & (POLLIN | POLLERR | POLLHUP)) != 0;
+}
+
 NDNDeviceAdapter::NDNDeviceAdapter(std::string devname)
 {
     NS_LOG_FUNCTION(this << devname);
 
-    const unsigned char broadcastAddr[ETH_ALEN] = { 0xff , 0xff , 0xff , 0xff , 0xff , 0xff };
-
     NdnRawSocket *ndnSocket;
     try {
         ndnSocket = new NdnRawSocket(devname);
     } catch (NdnSocketException e) {
         throw e.what();
     }
+    init(ndnSocket);
+
+    gpsdSocket = createGPSSocket();
+    if (gpsdSocket == -1) {
+        NS_LOG_ERROR("Could not open the gpsd socket");
+        // will try to reconnect to gpsd later
+    }
+}
+
+NDNDeviceAdapter::NDNDeviceAdapter(NdnSocket *socket, int gpsFd)
+{
+    NS_LOG_FUNCTION(this << socket->getDevice() << gpsFd);
+
+    init(socket);
+    gpsdSocket = gpsFd;
+}
+
+void NDNDeviceAdapter::init(NdnSocket *ndnSocket)
+{
+    const unsigned char broadcastAddr[ETH_ALEN] = { 0xff , 0xff , 0xff , 0xff , 0xff , 0xff };
 
     LLNomPolicy *policy = new LLNomPolicy;
     device = LLDevice(policy, ndnSocket);
-    device.setName(devname);
-    device.getNdnSocket()->setDestination(broadcastAddr);  //right now only broadcast communication is allowed
+    device.setName(ndnSocket->getDevice());
+    device.getNdnSocket()->setDestination(broadcastAddr);  //the policy gives the destination of each packet, see LLPolicy::getPktForRetransmission
     NS_LOG_DEBUG("socket id = " << device.getNdnSocket()->getSocket());
 
     buffer = new uint8_t[MAXNETWORKPKTSIZE + sizeof(NdnSocket::ndnSocketMetaData)];
 
-    gpsdSocket = createGPSSocket();
-    if (gpsdSocket == -1) {
-        NS_LOG_ERROR("Could not open the gpsd socket");
-        // will try to reconnect to gpsd later
+    //the (re)transmission deadlines of the policy are absolute times of CLOCK_MONOTONIC
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (timerFd == -1) {
+        NS_LOG_ERROR("Failed to create the timerfd for the retransmissions: " << strerror(errno));
+        throw "timerfd error";
     }
+    timerArmed = false;
 
-#ifdef LAL_STATISTICS
-    gettimeofday(&nextStatisticUpdate, NULL);
-    nextStatisticUpdate.tv_sec += STATISTIC_FREQUENCY_UPDATE;
-#endif
+    nextStatisticUpdate = TimerWheel::now() + (uint64_t) statisticsInterval * 1000000;
 }
 
 NDNDeviceAdapter::~NDNDeviceAdapter()
 {
     delete [] buffer;
     delete device.getNdnSocket();
+    close(timerFd);
 }
 
 
@@ -77,21 +120,10 @@ int NDNDeviceAdapter::start(NDNDeviceParams *param)
     upperLayerComServ.setNdnOutgoingTrigger(param->outgoingEventFd);
     upperLayerComServ.setNdnIncomingTrigger(param->incomingEventFd);
     device.getPolicy()->setLLupperLayerCommunication(&upperLayerComServ);
-    //prepare struct for select
-    fd_set read_fd;
-    FD_ZERO(&read_fd);
-    int maxfd = -1;
-    if (maxfd < device.getNdnSocket()->getSocket()) {
-        maxfd = device.getNdnSocket()->getSocket();
-    }
-    if (maxfd < upperLayerComServ.getNdnOutgoingTrigger()) {
-        maxfd = upperLayerComServ.getNdnOutgoingTrigger();
-    }
-    struct timeval tvNextDeadline, auxTimeVal;
-    tvNextDeadline.tv_sec = LLPolicy::NOTIMER;
-    tvNextDeadline.tv_usec = LLPolicy::NOTIMER;
-    auxTimeVal.tv_sec = LLPolicy::NOTIMER;
-    auxTimeVal.tv_usec = LLPolicy::NOTIMER;
+    //prepare struct for poll (select cannot handle fds above FD_SETSIZE, which are
+    //common when many NDNDeviceAdapters run in the same process, e.g. in the emulator)
+    struct pollfd read_fd[POLL_FD_COUNT];
+    struct timeval gpsdRetry;
     int len = -1;
     int cmd;
     int selectResult;
@@ -104,18 +136,10 @@ int NDNDeviceAdapter::start(NDNDeviceParams *param)
             NS_LOG_ERROR("Failed to send request to gpsd. Closing the socket.");
             close(gpsdSocket);
             gpsdSocket = -1;
-        } else { //NDNDeviceAdapter can use gpsdSocket
-            if (maxfd < gpsdSocket) {
-                maxfd = gpsdSocket;
-            }
         }
     }
 
-    bool selectForGpsd = false;
     while (true) {
-        selectForGpsd = false;
-        FD_SET(device.getNdnSocket()->getSocket(), &read_fd);
-        FD_SET(upperLayerComServ.getNdnOutgoingTrigger(), &read_fd);
         if (gpsdSocket == -1) {
             //try again to reconnect to gpsd
             gpsdSocket = createGPSSocket();
@@ -127,68 +151,65 @@ int NDNDeviceAdapter::start(NDNDeviceParams *param)
                     NS_LOG_ERROR("Failed to send request to gpsd. Closing the socket.");
                     close(gpsdSocket);
                     gpsdSocket = -1;
-                } else { //NDNDeviceAdapter can use gpsdSocket
-                    if (maxfd < gpsdSocket) {
-                        maxfd = gpsdSocket;
-                    }
                 }
             } else {
                 //set GpsInfo with default error value
                 locationService.noValidData();
             }
         }
-        if (gpsdSocket > 0) {
-            FD_SET(gpsdSocket, &read_fd);
+        read_fd[SOCKET_POLL_INDEX].fd = device.getNdnSocket()->getSocket();
+        read_fd[TRIGGER_POLL_INDEX].fd = upperLayerComServ.getNdnOutgoingTrigger();
+        read_fd[GPSD_POLL_INDEX].fd = gpsdSocket; //ignored by poll when -1
+        read_fd[TIMER_POLL_INDEX].fd = timerFd;
+        for (int i = 0; i < POLL_FD_COUNT; i++) {
+            read_fd[i].events = POLLIN;
+            read_fd[i].revents = 0;
         }
-        if (tvNextDeadline.tv_sec == LLPolicy::NOTIMER) {
-            if (gpsdSocket==-1) {
-                NS_LOG_DEBUG("select with no timer and no gpsd, maxfd=" << maxfd);
-                tvNextDeadline.tv_sec=2;  /**after a while with no traffic, we have to try again to connect to gpsd */
-                tvNextDeadline.tv_usec=0;
-                selectResult = select(maxfd + 1, &read_fd, NULL, NULL, &tvNextDeadline);
-                tvNextDeadline.tv_sec = LLPolicy::NOTIMER;
-                tvNextDeadline.tv_usec = LLPolicy::NOTIMER;
-                selectForGpsd=true;
-            } else {
-                NS_LOG_DEBUG("select with no timer, maxfd=" << maxfd);
-                selectResult = select(maxfd + 1, &read_fd, NULL, NULL, NULL);
-            }
-            if (selectResult == -1) {
-                NS_LOG_ERROR("select failed: " << std::strerror(errno));
-                return -1;
-            }
+        //the retransmissions are driven by the timerfd, the timeout is only needed to reconnect to gpsd
+        if (gpsdSocket == -1) {
+            NS_LOG_DEBUG("poll with no gpsd");
+            gpsdRetry.tv_sec = 2;  /**after a while with no traffic, we have to try again to connect to gpsd */
+            gpsdRetry.tv_usec = 0;
+            selectResult = waitForEvents(read_fd, &gpsdRetry);
         } else {
-            NS_LOG_DEBUG("select with timer");
-            selectResult = select(maxfd + 1, &read_fd, NULL, NULL, &tvNextDeadline);
-            if (selectResult == -1) {
-                NS_LOG_ERROR("select failed: " << std::strerror(errno));
-                return -1;
-            }
+            NS_LOG_DEBUG("poll");
+            selectResult = waitForEvents(read_fd, NULL);
+        }
+        if (selectResult == -1) {
+            NS_LOG_ERROR("select failed: " << std::strerror(errno));
+            return -1;
         }
 
-#ifdef LAL_STATISTICS
-        timeval tt;
-        gettimeofday(&tt, NULL);
-        if (( tt.tv_sec > nextStatisticUpdate.tv_sec ) ||
-                (tt.tv_sec == nextStatisticUpdate.tv_sec && tt.tv_usec > nextStatisticUpdate.tv_usec )) {
-            //time for an other statistic update
-            device.getPolicy()->printStatistic();
-            nextStatisticUpdate.tv_sec = tt.tv_sec + STATISTIC_FREQUENCY_UPDATE;
-            nextStatisticUpdate.tv_usec = tt.tv_usec;
+        if (statisticsInterval > 0) {
+            const uint64_t now = TimerWheel::now();
+            if (now >= nextStatisticUpdate) {
+                //time for an other statistic update, the rates are computed on the actual interval
+                device.getPolicy()->printStatistic();
+                nextStatisticUpdate = now + (uint64_t) statisticsInterval * 1000000;
+            }
         }
-#endif
         
-        if (selectResult == 0 && (!selectForGpsd)) {
+        if (isReadable(read_fd[TIMER_POLL_INDEX])) {
             NS_LOG_DEBUG("Timer expired");
-            //timer expired
-            //This means that NDNDeviceAdapter has to retransmit a pkt
-            memset(buffer, 0, MAXNETWORKPKTSIZE);
-            len = device.getPolicy()->getPktForRetransmission(buffer, locationService);
-            if (len == -1) {
-                NS_LOG_WARN("getPktForRetransmission() returned -1");
-            } else {
+            uint64_t expirations;
+            if (read(timerFd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN) {
+                NS_LOG_ERROR("read from the timerfd failed: " << strerror(errno));
+                return -1;
+            }
+            timerArmed = false;
+            //NDNDeviceAdapter has to (re)transmit all the packets whose deadline has expired
+            unsigned char destination[ETH_ALEN];
+            while (true) {
+                len = device.getPolicy()->getPktForRetransmission(buffer, destination, locationService);
+                if (len == 0) {
+                    break;
+                }
+                if (len == -1) {
+                    NS_LOG_WARN("getPktForRetransmission() returned -1");
+                    continue;
+                }
                 try {
-                    device.getNdnSocket()->send(buffer, len);
+                    device.getNdnSocket()->sendTo(buffer, len, destination);
                 } catch (NdnSocketException) {
                     NS_LOG_ERROR("NdnSocket failed to send the packet");
                     //trying to create a new ndn socket
@@ -198,64 +219,61 @@ int NDNDeviceAdapter::start(NDNDeviceParams *param)
                     }
                 }
             }
-        } else {
-            NS_LOG_DEBUG("select return");
-            if (FD_ISSET(device.getNdnSocket()->getSocket(), &read_fd)) {
-                //pkt from the network
-                memset(buffer, 0, MAXNETWORKPKTSIZE);
+        }
+        if (isReadable(read_fd[SOCKET_POLL_INDEX])) {
+            //pkt from the network
+            memset(buffer, 0, MAXNETWORKPKTSIZE);
+            try {
+                len = device.getNdnSocket()->read(buffer, MAXNETWORKPKTSIZE, 1); //flag=1 -> we want to get metadata too (source mac address)
+            } catch (NdnSocketException) {
+                NS_LOG_ERROR("read from NdnSocket failed: " << strerror(errno));
+                //trying to create a new ndn socket
+                if(connectToNDNSocket()==-1) {
+                    NS_LOG_ERROR("Failed to create a new NdnSocket");
+                    return -1;
+                }
+            }
+            NS_LOG_INFO("Reading from network: " << len);
+            void *dataWithoutLLHeader;
+            //TODO instead of dataWithoutLLHeader put the address of the correct element of the shared memory
+            cmd = device.getPolicy()->pktFromNetwork(buffer, &len, dataWithoutLLHeader, locationService);
+            if (cmd == LLPolicy::GOUPLAYER) { //NDNDeviceAdapter has to send the pkt to the ndn daemon
+                len = upperLayerComServ.writeMessageToNDN(dataWithoutLLHeader, len);
+                if (len == -1) {
+                    NS_LOG_ERROR("Sending packet to NDN layer failed: " << strerror(errno));
+                    return -1;
+                }
+                NS_LOG_INFO("Sent packet to upper layer: " << device.getName() << ", datalen: " << len);
+            } else {
+                //NS_LOG_ERROR("Packet received from the network has been discarder (LLNomPolicy decision)");
+            }
+        }
+        if (isReadable(read_fd[TRIGGER_POLL_INDEX])) {
+            //pkt from NDN Daemon
+            NS_LOG_INFO("Packet from the NDN daemon");
+            LLMetadata80211AdHoc *metadata;
+            len = upperLayerComServ.readMessageFromNDN(buffer, MAXNETWORKPKTSIZE, (LLMetadata **) &metadata);
+            if (len < 0) {
+                NS_LOG_ERROR("Failed to read from LLupperLayerCommunicationService");
+                return -1;
+            }
+            if (device.getPolicy()->addOutgoingPkt(buffer, &len, metadata, locationService) == LLPolicy::GOTONETWORK) {
+                //pkt has to send to the network through ndn socket
                 try {
-                    len = device.getNdnSocket()->read(buffer, MAXNETWORKPKTSIZE, 1); //flag=1 -> we want to get metadata too (source mac address)
+                    len = device.getNdnSocket()->send(buffer, len);
                 } catch (NdnSocketException) {
-                    NS_LOG_ERROR("read from NdnSocket failed: " << strerror(errno));
+                    NS_LOG_ERROR("Send packet to the network failed: " << strerror(errno));
                     //trying to create a new ndn socket
                     if(connectToNDNSocket()==-1) {
                         NS_LOG_ERROR("Failed to create a new NdnSocket");
                         return -1;
                     }
                 }
-                NS_LOG_INFO("Reading from network: " << len);
-                void *dataWithoutLLHeader;
-                //TODO instead of dataWithoutLLHeader put the address of the correct element of the shared memory
-                cmd = device.getPolicy()->pktFromNetwork(buffer, &len, dataWithoutLLHeader, locationService);
-                if (cmd == LLPolicy::GOUPLAYER) { //NDNDeviceAdapter has to send the pkt to the ndn daemon
-                    len = upperLayerComServ.writeMessageToNDN(dataWithoutLLHeader, len);
-                    if (len == -1) {
-                        NS_LOG_ERROR("Sending packet to NDN layer failed: " << strerror(errno));
-                        return -1;
-                    }
-                    NS_LOG_INFO("Sent packet to upper layer: " << device.getName() << ", datalen: " << len);
-                } else {
-                    //NS_LOG_ERROR("Packet received from the network has been discarder (LLNomPolicy decision)");
-                }
-            }
-            if (FD_ISSET(upperLayerComServ.getNdnOutgoingTrigger(), &read_fd)) {
-                //pkt from NDN Daemon
-                NS_LOG_INFO("Packet from the NDN daemon");
-                LLMetadata80211AdHoc *metadata;
-                len = upperLayerComServ.readMessageFromNDN(buffer, MAXNETWORKPKTSIZE, (LLMetadata **) &metadata);
-                if (len < 0) {
-                    NS_LOG_ERROR("Failed to read from LLupperLayerCommunicationService");
-                    return -1;
-                }
-                if (device.getPolicy()->addOutgoingPkt(buffer, &len, metadata, locationService) == LLPolicy::GOTONETWORK) {
-                    //pkt has to send to the network through ndn socket
-                    try {
-                        len = device.getNdnSocket()->send(buffer, len);
-                    } catch (NdnSocketException) {
-                        NS_LOG_ERROR("Send packet to the network failed: " << strerror(errno));
-                        //trying to create a new ndn socket
-                        if(connectToNDNSocket()==-1) {
-                            NS_LOG_ERROR("Failed to create a new NdnSocket");
-                            return -1;
-                        }
-                    }
-                }
             }
         }
         if (gpsdSocket != -1) {
-            if (FD_ISSET(gpsdSocket, &read_fd)) {
+            if (isReadable(read_fd[GPSD_POLL_INDEX])) {
                 NS_LOG_DEBUG("Received data from gpsd");
-                memset(buffer, 0, MAXNETWORKPKTSIZE);
                 len = read(gpsdSocket, buffer, MAXNETWORKPKTSIZE);
                 if (len == 0) {
                     NS_LOG_ERROR("Failed to read from gpsd. Closing the socket.");
@@ -266,34 +284,41 @@ int NDNDeviceAdapter::start(NDNDeviceParams *param)
                 }
             }
         }
-        //in the next loop tvNextDeadline and nextDevice will be set properly. If no deadline is found, first will remain 0
-        if (device.getPolicy()->getNextDeadline(&tvNextDeadline.tv_sec, &tvNextDeadline.tv_usec) != LLPolicy::NOTIMER) {
-            //set tvNextDeadline (it stores the time remaining for the next retransmission)
-            //with this approach, we have a gettymeofday every pkt sent or received, but with a single update
-            //in this way Policy doesn't have to update the deadline of all the pending pkt
-            gettimeofday(&auxTimeVal, NULL);
-            if ((tvNextDeadline.tv_sec < auxTimeVal.tv_sec) ||
-                    ((tvNextDeadline.tv_sec == auxTimeVal.tv_sec) && tvNextDeadline.tv_usec < auxTimeVal.tv_usec)) {
-                //timer already expired. setting the timer to 0 means that select will return immediately
-                tvNextDeadline.tv_sec = 0;
-                tvNextDeadline.tv_usec = 0;
-            } else {
-                if (tvNextDeadline.tv_usec < auxTimeVal.tv_usec) {
-                    tvNextDeadline.tv_sec--;
-                }
-                tvNextDeadline.tv_usec = (tvNextDeadline.tv_usec - auxTimeVal.tv_usec + 1000000 ) % 1000000;
-                tvNextDeadline.tv_sec = tvNextDeadline.tv_sec - auxTimeVal.tv_sec;
-            }
-        } else {
-            tvNextDeadline.tv_sec = LLPolicy::NOTIMER;
-            tvNextDeadline.tv_usec = LLPolicy::NOTIMER;
+        if (updateTimer() == -1) {
+            return -1;
         }
-        FD_ZERO(&read_fd);
     }
 
     return 1;
 }
 
+int NDNDeviceAdapter::updateTimer()
+{
+    struct itimerspec value;
+    memset(&value, 0, sizeof(value));
+    if (device.getPolicy()->getNextDeadline(&value.it_value) != LLPolicy::NOTIMER) {
+        //the timerfd is set again only if the closest deadline has changed (a zero it_value would disarm it)
+        if (timerArmed && value.it_value.tv_sec == armedDeadline.tv_sec && value.it_value.tv_nsec == armedDeadline.tv_nsec) {
+            return 1;
+        }
+        if (value.it_value.tv_sec == 0 && value.it_value.tv_nsec == 0) {
+            value.it_value.tv_nsec = 1;
+        }
+        armedDeadline = value.it_value;
+        timerArmed = true;
+    } else {
+        if (!timerArmed) {
+            return 1;
+        }
+        timerArmed = false;
+    }
+    if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &value, NULL) == -1) {
+        NS_LOG_ERROR("timerfd_settime failed: " << strerror(errno));
+        return -1;
+    }
+    return 1;
+}
+
 int NDNDeviceAdapter::createGPSSocket()
 {
     NS_LOG_FUNCTION_NOARGS();
@@ -359,7 +384,7 @@ int NDNDeviceAdapter::connectToNDNSocket()
     }
     device.setNdnSocket(ndnSocket);
     device.setName(device.getName());
-    device.getNdnSocket()->setDestination(broadcastAddr);  //right now only broadcast communication is allowed
+    device.getNdnSocket()->setDestination(broadcastAddr);  //the policy gives the destination of each packet, see LLPolicy::getPktForRetransmission
     NS_LOG_DEBUG("NdnSocket id = " << device.getNdnSocket()->getSocket());
 
     return 1;
@@ -28,6 +28,8 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <poll.h>
 #include <semaphore.h>
 
 #include "ndnsock/ndn-raw-socket.h"
@@ -86,6 +88,9 @@ public:
 
         /**Interface Network name associated to NDNDeviceAdapter*/
         std::string deviceName;
+
+        /**Already built NDNDeviceAdapter that the thread has to run, NULL to create one on deviceName*/
+        NDNDeviceAdapter *adapter;
     };
 
     struct NDNDeviceMetaData {
@@ -101,8 +106,33 @@ public:
      * */
     NDNDeviceAdapter(std::string devname);
 
+    /**
+     * \brief Create a NDNDeviceAdapter on top of an already open NdnSocket
+     *
+     * Used by the link-layer emulator: no network interface and no gpsd are needed.
+     * The NDNDeviceAdapter takes ownership of the socket.
+     *
+     * \param socket NdnSocket used to send/receive packets, its device name is used as the adapter name
+     * \param gpsFd connected stream socket that delivers gpsd JSON reports (see GpsdParser)
+     * */
+    NDNDeviceAdapter(NdnSocket *socket, int gpsFd);
+
     virtual ~NDNDeviceAdapter();
 
+    /**
+     * \brief Get the name of the network interface used by the adapter
+     * */
+    std::string getDeviceName() const { return device.getName(); }
+
+    /**
+     * \brief Sets the interval between two link-layer statistics messages of every NDNDeviceAdapter, 0 to disable them
+     *
+     * The default is 10 seconds. The messages are logged by the LALStatistic component (see LLPolicy::printStatistic).
+     * It has to be called before the adapter is created: init() schedules the first message.
+     * */
+    static void setStatisticsInterval(unsigned int seconds) { statisticsInterval = seconds; }
+    static unsigned int getStatisticsInterval() { return statisticsInterval; }
+
     /**
      * \brief Run NDNDeviceAdatper
      *
@@ -112,6 +142,11 @@ public:
     int start(NDNDeviceParams *param);
 
 protected:
+    /**
+     * \brief Common initialization of the constructors
+     * */
+    void init(NdnSocket *ndnSocket);
+
     /**
      * \brief set up the communication with gps daemon
      * */
@@ -127,6 +162,12 @@ protected:
      * */
     int connectToNDNSocket();
 
+    /**
+     * \brief Arms the timerfd with the closest (re)transmission deadline of the policy, or disarms it
+     * \return 1 if everything is ok, -1 otherwise
+     * */
+    int updateTimer();
+
 
     /**
      * LLdevice associated to this NDNDeviceAdapter
@@ -136,6 +177,12 @@ protected:
     /**Socket used to send command to gpsd and receive back data about the node location*/
     int gpsdSocket;
 
+    /**timerfd (CLOCK_MONOTONIC) that expires at the closest (re)transmission deadline*/
+    int timerFd;
+    /**Whether timerFd is armed, and with which deadline*/
+    bool timerArmed;
+    struct timespec armedDeadline;
+
     /**
      * \brief LocationService used to store actual node position and to get info about position of other nodes or packets
      * */
@@ -154,7 +201,11 @@ protected:
      * */
     LLUpperLayerCommunicationService upperLayerComServ;
 
-    timeval nextStatisticUpdate;
+    /** Interval between two statistics messages (seconds), see setStatisticsInterval */
+    static unsigned int statisticsInterval;
+
+    /** Time of the next statistics message (microseconds, see TimerWheel::now) */
+    uint64_t nextStatisticUpdate;
 
 };
 
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "ndn-emulated-medium.h"
+#include "ndn-socket-exception.h"
+#include "corelib/log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE("NdnEmulatedMedium");
+
+namespace vndn
+{
+
+/** Size of the receive buffer of each node, it must hold the bursts of a dense network*/
+static const int RECEIVE_BUFFER_SIZE = 1024 * 1024;
+
+static int64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+NdnEmulatedMedium::Config::Config()
+    : range(150.0)
+    , lossRate(0.0)
+    , bitrate(6e6)
+    , unicastBitrate(0)
+    , frameOverhead(100000)
+    , delay(100000)
+    , seed(1)
+    , macRetries(7)
+{
+}
+
+NdnEmulatedMedium::NdnEmulatedMedium(unsigned int nodeCount, const Config &conf)
+    : config(conf)
+    , nodes(nodeCount)
+    , seed(conf.seed)
+    , stopping(false)
+{
+    NS_LOG_FUNCTION(this << nodeCount);
+
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        Node &node = nodes[i];
+        if (::socketpair(AF_UNIX, SOCK_DGRAM, 0, node.fds) == -1) {
+            std::string err = "socketpair() failed: ";
+            err += strerror(errno);
+            throw NdnSocketException(err);
+        }
+        // the delivery thread must never block on a slow node
+        int bufSize = RECEIVE_BUFFER_SIZE;
+        ::setsockopt(node.fds[1], SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+        ::setsockopt(node.fds[0], SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+        ::fcntl(node.fds[1], F_SETFL, O_NONBLOCK);
+
+        // locally administered unicast address
+        const unsigned char mac[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, (unsigned char)(i >> 8), (unsigned char)(i & 0xff) };
+        memcpy(node.mac, mac, ETH_ALEN);
+        node.hasPosition = false;
+        node.busyUntil = 0;
+        node.rxEnd = 0;
+        node.rxCurrent = NULL;
+        memset(&node.stats, 0, sizeof(node.stats));
+    }
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&thread, NULL, &NdnEmulatedMedium::deliveryThread, this) != 0) {
+        throw NdnSocketException("Failed to create the delivery thread");
+    }
+}
+
+NdnEmulatedMedium::~NdnEmulatedMedium()
+{
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, NULL);
+
+    while (!receptions.empty()) {
+        delete receptions.top();
+        receptions.pop();
+    }
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        ::close(nodes[i].fds[0]);
+        ::close(nodes[i].fds[1]);
+    }
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+int NdnEmulatedMedium::getSocket(unsigned int node) const
+{
+    return nodes.at(node).fds[0];
+}
+
+const unsigned char *NdnEmulatedMedium::getMacAddress(unsigned int node) const
+{
+    return nodes.at(node).mac;
+}
+
+void NdnEmulatedMedium::setPosition(unsigned int node, double lat, double lon)
+{
+    geo::Coordinate position(lat, lon);
+
+    pthread_mutex_lock(&mutex);
+    nodes.at(node).position = position;
+    nodes.at(node).hasPosition = true;
+    pthread_mutex_unlock(&mutex);
+}
+
+int NdnEmulatedMedium::transmit(unsigned int node, const void *data, int len, const unsigned char destMacAddress[ETH_ALEN])
+{
+    static const unsigned char broadcastAddr[ETH_ALEN] = { 0xff , 0xff , 0xff , 0xff , 0xff , 0xff };
+
+    Ptr<Frame> frame = Create<Frame>();
+    frame->data.resize(ETH_ALEN + len);
+    memcpy(&frame->data[0], nodes.at(node).mac, ETH_ALEN);
+    memcpy(&frame->data[ETH_ALEN], data, len);
+    frame->sender = node;
+    frame->broadcast = memcmp(destMacAddress, broadcastAddr, ETH_ALEN) == 0;
+    memcpy(frame->destination, destMacAddress, ETH_ALEN);
+    frame->attempts = 0;
+
+    pthread_mutex_lock(&mutex);
+    startTransmission(frame);
+    // the reference counter is not atomic, the delivery thread
+    // must not release a copy of the frame at the same time
+    frame = Ptr<Frame>();
+    pthread_mutex_unlock(&mutex);
+    return len;
+}
+
+void NdnEmulatedMedium::startTransmission(const Ptr<Frame> &frame)
+{
+    const int len = frame->data.size() - ETH_ALEN;
+    Node &sender = nodes[frame->sender];
+    sender.stats.txFrames++;
+    sender.stats.txBytes += len;
+    if (frame->attempts++ > 0) {
+        sender.stats.retries++;
+    }
+    if (!sender.hasPosition) {
+        NS_LOG_DEBUG("node " << frame->sender << " has no position, nobody can hear it");
+        return;
+    }
+
+    // carrier sense: wait for the end of every transmission in range
+    const int64_t t = now();
+    const int64_t start = std::max(t, sender.busyUntil);
+    const double bitrate = !frame->broadcast && config.unicastBitrate > 0 ? config.unicastBitrate : config.bitrate;
+    const int64_t end = start + config.frameOverhead + static_cast<int64_t>(len * 8 * 1e9 / bitrate);
+    sender.stats.deferTime += start - t;
+    sender.busyUntil = end;
+
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        Node &receiver = nodes[i];
+        if (i == frame->sender || !receiver.hasPosition ||
+                sender.position.twoPointsDistance(receiver.position) > config.range) {
+            continue;
+        }
+
+        receiver.busyUntil = std::max(receiver.busyUntil, end);
+
+        Reception *reception = new Reception;
+        reception->time = end + config.delay;
+        reception->node = i;
+        reception->frame = frame;
+        reception->addressed = frame->broadcast || memcmp(frame->destination, receiver.mac, ETH_ALEN) == 0;
+        reception->lost = config.lossRate > 0 && rand_r(&seed) < config.lossRate * RAND_MAX;
+        reception->collided = false;
+
+        // the receiver is still receiving an other frame (hidden terminal): both are lost
+        if (receiver.rxEnd > start) {
+            reception->collided = true;
+            if (receiver.rxCurrent != NULL) {
+                receiver.rxCurrent->collided = true;
+            }
+        }
+        if (end >= receiver.rxEnd) {
+            receiver.rxEnd = end;
+            receiver.rxCurrent = reception;
+        }
+
+        receptions.push(reception);
+    }
+    pthread_cond_signal(&cond);
+}
+
+NdnEmulatedMedium::NodeStatistics NdnEmulatedMedium::getStatistics(unsigned int node) const
+{
+    pthread_mutex_lock(&mutex);
+    NodeStatistics stats = nodes.at(node).stats;
+    pthread_mutex_unlock(&mutex);
+    return stats;
+}
+
+void *NdnEmulatedMedium::deliveryThread(void *medium)
+{
+    static_cast<NdnEmulatedMedium *>(medium)->runDelivery();
+    return 0;
+}
+
+void NdnEmulatedMedium::runDelivery()
+{
+    pthread_mutex_lock(&mutex);
+    while (!stopping) {
+        if (receptions.empty()) {
+            pthread_cond_wait(&cond, &mutex);
+            continue;
+        }
+
+        const int64_t next = receptions.top()->time;
+        if (next > now()) {
+            struct timespec deadline;
+            deadline.tv_sec = next / 1000000000LL;
+            deadline.tv_nsec = next % 1000000000LL;
+            pthread_cond_timedwait(&cond, &mutex, &deadline);
+            continue;
+        }
+
+        Reception *reception = receptions.top();
+        receptions.pop();
+        deliver(reception);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+void NdnEmulatedMedium::deliver(Reception *reception)
+{
+    Node &node = nodes[reception->node];
+    if (node.rxCurrent == reception) {
+        node.rxCurrent = NULL;
+    }
+
+    if (reception->addressed) {
+        const std::vector<uint8_t> &data = reception->frame->data;
+        if (reception->collided || reception->lost) {
+            if (reception->collided) {
+                node.stats.collisions++;
+            } else {
+                node.stats.lost++;
+            }
+            // the sender of a unicast frame gets no ack, and tries again
+            if (!reception->frame->broadcast && reception->frame->attempts <= config.macRetries) {
+                startTransmission(reception->frame);
+            }
+        } else if (::send(node.fds[1], &data[0], data.size(), MSG_DONTWAIT) == -1) {
+            NS_LOG_WARN("node " << reception->node << " dropped a frame: " << strerror(errno));
+            node.stats.dropped++;
+        } else {
+            node.stats.rxFrames++;
+            node.stats.rxBytes += data.size() - ETH_ALEN;
+        }
+    }
+
+    delete reception;
+}
+
+} /* namespace vndn */
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef NDNEMULATEDMEDIUM_H_
+#define NDNEMULATEDMEDIUM_H_
+
+#include "corelib/ptr.h"
+#include "corelib/simple-ref-count.h"
+#include "utils/geo/coordinate.h"
+
+#include <pthread.h>
+#include <queue>
+#include <stdint.h>
+#include <vector>
+#include <linux/if_ether.h>
+
+namespace vndn
+{
+
+/**
+ * \brief Software broadcast medium shared by the NdnEmulatedSockets of the link-layer emulator
+ *
+ * It replaces the wireless channel between a set of nodes living in the same process.
+ * Every node has a position (set by the caller, e.g. from a mobility script) and a
+ * socket pair: frames addressed to the node are written by the medium on one end,
+ * the other end is the selectable fd of the node NdnEmulatedSocket.
+ *
+ * The channel model is deliberately simple:
+ *  - range: a frame reaches every node closer than the configured range (unit disc)
+ *  - airtime: a frame occupies the channel for frameOverhead + size / bitrate, unicast frames
+ *    can use a higher bit rate (as chosen by the rate adaptation), broadcast ones use the basic rate
+ *  - contention: a node defers its transmission until the channel, as sensed by the node
+ *    (i.e. any transmission in range), is idle. Two frames overlapping at a receiver
+ *    (hidden terminals) are both lost
+ *  - loss: every reception is independently lost with the configured probability
+ *  - retries: a unicast frame lost or collided at its destination is transmitted again,
+ *    up to the configured number of times, as a 802.11 sender does when the ack is missing
+ *  - delay: frames are delivered at the end of their airtime plus the configured delay
+ *
+ * All the methods are thread-safe, frames are delivered by an internal thread.
+ * */
+class NdnEmulatedMedium
+{
+public:
+    /**
+     * \brief Parameters of the channel model
+     * */
+    struct Config {
+        /**Transmission range, in meters*/
+        double range;
+        /**Probability (0 to 1) that a frame is lost by a receiver in range*/
+        double lossRate;
+        /**Bit rate of the channel, in bit/s*/
+        double bitrate;
+        /**Bit rate of the unicast frames, in bit/s, 0 to use bitrate*/
+        double unicastBitrate;
+        /**Airtime added to every frame (preamble, inter-frame space, average backoff), in nanoseconds*/
+        int64_t frameOverhead;
+        /**Propagation and processing delay added to every reception, in nanoseconds*/
+        int64_t delay;
+        /**Seed of the random loss*/
+        unsigned int seed;
+        /**Retransmissions of a unicast frame that did not reach its destination*/
+        unsigned int macRetries;
+
+        /**
+         * \brief Default configuration: 150 m range, no loss, 6 Mbit/s (802.11p) for all the frames, 100 us of overhead and delay, 7 retries
+         * */
+        Config();
+    };
+
+    /**
+     * \brief Counters of a node, updated by the medium
+     * */
+    struct NodeStatistics {
+        /**Frames and bytes transmitted by the node (retries included)*/
+        uint64_t txFrames;
+        uint64_t txBytes;
+        /**Unicast frames transmitted again by the node*/
+        uint64_t retries;
+        /**Frames and bytes delivered to the node*/
+        uint64_t rxFrames;
+        uint64_t rxBytes;
+        /**Frames addressed to the node and lost because of the random loss*/
+        uint64_t lost;
+        /**Frames addressed to the node and lost because of a collision*/
+        uint64_t collisions;
+        /**Frames addressed to the node and dropped because its receive buffer was full*/
+        uint64_t dropped;
+        /**Total time spent waiting for the channel to become idle, in nanoseconds*/
+        int64_t deferTime;
+    };
+
+    /**
+     * \brief Creates the medium and starts the delivery thread
+     *
+     * \param nodes number of nodes attached to the medium
+     * \param config channel model
+     * */
+    NdnEmulatedMedium(unsigned int nodes, const Config &config);
+
+    /**
+     * \brief Stops the delivery thread and closes all the sockets
+     * */
+    ~NdnEmulatedMedium();
+
+    unsigned int getNodeCount() const { return nodes.size(); }
+
+    /**
+     * \brief Get the fd on which the frames addressed to the node can be read
+     *
+     * Every read returns one frame: the source MAC address followed by the data
+     * */
+    int getSocket(unsigned int node) const;
+
+    /**
+     * \brief Get the MAC address of the node (02:00:00:00:xx:xx, xx:xx being the node index)
+     * */
+    const unsigned char *getMacAddress(unsigned int node) const;
+
+    /**
+     * \brief Updates the position of the node. A node without position cannot send or receive anything
+     * */
+    void setPosition(unsigned int node, double lat, double lon);
+
+    /**
+     * \brief Transmits a frame
+     *
+     * \param node index of the sender
+     * \param data frame payload
+     * \param len size of data
+     * \param destMacAddress destination (broadcast or the MAC address of a node)
+     * \return len
+     * */
+    int transmit(unsigned int node, const void *data, int len, const unsigned char destMacAddress[ETH_ALEN]);
+
+    /**
+     * \brief Get a snapshot of the counters of the node
+     * */
+    NodeStatistics getStatistics(unsigned int node) const;
+
+private:
+    NdnEmulatedMedium(const NdnEmulatedMedium &);
+    NdnEmulatedMedium &operator=(const NdnEmulatedMedium &);
+
+    /**
+     * \brief Frame on the air, shared by all its receptions
+     * */
+    struct Frame : public SimpleRefCount<Frame> {
+        /**source MAC address followed by the payload*/
+        std::vector<uint8_t> data;
+        unsigned int sender;
+        bool broadcast;
+        unsigned char destination[ETH_ALEN];
+        /**transmissions of the frame so far*/
+        unsigned int attempts;
+    };
+
+    /**
+     * \brief Reception of a frame by a node
+     * */
+    struct Reception {
+        /**delivery time (end of the frame plus delay)*/
+        int64_t time;
+        unsigned int node;
+        Ptr<Frame> frame;
+        /**false if the frame is unicast and addressed to an other node*/
+        bool addressed;
+        bool lost;
+        bool collided;
+    };
+
+    struct ReceptionLater {
+        bool operator()(const Reception *a, const Reception *b) const { return a->time > b->time; }
+    };
+
+    struct Node {
+        int fds[2];
+        unsigned char mac[ETH_ALEN];
+        bool hasPosition;
+        geo::Coordinate position;
+        /**time until which the node senses the channel busy*/
+        int64_t busyUntil;
+        /**end of the last frame received by the node*/
+        int64_t rxEnd;
+        /**reception of the frame that ends at rxEnd, NULL if already delivered*/
+        Reception *rxCurrent;
+        NodeStatistics stats;
+    };
+
+    static void *deliveryThread(void *medium);
+
+    /**
+     * \brief Delivers the receptions whose time has come, until the medium is destroyed
+     * */
+    void runDelivery();
+
+    /**
+     * \brief Puts the frame on the air, from its sender, and schedules its receptions
+     *
+     * Must be called with the mutex held
+     * */
+    void startTransmission(const Ptr<Frame> &frame);
+
+    /**
+     * \brief Writes the frame on the node socket (or accounts for its loss) and frees the reception
+     *
+     * Must be called with the mutex held
+     * */
+    void deliver(Reception *reception);
+
+    Config config;
+    std::vector<Node> nodes;
+    std::priority_queue<Reception *, std::vector<Reception *>, ReceptionLater> receptions;
+    unsigned int seed;
+
+    mutable pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool stopping;
+};
+
+} /* namespace vndn */
+
+#endif /* NDNEMULATEDMEDIUM_H_ */
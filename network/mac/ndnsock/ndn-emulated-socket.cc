@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "ndn-emulated-socket.h"
+#include "corelib/assert.h"
+#include "corelib/log.h"
+#include "network/mac/link-layer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <sys/socket.h>
+
+NS_LOG_COMPONENT_DEFINE("NdnEmulatedSocket");
+
+namespace vndn
+{
+
+NdnEmulatedSocket::NdnEmulatedSocket(NdnEmulatedMedium &mediumP, unsigned int nodeP, std::string deviceNameP)
+    : medium(mediumP)
+    , node(nodeP)
+    , socketId(mediumP.getSocket(nodeP))
+    , deviceName(deviceNameP)
+    , destinationIsSet(false)
+{
+    memcpy(macAddress, medium.getMacAddress(node), ETH_ALEN);
+    NS_LOG_DEBUG("Emulated socket created, device=" << deviceName << " fd=" << socketId
+                 << " mac=" << PRINTABLE_MAC_ADDRESS(macAddress));
+}
+
+int NdnEmulatedSocket::send(void *data, int len)
+{
+    if (!destinationIsSet) {
+        NS_LOG_ERROR("Destination is not set");
+        throw NdnSocketException("send failed: no destination address is set");
+    }
+    return sendTo(data, len, destination);
+}
+
+int NdnEmulatedSocket::sendTo(void *data, int len, const unsigned char destMacAddress[ETH_ALEN])
+{
+    if (socketId == -1) {
+        NS_LOG_ERROR("Invalid socket");
+        throw NdnSocketException("send failed: invalid socket");
+    }
+    if (len > MAXNETWORKPKTSIZE) {
+        throw NdnSocketException("send failed: frame too long");
+    }
+    return medium.transmit(node, data, len, destMacAddress);
+}
+
+int NdnEmulatedSocket::read(void *buffer, int maxSize, int flag)
+{
+    if (socketId < 0) {
+        throw NdnSocketException("read error: no valid socket");
+    }
+
+    // every datagram is the source MAC address followed by the data
+    uint8_t frame[ETH_ALEN + MAXNETWORKPKTSIZE];
+    int frameLen = ::recv(socketId, frame, sizeof(frame), 0);
+    if (frameLen < ETH_ALEN) {
+        std::string err = "read failed: ";
+        err.append(frameLen < 0 ? strerror(errno) : "truncated frame");
+        throw NdnSocketException(err);
+    }
+
+    int metaDataSize = (flag == 1) ? sizeof(ndnSocketMetaData) : 0;
+    int dataLen = std::min(frameLen - ETH_ALEN, maxSize);
+    uint8_t *buf = (uint8_t *)buffer;
+    if (flag == 1) {
+        memcpy(buf, frame, metaDataSize);
+    }
+    memcpy(&buf[metaDataSize], &frame[ETH_ALEN], dataLen);
+    return dataLen + metaDataSize;
+}
+
+int NdnEmulatedSocket::read(void *buffer, int maxSize)
+{
+    return read(buffer, maxSize, 0);
+}
+
+int NdnEmulatedSocket::readn(void *buffer, int dataSize)
+{
+    NS_ASSERT_MSG(false, "readn() not implemented");
+    return -1;
+}
+
+unsigned char *NdnEmulatedSocket::getDeviceMacAddress()
+{
+    return macAddress;
+}
+
+void NdnEmulatedSocket::setDestination(const unsigned char destMacAddress[ETH_ALEN])
+{
+    memcpy(destination, destMacAddress, ETH_ALEN);
+    destinationIsSet = true;
+}
+
+void NdnEmulatedSocket::unsetDestination()
+{
+    destinationIsSet = false;
+}
+
+void NdnEmulatedSocket::setDevice(std::string newDeviceName)
+{
+    deviceName = newDeviceName;
+}
+
+std::string NdnEmulatedSocket::getDevice()
+{
+    return deviceName;
+}
+
+void NdnEmulatedSocket::unsetDevice()
+{
+    deviceName = NULLDEVICE;
+}
+
+int NdnEmulatedSocket::getSocket()
+{
+    return socketId;
+}
+
+void NdnEmulatedSocket::closeSocket()
+{
+    socketId = -1;
+    destinationIsSet = false;
+    deviceName = NULLDEVICE;
+}
+
+} /* namespace vndn */
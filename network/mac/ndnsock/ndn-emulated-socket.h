@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef NDNEMULATEDSOCKET_H_
+#define NDNEMULATEDSOCKET_H_
+
+#include "ndn-socket.h"
+#include "ndn-emulated-medium.h"
+
+#include <string>
+
+namespace vndn
+{
+
+/**
+ * \brief NdnSocket attached to a node of an NdnEmulatedMedium
+ *
+ * It behaves as an NdnRawSocket bound to a wireless interface, but the frames
+ * go through the software medium instead of the network, so that many nodes can
+ * run in the same process without root privileges.
+ * */
+class NdnEmulatedSocket : public NdnSocket
+{
+public:
+    /**
+     * \brief Create the socket of a node of the medium. The socket is ready to use
+     *
+     * \param medium medium shared by all the emulated nodes
+     * \param node index of the node in the medium
+     * \param deviceName name reported by getDevice()
+     * */
+    NdnEmulatedSocket(NdnEmulatedMedium &medium, unsigned int node, std::string deviceName);
+
+    int send(void *data, int len);
+    int sendTo(void *data, int len, const unsigned char destMacAddress[ETH_ALEN]);
+    int read(void *buffer, int maxSize, int flag);
+    int read(void *buffer, int maxSize);
+    int readn(void *buffer, int dataSize);
+    unsigned char *getDeviceMacAddress();
+    void setDestination(const unsigned char destMacAddress[ETH_ALEN]);
+    void unsetDestination();
+    void setDevice(std::string deviceName);
+    std::string getDevice();
+    void unsetDevice();
+    int getSocket();
+
+    /**
+     * \brief Detach the socket from the medium, the fd is owned (and closed) by the medium
+     * */
+    void closeSocket();
+
+protected:
+    NdnEmulatedMedium &medium;
+    unsigned int node;
+    int socketId;
+    std::string deviceName;
+    unsigned char macAddress[ETH_ALEN];
+    unsigned char destination[ETH_ALEN];
+    bool destinationIsSet;
+};
+
+} /* namespace vndn */
+
+#endif /* NDNEMULATEDSOCKET_H_ */
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "neighbor-table.h"
+#include "ndnsock/ndn-socket.h"
+#include "corelib/log.h"
+
+#include <string.h>
+
+NS_LOG_COMPONENT_DEFINE("NeighborTable");
+
+namespace vndn
+{
+
+NeighborTable::NeighborTable()
+    : nextPurge(0)
+{
+}
+
+void NeighborTable::frameReceived(const unsigned char mac[ETH_ALEN], const LLHeaderInfo &hdr, unsigned int size, uint64_t now)
+{
+    purge(now);
+    std::pair<boost::unordered_map<uint64_t, Neighbor>::iterator, bool> ret =
+        neighbors.insert(std::make_pair(macKey(mac), Neighbor()));
+    Neighbor &neighbor = ret.first->second;
+    if (ret.second || now - neighbor.lastSeen > neighborLifetime) {
+        NS_LOG_DEBUG("New neighbor " << PRINTABLE_MAC_ADDRESS(mac));
+        memcpy(neighbor.mac, mac, ETH_ALEN);
+        neighbor.frames = 0;
+        neighbor.bytes = 0;
+    }
+    neighbor.position = GeoStorage(hdr.lat, hdr.longitude);
+    neighbor.lastSeen = now;
+    neighbor.frames++;
+    neighbor.bytes += size;
+}
+
+void NeighborTable::interestReceived(const unsigned char mac[ETH_ALEN], const PacketStorage::packetKey &key, uint64_t now)
+{
+    std::pair<boost::unordered_map<PacketStorage::packetKey, Request, PacketStorage::packetKeyHash>::iterator, bool> ret =
+        requests.insert(std::make_pair(key, Request()));
+    Request &request = ret.first->second;
+    if (ret.second || now > request.expiry) {
+        memcpy(request.mac, mac, ETH_ALEN);
+        request.several = false;
+    } else if (memcmp(request.mac, mac, ETH_ALEN) != 0) {
+        request.several = true;
+    }
+    request.expiry = now + requestLifetime;
+}
+
+bool NeighborTable::getRequester(const NameComponents &name, unsigned char mac[ETH_ALEN], uint64_t now)
+{
+    std::vector<PacketStorage::packetKey> keys;
+    PacketStorage::makePrefixKeys(PacketStorage::INTEREST_PACKET, name, keys);
+    bool found = false;
+    bool single = true;
+    for (size_t i = 0; i < keys.size(); i++) {
+        boost::unordered_map<PacketStorage::packetKey, Request, PacketStorage::packetKeyHash>::iterator it = requests.find(keys[i]);
+        if (it == requests.end()) {
+            continue;
+        }
+        const Request &request = it->second;
+        if (now <= request.expiry) {
+            if (request.several || (found && memcmp(mac, request.mac, ETH_ALEN) != 0)) {
+                single = false;
+            } else if (!found) {
+                memcpy(mac, request.mac, ETH_ALEN);
+                found = true;
+            }
+        }
+        requests.erase(it);
+    }
+    return found && single && getNeighbor(mac, now) != NULL;
+}
+
+const NeighborTable::Neighbor *NeighborTable::getNeighbor(const unsigned char mac[ETH_ALEN], uint64_t now) const
+{
+    boost::unordered_map<uint64_t, Neighbor>::const_iterator it = neighbors.find(macKey(mac));
+    if (it == neighbors.end() || now - it->second.lastSeen > neighborLifetime) {
+        return NULL;
+    }
+    return &it->second;
+}
+
+void NeighborTable::getNeighbors(uint64_t now, std::vector<Neighbor> &result) const
+{
+    for (boost::unordered_map<uint64_t, Neighbor>::const_iterator it = neighbors.begin(); it != neighbors.end(); it++) {
+        if (now - it->second.lastSeen <= neighborLifetime) {
+            result.push_back(it->second);
+        }
+    }
+}
+
+void NeighborTable::purge(uint64_t now)
+{
+    if (now < nextPurge) {
+        return;
+    }
+    nextPurge = now + purgeInterval;
+    boost::unordered_map<uint64_t, Neighbor>::iterator n = neighbors.begin();
+    while (n != neighbors.end()) {
+        if (now - n->second.lastSeen > neighborLifetime) {
+            n = neighbors.erase(n);
+        } else {
+            n++;
+        }
+    }
+    boost::unordered_map<PacketStorage::packetKey, Request, PacketStorage::packetKeyHash>::iterator r = requests.begin();
+    while (r != requests.end()) {
+        if (now > r->second.expiry) {
+            r = requests.erase(r);
+        } else {
+            r++;
+        }
+    }
+}
+
+} /* namespace vndn */
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef NEIGHBOR_TABLE_H_
+#define NEIGHBOR_TABLE_H_
+
+#include "packet-storage.h"
+#include "geo-storage.h"
+#include "ll-header.h"
+
+#include "network/ndn-name-components.h"
+
+#include <boost/unordered_map.hpp>
+#include <linux/if_ether.h>
+#include <stdint.h>
+#include <vector>
+
+namespace vndn
+{
+
+/**
+ * \brief Neighbors of the node, learnt from the source MAC address of the frames received
+ *
+ * For each neighbor it records the position announced in its last NDN-LAL header and when it has
+ * been heard last; a neighbor not heard for neighborLifetime is forgotten.
+ * It also remembers which neighbor sent each interest sent up to NDN, so that the data that satisfies
+ * an interest requested by a single neighbor can be unicast to it (see getRequester).
+ * Times are microseconds of CLOCK_MONOTONIC (see TimerWheel::now).
+ * */
+class NeighborTable
+{
+public:
+    /** A neighbor is forgotten after this time without any frame from it (microseconds) */
+    static const uint64_t neighborLifetime = 3000000;
+    /** A request is forgotten after this time, the default lifetime of the NDN interests (microseconds) */
+    static const uint64_t requestLifetime = 4000000;
+    /** Interval between two purges of the forgotten entries (microseconds) */
+    static const uint64_t purgeInterval = 1000000;
+
+    struct Neighbor {
+        unsigned char mac[ETH_ALEN];
+        /** Position of the last header received, DEFAULT_COORDINATE_DOUBLE if not valid */
+        GeoStorage position;
+        /** Time of the last frame received */
+        uint64_t lastSeen;
+        /** Frames received since the neighbor has been learnt, and their size (bytes) */
+        unsigned int frames;
+        uint64_t bytes;
+    };
+
+    NeighborTable();
+
+    /**
+     * \brief A frame of size bytes with the NDN-LAL header hdr has been received from mac
+     * */
+    void frameReceived(const unsigned char mac[ETH_ALEN], const LLHeaderInfo &hdr, unsigned int size, uint64_t now);
+
+    /**
+     * \brief The interest (as PacketStorage::makeKey) received from mac has been sent up to NDN
+     * */
+    void interestReceived(const unsigned char mac[ETH_ALEN], const PacketStorage::packetKey &key, uint64_t now);
+
+    /**
+     * \brief Finds the neighbor the data with the given name has to be sent to
+     *
+     * The data satisfies the requests of all its prefixes, which are forgotten.
+     * \param mac the function will store the MAC address of the neighbor
+     * \return true if all the requests satisfied come from the same neighbor, which is still in the table.
+     * false if the data has to be broadcast: no request, several neighbors, or neighbor gone
+     * */
+    bool getRequester(const NameComponents &name, unsigned char mac[ETH_ALEN], uint64_t now);
+
+    /**
+     * \brief Gets a neighbor heard in the last neighborLifetime
+     * \return NULL if the neighbor is not known
+     * */
+    const Neighbor *getNeighbor(const unsigned char mac[ETH_ALEN], uint64_t now) const;
+
+    /**
+     * \brief Gets the neighbors heard in the last neighborLifetime
+     * \param result the function will append them
+     * */
+    void getNeighbors(uint64_t now, std::vector<Neighbor> &result) const;
+
+    /** Number of neighbors, including the ones not purged yet */
+    size_t size() const { return neighbors.size(); }
+
+private:
+    struct Request {
+        unsigned char mac[ETH_ALEN];
+        /** The interest has been received from more than one neighbor */
+        bool several;
+        uint64_t expiry;
+    };
+
+    /**
+     * \brief Forgets the neighbors and the requests expired, at most every purgeInterval
+     * */
+    void purge(uint64_t now);
+
+    boost::unordered_map<uint64_t, Neighbor> neighbors;
+    boost::unordered_map<PacketStorage::packetKey, Request, PacketStorage::packetKeyHash> requests;
+    uint64_t nextPurge;
+};
+
+} /* namespace vndn */
+
+#endif /* NEIGHBOR_TABLE_H_ */
@@ -23,9 +23,9 @@
 #include <iterator>
 #include <string>
 #include <string.h>
+#include <vector>
 
 #include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
 
 using boost::multi_index_container;
@@ -36,85 +36,182 @@ NS_LOG_COMPONENT_DEFINE ("LLPacketStorage");
 namespace vndn
 {
 
+// FNV-1a, 64 bit
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
 PacketStorage::PacketStorage()
+    : wheel(TimerWheel::now())
 {
 }
 
 PacketStorage::~PacketStorage()
 {
-    const linkLayerPktElementSet::index<nameT>::type &timer_index = storage.get<nameT>();
-    const linkLayerPktElement *el;
-    linkLayerPktElementSet::index<nameT>::type::iterator it;
     /**Deleting all the elements present in the storage*/
-    for (it = timer_index.begin(); it != timer_index.end(); it++) {
-        el = &(*it);
-        delete[] el->data;
-        delete el->ackInfo;
-        storage.erase(it);
+    const linkLayerPktElementSet::index<nameT>::type &key_index = storage.get<nameT>();
+    linkLayerPktElementSet::index<nameT>::type::iterator it;
+    for (it = key_index.begin(); it != key_index.end(); it++) {
+        wheel.cancel(it->timerEntry);
+        delete[] it->data;
+        delete it->ackInfo;
+    }
+    storage.clear();
+}
+
+PacketStorage::nameTrieNode::~nameTrieNode()
+{
+    boost::unordered_map<std::string, nameTrieNode *>::iterator it;
+    for (it = children.begin(); it != children.end(); it++) {
+        delete it->second;
     }
 }
 
+/**
+ * \brief Adds a name component to a FNV-1a hash
+ * */
+static uint64_t hashComponent(uint64_t hash, const std::string &component)
+{
+    // the size of each component is hashed too, so that /a/bc and /ab/c are different
+    uint32_t size = component.size();
+    for (int b = 0; b < 4; b++) {
+        hash = (hash ^ ((size >> (8 * b)) & 0xff)) * FNV_PRIME;
+    }
+    const unsigned char *c = (const unsigned char *) component.data();
+    for (size_t j = 0; j < component.size(); j++) {
+        hash = (hash ^ c[j]) * FNV_PRIME;
+    }
+    return hash;
+}
 
-/*int PacketStorage::insertPkt(void * pkt, int len,int maxNumberOfRetransmission, std::string name,uint32_t nonce, std::pair<unsigned int, unsigned int> timerP)
+PacketStorage::packetKey PacketStorage::makeKey(PacketType type, const NameComponents &name)
 {
-    linkLayerPktElement el(name,nonce,len,1,maxNumberOfRetransmission, timerP);
-    el.data=new char[len];
-    memcpy(el.data,pkt,len);
-    //const linkLayerPktElementSet::nth_index<0>::type& key_index=storage.get<0>();
-    std::pair<linkLayerPktElementSet::nth_index<0>::type::iterator,bool> ret = storage.insert(el); 
-    if(ret.second)
-    {
-        return 1;
+    uint64_t hash = FNV_OFFSET_BASIS;
+    std::list<std::string>::const_iterator i;
+    for (i = name.GetComponents().begin(); i != name.GetComponents().end(); i++) {
+        hash = hashComponent(hash, *i);
     }
-    return -1;   // remove the function
-}*/
-
-
-//versione with nonce as a key (use it if we introduce a nonce also in content object)
-/*int PacketStorage::insertPkt(void * pkt, int len, int maxNumberOfRetransmission,std::string key,std::string name, std::pair<unsigned int, unsigned int> timerP, GeoStorage gpsInfo){
-    linkLayerPktElement el(key,name,len,1,maxNumberOfRetransmission, timerP);
-    el.geoInfo=gpsInfo;
-    el.data=new char[len];
-    memcpy(el.data,pkt,len);
-    //const linkLayerPktElementSet::nth_index<0>::type& key_index=storage.get<0>();
-    std::pair<linkLayerPktElementSet::nth_index<0>::type::iterator,bool> ret = storage.insert(el); //? check return value
-    if(ret.second)
-    {
-        return 1;
+    packetKey key;
+    key.type = type;
+    key.nameHash = hash;
+    return key;
+}
+
+void PacketStorage::makePrefixKeys(PacketType type, const NameComponents &name, std::vector<packetKey> &keys)
+{
+    // the hash of a prefix is an intermediate state of the hash of the name
+    packetKey key;
+    key.type = type;
+    key.nameHash = FNV_OFFSET_BASIS;
+    keys.clear();
+    keys.reserve(name.GetComponents().size() + 1);
+    keys.push_back(key);
+    std::list<std::string>::const_iterator i;
+    for (i = name.GetComponents().begin(); i != name.GetComponents().end(); i++) {
+        key.nameHash = hashComponent(key.nameHash, *i);
+        keys.push_back(key);
     }
-    return -1;  // caller has to check
-}*/
+}
 
+void PacketStorage::trieInsert(const linkLayerPktElement *el)
+{
+    nameTrieNode *node = &trieRoot;
+    std::list<std::string>::const_iterator i;
+    for (i = el->components->GetComponents().begin(); i != el->components->GetComponents().end(); i++) {
+        nameTrieNode *&child = node->children[*i];
+        if (child == NULL) {
+            child = new nameTrieNode();
+        }
+        node = child;
+    }
+    node->interest = el;
+}
+
+void PacketStorage::trieRemove(const linkLayerPktElement *el)
+{
+    const std::list<std::string> &name = el->components->GetComponents();
+    // path from the root to the node of the interest, to prune the nodes that are left empty
+    std::vector<nameTrieNode *> path;
+    path.reserve(name.size() + 1);
+    path.push_back(&trieRoot);
+    std::list<std::string>::const_iterator i;
+    for (i = name.begin(); i != name.end(); i++) {
+        boost::unordered_map<std::string, nameTrieNode *>::iterator child = path.back()->children.find(*i);
+        if (child == path.back()->children.end()) {
+            NS_LOG_WARN("Pending interest " << *el->components << " not found in the name trie");
+            return;
+        }
+        path.push_back(child->second);
+    }
+    if (path.back()->interest != el) {
+        NS_LOG_WARN("Pending interest " << *el->components << " not found in the name trie");
+        return;
+    }
+    path.back()->interest = NULL;
+
+    std::list<std::string>::const_reverse_iterator r = name.rbegin();
+    for (size_t depth = path.size() - 1; depth > 0; depth--, r++) {
+        nameTrieNode *node = path[depth];
+        if (node->interest != NULL || !node->children.empty()) {
+            break;
+        }
+        path[depth - 1]->children.erase(*r);
+        delete node;
+    }
+}
+
+void PacketStorage::releaseElement(const linkLayerPktElement *el)
+{
+    if (el->key.type == INTEREST_PACKET) {
+        trieRemove(el);
+    }
+    wheel.cancel(el->timerEntry);
+    delete[] el->data;
+    delete el->ackInfo;
+}
 
-int PacketStorage::insertPkt(void *pkt, int len, int maxNumberOfRetransmission, std::string name,  Ptr<const NameComponents> components,  uint32_t nonce, std::pair<unsigned int, unsigned int> timerP, GeoStorage gpsInfo, AckInfo *ackInfo)
+int PacketStorage::insertPkt(void *pkt, int len, int maxNumberOfRetransmission, packetKey key, Ptr<const NameComponents> components, uint32_t nonce, uint64_t deadline, GeoStorage gpsInfo, AckInfo *ackInfo,
+                             const unsigned char *destination)
 {
-    linkLayerPktElement el(name, components,nonce, len, 1, maxNumberOfRetransmission, timerP, ackInfo);
+    linkLayerPktElement el(key, components, nonce, len, 1, maxNumberOfRetransmission, ackInfo);
     el.geoInfo = gpsInfo;
+    if (destination != NULL) {
+        el.unicast = true;
+        memcpy(el.destination, destination, ETH_ALEN);
+    }
     el.data = new uint8_t[len];
     memcpy(el.data, pkt, len);
-    //const linkLayerPktElementSet::nth_index<0>::type& key_index=storage.get<0>();
     std::pair<linkLayerPktElementSet::index<nameT>::type::iterator, bool> ret = storage.insert(el);
-    if (ret.second) {
-        return 1;
+    if (!ret.second) {
+        delete[] el.data;
+        delete ackInfo;
+        return -1;
+    }
+    const linkLayerPktElement *stored = &(*ret.first);
+    stored->timerEntry.setOwner(stored);
+    wheel.schedule(stored->timerEntry, deadline);
+    if (key.type == INTEREST_PACKET) {
+        trieInsert(stored);
     }
-    return -1;
+    return 1;
 }
 
-int PacketStorage::getFirstDeadline(const linkLayerPktElement  *&el)
+int PacketStorage::getNextDeadline(uint64_t &deadline) const
 {
-    NS_LOG_DEBUG("PacketStorage::getFirstDeadline");
-    const linkLayerPktElementSet::index<timerT>::type &timer_index = storage.get<timerT>();
-    linkLayerPktElementSet::index<timerT>::type::iterator it = timer_index.begin();
-    if (it == timer_index.end()) {
-        //element not found
+    return wheel.getNextExpiry(deadline) ? 1 : -1;
+}
+
+int PacketStorage::getExpiredPkt(uint64_t now, uint64_t due, const linkLayerPktElement *&el)
+{
+    TimerWheel::Entry *entry = wheel.popDue(now, due);
+    if (entry == NULL) {
         return -1;
     }
-    el = &(*it);
+    el = static_cast<const linkLayerPktElement *>(entry->getOwner());
     return 1;
 }
 
 
-int PacketStorage::getPktByKey(std::string key, const linkLayerPktElement  *&el)
+int PacketStorage::getPktByKey(packetKey key, const linkLayerPktElement  *&el)
 {
     const linkLayerPktElementSet::index<nameT>::type &key_index = storage.get<nameT>();
     linkLayerPktElementSet::iterator it = key_index.find(key);
@@ -126,7 +223,7 @@ int PacketStorage::getPktByKey(std::string key, const linkLayerPktElement  *&el)
     return 1;
 }
 
-int PacketStorage::deletePktByKey(std::string key)
+int PacketStorage::deletePktByKey(packetKey key)
 {
     const linkLayerPktElementSet::index<nameT>::type &key_index = storage.get<nameT>();
     linkLayerPktElementSet::iterator it = key_index.find(key);
@@ -134,53 +231,13 @@ int PacketStorage::deletePktByKey(std::string key)
         //element not found
         return -1;
     }
-    const linkLayerPktElement *el = &(*it);
-    delete[] el->data;
-    delete el->ackInfo;
+    releaseElement(&(*it));
     storage.erase(it);
     return 1;
 }
 
-int PacketStorage::deleteFirstPkt(std::string key)
+int PacketStorage::setNewTimer(packetKey key, uint64_t deadline)
 {
-    const linkLayerPktElementSet::index<timerT>::type &time_index = storage.get<timerT>();
-    linkLayerPktElementSet::index<timerT>::type::iterator match = time_index.begin();
-    if (match == time_index.end()) {
-        NS_LOG_DEBUG("DEBUG PacketStorage, deleteFirstPkt, element not found");
-        //element not found
-        return -1;
-    }
-    const linkLayerPktElement *el = &(*match);
-    if (el->name.compare(key)!=0) {
-		NS_LOG_WARN("First element in the queue doesn't have the specified key");
-		return -1;
-	}
-    delete[] el->data;
-    delete el->ackInfo;
-    storage.get<timerT>().erase(match);
-    return 1;
-}
-
-
-//useful if we use nonce in content object and we use it also as key
-/*int PacketStorage::deletePktByName(std::string name){
-    int numEntries=0;
-    const linkLayerPktElementSet::nth_index<nameT>::type& indexByName=storage.get<nameT>();
-    linkLayerPktElementSet::nth_index<nameT>::type::iterator it;
-    const linkLayerPktElement * el;
-    for(it=indexByName.find(name); it!=indexByName.end(); it++){
-        el= &(*it); //it's stupid, but otherwise it won't compile
-        NS_LOG_DEBUG("deletePktByName, deleted "<< el->name <<", nonce: "<<el->key);
-        delete[] el->data;
-        storage.erase(it);
-        numEntries++;
-    }
-    return numEntries;
-}*/
-
-int PacketStorage::setNewTimer(std::string key, std::pair <unsigned int, unsigned int> newTime)
-{
-    //const linkLayerPktElementSet::nth_index<nameT>::type &key_index = storage.get<0>();
     const linkLayerPktElementSet::index<nameT>::type &key_index = storage.get<nameT>();
     linkLayerPktElementSet::iterator it = key_index.find(key);
     if (it == key_index.end()) {
@@ -188,15 +245,11 @@ int PacketStorage::setNewTimer(std::string key, std::pair <unsigned int, unsigne
         //element not found
         return -1;
     }
-    linkLayerPktElement updatedEl = *it;
-    updatedEl.timer = newTime;
-    if (storage.replace(it, updatedEl)) {
-        return 1;
-    }
-    return -1;
+    wheel.schedule(it->timerEntry, deadline);
+    return 1;
 }
 
-int PacketStorage::increaseRetransmissionCounterAndSetNewTimer(std::string key, std::pair <unsigned int, unsigned int> newTime)
+int PacketStorage::increaseRetransmissionCounterAndSetNewTimer(packetKey key, uint64_t deadline)
 {
     const linkLayerPktElementSet::index<nameT>::type &key_index = storage.get<nameT>();
     linkLayerPktElementSet::iterator it = key_index.find(key);
@@ -205,70 +258,61 @@ int PacketStorage::increaseRetransmissionCounterAndSetNewTimer(std::string key,
         //element not found
         return -1;
     }
-    linkLayerPktElement updatedEl = *it;
-    updatedEl.retransmission = updatedEl.retransmission + 1;
-    updatedEl.timer = newTime;
-    if (storage.replace(it, updatedEl)) {
-        return 1;
-    }
-    return -1;
+    it->retransmission++;
+    wheel.schedule(it->timerEntry, deadline);
+    return 1;
 }
 
 void PacketStorage::debugDumpAllStorage()
 {
-    const linkLayerPktElementSet::index<timerT>::type &timer_index = storage.get<timerT>();
+    const linkLayerPktElementSet::index<nameT>::type &key_index = storage.get<nameT>();
     const linkLayerPktElement *el;
-    linkLayerPktElementSet::index<timerT>::type::iterator it;// = timer_index.begin();
-    for (it = timer_index.begin(); it != timer_index.end(); it++) {
+    linkLayerPktElementSet::index<nameT>::type::iterator it;
+    for (it = key_index.begin(); it != key_index.end(); it++) {
         el = &(*it);
-        NS_LOG_INFO("Dump Storage: " << el->name << ", timer " << el->timer.first << "." << el->timer.second <<
+        NS_LOG_INFO("Dump Storage: " << (el->key.type == INTEREST_PACKET ? "INTEREST " : "CONTENT ") << *el->components <<
+                  ", deadline " << el->getDeadline() << (el->timerEntry.isScheduled() ? "" : " (not scheduled)") <<
                   " size: " << el->size << " retransmission remaining: " << el->retransmission);
     }
 
 
 }
 
-//int PacketStorage::searchByPrefixMatch(Ptr<const NameComponents> components, const linkLayerPktElement  *&el)s
 void PacketStorage::searchByPrefixMatch(Ptr<const NameComponents> components, std::list<const PacketStorage::linkLayerPktElement *> &matchingElements )
 {
     const NameComponents &name = *components;
     NS_LOG_DEBUG("Trying to match name:" << name);
-    for (size_t componentsCount = name.GetComponents().size() + 1; componentsCount > 0; componentsCount--) {
-        NameComponents subPrefix(name.GetSubComponents(componentsCount - 1));
-        NS_LOG_DEBUG("subPrefix:" << subPrefix);        
-        const linkLayerPktElementSet::index<__ndn_private::i_prefix>::type &components_index = storage.get<__ndn_private::i_prefix>();
-        linkLayerPktElementSet::index<__ndn_private::i_prefix>::type::iterator match = components_index.find(subPrefix);
-        if (match != components_index.end()) {
-            NS_LOG_DEBUG("Found entry (longest prefix match) in packet storage.");
-            matchingElements.push_back(&(*match));
-            //el = &(*match);
-            //return 1;
+    // every node on the path of the name is a prefix of it
+    const nameTrieNode *node = &trieRoot;
+    std::list<const linkLayerPktElement *>::iterator shorter = matchingElements.end();
+    std::list<std::string>::const_iterator i = name.GetComponents().begin();
+    while (true) {
+        if (node->interest != NULL) {
+            NS_LOG_DEBUG("Found entry (prefix match) in packet storage: " << *node->interest->components);
+            shorter = matchingElements.insert(shorter, node->interest);
         }
+        if (i == name.GetComponents().end()) {
+            break;
+        }
+        boost::unordered_map<std::string, nameTrieNode *>::const_iterator child = node->children.find(*i);
+        if (child == node->children.end()) {
+            break;
+        }
+        node = child->second;
+        i++;
     }
-    return;
 }
 
 
 int PacketStorage::searchAndDeleteByLongestPrefixMatch(Ptr<const NameComponents> components)
 {
-	const NameComponents &name = *components;
-    NS_LOG_DEBUG("Trying to match name:" << name);
-    for (size_t componentsCount = name.GetComponents().size() + 1; componentsCount > 0; componentsCount--) {
-        NameComponents subPrefix(name.GetSubComponents(componentsCount - 1));
-        NS_LOG_DEBUG("subPrefix:" << subPrefix);        
-        const linkLayerPktElementSet::index<__ndn_private::i_prefix>::type &components_index = storage.get<__ndn_private::i_prefix>();
-        linkLayerPktElementSet::index<__ndn_private::i_prefix>::type::iterator match = components_index.find(subPrefix);
-        if (match != components_index.end()) {
-            NS_LOG_DEBUG("Found entry (longest prefix match) in packet storage.");
-            const linkLayerPktElement *el = NULL;
-            el = &(*match);
-            delete[] el->data;
-            delete el->ackInfo;
-            storage.get<__ndn_private::i_prefix>().erase(match);
-            return 1;
-        }
+    std::list<const linkLayerPktElement *> matchingElements;
+    searchByPrefixMatch(components, matchingElements);
+    if (matchingElements.empty()) {
+        return 0;
     }
-    return 0;
+    NS_LOG_DEBUG("Found entry (longest prefix match) in packet storage.");
+    return deletePktByKey(matchingElements.front()->key) == 1 ? 1 : 0;
 }
 
 } /* namespace vndn */
@@ -44,6 +44,8 @@
 #include <iterator>
 #include <string>
 #include <string.h>
+#include <vector>
+#include <linux/if_ether.h>
 #include <bits/basic_string.h>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/tag.hpp>
@@ -54,12 +56,14 @@
 #include <boost/tuple/tuple.hpp>
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/unordered_map.hpp>
+#include <stdint.h>
 
 #include "geo-storage.h"
 #include "ack-info.h"
+#include "timer-wheel.h"
 #include "network/ndn-name-components.h"
 #include "daemon/ndn.h"
-#include "daemon/hash-helper.h"
 #include "corelib/ptr.h"
 
 #include "utils/geo/gps-info.h"
@@ -78,6 +82,12 @@ namespace vndn
  * -when should be retransmitted next time
  * -partial ack list
  * See linkLayerPktElement for further information about the information stored
+ *
+ * Packets are identified by their type and a 64-bit hash of their name (packetKey),
+ * so that no string has to be built for each packet received or sent out.
+ * Pending interests are also indexed by a trie of their name components:
+ * the interests satisfied by a content are found with a single descent of the trie
+ * along the name of the content.
  * */
 class PacketStorage
 {
@@ -92,7 +102,50 @@ public:
 
     struct nameT {};
     struct nonceT {};
-    struct timerT {};
+
+    /**
+     * \brief Type of the packets stored: an interest and a content with the same name are different entries
+     * */
+    enum PacketType {
+        INTEREST_PACKET,
+        CONTENT_PACKET
+    };
+
+    /**
+     * \brief Key of the storage: packet type + hash of the NDN name
+     *
+     * Two different names with the same 64-bit hash would be considered the same packet.
+     * With the few hundreds of packets pending in a node, the probability is negligible
+     * */
+    struct packetKey {
+        PacketType type;
+        uint64_t nameHash;
+
+        bool operator==(const packetKey &k) const {
+            return nameHash == k.nameHash && type == k.type;
+        }
+        bool operator!=(const packetKey &k) const {
+            return !(*this == k);
+        }
+    };
+
+    struct packetKeyHash : public std::unary_function<packetKey, std::size_t> {
+        std::size_t operator()(const packetKey &k) const {
+            return (std::size_t) (k.nameHash ^ (k.nameHash >> 32)) ^ k.type;
+        }
+    };
+
+    /**
+     * \brief Builds the key of a packet (FNV-1a hash of the name components)
+     * */
+    static packetKey makeKey(PacketType type, const NameComponents &name);
+
+    /**
+     * \brief Builds the keys of all the prefixes of a name, from the empty one to the whole name
+     *
+     * keys[i] is the key (as makeKey) of the first i components of the name
+     * */
+    static void makePrefixKeys(PacketType type, const NameComponents &name, std::vector<packetKey> &keys);
 
 
     /**
@@ -100,8 +153,8 @@ public:
      *
      * */
     struct linkLayerPktElement {
-        /**NDN name + type (Example CONTENT/local/ ... ) */
-        std::string name;
+        /**Packet type + hash of the NDN name*/
+        packetKey key;
         
         /**Components of the name*/
         Ptr<const NameComponents> components;
@@ -114,12 +167,14 @@ public:
         uint8_t *data;
         /**Size of the data stored*/
         unsigned int size;
-        /**Number of time the pkt has been retransmitted*/
-        unsigned int retransmission;
+        /**Number of time the pkt has been retransmitted (not part of any index)*/
+        mutable unsigned int retransmission;
         /**Maximum number of retransmission*/
         unsigned int retransmissionLimit;
-        /**Next retransmission (seconds, microseconds)*/
-        std::pair<unsigned int, unsigned int> timer;
+        /**Next (re)transmission, in the TimerWheel of the storage (not part of any index)*/
+        mutable TimerWheel::Entry timerEntry;
+        /**Time of the last transmission (microseconds, see TimerWheel::now), 0 if never sent (not part of any index)*/
+        mutable uint64_t lastTransmission;
 
 
         /**
@@ -140,19 +195,20 @@ public:
         //unsigned char * srcMacAddress;//pointer of array? unsigned char srcMacAddress[ETH_ALEN];
         //can I just use a bool: local source? y/n ?? the check would be faster, but without a good ack policy, we can't distinguish a retransmission of the source from an implicit ack of our transmission
 
-        linkLayerPktElement(std::string nameP, Ptr<const NameComponents> componentsP, uint32_t nonceP, unsigned int sizeP, unsigned int retransmissionP, unsigned int retransmissionLimitP, std::pair<unsigned int, unsigned int> timerP, AckInfo *ackInfo/*, Ptr<InterestHeader> header*/):
-            name(nameP), components(componentsP), nonce(nonceP), size(sizeP), retransmission(retransmissionP), retransmissionLimit(retransmissionLimitP), timer(timerP), ackInfo(ackInfo)/*, header(header)*/ {}
-        //linkLayerPktElement(std::string keyP,std::string nameP, unsigned int sizeP, unsigned int retransmissionP,unsigned int retransmissionLimitP, std::pair<unsigned int, unsigned int> timerP):
-        //        key(keyP),name(nameP),size(sizeP),retransmission(retransmissionP),retransmissionLimit(retransmissionLimitP), timer(timerP){}
+        /**
+         * If true, the packet is sent only to the neighbor whose MAC address is destination, otherwise it is broadcast
+         * */
+        bool unicast;
+        unsigned char destination[ETH_ALEN];
+
+        linkLayerPktElement(packetKey keyP, Ptr<const NameComponents> componentsP, uint32_t nonceP, unsigned int sizeP, unsigned int retransmissionP, unsigned int retransmissionLimitP, AckInfo *ackInfo/*, Ptr<InterestHeader> header*/):
+            key(keyP), components(componentsP), nonce(nonceP), size(sizeP), retransmission(retransmissionP), retransmissionLimit(retransmissionLimitP), lastTransmission(0), ackInfo(ackInfo), unicast(false)/*, header(header)*/ {}
 
         /**
-         * \brief Defines an order for the timer field of a linkLayerPktElement
-         *
-         * Boost:multi_index will keep the table ordered by the timer index using this function
+         * \brief Time of the next (re)transmission (microseconds, see TimerWheel::now)
          * */
-        bool operator<(const linkLayerPktElement &e)const {
-            return (timer.first < e.timer.first) ||
-                   ((timer.first == e.timer.first) && (timer.second < e.timer.second));
+        uint64_t getDeadline() const {
+            return timerEntry.getExpiry();
         }
         
         const NameComponents &GetPrefix() const {
@@ -160,7 +216,6 @@ public:
 		}
 
     };
-    //int insertPkt(void * pkt, int len, int maxNumberOfRetransmission,std::string name,std::pair<unsigned int, unsigned int> timerP, std::list<GeoStorage> * geoIncoming);
 
     /**
      * \brief inserts a packet in the hash table
@@ -168,82 +223,79 @@ public:
      * \param pkt pointer to the packet
      * \param len size of the packet
      * \param maxNumberOfRetransmission max number of retransmission
-     * \param name NDN name of the packet (used as key of the table). To avoid conflicts between interest and content with the same name, the type of the packet has to be attached to the name
+     * \param key type + hash of the NDN name of the packet (see makeKey)
      * \param components ptr to the name components of the packet
      * \param nonde NDN nonce (-1 for content)
-     * \param timerP indicates when the next retransmission should happen
+     * \param deadline when the packet has to be transmitted (microseconds, see TimerWheel::now)
      * \param gpsInfo information about the location of the node (packet generated locally) of of the previous hop(pkt forwarding)
-     * \param ackInfo it contains all useful information for the acknowledgment process
+     * \param ackInfo it contains all useful information for the acknowledgment process, the storage takes its ownership (it is deleted on error too)
+     * \param destination MAC address of the neighbor the packet is sent to, NULL if it is broadcast
      * \return 1 if the packet has been inserted, -1 in case of error
      *
      * */
-    int insertPkt(void *pkt, int len, int maxNumberOfRetransmission, std::string name,Ptr<const NameComponents> components, uint32_t nonce, std::pair<unsigned int, unsigned int> timerP, GeoStorage gpsInfo, AckInfo *ackInfo);
+    int insertPkt(void *pkt, int len, int maxNumberOfRetransmission, packetKey key, Ptr<const NameComponents> components, uint32_t nonce, uint64_t deadline, GeoStorage gpsInfo, AckInfo *ackInfo,
+                  const unsigned char *destination = NULL);
 
 
     /**
-     * \brief Get the element of the storage with the closest retransmission deadline
-     * \param el the function will store the element stored
+     * \brief Get the closest (re)transmission deadline
+     * \param deadline the function will store the deadline (microseconds, see TimerWheel::now)
+     * \return 1 if there is at least a packet scheduled, -1 otherwise
+     * */
+    int getNextDeadline(uint64_t &deadline) const;
+
+    /**
+     * \brief Get a packet whose deadline has expired
+     *
+     * The packet is no longer scheduled: it has to be rescheduled (setNewTimer, increaseRetransmissionCounterAndSetNewTimer) or deleted.
+     * Calling it until it fails gets all the packets due at now, then the ones due by due (see TimerWheel::popDue).
+     * \param now current time (microseconds, see TimerWheel::now)
+     * \param due latest deadline accepted (not earlier than now)
+     * \param el the function will store the expired element
      * \return 1 if an element has been found, -1 otherwise
      * */
-    int getFirstDeadline(const linkLayerPktElement  *&el);
+    int getExpiredPkt(uint64_t now, uint64_t due, const linkLayerPktElement *&el);
 
     /**
      * \brief Increase the number of retransmission of a packet and update the retransmission deadline
-     * \param key name of the packet that has to be updated
-     * \param newTime new retransmission deadline
+     * \param key key of the packet that has to be updated
+     * \param deadline new retransmission deadline (microseconds, see TimerWheel::now)
      * \return 1 if everything is ok, -1 in case of error
      * */
-    int increaseRetransmissionCounterAndSetNewTimer(std::string key, std::pair <unsigned int, unsigned int> newTime);
+    int increaseRetransmissionCounterAndSetNewTimer(packetKey key, uint64_t deadline);
 
     /**
-     * \brief Search a packet by key (NDN name + type)
-     * \param key NDN name + type (Example: INTEREST/local/traffic)
+     * \brief Search a packet by key (type + NDN name hash)
+     * \param key key of the packet
      * \param el the function will store the element with the required key
      * \return 1 if the element is found, -1 otherwise
      * */
-    int getPktByKey(std::string key, const linkLayerPktElement  *&el);
-
-    /**
-     * \brief It deletes all entry with a specified name
-     * Useful when a content is received and delete all the relative interest is necessary
-     * This function is disabled. It will be used again when we will use nonce as key
-     * \param name name of entries that have to be deleted
-     * \return number of deleted entries
-     * */
-    int deletePktByName(std::string name);
+    int getPktByKey(packetKey key, const linkLayerPktElement  *&el);
 
     /**
-     * \brief It deletes a linkLayerPktElement by key (name)
-     * \param key NDN name(+type) of packet that has to be deleted
+     * \brief It deletes a linkLayerPktElement by key, cancelling its timer
+     * \param key key of the packet that has to be deleted
      * \return 1 if everything is ok, -1 if there is no packet with this key
      * */
-    int deletePktByKey(std::string key);
-
-    /**
-     * \brief deletes the packet with the closest retransmission deadline
-     * \param key name (+type) of the packet that has to be deleted
-     * \return 1 if everything is ok, -1 if there is no packet
-     * */
-    int deleteFirstPkt(std::string key);//the key is just a double check. The element that is gonna be deletes is the pkt in the timer order
+    int deletePktByKey(packetKey key);
 
     /**
      * \brief Update the retransmission deadline of a packet
-     * \param key name+type of packet
-     * \param newTime new retransmission deadline
+     * \param key key of the packet
+     * \param deadline new retransmission deadline (microseconds, see TimerWheel::now)
      * */
-    int setNewTimer(std::string key, std::pair <unsigned int, unsigned int> newTime);
+    int setNewTimer(packetKey key, uint64_t deadline);
     
     
     /**
-     * \brief Search for elements in the storage using the longest prefix match
-     * \param components NameComponents which we're looking for
-     * \param el address where the linkLayerPktElement that match with components (if founded) will be stored
-     * \return 1 if an element is found, 0 otherwise
+     * \brief Search for the pending interests whose name is a prefix of components
+     * \param components NameComponents which we're looking for (usually the name of a content)
+     * \param matchingElements the matching interests are appended here, the longest prefix first
      * */
     void searchByPrefixMatch(Ptr<const NameComponents> components, std::list<const PacketStorage::linkLayerPktElement *> &matchingElements);
 
     /**
-     * \brief Search for elements in the storage using the longest prefix match and delete it
+     * \brief Search for the pending interest with the longest prefix of components and delete it
      * \param components NameComponents which we're looking for
      * \return 1 if an element is found (and deleted), 0 otherwise
      * */    
@@ -253,63 +305,72 @@ public:
 
     void debugDumpAllStorage();
 
+    /**
+     * \brief Number of pending packets
+     * */
+    size_t size() const { return storage.size(); }
+
 
 protected:
     /**
      * \brief Define the structure of the table stored (linkLayerPktElementSet)
      * It's a multi index hash table of linkLayerPktElement
-     * The name(+type) of the packet is used as key
-     * The second index of the table is the retransmission deadline. It's sorted in chronological order
+     * The key (type + name hash) of the packet is the only index: the retransmission deadlines are in the TimerWheel
      * */
     typedef boost::multi_index::multi_index_container <
     linkLayerPktElement,        // The type of the elements stored
     boost::multi_index::indexed_by <   // The indices that our container will support
     boost::multi_index::hashed_unique <
     boost::multi_index::tag<nameT>,
-    boost::multi_index::member<linkLayerPktElement, std::string , &linkLayerPktElement::name>
-    > ,
-    boost::multi_index::ordered_non_unique <
-    boost::multi_index::tag<timerT>,
-    boost::multi_index::member<linkLayerPktElement, std::pair<unsigned int, unsigned int>, &linkLayerPktElement::timer>
-    > ,// map-like index (sorted by name)
-    boost::multi_index::hashed_unique <
-    boost::multi_index::tag<__ndn_private::i_prefix>,
-    boost::multi_index::const_mem_fun <
-    linkLayerPktElement,
-    const NameComponents &,
-    &linkLayerPktElement::GetPrefix
-    > ,
-    NDNPrefixHash
+    boost::multi_index::member<linkLayerPktElement, packetKey, &linkLayerPktElement::key>,
+    packetKeyHash
     >
     >
     > linkLayerPktElementSet;
 
-    /* Restore this if we introduce nonce also inside the content pkt. If this happend, we will use nonce as key
-     *    typedef boost::multi_index::multi_index_container<
-                  linkLayerPktElement,        // The type of the elements stored
-                  boost::multi_index::indexed_by<    // The indices that our container will support
-                          boost::multi_index::hashed_unique<
-                              boost::multi_index::tag<nonceT>,
-                              boost::multi_index::member<linkLayerPktElement, uint32_t ,&linkLayerPktElement::nonce>
-                          >,
-                  boost::multi_index::ordered_non_unique<
-                      boost::multi_index::tag<timerT>,
-                      boost::multi_index::member<linkLayerPktElement,std::pair<unsigned int, unsigned int>,
-                                       &linkLayerPktElement::timer>
-                      >, // map-like index (sorted by name)
-                  boost::multi_index::hashed_non_unique<
-                      boost::multi_index::tag<nameT>,
-                      boost::multi_index::member<linkLayerPktElement, std::string ,&linkLayerPktElement::name>
-                  >
-               >
-             > linkLayerPktElementSet;
-    */
+    /**
+     * \brief Node of the name trie of the pending interests
+     *
+     * The path from the root to the node is the name of the interest stored in the node (if any).
+     * The elements of a multi_index_container don't move, so they are referenced by pointer
+     * */
+    struct nameTrieNode {
+        const linkLayerPktElement *interest;
+        boost::unordered_map<std::string, nameTrieNode *> children;
+
+        nameTrieNode(): interest(NULL) {}
+        ~nameTrieNode();
+    };
+
+    /**
+     * \brief Adds/removes a pending interest to/from the trie, pruning the nodes left empty
+     * */
+    void trieInsert(const linkLayerPktElement *el);
+    void trieRemove(const linkLayerPktElement *el);
+
+    /**
+     * \brief Removes an element from the trie (if it's an interest) and frees it
+     * */
+    void releaseElement(const linkLayerPktElement *el);
 
     /**
      * \brief Table that stored the pending packet
      * */
     linkLayerPktElementSet storage;
 
+    /**
+     * \brief Root of the name trie (empty name)
+     * */
+    nameTrieNode trieRoot;
+
+    /**
+     * \brief (Re)transmission deadlines of the packets stored
+     * */
+    TimerWheel wheel;
+
+private:
+    PacketStorage(const PacketStorage &);
+    PacketStorage &operator=(const PacketStorage &);
 };
 
 } /* namespace vndn */
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "prefix-compression.h"
+#include "ndnsock/ndn-socket.h"
+#include "corelib/log.h"
+#include "helper/ccnb-parser/ccnb-parser-common.h"
+
+#include <string.h>
+
+NS_LOG_COMPONENT_DEFINE("PrefixCompression");
+
+namespace vndn
+{
+
+namespace
+{
+
+/**
+ * \brief Reads the header of the ccnb block at pos, which is not a CCN_CLOSE
+ */
+bool readBlockHeader(const uint8_t *pkt, size_t len, size_t &pos, int &tt, size_t &val)
+{
+    val = 0;
+    while (pos < len) {
+        const uint8_t b = pkt[pos++];
+        if (b & 0x80) {
+            val = (val << 4) | ((b >> 3) & 0x0f);
+            tt = b & 0x07;
+            return true;
+        }
+        val = (val << 7) | b;
+        if (val > len) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief Moves pos past the ccnb element that starts there
+ */
+bool skipElement(const uint8_t *pkt, size_t len, size_t &pos)
+{
+    int tt;
+    size_t val;
+    if (!readBlockHeader(pkt, len, pos, tt, val)) {
+        return false;
+    }
+    switch (tt) {
+    case CcnbParser::CCN_BLOB:
+    case CcnbParser::CCN_UDATA:
+        pos += val;
+        return pos <= len;
+    case CcnbParser::CCN_DATTR:
+        //the value of the attribute follows
+        return skipElement(pkt, len, pos);
+    case CcnbParser::CCN_DTAG:
+        while (pos < len) {
+            if (pkt[pos] == CcnbParser::CCN_CLOSE) {
+                pos++;
+                return true;
+            }
+            if (!skipElement(pkt, len, pos)) {
+                return false;
+            }
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+}
+
+
+PrefixCompression::PrefixCompression()
+    : nextPurge(0)
+{
+    for (int i = 0; i < 256; i++) {
+        entries[i].defined = false;
+        entries[i].lastUsed = 0;
+    }
+}
+
+bool PrefixCompression::findNamePrefix(const uint8_t *pkt, size_t len, size_t &offset, size_t &length)
+{
+    size_t pos = 0;
+    int tt;
+    size_t val;
+    //<Interest> or <ContentObject>
+    if (!readBlockHeader(pkt, len, pos, tt, val) || tt != CcnbParser::CCN_DTAG) {
+        return false;
+    }
+    //<Name> is the first child of <Interest>, it follows <Signature> in <ContentObject>
+    while (true) {
+        if (pos >= len || pkt[pos] == CcnbParser::CCN_CLOSE) {
+            return false;
+        }
+        const size_t start = pos;
+        if (!readBlockHeader(pkt, len, pos, tt, val)) {
+            return false;
+        }
+        if (tt == CcnbParser::CCN_DTAG && val == CcnbParser::CCN_DTAG_Name) {
+            break;
+        }
+        pos = start;
+        if (!skipElement(pkt, len, pos)) {
+            return false;
+        }
+    }
+    //the prefix goes from the first <Component> to the last one, excluded
+    const size_t first = pos;
+    size_t last = pos;
+    unsigned int components = 0;
+    while (pos < len && pkt[pos] != CcnbParser::CCN_CLOSE) {
+        last = pos;
+        if (!skipElement(pkt, len, pos)) {
+            return false;
+        }
+        components++;
+    }
+    if (pos >= len || components < 2) {
+        return false;
+    }
+    offset = first;
+    length = last - first;
+    return length >= minPrefixSize && length <= maxPrefixSize;
+}
+
+size_t PrefixCompression::compress(const uint8_t *pkt, size_t len, bool broadcast, bool resync, uint64_t now, uint8_t *buffer)
+{
+    size_t offset, length;
+    if (!findNamePrefix(pkt, len, offset, length)) {
+        const size_t recordSize = writeLLPrefixRecord(buffer, LL_PREFIX_NONE, 0, 0, 0);
+        memcpy(&buffer[recordSize], pkt, len);
+        return recordSize + len;
+    }
+
+    const std::string prefix((const char *) &pkt[offset], length);
+    uint8_t id;
+    boost::unordered_map<std::string, uint8_t>::iterator it = ids.find(prefix);
+    if (it != ids.end()) {
+        id = it->second;
+    } else {
+        //the least recently used entry is given to the new prefix
+        id = 0;
+        for (int i = 1; i < 256; i++) {
+            if (entries[i].lastUsed < entries[id].lastUsed) {
+                id = i;
+            }
+        }
+        ids.erase(entries[id].prefix);
+        ids[prefix] = id;
+        entries[id].prefix = prefix;
+        entries[id].check = check(&pkt[offset], length);
+        entries[id].defined = false;
+    }
+    Entry &entry = entries[id];
+    entry.lastUsed = now;
+
+    if (resync || !entry.defined || now - entry.lastDefined >= refreshInterval) {
+        if (broadcast) {
+            entry.defined = true;
+            entry.lastDefined = now;
+        }
+        const size_t recordSize = writeLLPrefixRecord(buffer, LL_PREFIX_DEFINE, id, offset, length);
+        memcpy(&buffer[recordSize], pkt, len);
+        return recordSize + len;
+    }
+    const size_t recordSize = writeLLPrefixRecord(buffer, LL_PREFIX_REFERENCE, id, offset, entry.check);
+    memcpy(&buffer[recordSize], pkt, offset);
+    memcpy(&buffer[recordSize + offset], &pkt[offset + length], len - offset - length);
+    return recordSize + len - length;
+}
+
+int PrefixCompression::expand(const unsigned char mac[ETH_ALEN], const uint8_t *data, size_t len, uint64_t now, uint8_t *buffer)
+{
+    uint8_t mode, id;
+    size_t offset;
+    uint16_t value;
+    const int recordSize = readLLPrefixRecord(data, len, mode, id, offset, value);
+    if (recordSize == -1) {
+        return -1;
+    }
+    const uint8_t *pkt = &data[recordSize];
+    const size_t pktLen = len - recordSize;
+    if (mode == LL_PREFIX_NONE) {
+        memcpy(buffer, pkt, pktLen);
+        return pktLen;
+    }
+
+    purge(now);
+    Dictionary &dictionary = dictionaries[macKey(mac)];
+    dictionary.lastSeen = now;
+    if (mode == LL_PREFIX_DEFINE) {
+        if (offset + value > pktLen || value > maxPrefixSize) {
+            return -1;
+        }
+        dictionary.prefixes[id].assign((const char *) &pkt[offset], value);
+        memcpy(buffer, pkt, pktLen);
+        return pktLen;
+    }
+
+    const std::string &prefix = dictionary.prefixes[id];
+    if (offset > pktLen || prefix.empty() || check((const uint8_t *) prefix.data(), prefix.size()) != value) {
+        NS_LOG_DEBUG("Unknown prefix " << (int) id << " from " << PRINTABLE_MAC_ADDRESS(mac));
+        return -1;
+    }
+    memcpy(buffer, pkt, offset);
+    memcpy(&buffer[offset], prefix.data(), prefix.size());
+    memcpy(&buffer[offset + prefix.size()], &pkt[offset], pktLen - offset);
+    return pktLen + prefix.size();
+}
+
+uint16_t PrefixCompression::check(const uint8_t *prefix, size_t length)
+{
+    //FNV-1a, folded
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ prefix[i]) * 16777619u;
+    }
+    return (hash >> 16) ^ (hash & 0xffff);
+}
+
+void PrefixCompression::purge(uint64_t now)
+{
+    if (now < nextPurge) {
+        return;
+    }
+    nextPurge = now + purgeInterval;
+    boost::unordered_map<uint64_t, Dictionary>::iterator it = dictionaries.begin();
+    while (it != dictionaries.end()) {
+        if (now - it->second.lastSeen > dictionaryLifetime) {
+            it = dictionaries.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+} /* namespace vndn */
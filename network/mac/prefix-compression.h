@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef PREFIX_COMPRESSION_H_
+#define PREFIX_COMPRESSION_H_
+
+#include "ll-header.h"
+
+#include <boost/unordered_map.hpp>
+#include <linux/if_ether.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace vndn
+{
+
+/**
+ * \brief Compression of the name prefixes of the NDN packets sent on the link (see llPrefixRecord)
+ *
+ * The prefix of a name is all its components but the last one: the packets of a photo or of the
+ * traffic information of a road share it. Every node numbers the prefixes it sends with a
+ * broadcast dictionary of 256 entries, replaced in LRU order, and defines an entry again every
+ * refreshInterval and whenever a packet is retransmitted, so that a neighbor that missed a
+ * definition or just arrived resynchronizes quickly. Each receiver keeps the dictionary of every
+ * neighbor; a packet referring to a prefix it does not know is dropped, as if it had not been
+ * received, and the retransmission of the packet carries the definition.
+ * Times are microseconds of CLOCK_MONOTONIC (see TimerWheel::now).
+ * */
+class PrefixCompression
+{
+public:
+    /** Shorter prefixes are sent as they are, the record would be as long as the bytes saved */
+    static const size_t minPrefixSize = 8;
+    /** Longer prefixes are sent as they are */
+    static const size_t maxPrefixSize = 512;
+    /** A prefix used again after this time is defined again (microseconds) */
+    static const uint64_t refreshInterval = 1000000;
+    /** The dictionary of a neighbor is forgotten after this time without any packet from it (microseconds) */
+    static const uint64_t dictionaryLifetime = 10000000;
+    /** Interval between two purges of the dictionaries forgotten (microseconds) */
+    static const uint64_t purgeInterval = 1000000;
+
+    PrefixCompression();
+
+    /**
+     * \brief Writes the prefix record of an NDN packet followed by the packet, without its prefix if the neighbors know it
+     *
+     * \param broadcast the packet is sent to all the neighbors: a definition sent to a single one
+     *        does not make the prefix known to the others
+     * \param resync define the prefix even if it has been defined recently
+     * \param buffer must have room for len + sizeof(llPrefixRecord) bytes
+     * \return size written in buffer
+     * */
+    size_t compress(const uint8_t *pkt, size_t len, bool broadcast, bool resync, uint64_t now, uint8_t *buffer);
+
+    /**
+     * \brief Restores an NDN packet received from mac, that starts with its prefix record
+     *
+     * \param buffer must have room for len + maxPrefixSize bytes
+     * \return size of the packet written in buffer, or -1 if the record is invalid or refers to a prefix unknown
+     * */
+    int expand(const unsigned char mac[ETH_ALEN], const uint8_t *data, size_t len, uint64_t now, uint8_t *buffer);
+
+    /**
+     * \brief Finds the bytes of a ccnb-encoded interest or content object that encode the prefix of its name
+     *
+     * \return false if the packet cannot be parsed, or its prefix is not within minPrefixSize and maxPrefixSize
+     * */
+    static bool findNamePrefix(const uint8_t *pkt, size_t len, size_t &offset, size_t &length);
+
+private:
+    struct Entry {
+        std::string prefix;
+        uint16_t check;
+        bool defined;
+        uint64_t lastDefined;
+        uint64_t lastUsed;
+    };
+
+    struct Dictionary {
+        std::string prefixes[256];
+        uint64_t lastSeen;
+    };
+
+    static uint16_t check(const uint8_t *prefix, size_t length);
+
+    /**
+     * \brief Forgets the dictionaries of the neighbors gone, at most every purgeInterval
+     * */
+    void purge(uint64_t now);
+
+    /** Prefixes sent by this node, indexed by id */
+    Entry entries[256];
+    boost::unordered_map<std::string, uint8_t> ids;
+    /** Prefixes received, by neighbor */
+    boost::unordered_map<uint64_t, Dictionary> dictionaries;
+    uint64_t nextPurge;
+};
+
+} /* namespace vndn */
+
+#endif /* PREFIX_COMPRESSION_H_ */
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "timer-wheel.h"
+
+#include <string.h>
+#include <time.h>
+
+namespace vndn
+{
+
+TimerWheel::Entry::Entry(const void *owner)
+    : expiry(0), slot(NOT_SCHEDULED), owner(owner)
+{
+    prev = next = NULL;
+}
+
+TimerWheel::Entry::Entry(const Entry &)
+    : expiry(0), slot(NOT_SCHEDULED), owner(NULL)
+{
+    prev = next = NULL;
+}
+
+TimerWheel::Entry &TimerWheel::Entry::operator=(const Entry &)
+{
+    return *this;
+}
+
+TimerWheel::TimerWheel(uint64_t now)
+    : currentTick(now / TICK_USEC), count(0)
+{
+    for (uint32_t i = 0; i < SLOT_COUNT; i++) {
+        slots[i].prev = slots[i].next = &slots[i];
+    }
+    expired.prev = expired.next = &expired;
+    memset(occupied, 0, sizeof(occupied));
+}
+
+uint64_t TimerWheel::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void TimerWheel::link(Link &head, Entry &entry)
+{
+    entry.prev = head.prev;
+    entry.next = &head;
+    head.prev->next = &entry;
+    head.prev = &entry;
+}
+
+void TimerWheel::unlink(Entry &entry)
+{
+    entry.prev->next = entry.next;
+    entry.next->prev = entry.prev;
+    if (entry.slot < SLOT_COUNT && slots[entry.slot].next == &slots[entry.slot]) {
+        occupied[entry.slot / 64] &= ~((uint64_t) 1 << (entry.slot % 64));
+    }
+    entry.prev = entry.next = NULL;
+    entry.slot = Entry::NOT_SCHEDULED;
+}
+
+void TimerWheel::schedule(Entry &entry, uint64_t expiry)
+{
+    if (entry.isScheduled()) {
+        unlink(entry);
+    } else {
+        count++;
+    }
+    // an expiry in the past goes in the current slot, which is the first one looked at by advance
+    uint64_t tick = expiry / TICK_USEC;
+    if (tick < currentTick) {
+        tick = currentTick;
+    }
+    entry.expiry = expiry;
+    entry.slot = tick & SLOT_MASK;
+    link(slots[entry.slot], entry);
+    occupied[entry.slot / 64] |= (uint64_t) 1 << (entry.slot % 64);
+}
+
+void TimerWheel::cancel(Entry &entry)
+{
+    if (entry.isScheduled()) {
+        unlink(entry);
+        count--;
+    }
+}
+
+long TimerWheel::findOccupied(uint64_t fromTick, uint64_t count) const
+{
+    uint64_t offset = 0;
+    while (offset < count) {
+        const uint32_t slot = (fromTick + offset) & SLOT_MASK;
+        const uint64_t word = occupied[slot / 64] >> (slot % 64);
+        if (word != 0) {
+            const uint64_t found = offset + __builtin_ctzll(word);
+            return found < count ? (long) found : -1;
+        }
+        offset += 64 - slot % 64;
+    }
+    return -1;
+}
+
+void TimerWheel::expireSlot(uint32_t slot, uint64_t now)
+{
+    Link &head = slots[slot];
+    Link *node = head.next;
+    while (node != &head) {
+        Link *next = node->next;
+        Entry *entry = static_cast<Entry *>(node);
+        // the entries of the next turns stay where they are
+        if (entry->expiry <= now) {
+            unlink(*entry);
+            entry->slot = Entry::EXPIRED;
+            link(expired, *entry);
+        }
+        node = next;
+    }
+}
+
+void TimerWheel::advance(uint64_t now)
+{
+    const uint64_t nowTick = now / TICK_USEC;
+    if (nowTick < currentTick) {
+        // the slots before the current tick have no entry expired at now: the ones scheduled in the past
+        // since the wheel got ahead of now went in the current slot
+        expireSlot(currentTick & SLOT_MASK, now);
+        return;
+    }
+    // after a whole turn every slot has been visited
+    const uint64_t span = nowTick - currentTick + 1 < SLOT_COUNT ? nowTick - currentTick + 1 : SLOT_COUNT;
+    uint64_t offset = 0;
+    while (offset < span) {
+        const long found = findOccupied(currentTick + offset, span - offset);
+        if (found < 0) {
+            break;
+        }
+        offset += found;
+        expireSlot((currentTick + offset) & SLOT_MASK, now);
+        offset++;
+    }
+    // the slot of nowTick can still hold entries that expire later in the same tick
+    currentTick = nowTick;
+}
+
+TimerWheel::Entry *TimerWheel::popExpired(uint64_t now)
+{
+    if (expired.next == &expired) {
+        advance(now);
+        if (expired.next == &expired) {
+            return NULL;
+        }
+    }
+    Entry *entry = static_cast<Entry *>(expired.next);
+    unlink(*entry);
+    count--;
+    return entry;
+}
+
+TimerWheel::Entry *TimerWheel::popDue(uint64_t now, uint64_t due)
+{
+    Entry *entry = popExpired(now);
+    if (entry == NULL) {
+        entry = findNext();
+        if (entry == NULL || entry->expiry > due) {
+            return NULL;
+        }
+        cancel(*entry);
+    }
+    return entry;
+}
+
+bool TimerWheel::getNextExpiry(uint64_t &expiry) const
+{
+    if (expired.next != &expired) {
+        expiry = static_cast<const Entry *>(expired.next)->expiry;
+        return true;
+    }
+    const Entry *next = findNext();
+    if (next == NULL) {
+        return false;
+    }
+    expiry = next->expiry;
+    return true;
+}
+
+TimerWheel::Entry *TimerWheel::findNext() const
+{
+    // the first slot with an entry of the current turn has the earliest expiry:
+    // the entries of the next turns met before are later than it
+    Entry *found = NULL;
+    uint64_t offset = 0;
+    while (offset < SLOT_COUNT) {
+        const long next = findOccupied(currentTick + offset, SLOT_COUNT - offset);
+        if (next < 0) {
+            break;
+        }
+        offset += next;
+        const Link &head = slots[(currentTick + offset) & SLOT_MASK];
+        bool currentTurn = false;
+        for (Link *node = head.next; node != &head; node = node->next) {
+            Entry *entry = static_cast<Entry *>(node);
+            if (found == NULL || entry->expiry < found->expiry) {
+                found = entry;
+            }
+            if (entry->expiry / TICK_USEC <= currentTick + offset) {
+                currentTurn = true;
+            }
+        }
+        if (currentTurn) {
+            return found;
+        }
+        offset++;
+    }
+    return found;
+}
+
+} /* namespace vndn */
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace vndn
+{
+
+/**
+ * \brief Hashed timing wheel for the link-layer (re)transmissions
+ *
+ * Times are microseconds of CLOCK_MONOTONIC (see now()). The wheel is made of SLOT_COUNT
+ * slots of TICK_USEC each: an entry is linked in the slot of its expiry tick, so scheduling,
+ * rescheduling and cancelling are O(1). Each entry keeps its exact expiry, the slots are only
+ * an index: entries are never expired early, and an expiry more than one turn of the wheel
+ * in the future simply waits for the right turn.
+ * A bitmap of the non-empty slots lets the wheel skip the empty ones.
+ *
+ * Entries are intrusive: they are embedded in the scheduled objects, and the wheel does not own them.
+ * */
+class TimerWheel
+{
+public:
+    /** Resolution of the slots (microseconds) */
+    static const uint64_t TICK_USEC = 100;
+    /** Number of slots (power of 2): one turn of the wheel lasts SLOT_COUNT * TICK_USEC */
+    static const uint32_t SLOT_COUNT = 4096;
+
+private:
+    /**
+     * \brief Links of the circular lists of the slots, whose heads are bare links
+     * */
+    struct Link {
+        Link *prev;
+        Link *next;
+    };
+
+public:
+
+    /**
+     * \brief A timer, to be embedded in the object that is scheduled
+     *
+     * The copy of an entry is not scheduled and has no owner, since it belongs to another object.
+     * Assigning an entry leaves it as it is. An entry has to be cancelled before being destroyed.
+     * */
+    class Entry : public Link
+    {
+    public:
+        explicit Entry(const void *owner = NULL);
+        Entry(const Entry &other);
+        Entry &operator=(const Entry &other);
+
+        bool isScheduled() const { return slot != NOT_SCHEDULED; }
+        uint64_t getExpiry() const { return expiry; }
+
+        /** The object that contains the entry */
+        const void *getOwner() const { return owner; }
+        void setOwner(const void *o) { owner = o; }
+
+    private:
+        friend class TimerWheel;
+
+        static const uint32_t NOT_SCHEDULED = 0xffffffff;
+        static const uint32_t EXPIRED = 0xfffffffe;
+
+        uint64_t expiry;
+        /**Slot of the wheel, EXPIRED or NOT_SCHEDULED*/
+        uint32_t slot;
+        const void *owner;
+    };
+
+    /**
+     * \brief Creates an empty wheel, whose first tick is the one of now
+     * */
+    explicit TimerWheel(uint64_t now);
+
+    /**
+     * \brief Schedules (or reschedules) an entry
+     * \param expiry absolute time (microseconds, see now()). It can be in the past: the entry will expire at the next popExpired
+     * */
+    void schedule(Entry &entry, uint64_t expiry);
+
+    /**
+     * \brief Cancels an entry, if it is scheduled
+     * */
+    void cancel(Entry &entry);
+
+    /**
+     * \brief Pops an entry whose expiry is not later than now
+     *
+     * All the entries expired at now are collected at once, then returned one by one,
+     * in the order of their slots. The entry returned is no longer scheduled.
+     * \return the expired entry, NULL if no entry is expired
+     * */
+    Entry *popExpired(uint64_t now);
+
+    /**
+     * \brief Pops an entry expired at now or, if there is none, the earliest entry whose expiry is not later than due
+     *
+     * Unlike popExpired(due), it does not move the wheel beyond now, so the entries scheduled afterwards expire on time.
+     * \return the entry, NULL if no entry is due
+     * */
+    Entry *popDue(uint64_t now, uint64_t due);
+
+    /**
+     * \brief Gets the earliest expiry of the scheduled entries
+     * \return false if there is no scheduled entry
+     * */
+    bool getNextExpiry(uint64_t &expiry) const;
+
+    /**
+     * \brief Number of scheduled entries (including the ones expired and not popped yet)
+     * */
+    size_t size() const { return count; }
+
+    /**
+     * \brief Current time of CLOCK_MONOTONIC, in microseconds
+     * */
+    static uint64_t now();
+
+private:
+    static const uint32_t SLOT_MASK = SLOT_COUNT - 1;
+    static const uint32_t BITMAP_WORDS = SLOT_COUNT / 64;
+
+    TimerWheel(const TimerWheel &);
+    TimerWheel &operator=(const TimerWheel &);
+
+    void link(Link &head, Entry &entry);
+    void unlink(Entry &entry);
+
+    /**
+     * \brief Offset (in ticks) from fromTick of the first non-empty slot within count ticks, -1 if none
+     * */
+    long findOccupied(uint64_t fromTick, uint64_t count) const;
+
+    /**
+     * \brief Moves the entries expired at now from the slots of the ticks up to now to the expired list
+     *
+     * A now earlier than the current tick (e.g. after a popExpired with a later time) only looks at the slot
+     * of the current tick, where the entries scheduled since then in the past have gone.
+     * */
+    void advance(uint64_t now);
+
+    /**
+     * \brief Moves the entries of the slot expired at now to the expired list
+     * */
+    void expireSlot(uint32_t slot, uint64_t now);
+
+    /**
+     * \brief Gets the scheduled entry with the earliest expiry, not including the expired list
+     * */
+    Entry *findNext() const;
+
+    Link slots[SLOT_COUNT];
+    uint64_t occupied[BITMAP_WORDS];
+    /**Entries expired and not popped yet*/
+    Link expired;
+    /**All the slots before this tick have been emptied of the entries expired*/
+    uint64_t currentTick;
+    size_t count;
+};
+
+} /* namespace vndn */
+
+#endif /* TIMER_WHEEL_H_ */
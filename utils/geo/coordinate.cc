@@ -381,7 +381,7 @@ double Coordinate::pointToSegmentDist(Coordinate start, Coordinate end) const
 }
     
 //TODO check who is using whis function. they shoul use  the func above
-double Coordinate::pointToSegmentDistUTM(Coordinate lineStart, Coordinate lineEnd) const
+double Coordinate::pointToSegmentDistUTM(const Coordinate &lineStart, const Coordinate &lineEnd) const
 {
     // distance between myself and a segment
     // point == current Position in UTM
@@ -412,6 +412,14 @@ double Coordinate::pointToSegmentDistUTM(Coordinate lineStart, Coordinate lineEn
      */
 }
     
+double Coordinate::pointToSegmentDistUTM(double startNorthing, double startEasting, double endNorthing, double endEasting) const
+{
+    if(startNorthing==endNorthing&&startEasting==endEasting){
+        return 0;
+    }
+    return linePointDist(startEasting, startNorthing, endEasting, endNorthing, UTMEasting, UTMNorthing);
+}
+
 double Coordinate::linePointDist(double xA, double yA, double xB, double yB, double xC, double yC) const
 {
     if (dot(xA, yA, xB, yB, xC, yC) > 0) {
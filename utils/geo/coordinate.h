@@ -79,12 +79,12 @@ public:
     /**
      * \brief Get UTM Northing coordinate
      */
-    double getUTMNorthing(){return UTMNorthing;}
+    double getUTMNorthing() const {return UTMNorthing;}
     
     /**
      * \brief Get UTM easting coordinate
      */
-    double getUTMEasting(){return UTMEasting;}     
+    double getUTMEasting() const {return UTMEasting;}     
 
     /**
     * \brief Calculates the distance using the haversine formula
@@ -145,7 +145,12 @@ public:
      * \param end second coordinate of the segment
      * \result distance between the segment and this
      */
-    double pointToSegmentDistUTM(Coordinate lineStart, Coordinate lineEnd) const;
+    double pointToSegmentDistUTM(const Coordinate &lineStart, const Coordinate &lineEnd) const;
+
+    /**
+     * \brief As pointToSegmentDistUTM(const Coordinate &, const Coordinate &), with the UTM coordinates of the segment
+     */
+    double pointToSegmentDistUTM(double startNorthing, double startEasting, double endNorthing, double endEasting) const;
     
     /**
      * \brief Calculates the distance between 1 segment and a coordinate
@@ -163,7 +168,7 @@ public:
     /**
      * \brief compare 2 coordinates (this and the one given as parameter)
      */
-    bool isEqual(const Coordinate coord) {return coord.getLatitude()==latitude&&coord.getLongitude()==longitude;}
+    bool isEqual(const Coordinate &coord) const {return coord.getLatitude()==latitude&&coord.getLongitude()==longitude;}
 
     /**
      * \brief return the string (lat long) 
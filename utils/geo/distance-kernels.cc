@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "distance-kernels.h"
+
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace vndn {
+namespace geo {
+
+// same sphere as Coordinate::getDistance
+static const double EARTH_RADIUS = 6367000;
+static const double RADIANS_PER_DEGREE = M_PI / 180;
+
+// the error is mostly due to the scale of the longitude, which is the one of the reference:
+// about PLANAR_MAX_DEGREES * tan(PLANAR_MAX_LATITUDE) radians, i.e. 0.25%
+const double LocalProjection::PLANAR_MAX_DEGREES = 0.05;
+const double LocalProjection::PLANAR_MAX_LATITUDE = 70;
+const double LocalProjection::PLANAR_RELATIVE_ERROR = 0.01;
+
+LocalProjection::LocalProjection(double lat, double lon)
+    : refLat(lat), refLon(lon)
+    , metersPerDegreeLat(EARTH_RADIUS * RADIANS_PER_DEGREE)
+    , metersPerDegreeLon(EARTH_RADIUS * RADIANS_PER_DEGREE * std::cos(lat * RADIANS_PER_DEGREE))
+{
+}
+
+bool LocalProjection::isAccurate(double lat, double lon) const
+{
+    return std::fabs(refLat) <= PLANAR_MAX_LATITUDE &&
+           std::fabs(lat - refLat) <= PLANAR_MAX_DEGREES && std::fabs(lon - refLon) <= PLANAR_MAX_DEGREES;
+}
+
+void haversineDistances(double lat, double lon, const double *lats, const double *lons, size_t n, double *result)
+{
+    // the transcendental functions are not vectorized
+    const double cosLat = std::cos(lat * RADIANS_PER_DEGREE);
+    for (size_t i = 0; i < n; i++) {
+        const double sinDLat = std::sin((lats[i] - lat) * RADIANS_PER_DEGREE / 2.0);
+        const double sinDLon = std::sin((lons[i] - lon) * RADIANS_PER_DEGREE / 2.0);
+        const double a = sinDLat * sinDLat + cosLat * std::cos(lats[i] * RADIANS_PER_DEGREE) * sinDLon * sinDLon;
+        result[i] = EARTH_RADIUS * 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+    }
+}
+
+void planarDistances(const LocalProjection &projection, const double *lats, const double *lons, size_t n, double *result)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128d refLat = _mm_set1_pd(projection.refLat), refLon = _mm_set1_pd(projection.refLon);
+    const __m128d kLat = _mm_set1_pd(projection.metersPerDegreeLat), kLon = _mm_set1_pd(projection.metersPerDegreeLon);
+    for (; i + 2 <= n; i += 2) {
+        const __m128d y = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(lats + i), refLat), kLat);
+        const __m128d x = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(lons + i), refLon), kLon);
+        _mm_storeu_pd(result + i, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y))));
+    }
+#endif
+    for (; i < n; i++) {
+        const double y = (lats[i] - projection.refLat) * projection.metersPerDegreeLat;
+        const double x = (lons[i] - projection.refLon) * projection.metersPerDegreeLon;
+        result[i] = std::sqrt(x * x + y * y);
+    }
+}
+
+void pointDistances(double x, double y, const double *xs, const double *ys, size_t n, double *result)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128d px = _mm_set1_pd(x), py = _mm_set1_pd(y);
+    for (; i + 2 <= n; i += 2) {
+        const __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + i), px);
+        const __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + i), py);
+        _mm_storeu_pd(result + i, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+    }
+#endif
+    for (; i < n; i++) {
+        const double dx = xs[i] - x, dy = ys[i] - y;
+        result[i] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+void segmentDistances(double x, double y, const double *x1, const double *y1, const double *x2, const double *y2,
+                      size_t n, double *result)
+{
+    // the point is projected on the line of the segment, and the projection clamped to the segment
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128d px = _mm_set1_pd(x), py = _mm_set1_pd(y);
+    const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1);
+    for (; i + 2 <= n; i += 2) {
+        const __m128d ax = _mm_loadu_pd(x1 + i), ay = _mm_loadu_pd(y1 + i);
+        const __m128d dx = _mm_sub_pd(_mm_loadu_pd(x2 + i), ax), dy = _mm_sub_pd(_mm_loadu_pd(y2 + i), ay);
+        const __m128d vx = _mm_sub_pd(px, ax), vy = _mm_sub_pd(py, ay);
+        const __m128d length2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        __m128d t = _mm_div_pd(_mm_add_pd(_mm_mul_pd(vx, dx), _mm_mul_pd(vy, dy)), length2);
+        // beyond an end the distance is the one from the end, computed as such so that two links
+        // that share the closest junction are at exactly the same distance
+        const __m128d atStart = _mm_cmple_pd(t, zero), atEnd = _mm_cmpge_pd(t, one);
+        __m128d ex = _mm_sub_pd(vx, _mm_mul_pd(t, dx)), ey = _mm_sub_pd(vy, _mm_mul_pd(t, dy));
+        ex = _mm_or_pd(_mm_and_pd(atStart, vx), _mm_andnot_pd(atStart, ex));
+        ey = _mm_or_pd(_mm_and_pd(atStart, vy), _mm_andnot_pd(atStart, ey));
+        ex = _mm_or_pd(_mm_and_pd(atEnd, _mm_sub_pd(px, _mm_loadu_pd(x2 + i))), _mm_andnot_pd(atEnd, ex));
+        ey = _mm_or_pd(_mm_and_pd(atEnd, _mm_sub_pd(py, _mm_loadu_pd(y2 + i))), _mm_andnot_pd(atEnd, ey));
+        const __m128d distance = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey)));
+        // segments of length 0 (NaN above) are at distance 0
+        _mm_storeu_pd(result + i, _mm_andnot_pd(_mm_cmpeq_pd(length2, zero), distance));
+    }
+#endif
+    for (; i < n; i++) {
+        const double dx = x2[i] - x1[i], dy = y2[i] - y1[i];
+        const double length2 = dx * dx + dy * dy;
+        if (length2 == 0) {
+            result[i] = 0;
+            continue;
+        }
+        const double vx = x - x1[i], vy = y - y1[i];
+        const double t = (vx * dx + vy * dy) / length2;
+        double ex, ey;
+        if (t <= 0) {
+            ex = vx;
+            ey = vy;
+        } else if (t >= 1) {
+            ex = x - x2[i];
+            ey = y - y2[i];
+        } else {
+            ex = vx - t * dx;
+            ey = vy - t * dy;
+        }
+        result[i] = std::sqrt(ex * ex + ey * ey);
+    }
+}
+
+}
+}
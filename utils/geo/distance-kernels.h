@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef DISTANCE_KERNELS_H
+#define DISTANCE_KERNELS_H
+
+#include <stddef.h>
+
+namespace vndn {
+namespace geo {
+
+/**
+ * \brief Equirectangular projection around a reference point, in meters
+ *
+ * Within PLANAR_MAX_DEGREES of the reference, and below PLANAR_MAX_LATITUDE,
+ * the planar distance from the reference differs from the haversine distance
+ * of Coordinate::getDistance by less than PLANAR_RELATIVE_ERROR of it.
+ */
+struct LocalProjection
+{
+    static const double PLANAR_MAX_DEGREES;
+    static const double PLANAR_MAX_LATITUDE;
+    static const double PLANAR_RELATIVE_ERROR;
+
+    LocalProjection(double lat, double lon);
+
+    /**
+     * \brief Whether the planar distance from the reference to (lat, lon) is within the error bound
+     */
+    bool isAccurate(double lat, double lon) const;
+
+    double refLat, refLon;
+    double metersPerDegreeLat, metersPerDegreeLon;
+};
+
+/*
+ * Batch versions of the distances computed by Coordinate, for the hot paths
+ * that evaluate many candidates for the same position. The inputs are arrays
+ * of n values (structure of arrays), the distances are stored in result.
+ * Two distances are computed at a time with SSE2 where it is available,
+ * the other architectures use a plain loop.
+ */
+
+/**
+ * \brief Haversine distances (as Coordinate::getDistance) from (lat, lon) to (lats[i], lons[i])
+ */
+void haversineDistances(double lat, double lon, const double *lats, const double *lons, size_t n, double *result);
+
+/**
+ * \brief Distances from the reference of the projection to (lats[i], lons[i]), on the projection plane
+ */
+void planarDistances(const LocalProjection &projection, const double *lats, const double *lons, size_t n, double *result);
+
+/**
+ * \brief Euclidean distances from (x, y) to (xs[i], ys[i])
+ */
+void pointDistances(double x, double y, const double *xs, const double *ys, size_t n, double *result);
+
+/**
+ * \brief Distances from (x, y) to the segments from (x1[i], y1[i]) to (x2[i], y2[i])
+ *
+ * As Coordinate::pointToSegmentDistUTM, the distance from a segment of length 0 is 0.
+ */
+void segmentDistances(double x, double y, const double *x1, const double *y1, const double *x2, const double *y2,
+                      size_t n, double *result);
+
+}
+}
+
+#endif
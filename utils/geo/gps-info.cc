@@ -32,10 +32,13 @@ GpsInfo::GpsInfo()
     longitude = 0;
     speed = 0;
     heading = 0;
+    latError = 0;
+    lonError = 0;
     memset(latChar, 0 , GPS_STRING_SIZE);
     memset(longitudeChar, 0 , GPS_STRING_SIZE);
     sprintf(latChar, "0.0");
     sprintf(longitudeChar, "0.0");
+    charsValid = true;
     previousAlt = 0;
     previousLat = 0;
     previousLongitude = 0;
@@ -50,10 +53,13 @@ GpsInfo::GpsInfo(double latP, double longitudeP)
     alt = 0;
     speed = 0;
     heading = 0;
+    latError = 0;
+    lonError = 0;
     memset(latChar, 0 , GPS_STRING_SIZE);
     memset(longitudeChar, 0 , GPS_STRING_SIZE);
     sprintf(latChar, "%f", lat);
     sprintf(longitudeChar, "%f", longitude);
+    charsValid = true;
     previousAlt = 0;
     previousLat = 0;
     previousLongitude = 0;
@@ -126,18 +132,26 @@ void GpsInfo::setPosition(double latit, double lon,  double alt, double speed, d
     this->alt = alt;
     this->speed = speed;
     this->heading = heading;
+    charsValid = false;
+}
+
+void GpsInfo::formatChars() const
+{
+    if (charsValid)
+        return;
     memset(latChar, 0 , GPS_STRING_SIZE);
     memset(longitudeChar, 0 , GPS_STRING_SIZE);
     if (lat==DEFAULT_COORDINATE_DOUBLE) {
         memcpy(latChar, DEFAULT_COORDINATE_CHAR, strlen(DEFAULT_COORDINATE_CHAR));    
     } else {
-        sprintf(this->latChar, "%#1.6f", this->lat);
+        sprintf(latChar, "%#1.6f", lat);
     }
-    if (lon==DEFAULT_COORDINATE_DOUBLE) {
+    if (longitude==DEFAULT_COORDINATE_DOUBLE) {
         memcpy(longitudeChar, DEFAULT_COORDINATE_CHAR, strlen(DEFAULT_COORDINATE_CHAR));    
     } else {
-        sprintf(this->longitudeChar, "%#1.6f", this->longitude);
+        sprintf(longitudeChar, "%#1.6f", longitude);
     }
+    charsValid = true;
 }
 
 } /* namespace geo */
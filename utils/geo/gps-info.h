@@ -96,12 +96,12 @@ public:
     /**
      * \brief return a pointer to the char version of the latitude
      */
-    const char * getLatChar() const {return latChar;}
+    const char * getLatChar() const {formatChars(); return latChar;}
     
     /**
      * \brief return a pointer to the char version of the longitude
      */
-    const char * getLonChar() const {return longitudeChar;}
+    const char * getLonChar() const {formatChars(); return longitudeChar;}
     
     /**
      * \brief Return the actual latitude
@@ -128,10 +128,25 @@ public:
      */
     double getHeading() const {return heading;}
     
+    /**
+     * \brief Return the expected error of the actual latitude (in meters, 0 if unknown)
+     */
+    double getLatError() const {return latError;}
+    
+    /**
+     * \brief Return the expected error of the actual longitude (in meters, 0 if unknown)
+     */
+    double getLonError() const {return lonError;}
+    
     /**
      \brief Set the actual position
      */
     void setPosition(double latit, double lon,  double alt, double speed, double heading);
+    
+    /**
+     * \brief Set the expected errors of the actual position, as reported by gpsd (epy and epx)
+     */
+    void setError(double latErr, double lonErr) {latError = latErr; lonError = lonErr;}
 
 protected:
 
@@ -161,6 +176,13 @@ protected:
      * \return haversine distance between 2 point (in meters)
      * */
     double haversineFormula(double gpsLat, double gpsLongitude);
+
+    /**
+     * \brief Writes the char versions of the coordinates, if they changed
+     *
+     * They are only needed for logging, so they are not written at every update.
+     * */
+    void formatChars() const;
     
     const MapElement * mapPositon;
     
@@ -174,11 +196,17 @@ protected:
     double speed;
     /**heading (in degree)*/
     double heading;
+    /**Expected error of the latitude (in meters)*/
+    double latError;
+    /**Expected error of the longitude (in meters)*/
+    double lonError;
 
     /**Latitude, expressed in char*/
-    char latChar[GPS_STRING_SIZE];
+    mutable char latChar[GPS_STRING_SIZE];
     /**Longitude (expressed in char)*/
-    char longitudeChar[GPS_STRING_SIZE];
+    mutable char longitudeChar[GPS_STRING_SIZE];
+    /**Whether latChar and longitudeChar match lat and longitude*/
+    mutable bool charsValid;
 
     /**Latitude (relative of previous update) */
     double previousLat;
@@ -18,6 +18,10 @@
 #include "gpsd-parser.h"
 #include "corelib/log.h"
 
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
 NS_LOG_COMPONENT_DEFINE ("geo.GpsdParser");
 
 namespace vndn {
@@ -31,10 +35,176 @@ struct FakeGpsMessage {
 };
 #endif
 
-int GpsdParser::parseData(char *data, int len, GpsInfo *info)
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const char *skipSpace(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+    return p;
+}
+
+/**
+ * \brief Skips a string, p points after the opening quote
+ * \return the character after the closing quote, NULL if the string is not terminated
+ */
+static const char *skipString(const char *p, const char *end)
+{
+    while (p < end) {
+        const char *quote = (const char *) memchr(p, '"', end - p);
+        if (quote == NULL)
+            return NULL;
+        // the quote is escaped if it follows an odd number of backslashes
+        const char *q = quote;
+        while (q > p && q[-1] == '\\')
+            q--;
+        if ((quote - q) % 2 == 0)
+            return quote + 1;
+        p = quote + 1;
+    }
+    return NULL;
+}
+
+/**
+ * \brief Skips a value of any type, including objects and arrays
+ * \return the character after the value, NULL if it is not terminated
+ */
+static const char *skipValue(const char *p, const char *end)
+{
+    int depth = 0;
+    while (p < end) {
+        switch (*p) {
+        case '"':
+            p = skipString(p + 1, end);
+            if (p == NULL)
+                return NULL;
+            break;
+        case '{':
+        case '[':
+            depth++;
+            p++;
+            break;
+        case '}':
+        case ']':
+            if (depth == 0)
+                return p;
+            depth--;
+            p++;
+            break;
+        case ',':
+            if (depth == 0)
+                return p;
+            p++;
+            break;
+        default:
+            p++;
+        }
+    }
+    return depth == 0 ? p : NULL;
+}
+
+/**
+ * \brief Parses a JSON number
+ *
+ * Up to 19 significant digits are exact, and are scaled by a single multiplication or division,
+ * which gives the same result as strtod for the coordinates sent by gpsd.
+ * \return the character after the number, NULL if p does not point to a number
+ */
+static const char *parseNumber(const char *p, const char *end, double &value)
+{
+    const bool negative = p < end && *p == '-';
+    if (negative)
+        p++;
+    const char *digits = p;
+    uint64_t mantissa = 0;
+    int significant = 0, exponent = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0)
+                significant++;
+        } else {
+            exponent++;
+        }
+    }
+    if (p == digits)
+        return NULL;
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0)
+                    significant++;
+                exponent--;
+            }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        const bool negativeExponent = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+'))
+            p++;
+        int e = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (e < 1000)
+                e = e * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    value = (double) mantissa;
+    if (exponent < 0 && exponent >= -22)
+        value /= POWERS_OF_TEN[-exponent];
+    else if (exponent > 0 && exponent <= 22)
+        value *= POWERS_OF_TEN[exponent];
+    else if (exponent != 0)
+        value *= std::pow(10.0, exponent);
+    if (negative)
+        value = -value;
+    return p;
+}
+
+int GpsdParser::findField(const char *key, size_t size)
+{
+    if (size == 3) {
+        if (memcmp(key, "lat", 3) == 0)
+            return FIELD_LAT;
+        if (memcmp(key, "lon", 3) == 0)
+            return FIELD_LON;
+        if (memcmp(key, "alt", 3) == 0)
+            return FIELD_ALT;
+        if (memcmp(key, "epx", 3) == 0)
+            return FIELD_EPX;
+        if (memcmp(key, "epy", 3) == 0)
+            return FIELD_EPY;
+    } else if (size == 5) {
+        if (memcmp(key, "speed", 5) == 0)
+            return FIELD_SPEED;
+        if (memcmp(key, "track", 5) == 0)
+            return FIELD_TRACK;
+    }
+    return FIELD_COUNT;
+}
+
+GpsdParser::GpsdParser()
+    : lineSize(0)
+    , overflow(false)
+{
+}
+
+void GpsdParser::reset()
+{
+    lineSize = 0;
+    overflow = false;
+}
+
+int GpsdParser::parseData(const char *data, int len, GpsInfo *info)
 {
 #ifdef FAKE
-    FakeGpsMessage *msg = (FakeGpsMessage *) data;
+    const FakeGpsMessage *msg = (const FakeGpsMessage *) data;
     info->storeInPrevious();
     info->setPosition(msg->lat, msg->longitude, 0, 0, 0);
     //home: 34.048369,-118.464064
@@ -43,72 +213,145 @@ int GpsdParser::parseData(char *data, int len, GpsInfo *info)
     return 1;
 #endif
 
-    char *token ;
-    char *start ;
-    char *end ;
-    char val_sec[64] ;
-    char val_usec[64] ;
-    char val_lat[64] ;
-    char val_log[64] ;
-    data[len] = '\0' ;
-    token = strstr( data , "\"class\":\"TPV\"" ) ;
-    if ( token == NULL )
-        return -1;
-    //parse time
-    token = strstr ( data , "\"time\":" ) ;
-    if ( token == NULL )
-        return -1;
-    start = strstr ( token , ":" ) ;
-    end = strstr ( token , "." ) ;
-    strncpy ( val_sec, start + 1, end - ( start + 1 ) ) ;
-    val_sec[end - ( start + 1 )] = '\0' ;
-    token = start = end ;
-    end = strstr ( token , "," ) ;
-    if ( token == NULL )
-        return -1;
-    strncpy ( val_usec, start + 1, end - ( start + 1 ) ) ;
-    val_usec[end - ( start + 1 )] = '\0' ;
-    //parse latitude
-    token = strstr ( data , "\"lat\":" ) ;
-    if ( token == NULL)
-        return -1;
-    start = strstr ( token , ":" ) ;
-    end = strstr ( token , "," ) ;
-    strncpy ( val_lat, start + 1, end - ( start + 1 ) ) ;
-    val_lat[end - ( start + 1 )] = '\0' ;
-    //parse longitude
-    token = strstr ( data , "\"lon\":" ) ;
-    if ( token == NULL )
+    if (data == NULL || len <= 0)
+        return 0;
+
+    const char *const end = data + len;
+    Report report, last;
+    bool found = false, malformed = false;
+    while (data < end) {
+        const char *newline = (const char *) memchr(data, '\n', end - data);
+        if (newline == NULL) {
+            // the rest of the report will come with the next chunk
+            const size_t size = end - data;
+            if (!overflow && lineSize + size <= MAX_LINE_SIZE) {
+                memcpy(line + lineSize, data, size);
+                lineSize += size;
+            } else {
+                overflow = true;
+                lineSize = 0;
+            }
+            break;
+        }
+
+        const size_t size = newline - data;
+        int res;
+        if (overflow) {
+            NS_LOG_WARN("Discarded a report longer than " << MAX_LINE_SIZE << " bytes");
+            res = -1;
+            overflow = false;
+        } else if (lineSize == 0) {
+            // the common case, the whole report is in the chunk
+            res = parseLine(data, newline, report);
+        } else if (lineSize + size <= MAX_LINE_SIZE) {
+            memcpy(line + lineSize, data, size);
+            res = parseLine(line, line + lineSize + size, report);
+        } else {
+            NS_LOG_WARN("Discarded a report longer than " << MAX_LINE_SIZE << " bytes");
+            res = -1;
+        }
+        lineSize = 0;
+
+        if (res == 1) {
+            last = report;
+            found = true;
+        } else if (res == -1) {
+            malformed = true;
+        }
+        data = newline + 1;
+    }
+
+    if (found) {
+        store(last, info);
+        return 1;
+    }
+    return malformed ? -1 : 0;
+}
+
+int GpsdParser::parseLine(const char *begin, const char *end, Report &report)
+{
+    const char *p = skipSpace(begin, end);
+    if (p == end)
+        return 0;
+    if (*p != '{')
         return -1;
-    start = strstr ( token , ":" ) ;
-    end = strstr ( token , "," ) ;
-    strncpy ( val_log, start + 1, end - ( start + 1 ) ) ;
-    val_log[end - ( start + 1 )] = '\0' ;
-    //Update data
-    /*
-     *      sscanf( val_sec , "%lu", &(packet->sec) );
-            if ( DEBUG ) printf ( "From GPSd: time (sec) %lu [%x]\n" , packet->sec , ( unsigned int ) packet->sec ) ;
-                    sscanf( val_usec , "%lu", &(packet->usec) );
-                    if ( DEBUG ) printf ( "From GPSd: time (usec) %lu [%x]\n" , packet->usec , ( unsigned int ) packet->usec ) ;
-                    sscanf( val_lat , "%lf", &(packet->lat) );
-                    if ( DEBUG ) printf ( "From GPSd: lat %lf [%x]\n" , packet->lat , ( unsigned int ) packet->lat ) ;
-                    sscanf( val_log , "%lf", &(packet->log) );
-                    if ( DEBUG ) printf ( "From GPSd: log %lf [%x]\n" , packet->log , ( unsigned int ) packet->log) ;
-
-    */
 
-    info->storeInPrevious();
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        report.values[i] = 0;
+        report.present[i] = false;
+    }
+    bool tpv = false;
+
+    p = skipSpace(p + 1, end);
+    if (p < end && *p == '}')
+        return 0;
+    for (;;) {
+        if (p == end || *p != '"')
+            return -1;
+        const char *key = p + 1;
+        p = skipString(key, end);
+        if (p == NULL)
+            return -1;
+        const size_t keySize = p - 1 - key;
+        p = skipSpace(p, end);
+        if (p == end || *p != ':')
+            return -1;
+        p = skipSpace(p + 1, end);
+        if (p == end)
+            return -1;
 
-    //testing
-    /*  double randomLat = 34 + (rand()%1000)/10000.0 ;
-    double randomLong = -118 - (rand()%1000)/10000.0;
+        if (keySize == 5 && memcmp(key, "class", 5) == 0) {
+            if (*p != '"')
+                return -1;
+            const char *value = p + 1;
+            p = skipString(value, end);
+            if (p == NULL)
+                return -1;
+            // gpsd sends the class first, the other reports are not scanned further
+            if (p - 1 - value != 3 || memcmp(value, "TPV", 3) != 0)
+                return 0;
+            tpv = true;
+        } else {
+            const int field = findField(key, keySize);
+            const char *next = NULL;
+            if (field < FIELD_COUNT && (*p == '-' || (*p >= '0' && *p <= '9'))) {
+                next = parseNumber(p, end, report.values[field]);
+                report.present[field] = next != NULL;
+            } else {
+                next = skipValue(p, end);
+            }
+            if (next == NULL)
+                return -1;
+            p = next;
+        }
 
-    info->setPosition(randomLat,randomLong, 0, 0, 0);*/
-    //end test
+        p = skipSpace(p, end);
+        if (p == end)
+            return -1;
+        if (*p == '}')
+            break;
+        if (*p != ',')
+            return -1;
+        p = skipSpace(p + 1, end);
+    }
 
-    info->setPosition(atof(val_lat), atof(val_log), 0, 0, 0);
+    // without a fix (mode 1) the TPV report has no position
+    return tpv && report.present[FIELD_LAT] && report.present[FIELD_LON] ? 1 : 0;
+}
+
+void GpsdParser::store(const Report &report, GpsInfo *info)
+{
+    info->storeInPrevious();
+
+    //speed (m/s) and track (degrees from true north) are missing without a fix in 2D
+    double speed = 0, heading = 0;
+    if (report.present[FIELD_SPEED] && report.present[FIELD_TRACK]) {
+        speed = report.values[FIELD_SPEED];
+        heading = report.values[FIELD_TRACK];
+    }
+    info->setPosition(report.values[FIELD_LAT], report.values[FIELD_LON], report.values[FIELD_ALT], speed, heading);
+    info->setError(report.values[FIELD_EPY], report.values[FIELD_EPX]);
     NS_LOG_INFO("New position: latitude = " << info->getLatChar() << "; longitude = " << info->getLonChar());
-    return 1;
 }
 
 } /* namespace geo */
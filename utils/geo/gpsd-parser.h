@@ -20,6 +20,8 @@
 
 #include "gps-info.h"
 
+#include <stddef.h>
+
 namespace vndn {
 namespace geo {
 
@@ -27,18 +29,82 @@ namespace geo {
  * \brief Parses the gpsd output and stores the location information into a gpsInfo object
  *
  * The gpsd command necessary to correctly parsed the data is the following: ?WATCH={\"enable\":true,\"json\":true}"
+ *
+ * gpsd sends one JSON object per line. The parser consumes the stream in chunks of any size,
+ * as returned by read(): a report split across two chunks is kept until its end arrives,
+ * and a chunk may contain several reports. Complete lines are scanned in place and only
+ * the tail of a split report is buffered, so parsing does not allocate memory.
  */
 class GpsdParser
 {
 public:
+    /**
+     * \brief Maximum length of a report, longer lines are discarded
+     */
+    static const size_t MAX_LINE_SIZE = 4096;
+
+    GpsdParser();
+
     /**
      * \brief Parses the gpsd output and stores the location information into a gpsInfo object
      *
+     * Only the TPV reports with a position are used, the other classes are skipped.
+     * If the chunk completes more than one of them, the last one is stored.
+     *
      * \param data pointer to the buffer where the gpsd output is stored
      * \param len size of the gpsd output
-     * \param info pointer to the gpsInfo object that will store all the useful information extracted by gpsd: lat, long, altitude (not implemented), speed (not implemented), heading(not implemented);
+     * \param info pointer to the gpsInfo object that will store all the useful information extracted by gpsd: lat, long, altitude, speed, heading and the expected errors (0 if gpsd does not report them);
+     * \return 1 if the position was updated, 0 if the chunk did not complete any TPV report, -1 if a malformed report was found
+     */
+    int parseData(const char *data, int len, GpsInfo *info);
+
+    /**
+     * \brief Drops the partial report, e.g. after reconnecting to gpsd
+     */
+    void reset();
+
+private:
+    /**
+     * \brief Numeric fields of a TPV report
+     */
+    enum Field {
+        FIELD_LAT,
+        FIELD_LON,
+        FIELD_ALT,
+        FIELD_SPEED,
+        FIELD_TRACK,
+        FIELD_EPX,
+        FIELD_EPY,
+        FIELD_COUNT
+    };
+
+    struct Report
+    {
+        double values[FIELD_COUNT];
+        bool present[FIELD_COUNT];
+    };
+
+    /**
+     * \brief Returns the field named key, FIELD_COUNT if it is not used
+     */
+    static int findField(const char *key, size_t size);
+
+    /**
+     * \brief Parses the report in [begin, end), a single line without the newline
+     * \return 1 if it is a TPV report with a position, 0 if it is another report, -1 if it is malformed
+     */
+    static int parseLine(const char *begin, const char *end, Report &report);
+
+    /**
+     * \brief Stores the report into info
      */
-    int parseData(char *data, int len, GpsInfo *info);
+    static void store(const Report &report, GpsInfo *info);
+
+    /// beginning of a report split across chunks
+    char line[MAX_LINE_SIZE];
+    size_t lineSize;
+    /// true while skipping the rest of a line longer than MAX_LINE_SIZE
+    bool overflow;
 };
 
 } /* namespace geo */
@@ -19,18 +19,36 @@
 #include "corelib/log.h"
 
 #include <iomanip>
+#include <unistd.h>
 
 NS_LOG_COMPONENT_DEFINE("geo.LocationService");
 
 namespace vndn {
 namespace geo {
 
+static const char MAP_FILE[] = "utils/geo/map/map.bin";
+
+/**
+ * \brief Loads the binary map if it has been generated (see mapConvert), the text map otherwise
+ */
+static Map loadMap()
+{
+    if (access(MAP_FILE, R_OK) == 0) {
+        try {
+            return Map(MAP_FILE);
+        } catch (MapException &e) {
+            NS_LOG_WARN(e.what() << ", using the text map");
+        }
+    }
+    return Map("utils/geo/map/nodes", "utils/geo/map/edges");
+}
+
 LocationService::LocationService()
+    : positionId(RoadGraph::INVALID_ID)
+    , map(loadMap())
 {
     noValidData();
 
-    map = Map("utils/geo/map/nodes", "utils/geo/map/edges");
-
     NS_LOG_INFO("Map: minLat = " << map.getMinLat() << ", maxLat = " << map.getMaxLat() << ", minLong = " << map.getMinLon() << ", maxLong = " << map.getMaxLon());
 }
 
@@ -40,10 +58,15 @@ LocationService::~LocationService()
 
 void LocationService::updatePosition(uint8_t * buffer, int len)
 {
-    if (gpsParser.parseData((char *) buffer, len, &position) == -1) {
+    const int res = gpsParser.parseData((const char *) buffer, len, &position);
+    if (res == -1) {
         NS_LOG_WARN("parsing data from gps failed");
         return;
     }
+    if (res == 0) {
+        // no complete position report yet, or a report of another class
+        return;
+    }
 
     position.getCoordinate().updateUTM();
     updateMapInfo();
@@ -90,56 +113,38 @@ const std::string LocationService::findLocationIdInMap(Coordinate c) const
 
 const MapElement * LocationService::findLocationInMap(Coordinate c) const
 {
-    const Junction *jun = map.findClosestJunction(c,0.001); //	111 m (at the equator)
-    if(jun!=NULL){
-        if(jun->isValid()){
-            if(c.twoPointsDistance(jun->getCoordinate())<SIZEOFINTERSECTION){
-                //we are at an intersection
-                NS_LOG_DEBUG("we are at an intersection: lat/long:" <<jun->getCoordinate().getLatitude()<<","<<jun->getCoordinate().getLongitude() << " id :"<< jun->printId());
-                return jun;
-            }
-        }
-    }
-    NS_LOG_DEBUG("findClosestJunction found nothing");
-    const Link *link = map.findClosestLink(c,0.001); //	111 m
-    if(link==NULL){
-        NS_LOG_ERROR("element not found in the map");
-        return NULL;
-    }
-    if(!link->isValid()){
-        //ERROR, noting found
-        NS_LOG_ERROR("element not found in the map");
-        return NULL;
-    }
-    NS_LOG_DEBUG("we are at a link: " <<std::setprecision(15)<<link->getId() << " id: "<< link->printId());
-    return link;
+    RoadGraph::ElementId id = findLocationInGraph(c);
+    return id==RoadGraph::INVALID_ID ? NULL : map.getGraph().getElement(id);
+}
+
+RoadGraph::ElementId LocationService::findLocationInGraph(const Coordinate &c) const
+{
+    return MapMatcher::matchGlobal(map, c);
 }
 
 void LocationService::getClosestMapToParamAndFarthestToMe(std::string elId, Coordinate c, std::list<std::string> & result) const
 {
-    std::list<std::string> connections;
-    const MapElement *el;
-    try{
-        el = map.getMapSegmentById(elId);
-    } catch (MapException e){
-        NS_LOG_WARN( e.what()<<" for id "<< elId);
+    RoadGraph::ElementId el = map.getElementId(elId);
+    if(el==RoadGraph::INVALID_ID){
+        NS_LOG_WARN("Element not found in the map for id "<< elId);
         return;
     }
-    el->getConnection(connections);
-    
-    std::list<std::string>::iterator it;
-    NS_LOG_DEBUG("getClosestMapToParamAndFarthestToMe " << el->printId());
-    for (it=connections.begin(); it!=connections.end(); it++) {
-        const MapElement * element;
-        try{
-            element = map.getMapSegmentById(*it);
-        } catch (MapException e){
-            NS_LOG_WARN( e.what()<<" for id "<< *it);
-            continue;
-        }
+    std::vector<RoadGraph::ElementId> closer;
+    getClosestMapToParamAndFarthestToMe(el, c, closer);
+    for(size_t i=0; i<closer.size(); i++){
+        result.push_back(map.getGraph().getElement(closer[i])->printId());
+    }
+}
 
-        NS_LOG_DEBUG("distance: from me " <<element->getDistance(position.getCoordinate())<<"; from source:" <<element->getDistance(c));
-        if(element->getDistance(c)<=element->getDistance(position.getCoordinate())){
+void LocationService::getClosestMapToParamAndFarthestToMe(RoadGraph::ElementId el, const Coordinate &c, std::vector<RoadGraph::ElementId> &result) const
+{
+    const RoadGraph &graph = map.getGraph();
+    const Coordinate me = position.getCoordinate();
+    NS_LOG_DEBUG("getClosestMapToParamAndFarthestToMe " << el);
+    for(const RoadGraph::ElementId *it=graph.neighboursBegin(el); it!=graph.neighboursEnd(el); it++){
+        double fromSource = graph.getDistance(*it, c), fromMe = graph.getDistance(*it, me);
+        NS_LOG_DEBUG("distance: from me " <<fromMe<<"; from source:" <<fromSource);
+        if(fromSource<=fromMe){
             result.push_back(*it);
         }
     }
@@ -167,26 +172,18 @@ void LocationService::getNeighbourMapElement(std::list<std::string> & result) co
 void LocationService::updateMapInfo()
 {
     NS_LOG_DEBUG("updateMapInfo");
-    const MapElement * mapEl=findLocationInMap(position.getCoordinate());
-    NS_LOG_DEBUG("location in the map found:" << mapEl->toString());
-    updateMapInfo(mapEl);
-    /*only for debug*/
-    NS_LOG_DEBUG("position: "<< position.getMapElement()->toString());
-    std::list<std::string> result;
-    getNeighbourMapElement(mapEl,result);
-    
-    std::list<std::string>::iterator it;
-    for(it=result.begin(); it!=result.end(); it++){
-        // NS_LOG_DEBUG("getNeighbourMapElement "<<mapEl->toString()<<" "<<mapEl->printId()<<"neighbour: "< *it);
-    }
+    updateMapInfo(matcher.match(map, position.getCoordinate(), position.getSpeed(), position.getHeading()));
+    NS_LOG_DEBUG("match confidence: " << matcher.getConfidence());
 }
 
-void LocationService::updateMapInfo(const MapElement * mapEl)
+void LocationService::updateMapInfo(RoadGraph::ElementId id)
 {
-    if (mapEl==NULL) {
+    if (id==RoadGraph::INVALID_ID) {
         return;
     }
-    position.setMapElement(mapEl);
+    positionId = id;
+    position.setMapElement(map.getGraph().getElement(id));
+    NS_LOG_DEBUG("position: "<< position.getMapElement()->toString());
 }
 
 double LocationService::getDistance (double lat, double lon) const
@@ -197,6 +194,7 @@ double LocationService::getDistance (double lat, double lon) const
 void LocationService::noValidData()
 {
     //there are some problem with gpsd. We do not have valid gps data
+    matcher.reset();
     position.setPosition(DEFAULT_COORDINATE_DOUBLE,DEFAULT_COORDINATE_DOUBLE,DEFAULT_COORDINATE_DOUBLE,DEFAULT_COORDINATE_DOUBLE,DEFAULT_COORDINATE_DOUBLE);
 }
 
@@ -19,17 +19,17 @@
 #define LOCATION_SERVICE
 
 #include <list>
+#include <vector>
 
 #include "gps-info.h"
 #include "gpsd-parser.h"
 #include "map.h"
+#include "map-matcher.h"
 #include "coordinate.h"
 
 namespace vndn {
 namespace geo {
 
-#define SIZEOFINTERSECTION 40
-
 /**
  * \brief This obkject takes care of the localization of a node. 
  * 
@@ -43,6 +43,7 @@ public:
      *\brief It creates the LocationService
      *
      * The LocationService will loaded the tigerMap (the path is written in the code, but this is just a temporary solution)
+     * from utils/geo/map/map.bin if it has been generated with mapConvert, from the text files otherwise
      * */
     LocationService();
 
@@ -51,7 +52,8 @@ public:
     /**
      * \brief Update car position using information given by gpsd
      * 
-     * \param buffer pointer to the gpsd output (the otiginally gpsd output, not parsed yet)
+     * \param buffer pointer to the gpsd output (the otiginally gpsd output, not parsed yet);
+     *        any chunk read from the socket, a report may be split across two calls
      * \param len size of gpsd output
      * */
     void updatePosition(uint8_t * buffer, int len);
@@ -66,6 +68,21 @@ public:
      */
     double getLongitude() const {return position.getCoordinate().getLongitude();}
     
+    /**
+     * \brief Get actual speed (m/s)
+     */
+    double getSpeed() const {return position.getSpeed();}
+
+    /**
+     * \brief Get actual heading (degrees clockwise from north)
+     */
+    double getHeading() const {return position.getHeading();}
+
+    /**
+     * \brief Check if the actual position is valid (gpsd has a fix)
+     */
+    bool hasValidPosition() const {return position.getLat()!=DEFAULT_COORDINATE_DOUBLE && position.getLon()!=DEFAULT_COORDINATE_DOUBLE;}
+
     /**
      * Calculates the distance between the actual position and the poind given by parameter (double, double)
      */
@@ -90,6 +107,26 @@ public:
      * \brief Return the actual mapElement
      */
     const MapElement *getPositionInTheMap() const {return position.getMapElement();}
+
+    /**
+     * \brief Id in the road graph of the actual MapElement, RoadGraph::INVALID_ID if the position is unknown
+     */
+    RoadGraph::ElementId getPositionIdInTheGraph() const {return positionId;}
+
+    /**
+     * \brief Confidence of the match of the actual position to its MapElement, from 0 (none) to 1
+     */
+    double getMatchConfidence() const {return matcher.getConfidence();}
+
+    /**
+     * \brief The map matcher, e.g. to read its counters
+     */
+    const MapMatcher &getMatcher() const {return matcher;}
+
+    /**
+     * \brief Road graph of the map, to visit the neighbours of a MapElement without building lists of ids
+     */
+    const RoadGraph &getRoadGraph() const {return map.getGraph();}
     const std::string getPositionIdInTheMap() const {return position.getMapElement()->printId();}
 
     
@@ -120,6 +157,13 @@ public:
     //void getClosestMapToParamAndFarthestToMe(const MapElement &el, Coordinate c, std::list<const MapElement*> & result) const;
     void getClosestMapToParamAndFarthestToMe(std::string elId, Coordinate c, std::list<std::string> & result) const;
 
+    /**
+     * \brief As getClosestMapToParamAndFarthestToMe, with the ids of the road graph
+     *
+     * The ids are appended to result, no memory is allocated if result has enough capacity.
+     */
+    void getClosestMapToParamAndFarthestToMe(RoadGraph::ElementId el, const Coordinate &c, std::vector<RoadGraph::ElementId> &result) const;
+
     
     /**
      * \brief apply reverse geocoding technique to find out which street is indicated by the Coordinate
@@ -127,6 +171,11 @@ public:
 	  const MapElement * findLocationInMap(Coordinate c) const;
     const std::string findLocationIdInMap(Coordinate c) const; //return "" if not found
 
+    /**
+     * \brief As findLocationInMap, returns the id of the MapElement in the road graph (RoadGraph::INVALID_ID if not found)
+     */
+    RoadGraph::ElementId findLocationInGraph(const Coordinate &c) const;
+
 	
     /**
      * \brief Gets the list of the MapElement connected to the MapElement given as parameter
@@ -155,22 +204,30 @@ protected:
 
     /**
      * \brief search the correct segment in the map and update the node position
+     *
+     * The search starts from the actual MapElement and its neighbours (see MapMatcher)
      * */
     void updateMapInfo();
     
     /**
      * \brief Updates the actual position with the MapElement given as parameter
      */
-    void updateMapInfo(const MapElement * mapEl);
+    void updateMapInfo(RoadGraph::ElementId id);
     
     
     /**Actual position*/
     GpsInfo position;
+
+    /**Id of the MapElement of the actual position in the road graph*/
+    RoadGraph::ElementId positionId;
   
     /**It takes care of the gpsd output parsing*/
     GpsdParser gpsParser;  
     
     Map map;
+
+    /**Matches the positions to the map, from one fix to the next*/
+    MapMatcher matcher;
 };
 
 }
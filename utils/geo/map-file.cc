@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "map-file.h"
+#include "map.h"
+#include "corelib/log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE("geo.MapFile");
+
+namespace vndn {
+namespace geo {
+
+const char MapFileHeader::MAGIC[4] = {'V', 'N', 'M', 'P'};
+
+namespace {
+
+bool checkOffsets(const uint32_t *offsets, uint32_t count, uint32_t itemCount)
+{
+    if (offsets[0] != 0 || offsets[count] != itemCount)
+        return false;
+    for (uint32_t i = 0; i < count; i++)
+        if (offsets[i] > offsets[i + 1])
+            return false;
+    return true;
+}
+
+bool checkItems(const uint32_t *items, uint32_t count, uint32_t bound)
+{
+    for (uint32_t i = 0; i < count; i++)
+        if (items[i] >= bound)
+            return false;
+    return true;
+}
+
+template <typename T>
+bool writeArray(FILE *file, const T *array, size_t count)
+{
+    return count == 0 || fwrite(array, sizeof(T), count, file) == count;
+}
+
+}
+
+MapFile::MapFile(const std::string &pathP)
+    : path(pathP)
+    , base(MAP_FAILED)
+    , size(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw MapException("Cannot open " + path + ": " + strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(MapFileHeader)) {
+        close(fd);
+        throw MapException(path + " is not a map file");
+    }
+    size = st.st_size;
+    base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        throw MapException("Cannot map " + path + ": " + strerror(errno));
+
+    header = static_cast<const MapFileHeader *>(base);
+    if (memcmp(header->magic, MapFileHeader::MAGIC, sizeof(header->magic)) != 0 ||
+        header->byteOrder != MapFileHeader::BYTE_ORDER_MARK) {
+        munmap(base, size);
+        throw MapException(path + " is not a map file, or it was written on a machine with a different byte order");
+    }
+    if (header->version != MapFileHeader::VERSION) {
+        munmap(base, size);
+        throw MapException(path + " has an unsupported version, convert the map again");
+    }
+    if (fileSize(*header) != size) {
+        munmap(base, size);
+        throw MapException(path + " is truncated");
+    }
+
+    const char *p = static_cast<const char *>(base) + sizeof(MapFileHeader);
+    const uint32_t cells = header->rows * header->cols;
+    junctions = reinterpret_cast<const MapJunctionRecord *>(p);
+    p += header->junctionCount * sizeof(MapJunctionRecord);
+    links = reinterpret_cast<const MapLinkRecord *>(p);
+    p += header->linkCount * sizeof(MapLinkRecord);
+    junctionLinkStart = reinterpret_cast<const uint32_t *>(p);
+    p += (header->junctionCount + 1) * sizeof(uint32_t);
+    junctionLinks = reinterpret_cast<const uint32_t *>(p);
+    p += 2 * header->linkCount * sizeof(uint32_t);
+    junctionCells = reinterpret_cast<const uint32_t *>(p);
+    p += (cells + 1) * sizeof(uint32_t);
+    junctionCellItems = reinterpret_cast<const uint32_t *>(p);
+    p += header->junctionCount * sizeof(uint32_t);
+    linkCells = reinterpret_cast<const uint32_t *>(p);
+    p += (cells + 1) * sizeof(uint32_t);
+    linkCellItems = reinterpret_cast<const uint32_t *>(p);
+
+    if (!validate()) {
+        munmap(base, size);
+        throw MapException(path + " is corrupted");
+    }
+    NS_LOG_INFO("Mapped " << path << ": " << header->junctionCount << " junctions, "
+                << header->linkCount << " links, " << size << " bytes");
+}
+
+MapFile::~MapFile()
+{
+    if (base != MAP_FAILED)
+        munmap(base, size);
+}
+
+uint64_t MapFile::fileSize(const MapFileHeader &h)
+{
+    const uint64_t cells = (uint64_t)h.rows * h.cols;
+    return sizeof(MapFileHeader)
+         + h.junctionCount * (uint64_t)sizeof(MapJunctionRecord)
+         + h.linkCount * (uint64_t)sizeof(MapLinkRecord)
+         + (h.junctionCount + 1 + 2 * (uint64_t)h.linkCount) * sizeof(uint32_t)
+         + (cells + 1 + h.junctionCount) * sizeof(uint32_t)
+         + (cells + 1 + (uint64_t)h.linkCellItemCount) * sizeof(uint32_t);
+}
+
+bool MapFile::validate() const
+{
+    const uint32_t cells = header->rows * header->cols;
+    if (cells == 0)
+        return false;
+    for (uint32_t i = 0; i < header->linkCount; i++)
+        if (links[i].junction1 >= header->junctionCount || links[i].junction2 >= header->junctionCount)
+            return false;
+    return checkOffsets(junctionLinkStart, header->junctionCount, 2 * header->linkCount)
+        && checkItems(junctionLinks, 2 * header->linkCount, header->linkCount)
+        && checkOffsets(junctionCells, cells, header->junctionCount)
+        && checkItems(junctionCellItems, header->junctionCount, header->junctionCount)
+        && checkOffsets(linkCells, cells, header->linkCellItemCount)
+        && checkItems(linkCellItems, header->linkCellItemCount, header->linkCount);
+}
+
+bool MapFile::write(const std::string &path, const SpatialIndex &index)
+{
+    if (index.getJunctionCount() == 0) {
+        NS_LOG_ERROR("The map is empty, " << path << " not written");
+        return false;
+    }
+
+    MapFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MapFileHeader::MAGIC, sizeof(h.magic));
+    h.version = MapFileHeader::VERSION;
+    h.byteOrder = MapFileHeader::BYTE_ORDER_MARK;
+    h.junctionCount = index.getJunctionCount();
+    h.linkCount = index.getLinkCount();
+    h.rows = index.getRows();
+    h.cols = index.getCols();
+    h.linkCellItemCount = index.getLinkCellItemCount();
+    h.minLat = index.getMinLat();
+    h.minLon = index.getMinLon();
+    h.cellSize = index.getCellSize();
+    const MapJunctionRecord *junctions = index.getJunctionRecords();
+    int32_t maxLat = junctions[0].lat, maxLon = junctions[0].lon;
+    for (uint32_t i = 1; i < h.junctionCount; i++) {
+        maxLat = std::max(maxLat, junctions[i].lat);
+        maxLon = std::max(maxLon, junctions[i].lon);
+    }
+    h.maxLat = maxLat / SpatialIndex::FIXED_POINT_SCALE;
+    h.maxLon = maxLon / SpatialIndex::FIXED_POINT_SCALE;
+
+    // adjacency: counting sort of the link ends by junction
+    const MapLinkRecord *links = index.getLinkRecords();
+    std::vector<uint32_t> linkStart(h.junctionCount + 1, 0);
+    for (uint32_t i = 0; i < h.linkCount; i++) {
+        linkStart[links[i].junction1 + 1]++;
+        linkStart[links[i].junction2 + 1]++;
+    }
+    for (uint32_t i = 0; i < h.junctionCount; i++)
+        linkStart[i + 1] += linkStart[i];
+    std::vector<uint32_t> junctionLinks(2 * h.linkCount);
+    std::vector<uint32_t> next(linkStart.begin(), linkStart.end() - 1);
+    for (uint32_t i = 0; i < h.linkCount; i++) {
+        junctionLinks[next[links[i].junction1]++] = i;
+        junctionLinks[next[links[i].junction2]++] = i;
+    }
+
+    // processes may have the old file mapped: write a new one and rename it
+    const std::string tmpPath = path + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (file == NULL) {
+        NS_LOG_ERROR("Cannot create " << tmpPath << ": " << strerror(errno));
+        return false;
+    }
+    const uint32_t cells = h.rows * h.cols;
+    bool ok = writeArray(file, &h, 1)
+           && writeArray(file, junctions, h.junctionCount)
+           && writeArray(file, links, h.linkCount)
+           && writeArray(file, &linkStart[0], linkStart.size())
+           && writeArray(file, junctionLinks.empty() ? NULL : &junctionLinks[0], junctionLinks.size())
+           && writeArray(file, index.getJunctionCells(), cells + 1)
+           && writeArray(file, index.getJunctionCellItems(), h.junctionCount)
+           && writeArray(file, index.getLinkCells(), cells + 1)
+           && writeArray(file, index.getLinkCellItems(), h.linkCellItemCount);
+    if (fclose(file) != 0)
+        ok = false;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        NS_LOG_ERROR("Cannot write " << path << ": " << strerror(errno));
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+}
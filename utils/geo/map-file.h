@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef MAP_FILE_H
+#define MAP_FILE_H
+
+#include <string>
+#include <stdint.h>
+
+#include "corelib/simple-ref-count.h"
+#include "spatial-index.h"
+
+namespace vndn {
+namespace geo {
+
+/**
+ * \brief Header of a binary map file
+ *
+ * The header is followed by these arrays, in native byte order:
+ *  - MapJunctionRecord junctions[junctionCount]
+ *  - MapLinkRecord links[linkCount]
+ *  - uint32_t junctionLinkStart[junctionCount + 1], start of the links of each junction in junctionLinks
+ *  - uint32_t junctionLinks[2 * linkCount], indexes of the links, grouped by junction
+ *  - uint32_t junctionCells[rows * cols + 1], junctionCellItems[junctionCount]
+ *  - uint32_t linkCells[rows * cols + 1], linkCellItems[linkCellItemCount]
+ *
+ * The last four are the arrays of SpatialIndex.
+ */
+struct MapFileHeader {
+    char magic[4];              ///< \brief MAGIC
+    uint16_t version;           ///< \brief VERSION
+    uint16_t byteOrder;         ///< \brief BYTE_ORDER_MARK as written by the converter
+    uint32_t junctionCount;
+    uint32_t linkCount;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t linkCellItemCount;
+    uint32_t reserved;
+    double minLat;              ///< \brief minimum latitude of the junctions, origin of the grid
+    double minLon;              ///< \brief minimum longitude of the junctions, origin of the grid
+    double maxLat;              ///< \brief maximum latitude of the junctions
+    double maxLon;              ///< \brief maximum longitude of the junctions
+    double cellSize;            ///< \brief side of a cell of the grid, in degrees
+
+    static const char MAGIC[4];
+    static const uint16_t VERSION = 1;
+    static const uint16_t BYTE_ORDER_MARK = 0x0102;
+};
+
+/**
+ * \brief A binary map file, mapped read-only in memory
+ *
+ * Binary map files are created offline from the text maps (see mapConvert).
+ * All the processes that open the same file share its pages, and opening it
+ * requires no parsing: the arrays are used in place.
+ */
+class MapFile : public SimpleRefCount<MapFile>
+{
+public:
+    /**
+     * \brief Maps the file, throws MapException if it can't be opened or it is not valid
+     */
+    explicit MapFile(const std::string &path);
+    ~MapFile();
+
+    /**
+     * \brief Writes the arrays of \p index and the adjacency of its junctions to \p path
+     *
+     * \return false if the map is empty or the file can't be written
+     */
+    static bool write(const std::string &path, const SpatialIndex &index);
+
+    const std::string &getPath() const {return path;}
+
+    uint32_t getJunctionCount() const {return header->junctionCount;}
+    uint32_t getLinkCount() const {return header->linkCount;}
+    double getMinLat() const {return header->minLat;}
+    double getMinLon() const {return header->minLon;}
+    double getMaxLat() const {return header->maxLat;}
+    double getMaxLon() const {return header->maxLon;}
+    double getCellSize() const {return header->cellSize;}
+    uint32_t getRows() const {return header->rows;}
+    uint32_t getCols() const {return header->cols;}
+
+    const MapJunctionRecord *getJunctions() const {return junctions;}
+    const MapLinkRecord *getLinks() const {return links;}
+    const uint32_t *getJunctionLinkStart() const {return junctionLinkStart;}
+    const uint32_t *getJunctionLinks() const {return junctionLinks;}
+    const uint32_t *getJunctionCells() const {return junctionCells;}
+    const uint32_t *getJunctionCellItems() const {return junctionCellItems;}
+    const uint32_t *getLinkCells() const {return linkCells;}
+    const uint32_t *getLinkCellItems() const {return linkCellItems;}
+
+private:
+    MapFile(const MapFile &);
+    MapFile &operator=(const MapFile &);
+
+    /**
+     * \brief Size of a file with the counts of \p h
+     */
+    static uint64_t fileSize(const MapFileHeader &h);
+
+    /**
+     * \brief Checks that the indexes in the arrays are in range
+     */
+    bool validate() const;
+
+    std::string path;
+    void *base;
+    size_t size;
+
+    const MapFileHeader *header;
+    const MapJunctionRecord *junctions;
+    const MapLinkRecord *links;
+    const uint32_t *junctionLinkStart;
+    const uint32_t *junctionLinks;
+    const uint32_t *junctionCells;
+    const uint32_t *junctionCellItems;
+    const uint32_t *linkCells;
+    const uint32_t *linkCellItems;
+};
+
+}
+}
+
+#endif
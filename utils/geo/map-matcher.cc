@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "map-matcher.h"
+#include "map.h"
+#include "corelib/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE("geo.MapMatcher");
+
+namespace vndn {
+namespace geo {
+
+const double MapMatcher::INTERSECTION_RADIUS = 40;
+const double MapMatcher::INTERSECTION_HYSTERESIS = 10;
+const double MapMatcher::LINK_HYSTERESIS = 5;
+const double MapMatcher::MAX_LINK_DISTANCE = 30;
+const double MapMatcher::MAX_JUMP = 150;
+const double MapMatcher::HEADING_PENALTY = 15;
+const double MapMatcher::MIN_HEADING_SPEED = 2;
+const double MapMatcher::MIN_HEADING_DISPLACEMENT = 5;
+const double MapMatcher::RESEARCH_BOX = 0.001; // 111 m (at the equator)
+
+MapMatcher::MapMatcher()
+    : incrementalMatches(0)
+    , globalMatches(0)
+{
+    reset();
+}
+
+void MapMatcher::reset()
+{
+    current = RoadGraph::INVALID_ID;
+    confidence = 0;
+    hasPrevious = false;
+    previousNorthing = previousEasting = 0;
+    headingKnown = false;
+    headingNorth = headingEast = 0;
+}
+
+RoadGraph::ElementId MapMatcher::matchGlobal(const Map &map, const Coordinate &c)
+{
+    const RoadGraph &graph = map.getGraph();
+    RoadGraph::ElementId junction = map.findClosestJunctionId(c, RESEARCH_BOX);
+    if (junction != RoadGraph::INVALID_ID && graph.getDistance(junction, c) < INTERSECTION_RADIUS) {
+        //we are at an intersection
+        NS_LOG_DEBUG("we are at an intersection: id: " << graph.getElement(junction)->printId());
+        return junction;
+    }
+    RoadGraph::ElementId link = map.findClosestLinkId(c, RESEARCH_BOX);
+    if (link == RoadGraph::INVALID_ID) {
+        NS_LOG_ERROR("element not found in the map");
+        return RoadGraph::INVALID_ID;
+    }
+    NS_LOG_DEBUG("we are at a link: id: " << graph.getElement(link)->printId());
+    return link;
+}
+
+RoadGraph::ElementId MapMatcher::match(const Map &map, const Coordinate &c, double speed, double heading)
+{
+    const RoadGraph &graph = map.getGraph();
+
+    double moved = -1, dn = 0, de = 0;
+    if (hasPrevious) {
+        dn = c.getUTMNorthing() - previousNorthing;
+        de = c.getUTMEasting() - previousEasting;
+        moved = std::sqrt(dn * dn + de * de);
+    }
+    if (speed >= MIN_HEADING_SPEED) {
+        headingKnown = true;
+        headingNorth = std::cos(heading * M_PI / 180.0);
+        headingEast = std::sin(heading * M_PI / 180.0);
+    } else if (moved >= MIN_HEADING_DISPLACEMENT) {
+        headingKnown = true;
+        headingNorth = dn / moved;
+        headingEast = de / moved;
+    }
+    // otherwise the node is (almost) stopped, the last heading is kept
+    hasPrevious = true;
+    previousNorthing = c.getUTMNorthing();
+    previousEasting = c.getUTMEasting();
+
+    RoadGraph::ElementId id = RoadGraph::INVALID_ID;
+    if (current != RoadGraph::INVALID_ID && current < graph.getElementCount() && moved <= MAX_JUMP) {
+        id = matchIncremental(graph, c);
+        if (id != RoadGraph::INVALID_ID)
+            incrementalMatches++;
+    }
+    if (id == RoadGraph::INVALID_ID) {
+        NS_LOG_DEBUG("no incremental match, global search");
+        id = matchGlobal(map, c);
+        globalMatches++;
+    }
+
+    current = id;
+    updateConfidence(graph, c);
+    return current;
+}
+
+/**
+ * \brief As RoadGraph::getDistance, on the UTM plane for the junctions too, which is much
+ *        cheaper than the great-circle distance and as accurate at the scale of a few links
+ */
+static double planarDistance(const RoadGraph &graph, RoadGraph::ElementId id, const Coordinate &c)
+{
+    if (!graph.isJunction(id))
+        return graph.getDistance(id, c);
+    const double dn = c.getUTMNorthing() - graph.getUTMNorthing(id);
+    const double de = c.getUTMEasting() - graph.getUTMEasting(id);
+    return std::sqrt(dn * dn + de * de);
+}
+
+RoadGraph::ElementId MapMatcher::matchIncremental(const RoadGraph &graph, const Coordinate &c) const
+{
+    // the current element, its neighbours and their neighbours: a link, its junctions
+    // and their links, or a junction, its links and the junctions at their other end
+    Candidates best;
+    consider(graph, c, current, best);
+    for (const RoadGraph::ElementId *n1 = graph.neighboursBegin(current); n1 != graph.neighboursEnd(current); ++n1) {
+        consider(graph, c, *n1, best);
+        for (const RoadGraph::ElementId *n2 = graph.neighboursBegin(*n1); n2 != graph.neighboursEnd(*n1); ++n2)
+            consider(graph, c, *n2, best);
+    }
+    return best.junction != RoadGraph::INVALID_ID ? best.junction : best.link;
+}
+
+void MapMatcher::consider(const RoadGraph &graph, const Coordinate &c, RoadGraph::ElementId id, Candidates &best) const
+{
+    const double distance = planarDistance(graph, id, c);
+    if (graph.isJunction(id)) {
+        const double cost = distance - (id == current ? INTERSECTION_HYSTERESIS : 0);
+        if (cost < INTERSECTION_RADIUS && (best.junction == RoadGraph::INVALID_ID || cost < best.junctionCost)) {
+            best.junction = id;
+            best.junctionCost = cost;
+        }
+    } else if (distance <= MAX_LINK_DISTANCE) {
+        const double cost = distance + HEADING_PENALTY * (1 - headingAgreement(graph, id))
+                          - (id == current ? LINK_HYSTERESIS : 0);
+        if (best.link == RoadGraph::INVALID_ID || cost < best.linkCost) {
+            best.link = id;
+            best.linkCost = cost;
+        }
+    }
+}
+
+double MapMatcher::headingAgreement(const RoadGraph &graph, RoadGraph::ElementId link) const
+{
+    if (!headingKnown)
+        return 1;
+    const RoadGraph::ElementId start = graph.getLinkStart(link), end = graph.getLinkEnd(link);
+    const double dn = graph.getUTMNorthing(end) - graph.getUTMNorthing(start);
+    const double de = graph.getUTMEasting(end) - graph.getUTMEasting(start);
+    const double length = std::sqrt(dn * dn + de * de);
+    if (length == 0)
+        return 1;
+    // links have no direction
+    return std::fabs(dn * headingNorth + de * headingEast) / length;
+}
+
+void MapMatcher::updateConfidence(const RoadGraph &graph, const Coordinate &c)
+{
+    if (current == RoadGraph::INVALID_ID) {
+        confidence = 0;
+    } else if (graph.isJunction(current)) {
+        confidence = 1 - planarDistance(graph, current, c) / (INTERSECTION_RADIUS + INTERSECTION_HYSTERESIS);
+    } else {
+        confidence = (1 - planarDistance(graph, current, c) / MAX_LINK_DISTANCE) * headingAgreement(graph, current);
+    }
+    confidence = std::max(0.0, std::min(confidence, 1.0));
+}
+
+}
+}
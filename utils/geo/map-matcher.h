@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef MAP_MATCHER_H
+#define MAP_MATCHER_H
+
+#include <stdint.h>
+
+#include "coordinate.h"
+#include "road-graph.h"
+
+namespace vndn {
+namespace geo {
+
+class Map;
+
+/**
+ * \brief Matches the GPS fixes of a moving node to the elements of a Map
+ *
+ * The first fix is matched with a global search: the closest Junction if it
+ * is within INTERSECTION_RADIUS, the closest Link otherwise. The following
+ * fixes are matched incrementally: only the current element and the elements
+ * at two hops from it in the RoadGraph are considered, so a car that stays on
+ * its link or moves to an adjacent one never triggers a search in the spatial
+ * index. Links whose direction disagrees with the heading of the node are
+ * penalized, and the current element is preferred by a small margin, which
+ * avoids flapping between elements when the fix is close to a boundary.
+ * The global search is run again when no candidate is close enough, or when
+ * the node jumped too far since the previous fix.
+ *
+ * Every match has a confidence between 0 (no match) and 1 (on the element,
+ * and moving along it).
+ */
+class MapMatcher
+{
+public:
+    static const double INTERSECTION_RADIUS;        ///< \brief meters, a node closer than this to a Junction is at the Junction
+    static const double INTERSECTION_HYSTERESIS;    ///< \brief meters, added to INTERSECTION_RADIUS to leave the current Junction
+    static const double LINK_HYSTERESIS;            ///< \brief meters, subtracted from the cost of the current Link
+    static const double MAX_LINK_DISTANCE;          ///< \brief meters, farther incremental candidates are rejected
+    static const double MAX_JUMP;                   ///< \brief meters between two fixes, beyond it the search is global
+    static const double HEADING_PENALTY;            ///< \brief meters, added to the cost of a Link perpendicular to the heading
+    static const double MIN_HEADING_SPEED;          ///< \brief m/s, below it the heading reported by gpsd is ignored
+    static const double MIN_HEADING_DISPLACEMENT;   ///< \brief meters, minimum movement to compute the heading from two fixes
+    static const double RESEARCH_BOX;               ///< \brief degrees, half side of the research box of the global search
+
+    MapMatcher();
+
+    /**
+     * \brief Matches a new fix
+     *
+     * \param speed speed in m/s, 0 if unknown
+     * \param heading heading in degrees from north, used only if speed is at least MIN_HEADING_SPEED
+     * \return the matched element, RoadGraph::INVALID_ID if there is none
+     */
+    RoadGraph::ElementId match(const Map &map, const Coordinate &c, double speed, double heading);
+
+    /**
+     * \brief Forgets the current element and the previous fix, the next match is global
+     */
+    void reset();
+
+    /**
+     * \brief The closest Junction within INTERSECTION_RADIUS, or the closest Link, without any history
+     */
+    static RoadGraph::ElementId matchGlobal(const Map &map, const Coordinate &c);
+
+    RoadGraph::ElementId getElement() const {return current;}
+    double getConfidence() const {return confidence;}
+
+    /**
+     * \brief Number of fixes matched among the neighbours of the current element and with a global search
+     */
+    uint64_t getIncrementalMatches() const {return incrementalMatches;}
+    uint64_t getGlobalMatches() const {return globalMatches;}
+
+private:
+    /**
+     * \brief Best candidate among the current element and its neighbours, INVALID_ID if none is acceptable
+     */
+    RoadGraph::ElementId matchIncremental(const RoadGraph &graph, const Coordinate &c) const;
+
+    /**
+     * \brief Best junction and best link seen by matchIncremental()
+     */
+    struct Candidates {
+        RoadGraph::ElementId junction, link;
+        double junctionCost, linkCost;
+
+        Candidates() : junction(RoadGraph::INVALID_ID), link(RoadGraph::INVALID_ID), junctionCost(0), linkCost(0) { }
+    };
+
+    /**
+     * \brief Updates best with an element, if acceptable
+     *
+     * The cost of a junction is its distance, the cost of a link its distance plus
+     * the heading penalty; the current element has a discount (the hysteresis).
+     */
+    void consider(const RoadGraph &graph, const Coordinate &c, RoadGraph::ElementId id, Candidates &best) const;
+
+    /**
+     * \brief |cos| of the angle between a link and the heading, 1 if the heading is unknown
+     */
+    double headingAgreement(const RoadGraph &graph, RoadGraph::ElementId link) const;
+
+    void updateConfidence(const RoadGraph &graph, const Coordinate &c);
+
+    RoadGraph::ElementId current;
+    double confidence;
+
+    bool hasPrevious;
+    double previousNorthing, previousEasting;
+
+    bool headingKnown;
+    double headingNorth, headingEast;   ///< \brief unit vector of the heading, in UTM
+
+    uint64_t incrementalMatches;
+    uint64_t globalMatches;
+};
+
+}
+}
+
+#endif
@@ -27,6 +27,8 @@ namespace vndn {
 namespace geo {
 
 Map::Map()
+    : maxSegmentLengthAllowed(0)
+    , minLat(0), maxLat(0), minLon(0), maxLon(0)
 {
 }
 
@@ -115,10 +117,10 @@ Map::Map(std::string nodesFile, std::string edgesFile)
     }
 
     for(junIt=nodeTable.begin(); junIt!=nodeTable.end(); junIt++){
-        lookupNode.push_back(junIt->second);
         NS_LOG_DEBUG("number of links per node "<< junIt->second.printId()<< " : "<< junIt->second.tmpGetLinksSize());
     }
-    lookupNode.sort();
+    index.build(nodeTable, linkTable);
+    graph.build(index);
 
     //TODO use list of string instead of list of Link in junction ?? is it a good idea. then who manage the junction has to get the id of link and elaborate them
     NS_LOG_INFO("Number of nodes = " << nodeTable.size() << "; number of edges = " << linkTable.size());
@@ -126,6 +128,83 @@ Map::Map(std::string nodesFile, std::string edgesFile)
     nodesFileStream.close();
 }
 
+Map::Map(std::string mapFile)
+    : file(Create<MapFile>(mapFile))
+    , maxSegmentLengthAllowed(0)
+    , minLat(file->getMinLat()), maxLat(file->getMaxLat()), minLon(file->getMinLon()), maxLon(file->getMaxLon())
+{
+    const double scale = SpatialIndex::FIXED_POINT_SCALE;
+
+    //the records are sorted by id, every insertion is at the end of the tables
+    const MapJunctionRecord *junctions = file->getJunctions();
+    std::vector<std::map<std::string,Junction>::iterator> junctionIts(file->getJunctionCount());
+    std::vector<const Junction *> junctionObjects(file->getJunctionCount());
+    for(uint32_t i=0; i<file->getJunctionCount(); i++){
+        Junction newJunction(Coordinate(junctions[i].lat / scale, junctions[i].lon / scale));
+        junctionIts[i] = nodeTable.insert(nodeTable.end(), std::pair<std::string, Junction> (newJunction.printId(), newJunction));
+        junctionObjects[i] = &(junctionIts[i]->second);
+    }
+
+    const MapLinkRecord *links = file->getLinks();
+    std::vector<std::map<std::string,Link>::iterator> linkIts(file->getLinkCount());
+    std::vector<const Link *> linkObjects(file->getLinkCount());
+    for(uint32_t i=0; i<file->getLinkCount(); i++){
+        const Junction &startJunction = junctionIts[links[i].junction1]->second;
+        const Junction &endJunction = junctionIts[links[i].junction2]->second;
+        Link newLink(startJunction.printId(), endJunction.printId(), "", "", startJunction.getCoordinate(), endJunction.getCoordinate());
+        linkIts[i] = linkTable.insert(linkTable.end(), std::pair<std::string, Link> (newLink.printId(), newLink));
+        linkObjects[i] = &(linkIts[i]->second);
+    }
+
+    //Adding link references to the end-point junctions, from the adjacency of the file
+    const uint32_t *linkStart = file->getJunctionLinkStart();
+    const uint32_t *junctionLinks = file->getJunctionLinks();
+    for(uint32_t i=0; i<file->getJunctionCount(); i++){
+        for(uint32_t l=linkStart[i]; l<linkStart[i+1]; l++){
+            const Link &link = linkIts[junctionLinks[l]]->second;
+            junctionIts[i]->second.addLinkId(link.printId());
+            junctionIts[i]->second.addLink(link);
+        }
+    }
+
+    index.attach(*file, junctionObjects, linkObjects);
+    graph.build(index);
+    NS_LOG_INFO("Number of nodes = " << nodeTable.size() << "; number of edges = " << linkTable.size() << " (from " << mapFile << ")");
+}
+
+Map::Map(const Map &other)
+    : nodeTable(other.nodeTable)
+    , linkTable(other.linkTable)
+    , file(other.file)
+    , lookupLinks(other.lookupLinks)
+    , iNodes(other.iNodes)
+    , maxSegmentLengthAllowed(other.maxSegmentLengthAllowed)
+    , minLat(other.minLat), maxLat(other.maxLat), minLon(other.minLon), maxLon(other.maxLon)
+{
+    //the index and the graph of other point into its own tables
+    index.rebind(other.index, nodeTable, linkTable);
+    graph.build(index);
+}
+
+Map &Map::operator=(const Map &other)
+{
+    if(this!=&other){
+        nodeTable = other.nodeTable;
+        linkTable = other.linkTable;
+        file = other.file;
+        lookupLinks = other.lookupLinks;
+        iNodes = other.iNodes;
+        maxSegmentLengthAllowed = other.maxSegmentLengthAllowed;
+        minLat = other.minLat;
+        maxLat = other.maxLat;
+        minLon = other.minLon;
+        maxLon = other.maxLon;
+        index.rebind(other.index, nodeTable, linkTable);
+        graph.build(index);
+    }
+    return *this;
+}
+
 Map::~Map()
 {
 }
@@ -133,13 +212,9 @@ Map::~Map()
 const MapElement  *Map::getMapSegmentById(std::string elId) const
 {
     //TODO check that is impossible to have a junction and a link with the same id (if it's possible, just add a "l" for link in the id, a "j" in the junction)
-    std::map<std::string,Junction>::const_iterator junIt =  nodeTable.find(elId);
-    if(junIt!=nodeTable.end()){
-        return &(junIt->second);
-    }
-    std::map<std::string,Link>::const_iterator linkIt = linkTable.find(elId);
-    if(linkIt!=linkTable.end()){
-        return &(linkIt->second);
+    RoadGraph::ElementId id = graph.findId(elId);
+    if(id!=RoadGraph::INVALID_ID){
+        return graph.getElement(id);
     }
     NS_LOG_WARN("MapElement "<< elId << " not found");
     throw MapException("Element not found in the map");
@@ -148,61 +223,10 @@ const MapElement  *Map::getMapSegmentById(std::string elId) const
 
 const Junction *Map::findClosestJunction(Coordinate c, double maxResearchBoxSize) const
 {
-    //int min, max = lookupNode.BinarySearch(coord);
-    Junction jun = Junction(c);
-    NS_LOG_DEBUG("junction created");
-    std::list<Junction>::const_iterator lowerBound = std::lower_bound(lookupNode.begin(), lookupNode.end(), jun);
-    if(jun.isEqual(*lowerBound)){
-        NS_LOG_DEBUG("exact match with a junction in the map:"<< (*lowerBound).toString());
-        return &(*lowerBound);
-    }
-    double distance, minDistance=-1;
-    std::list<Junction>::const_iterator closestJunction;
-    bool found=false;
-    //looking at upper values
-    NS_LOG_DEBUG("looking at upper values "<<maxResearchBoxSize);
-    int numberOfElement=0;
-    std::list<Junction>::const_iterator it;
-    for(it=lowerBound; it!=lookupNode.end();it++){
-        numberOfElement++;
-        // NS_LOG_DEBUG("upper values: "<<std::setprecision(10)<<(*it).getCoordinate().getLatitude()<<","<<(*it).getCoordinate().getLongitude()<<"max:"<<jun.getCoordinate().getLatitude()+maxResearchBoxSize);
-        if((*it).getCoordinate().getLatitude()>(jun.getCoordinate().getLatitude()+maxResearchBoxSize)){
-            break;
-        }
-        distance = c.twoPointsDistance((*it).getCoordinate());
-        if((minDistance==-1)||(distance<minDistance)){
-            minDistance=distance;
-            closestJunction=it;
-            found=true;
-        }
-        if(distance<50){
-            NS_LOG_DEBUG("distance from "<<(*it).toString() <<" is "<< distance);
-        }
-    }
-    NS_LOG_DEBUG("number of element checked: "<<numberOfElement);
-    numberOfElement=0;
-    //looking at lower values
-    NS_LOG_DEBUG("looking at lower values");
-    for(it=lowerBound; it!=lookupNode.begin(); it--){
-        numberOfElement++;
-
-        if((*it).getCoordinate().getLatitude()<(jun.getCoordinate().getLatitude()-maxResearchBoxSize)){
-            break;
-        }
-        distance = c.twoPointsDistance((*it).getCoordinate());
-        if((minDistance==-1)||(distance<minDistance)){
-            minDistance=distance;
-            closestJunction=it;
-            found =true;
-        }
-        if(distance<50){
-            NS_LOG_DEBUG("distance from "<<(*it).toString() <<" is "<< distance);
-        }
-    }
-    NS_LOG_DEBUG("number of element checked: "<<numberOfElement);
-    if(found){
-        NS_LOG_INFO("found the junction: "<< (*closestJunction).toString()<<" number of links:"<<(*closestJunction).tmpGetLinksSize());
-        return  &(*closestJunction);
+    const Junction *closestJunction = index.findClosestJunction(c, maxResearchBoxSize);
+    if(closestJunction!=NULL){
+        NS_LOG_INFO("found the junction: "<< closestJunction->toString()<<" number of links:"<<closestJunction->tmpGetLinksSize());
+        return closestJunction;
     }
     NS_LOG_DEBUG("search for junction failed");
     return NULL;
@@ -210,73 +234,27 @@ const Junction *Map::findClosestJunction(Coordinate c, double maxResearchBoxSize
 
 const Link * Map::findClosestLink(Coordinate c, double maxResearchBoxSize) const
 {
-    Junction jun = Junction(c);
-    std::list<Junction>::const_iterator lowerBound = std::lower_bound(lookupNode.begin(), lookupNode.end(), jun);
-    
-    double distance, minDistance=-1;
-    std::list<Link>::const_iterator closestLink, linkIterator;
-    std::list<Junction>::const_iterator it;
-    bool found =false;
-    //looking at upper values
-    NS_LOG_DEBUG("looking at upper values");
-    int numberOfElement=0;
-    for(it=lowerBound; it!=lookupNode.end();it++){
-        numberOfElement++;
-        //NS_LOG_DEBUG("upper values: "<<std::setprecision(10)<<(*it).getCoordinate().getLatitude()<<","<<(*it).getCoordinate().getLongitude()<<"max:"<<jun.getCoordinate().getLatitude()+maxResearchBoxSize);
-
-        if((*it).getCoordinate().getLatitude()>(jun.getCoordinate().getLatitude()+maxResearchBoxSize)){
-            break;
-        }
-        for(linkIterator=(*it).getLinks().begin(); linkIterator!=(*it).getLinks().end(); linkIterator++){
-            std::map<std::string,Junction>::const_iterator jun1It = nodeTable.find((*linkIterator).getKeyNode1());
-            std::map<std::string,Junction>::const_iterator jun2It = nodeTable.find((*linkIterator).getKeyNode2());
-            distance=c.pointToSegmentDistUTM(jun1It->second.getCoordinate(),jun2It->second.getCoordinate());
-            if((minDistance==-1)||(distance<minDistance)){
-                minDistance=distance;
-                closestLink=linkIterator;
-                found =true;
-            }
-            if(distance<50){
-                NS_LOG_DEBUG("distance from "<<(*linkIterator).toString() <<" is "<< distance);
-            }
-        }
-        
-    }
-    NS_LOG_DEBUG("number of element checked: "<<numberOfElement);
-    numberOfElement=0;
-    //looking at lower values
-    NS_LOG_DEBUG("looking at lower values");
-    for(it=lowerBound; it!=lookupNode.begin(); it--){
-        numberOfElement++;
-        // NS_LOG_DEBUG("lower values: "<<std::setprecision(10)<<(*it).getCoordinate().getLatitude()<<","<<(*it).getCoordinate().getLongitude()<<"min:"<<jun.getCoordinate().getLatitude()-maxResearchBoxSize);
-
-        if((*it).getCoordinate().getLatitude()<(jun.getCoordinate().getLatitude()-maxResearchBoxSize)){
-            break;
-        }
-        for(linkIterator=(*it).getLinks().begin(); linkIterator!=(*it).getLinks().end(); linkIterator++){
-            std::map<std::string,Junction>::const_iterator jun1It = nodeTable.find((*linkIterator).getKeyNode1());
-            std::map<std::string,Junction>::const_iterator jun2It = nodeTable.find((*linkIterator).getKeyNode2());
-            distance=c.pointToSegmentDistUTM(jun1It->second.getCoordinate(),jun2It->second.getCoordinate());
-
-            if((minDistance==-1)||(distance<minDistance)){
-                minDistance=distance;
-                closestLink=linkIterator;
-                found =true;
-            }
-            if(distance<50){
-                NS_LOG_DEBUG("distance from "<<(*linkIterator).toString() <<" is "<< distance);
-            }
-        }
-    }
-    NS_LOG_DEBUG("number of element checked: "<<numberOfElement);
-    if(found){
-        NS_LOG_DEBUG("foudn link:" << (*closestLink).toString());
-        return &(*closestLink);
+    const Link *closestLink = index.findClosestLink(c, maxResearchBoxSize);
+    if(closestLink!=NULL){
+        NS_LOG_DEBUG("found link:" << closestLink->toString());
+        return closestLink;
     }
     NS_LOG_DEBUG("search for link failed");
     return NULL;
 }
 
+RoadGraph::ElementId Map::findClosestJunctionId(const Coordinate &c, double maxResearchBoxSize) const
+{
+    uint32_t junction = index.findClosestJunctionIndex(c, maxResearchBoxSize);
+    return junction==SpatialIndex::NOT_FOUND ? RoadGraph::INVALID_ID : junction;
+}
+
+RoadGraph::ElementId Map::findClosestLinkId(const Coordinate &c, double maxResearchBoxSize) const
+{
+    uint32_t link = index.findClosestLinkIndex(c, maxResearchBoxSize);
+    return link==SpatialIndex::NOT_FOUND ? RoadGraph::INVALID_ID : graph.getJunctionCount() + link;
+}
+
 void Map::getJunctionConnectedByLink(Link link, std::list<Junction> &result)
 {
     //TODO safety check
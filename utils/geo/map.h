@@ -27,6 +27,10 @@
 #include "junction.h"
 #include "link.h"
 #include "map-element.h"
+#include "map-file.h"
+#include "road-graph.h"
+#include "spatial-index.h"
+#include "corelib/ptr.h"
 
 namespace vndn {
 namespace geo {
@@ -69,18 +73,39 @@ public:
      * nodes format: nodeId latitude longitude
      */
     Map(std::string nodesFile, std::string edgesFile);
+
+    /**
+     * \brief Create a map from a binary map file (see MapFile), throws MapException if the file is not valid
+     *
+     * The coordinates, the adjacency and the spatial index are used in place in the file,
+     * which stays mapped as long as the map (or a copy of it) exists.
+     */
+    explicit Map(std::string mapFile);
+
+    /**
+     * \brief Copies the tables, the spatial index and the road graph of the copy point into its own tables
+     */
+    Map(const Map &other);
+    Map &operator=(const Map &other);
     
     virtual ~Map();
     
     //can throw MapException if element not found
     const MapElement *getMapSegmentById(std::string elId) const;
 
+    /**
+     * \brief Id in the road graph of the MapElement with the given printId(), RoadGraph::INVALID_ID if not found
+     */
+    RoadGraph::ElementId getElementId(const std::string &elId) const {return graph.findId(elId);}
+
 
     /**
      * \brief Find the closest Junction to a Coordinate, within a distance
      *
+     * The query runs on the spatial index, only the junctions in the research box are checked.
+     *
      * \param c Coordinate
-     * \param maxResearchBoxSize set the size of the research box ( be careful, a research box too big will speed-down the research)
+     * \param maxResearchBoxSize half side of the research box, in degrees ( be careful, a research box too big will speed-down the research)
      * \return The pointer to the closest Junction to c ( NULL if there no such Junction)
      */
     const Junction *findClosestJunction(Coordinate c, double maxResearchBoxSize) const;
@@ -89,11 +114,23 @@ public:
     /**
      * \brief Find the closest Link to a Coordinate, within a distance
      *
+     * The query runs on the spatial index, only the links that overlap the research box are checked.
+     *
      * \param c Coordinate
-     * \param maxResearchBoxSize set the size of the research box ( be careful, a research box too big will speed-down the research)
+     * \param maxResearchBoxSize half side of the research box, in degrees ( be careful, a research box too big will speed-down the research)
      * \return The pointer to the closest Link to c ( NULL if there no such Junction)
      */
     const Link *findClosestLink(Coordinate c, double maxResearchBoxSize) const;
+
+    /**
+     * \brief As findClosestJunction, returns the id of the Junction in the road graph (RoadGraph::INVALID_ID if not found)
+     */
+    RoadGraph::ElementId findClosestJunctionId(const Coordinate &c, double maxResearchBoxSize) const;
+
+    /**
+     * \brief As findClosestLink, returns the id of the Link in the road graph (RoadGraph::INVALID_ID if not found)
+     */
+    RoadGraph::ElementId findClosestLinkId(const Coordinate &c, double maxResearchBoxSize) const;
     
     /**
      * \brief Get the list of Junction connected to the Link given as parameter
@@ -109,11 +146,26 @@ public:
      * \param key key of the Junction that you're looking for
      */
     Junction &lookupJunction(std::string key) {return nodeTable[key];}
+
+    /**
+     * \brief Return the spatial index of the map
+     */
+    const SpatialIndex &getIndex() const {return index;}
+
+    /**
+     * \brief Return the road graph of the map, with the same Junction and Link
+     */
+    const RoadGraph &getGraph() const {return graph;}
     
     /**
      * \brief Return the map where all the Junction are stored
      */
     const std::map<std::string,Junction> &getNodeTable() const {return nodeTable;}
+
+    /**
+     * \brief Return the map where all the Link are stored
+     */
+    const std::map<std::string,Link> &getLinkTable() const {return linkTable;}
     
     double getMinLat() {return minLat;}
     double getMaxLat() {return maxLat;}
@@ -127,8 +179,13 @@ protected:
     /**Map of Link that are in the map*/
     std::map<std::string,Link>  linkTable;
 
-    /**List (ordered) of Junction that are in the map*/
-    std::list<Junction> lookupNode;
+    /**Binary map file the map has been loaded from, if any*/
+    Ptr<MapFile> file;
+
+    /**Grid of the Junction and Link that are in the map, points into nodeTable and linkTable*/
+    SpatialIndex index;
+    /**Integer ids and adjacency of the Junction and Link that are in the map, numbered as in index*/
+    RoadGraph graph;
     /**List of all the Link that are in the map*/
     std::list<Link> lookupLinks;
     
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "road-graph.h"
+#include "junction.h"
+#include "link.h"
+#include "spatial-index.h"
+#include "corelib/log.h"
+
+NS_LOG_COMPONENT_DEFINE("geo.RoadGraph");
+
+namespace vndn {
+namespace geo {
+
+const RoadGraph::ElementId RoadGraph::INVALID_ID = 0xffffffff;
+
+RoadGraph::RoadGraph()
+{
+    clear();
+}
+
+void RoadGraph::clear()
+{
+    junctionCount = linkCount = 0;
+    lat.clear();
+    lon.clear();
+    northing.clear();
+    easting.clear();
+    linkStart.clear();
+    linkEnd.clear();
+    neighbourStart.assign(1, 0);
+    neighbours.assign(1, INVALID_ID);
+    elements.clear();
+    ids.clear();
+}
+
+void RoadGraph::build(const SpatialIndex &index)
+{
+    clear();
+    junctionCount = index.getJunctionCount();
+    linkCount = index.getLinkCount();
+    elements.reserve(junctionCount + linkCount);
+    ids.rehash((junctionCount + linkCount) / ids.max_load_factor() + 1);
+
+    lat.resize(junctionCount);
+    lon.resize(junctionCount);
+    northing.resize(junctionCount);
+    easting.resize(junctionCount);
+    for (uint32_t i = 0; i < junctionCount; i++) {
+        const Junction *junction = index.getJunction(i);
+        const Coordinate coord = junction->getCoordinate();
+        lat[i] = coord.getLatitude();
+        lon[i] = coord.getLongitude();
+        northing[i] = coord.getUTMNorthing();
+        easting[i] = coord.getUTMEasting();
+        elements.push_back(junction);
+        ids.insert(std::make_pair(junction->printId(), i));
+    }
+
+    const MapLinkRecord *links = index.getLinkRecords();
+    linkStart.resize(linkCount);
+    linkEnd.resize(linkCount);
+    for (uint32_t i = 0; i < linkCount; i++) {
+        linkStart[i] = links[i].junction1;
+        linkEnd[i] = links[i].junction2;
+        elements.push_back(index.getLink(i));
+        ids.insert(std::make_pair(index.getLink(i)->printId(), junctionCount + i));
+    }
+
+    // neighbours: the links of each junction (counting sort), then the junctions of each link
+    neighbourStart.assign(junctionCount + linkCount + 1, 0);
+    for (uint32_t i = 0; i < linkCount; i++) {
+        neighbourStart[linkStart[i] + 1]++;
+        if (linkEnd[i] != linkStart[i])
+            neighbourStart[linkEnd[i] + 1]++;
+    }
+    for (uint32_t i = 0; i < linkCount; i++)
+        neighbourStart[junctionCount + i + 1] = linkEnd[i] != linkStart[i] ? 2 : 1;
+    for (uint32_t id = 0; id < junctionCount + linkCount; id++)
+        neighbourStart[id + 1] += neighbourStart[id];
+
+    neighbours.assign(neighbourStart.back() + 1, INVALID_ID);
+    std::vector<uint32_t> next(neighbourStart.begin(), neighbourStart.begin() + junctionCount);
+    for (uint32_t i = 0; i < linkCount; i++) {
+        neighbours[next[linkStart[i]]++] = junctionCount + i;
+        if (linkEnd[i] != linkStart[i])
+            neighbours[next[linkEnd[i]]++] = junctionCount + i;
+        neighbours[neighbourStart[junctionCount + i]] = linkStart[i];
+        if (linkEnd[i] != linkStart[i])
+            neighbours[neighbourStart[junctionCount + i] + 1] = linkEnd[i];
+    }
+
+    NS_LOG_INFO("Road graph with " << junctionCount << " junctions and " << linkCount << " links");
+}
+
+RoadGraph::ElementId RoadGraph::findId(const std::string &printId) const
+{
+    boost::unordered_map<std::string, ElementId>::const_iterator it = ids.find(printId);
+    return it == ids.end() ? INVALID_ID : it->second;
+}
+
+double RoadGraph::getDistance(ElementId id, const Coordinate &c) const
+{
+    if (isJunction(id))
+        return c.getDistance(lat[id], lon[id]);
+    const ElementId start = linkStart[id - junctionCount], end = linkEnd[id - junctionCount];
+    return c.pointToSegmentDistUTM(northing[start], easting[start], northing[end], easting[end]);
+}
+
+}
+}
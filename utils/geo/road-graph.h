@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef ROAD_GRAPH_H
+#define ROAD_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+
+#include "coordinate.h"
+
+namespace vndn {
+namespace geo {
+
+class MapElement;
+class SpatialIndex;
+
+/**
+ * \brief The junctions and the links of a Map as a graph with dense integer ids
+ *
+ * Junction i of the SpatialIndex has id i, link i has id getJunctionCount() + i.
+ * The coordinates are stored as a struct of arrays, and the neighbours of every
+ * element (the links of a junction, the two junctions of a link) as one range
+ * of a flat array, so neighbour and distance queries never allocate memory
+ * nor compare strings. The string ids returned by MapElement::printId() are
+ * only used to translate names to ids and back.
+ */
+class RoadGraph
+{
+public:
+    typedef uint32_t ElementId;
+
+    static const ElementId INVALID_ID;   ///< \brief returned when an element is not found
+
+    RoadGraph();
+
+    /**
+     * \brief Builds the graph from the elements of a spatial index, the previous content is discarded
+     */
+    void build(const SpatialIndex &index);
+
+    void clear();
+
+    size_t getJunctionCount() const {return junctionCount;}
+    size_t getLinkCount() const {return linkCount;}
+    size_t getElementCount() const {return junctionCount + linkCount;}
+
+    bool isJunction(ElementId id) const {return id < junctionCount;}
+    bool isLink(ElementId id) const {return id >= junctionCount && id < junctionCount + linkCount;}
+
+    /**
+     * \brief Id of the element with the given printId(), INVALID_ID if there is no such element
+     */
+    ElementId findId(const std::string &printId) const;
+
+    /**
+     * \brief The Junction or the Link with the given id
+     */
+    const MapElement *getElement(ElementId id) const {return elements[id];}
+
+    /**
+     * \brief First neighbour of an element: the links of a junction, the junctions of a link
+     */
+    const ElementId *neighboursBegin(ElementId id) const {return &neighbours[0] + neighbourStart[id];}
+    const ElementId *neighboursEnd(ElementId id) const {return &neighbours[0] + neighbourStart[id + 1];}
+
+    /**
+     * \brief Coordinates of a junction
+     */
+    double getLatitude(ElementId junction) const {return lat[junction];}
+    double getLongitude(ElementId junction) const {return lon[junction];}
+    double getUTMNorthing(ElementId junction) const {return northing[junction];}
+    double getUTMEasting(ElementId junction) const {return easting[junction];}
+
+    /**
+     * \brief Junctions at the ends of a link
+     */
+    ElementId getLinkStart(ElementId link) const {return linkStart[link - junctionCount];}
+    ElementId getLinkEnd(ElementId link) const {return linkEnd[link - junctionCount];}
+
+    /**
+     * \brief Distance between an element and c, as MapElement::getDistance()
+     *
+     * For a junction it is the haversine distance, for a link the UTM distance from the segment.
+     */
+    double getDistance(ElementId id, const Coordinate &c) const;
+
+private:
+    RoadGraph(const RoadGraph &);
+    RoadGraph &operator=(const RoadGraph &);
+
+    uint32_t junctionCount, linkCount;
+
+    // junctions, indexed by id
+    std::vector<double> lat, lon;
+    std::vector<double> northing, easting;
+
+    // links, indexed by id - junctionCount
+    std::vector<ElementId> linkStart, linkEnd;
+
+    // neighbours of element id: neighbours[neighbourStart[id]] .. neighbours[neighbourStart[id + 1] - 1],
+    // followed by an INVALID_ID so that the array is never empty
+    std::vector<uint32_t> neighbourStart;
+    std::vector<ElementId> neighbours;
+
+    std::vector<const MapElement *> elements;
+    boost::unordered_map<std::string, ElementId> ids;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "spatial-index.h"
+#include "distance-kernels.h"
+#include "junction.h"
+#include "link.h"
+#include "map-file.h"
+#include "corelib/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE("geo.SpatialIndex");
+
+namespace vndn {
+namespace geo {
+
+const double SpatialIndex::FIXED_POINT_SCALE = 1e7;
+const double SpatialIndex::DEFAULT_CELL_SIZE = 0.001;
+const size_t SpatialIndex::MAX_CELLS = 4 * 1024 * 1024;
+const uint32_t SpatialIndex::NOT_FOUND = 0xffffffff;
+
+SpatialIndex::SpatialIndex()
+{
+    clear();
+}
+
+void SpatialIndex::clear()
+{
+    minLat = minLon = 0;
+    cellSize = DEFAULT_CELL_SIZE;
+    rows = cols = 0;
+    ownedJunctions.clear();
+    ownedLinks.clear();
+    ownedJunctionCells.clear();
+    ownedJunctionCellItems.clear();
+    ownedLinkCells.clear();
+    ownedLinkCellItems.clear();
+    junctionObjects.clear();
+    linkObjects.clear();
+    useOwnedArrays();
+}
+
+void SpatialIndex::useOwnedArrays()
+{
+    junctions = ownedJunctions.empty() ? NULL : &ownedJunctions[0];
+    junctionCount = ownedJunctions.size();
+    links = ownedLinks.empty() ? NULL : &ownedLinks[0];
+    linkCount = ownedLinks.size();
+    junctionCells = ownedJunctionCells.empty() ? NULL : &ownedJunctionCells[0];
+    junctionCellItems = ownedJunctionCellItems.empty() ? NULL : &ownedJunctionCellItems[0];
+    linkCells = ownedLinkCells.empty() ? NULL : &ownedLinkCells[0];
+    linkCellItems = ownedLinkCellItems.empty() ? NULL : &ownedLinkCellItems[0];
+}
+
+uint32_t SpatialIndex::rowOf(double lat) const
+{
+    double row = std::floor((lat - minLat) / cellSize);
+    return row < 0 ? 0 : (row >= rows ? rows - 1 : (uint32_t)row);
+}
+
+uint32_t SpatialIndex::colOf(double lon) const
+{
+    double col = std::floor((lon - minLon) / cellSize);
+    return col < 0 ? 0 : (col >= cols ? cols - 1 : (uint32_t)col);
+}
+
+void SpatialIndex::build(const std::map<std::string,Junction> &nodes, const std::map<std::string,Link> &linkTable,
+                         double cellSizeP)
+{
+    clear();
+    if (nodes.empty())
+        return;
+
+    std::map<std::string,uint32_t> junctionIndex;
+    ownedJunctions.reserve(nodes.size());
+    junctionObjects.reserve(nodes.size());
+    double maxLat = 0, maxLon = 0;
+    for (std::map<std::string,Junction>::const_iterator it = nodes.begin(); it != nodes.end(); it++) {
+        const Coordinate coord = it->second.getCoordinate();
+        MapJunctionRecord record;
+        record.lat = (int32_t)lround(coord.getLatitude() * FIXED_POINT_SCALE);
+        record.lon = (int32_t)lround(coord.getLongitude() * FIXED_POINT_SCALE);
+        record.northing = (int32_t)lround(coord.getUTMNorthing() * 100);
+        record.easting = (int32_t)lround(coord.getUTMEasting() * 100);
+        if (ownedJunctions.empty()) {
+            minLat = maxLat = coord.getLatitude();
+            minLon = maxLon = coord.getLongitude();
+        }
+        minLat = std::min(minLat, coord.getLatitude());
+        maxLat = std::max(maxLat, coord.getLatitude());
+        minLon = std::min(minLon, coord.getLongitude());
+        maxLon = std::max(maxLon, coord.getLongitude());
+        junctionIndex.insert(std::make_pair(it->first, (uint32_t)ownedJunctions.size()));
+        ownedJunctions.push_back(record);
+        junctionObjects.push_back(&(it->second));
+    }
+
+    ownedLinks.reserve(linkTable.size());
+    linkObjects.reserve(linkTable.size());
+    for (std::map<std::string,Link>::const_iterator it = linkTable.begin(); it != linkTable.end(); it++) {
+        std::map<std::string,uint32_t>::const_iterator jun1It = junctionIndex.find(it->second.getKeyNode1());
+        std::map<std::string,uint32_t>::const_iterator jun2It = junctionIndex.find(it->second.getKeyNode2());
+        if (jun1It == junctionIndex.end() || jun2It == junctionIndex.end()) {
+            NS_LOG_WARN("Junctions of link " << it->first << " not found, the link is not indexed");
+            continue;
+        }
+        MapLinkRecord record;
+        record.junction1 = jun1It->second;
+        record.junction2 = jun2It->second;
+        ownedLinks.push_back(record);
+        linkObjects.push_back(&(it->second));
+    }
+
+    // a city-scale map with a small cell would need too much memory
+    cellSize = cellSizeP > 0 ? cellSizeP : DEFAULT_CELL_SIZE;
+    while ((std::floor((maxLat - minLat) / cellSize) + 1) * (std::floor((maxLon - minLon) / cellSize) + 1) > MAX_CELLS)
+        cellSize *= 2;
+    rows = (uint32_t)std::floor((maxLat - minLat) / cellSize) + 1;
+    cols = (uint32_t)std::floor((maxLon - minLon) / cellSize) + 1;
+
+    // junctions: counting sort by cell
+    std::vector<uint32_t> cellOf(ownedJunctions.size());
+    ownedJunctionCells.assign(rows * cols + 1, 0);
+    for (size_t i = 0; i < ownedJunctions.size(); i++) {
+        cellOf[i] = rowOf(ownedJunctions[i].lat / FIXED_POINT_SCALE) * cols + colOf(ownedJunctions[i].lon / FIXED_POINT_SCALE);
+        ownedJunctionCells[cellOf[i] + 1]++;
+    }
+    for (size_t cell = 0; cell < rows * cols; cell++)
+        ownedJunctionCells[cell + 1] += ownedJunctionCells[cell];
+    ownedJunctionCellItems.resize(ownedJunctions.size());
+    std::vector<uint32_t> next(ownedJunctionCells.begin(), ownedJunctionCells.end() - 1);
+    for (size_t i = 0; i < ownedJunctions.size(); i++)
+        ownedJunctionCellItems[next[cellOf[i]]++] = i;
+
+    // links: one item in every cell overlapped by the bounding box
+    std::vector<uint32_t> minRow(ownedLinks.size()), maxRow(ownedLinks.size());
+    std::vector<uint32_t> minCol(ownedLinks.size()), maxCol(ownedLinks.size());
+    ownedLinkCells.assign(rows * cols + 1, 0);
+    for (size_t i = 0; i < ownedLinks.size(); i++) {
+        const MapJunctionRecord &start = ownedJunctions[ownedLinks[i].junction1];
+        const MapJunctionRecord &end = ownedJunctions[ownedLinks[i].junction2];
+        minRow[i] = rowOf(std::min(start.lat, end.lat) / FIXED_POINT_SCALE);
+        maxRow[i] = rowOf(std::max(start.lat, end.lat) / FIXED_POINT_SCALE);
+        minCol[i] = colOf(std::min(start.lon, end.lon) / FIXED_POINT_SCALE);
+        maxCol[i] = colOf(std::max(start.lon, end.lon) / FIXED_POINT_SCALE);
+        for (uint32_t row = minRow[i]; row <= maxRow[i]; row++)
+            for (uint32_t col = minCol[i]; col <= maxCol[i]; col++)
+                ownedLinkCells[row * cols + col + 1]++;
+    }
+    for (size_t cell = 0; cell < rows * cols; cell++)
+        ownedLinkCells[cell + 1] += ownedLinkCells[cell];
+    ownedLinkCellItems.resize(ownedLinkCells.back());
+    next.assign(ownedLinkCells.begin(), ownedLinkCells.end() - 1);
+    for (size_t i = 0; i < ownedLinks.size(); i++)
+        for (uint32_t row = minRow[i]; row <= maxRow[i]; row++)
+            for (uint32_t col = minCol[i]; col <= maxCol[i]; col++)
+                ownedLinkCellItems[next[row * cols + col]++] = i;
+
+    useOwnedArrays();
+    NS_LOG_INFO("Indexed " << junctionCount << " junctions and " << linkCount << " links in "
+                << rows << "x" << cols << " cells of " << cellSize << " degrees");
+}
+
+void SpatialIndex::attach(const MapFile &file, const std::vector<const Junction *> &junctionObjectsP,
+                          const std::vector<const Link *> &linkObjectsP)
+{
+    clear();
+    minLat = file.getMinLat();
+    minLon = file.getMinLon();
+    cellSize = file.getCellSize();
+    rows = file.getRows();
+    cols = file.getCols();
+    junctions = file.getJunctions();
+    junctionCount = file.getJunctionCount();
+    links = file.getLinks();
+    linkCount = file.getLinkCount();
+    junctionCells = file.getJunctionCells();
+    junctionCellItems = file.getJunctionCellItems();
+    linkCells = file.getLinkCells();
+    linkCellItems = file.getLinkCellItems();
+    junctionObjects = junctionObjectsP;
+    linkObjects = linkObjectsP;
+}
+
+void SpatialIndex::rebind(const SpatialIndex &other, const std::map<std::string,Junction> &nodes,
+                          const std::map<std::string,Link> &linkTable)
+{
+    if (this == &other)
+        return;
+    clear();
+    minLat = other.minLat;
+    minLon = other.minLon;
+    cellSize = other.cellSize;
+    rows = other.rows;
+    cols = other.cols;
+    if (other.junctions == (other.ownedJunctions.empty() ? NULL : &other.ownedJunctions[0])) {
+        ownedJunctions = other.ownedJunctions;
+        ownedLinks = other.ownedLinks;
+        ownedJunctionCells = other.ownedJunctionCells;
+        ownedJunctionCellItems = other.ownedJunctionCellItems;
+        ownedLinkCells = other.ownedLinkCells;
+        ownedLinkCellItems = other.ownedLinkCellItems;
+        useOwnedArrays();
+    } else {
+        // the arrays are in a MapFile, shared with other
+        junctions = other.junctions;
+        junctionCount = other.junctionCount;
+        links = other.links;
+        linkCount = other.linkCount;
+        junctionCells = other.junctionCells;
+        junctionCellItems = other.junctionCellItems;
+        linkCells = other.linkCells;
+        linkCellItems = other.linkCellItems;
+    }
+
+    junctionObjects.reserve(other.junctionObjects.size());
+    for (size_t i = 0; i < other.junctionObjects.size(); i++) {
+        std::map<std::string,Junction>::const_iterator it = nodes.find(other.junctionObjects[i]->printId());
+        junctionObjects.push_back(it == nodes.end() ? NULL : &(it->second));
+    }
+    linkObjects.reserve(other.linkObjects.size());
+    for (size_t i = 0; i < other.linkObjects.size(); i++) {
+        std::map<std::string,Link>::const_iterator it = linkTable.find(other.linkObjects[i]->printId());
+        linkObjects.push_back(it == linkTable.end() ? NULL : &(it->second));
+    }
+}
+
+bool SpatialIndex::cellRange(const Coordinate &c, double box,
+                             uint32_t &row0, uint32_t &row1, uint32_t &col0, uint32_t &col1) const
+{
+    if (rows == 0)
+        return false;
+    double maxLat = minLat + rows * cellSize, maxLon = minLon + cols * cellSize;
+    if (c.getLatitude() + box < minLat || c.getLatitude() - box > maxLat ||
+        c.getLongitude() + box < minLon || c.getLongitude() - box > maxLon)
+        return false;
+    row0 = rowOf(c.getLatitude() - box);
+    row1 = rowOf(c.getLatitude() + box);
+    col0 = colOf(c.getLongitude() - box);
+    col1 = colOf(c.getLongitude() + box);
+    return true;
+}
+
+const Junction *SpatialIndex::findClosestJunction(const Coordinate &c, double maxResearchBoxSize) const
+{
+    uint32_t junction = findClosestJunctionIndex(c, maxResearchBoxSize);
+    return junction == NOT_FOUND ? NULL : junctionObjects[junction];
+}
+
+const Link *SpatialIndex::findClosestLink(const Coordinate &c, double maxResearchBoxSize) const
+{
+    uint32_t link = findClosestLinkIndex(c, maxResearchBoxSize);
+    return link == NOT_FOUND ? NULL : linkObjects[link];
+}
+
+// the candidates of a query are evaluated in batches, with the distance kernels
+static const size_t BATCH_SIZE = 64;
+
+namespace {
+
+/**
+ * \brief Candidate junctions of a query, and the closest one among the ones evaluated so far
+ */
+struct JunctionBatch {
+    uint32_t items[BATCH_SIZE];
+    double lats[BATCH_SIZE], lons[BATCH_SIZE];
+    size_t size;
+    uint32_t closest;
+    double minDistance;
+
+    JunctionBatch() : size(0), closest(SpatialIndex::NOT_FOUND), minDistance(-1) { }
+
+    /**
+     * \brief Evaluates the candidates, keeps the first one at the minimum haversine distance as the scalar code did
+     *
+     * With an accurate projection, the planar distances discard the candidates that cannot be
+     * closer than the current one, and only the others are measured with the haversine formula.
+     */
+    void flush(const Coordinate &c, const LocalProjection *projection)
+    {
+        double distances[BATCH_SIZE];
+        if (projection != NULL) {
+            planarDistances(*projection, lats, lons, size, distances);
+            for (size_t i = 0; i < size; i++) {
+                if (closest != SpatialIndex::NOT_FOUND &&
+                        distances[i] / (1 + LocalProjection::PLANAR_RELATIVE_ERROR) >= minDistance)
+                    continue;
+                const double distance = c.twoPointsDistance(lats[i], lons[i]);
+                if (closest == SpatialIndex::NOT_FOUND || distance < minDistance) {
+                    minDistance = distance;
+                    closest = items[i];
+                }
+            }
+        } else {
+            haversineDistances(c.getLatitude(), c.getLongitude(), lats, lons, size, distances);
+            for (size_t i = 0; i < size; i++) {
+                if (closest == SpatialIndex::NOT_FOUND || distances[i] < minDistance) {
+                    minDistance = distances[i];
+                    closest = items[i];
+                }
+            }
+        }
+        size = 0;
+    }
+};
+
+/**
+ * \brief Candidate links of a query, as segments in UTM meters, and the closest one so far
+ */
+struct LinkBatch {
+    uint32_t items[BATCH_SIZE];
+    double startEastings[BATCH_SIZE], startNorthings[BATCH_SIZE], endEastings[BATCH_SIZE], endNorthings[BATCH_SIZE];
+    size_t size;
+    uint32_t closest;
+    double minDistance;
+
+    LinkBatch() : size(0), closest(SpatialIndex::NOT_FOUND), minDistance(-1) { }
+
+    void flush(const Coordinate &c)
+    {
+        double distances[BATCH_SIZE];
+        segmentDistances(c.getUTMEasting(), c.getUTMNorthing(), startEastings, startNorthings,
+                         endEastings, endNorthings, size, distances);
+        for (size_t i = 0; i < size; i++) {
+            if (closest == SpatialIndex::NOT_FOUND || distances[i] < minDistance) {
+                minDistance = distances[i];
+                closest = items[i];
+            }
+        }
+        size = 0;
+    }
+};
+
+}
+
+uint32_t SpatialIndex::findClosestJunctionIndex(const Coordinate &c, double maxResearchBoxSize) const
+{
+    uint32_t row0, row1, col0, col1;
+    if (!cellRange(c, maxResearchBoxSize, row0, row1, col0, col1))
+        return NOT_FOUND;
+
+    // the planar distances are used if they are accurate in the whole research box
+    const LocalProjection projection(c.getLatitude(), c.getLongitude());
+    const bool planar = projection.isAccurate(c.getLatitude() + maxResearchBoxSize, c.getLongitude() + maxResearchBoxSize) &&
+                        projection.isAccurate(c.getLatitude() - maxResearchBoxSize, c.getLongitude() - maxResearchBoxSize);
+
+    JunctionBatch batch;
+    for (uint32_t row = row0; row <= row1; row++) {
+        const uint32_t *cell = &junctionCells[row * cols];
+        for (uint32_t i = cell[col0]; i < cell[col1 + 1]; i++) {
+            uint32_t junction = junctionCellItems[i];
+            double lat = junctions[junction].lat / FIXED_POINT_SCALE;
+            double lon = junctions[junction].lon / FIXED_POINT_SCALE;
+            if (std::fabs(lat - c.getLatitude()) > maxResearchBoxSize ||
+                std::fabs(lon - c.getLongitude()) > maxResearchBoxSize)
+                continue;
+            batch.items[batch.size] = junction;
+            batch.lats[batch.size] = lat;
+            batch.lons[batch.size] = lon;
+            if (++batch.size == BATCH_SIZE)
+                batch.flush(c, planar ? &projection : NULL);
+        }
+    }
+    batch.flush(c, planar ? &projection : NULL);
+    return batch.closest;
+}
+
+uint32_t SpatialIndex::findClosestLinkIndex(const Coordinate &c, double maxResearchBoxSize) const
+{
+    uint32_t row0, row1, col0, col1;
+    if (!cellRange(c, maxResearchBoxSize, row0, row1, col0, col1))
+        return NOT_FOUND;
+
+    // research box in fixed point
+    const double boxMinLat = (c.getLatitude() - maxResearchBoxSize) * FIXED_POINT_SCALE;
+    const double boxMaxLat = (c.getLatitude() + maxResearchBoxSize) * FIXED_POINT_SCALE;
+    const double boxMinLon = (c.getLongitude() - maxResearchBoxSize) * FIXED_POINT_SCALE;
+    const double boxMaxLon = (c.getLongitude() + maxResearchBoxSize) * FIXED_POINT_SCALE;
+
+    LinkBatch batch;
+    for (uint32_t row = row0; row <= row1; row++) {
+        for (uint32_t col = col0; col <= col1; col++) {
+            const uint32_t cell = row * cols + col;
+            for (uint32_t i = linkCells[cell]; i < linkCells[cell + 1]; i++) {
+                const uint32_t link = linkCellItems[i];
+                const MapJunctionRecord &start = junctions[links[link].junction1];
+                const MapJunctionRecord &end = junctions[links[link].junction2];
+                const int32_t linkMinLat = std::min(start.lat, end.lat), linkMinLon = std::min(start.lon, end.lon);
+                // a link in several cells is checked only in the first one of the research box
+                if (std::max(rowOf(linkMinLat / FIXED_POINT_SCALE), row0) != row ||
+                    std::max(colOf(linkMinLon / FIXED_POINT_SCALE), col0) != col)
+                    continue;
+                if (linkMinLat > boxMaxLat || std::max(start.lat, end.lat) < boxMinLat ||
+                    linkMinLon > boxMaxLon || std::max(start.lon, end.lon) < boxMinLon)
+                    continue;
+                batch.items[batch.size] = link;
+                batch.startEastings[batch.size] = start.easting / 100.0;
+                batch.startNorthings[batch.size] = start.northing / 100.0;
+                batch.endEastings[batch.size] = end.easting / 100.0;
+                batch.endNorthings[batch.size] = end.northing / 100.0;
+                if (++batch.size == BATCH_SIZE)
+                    batch.flush(c);
+            }
+        }
+    }
+    batch.flush(c);
+    return batch.closest;
+}
+
+}
+}
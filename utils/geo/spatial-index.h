@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "coordinate.h"
+
+namespace vndn {
+namespace geo {
+
+class Junction;
+class Link;
+class MapFile;
+
+/**
+ * \brief A junction as stored by SpatialIndex and in the binary map files, in fixed point
+ */
+struct MapJunctionRecord {
+    int32_t lat;        ///< \brief latitude in 1e-7 degrees
+    int32_t lon;        ///< \brief longitude in 1e-7 degrees
+    int32_t northing;   ///< \brief UTM northing in centimeters
+    int32_t easting;    ///< \brief UTM easting in centimeters
+};
+
+/**
+ * \brief A link as stored by SpatialIndex and in the binary map files
+ */
+struct MapLinkRecord {
+    uint32_t junction1; ///< \brief index of the first junction
+    uint32_t junction2; ///< \brief index of the second junction
+};
+
+/**
+ * \brief Uniform grid over the junctions and the links of a Map
+ *
+ * The bounding box of the map is divided in square cells (in degrees). Every
+ * junction is stored in the cell that contains it, every link in all the
+ * cells overlapped by its bounding box. Junctions and links are identified
+ * by their index in flat arrays of records, and each cell is a contiguous
+ * range of indexes. A query only visits the cells that overlap the research
+ * box, so its cost depends on the density of the map around the coordinate,
+ * not on the size of the map.
+ *
+ * The arrays are either built from the tables of a Map, or used in place in
+ * a MapFile. Either way the index also keeps, for every index, a pointer to
+ * the Junction or Link object of the Map, which is what the queries return.
+ * Queries are read-only and can be run concurrently.
+ */
+class SpatialIndex
+{
+public:
+    static const double FIXED_POINT_SCALE;   ///< \brief units per degree of the fixed point coordinates
+    static const double DEFAULT_CELL_SIZE;   ///< \brief side of a cell in degrees, about 111 m of latitude
+    static const size_t MAX_CELLS;           ///< \brief cells are enlarged if the grid would be bigger
+    static const uint32_t NOT_FOUND;         ///< \brief index returned when a query finds nothing
+
+    SpatialIndex();
+
+    /**
+     * \brief Indexes the junctions and the links, the previous content is discarded
+     *
+     * Junctions and links are numbered in the order of the tables.
+     */
+    void build(const std::map<std::string,Junction> &nodes, const std::map<std::string,Link> &links,
+               double cellSize = DEFAULT_CELL_SIZE);
+
+    /**
+     * \brief Uses the arrays of a map file, which must outlive the index
+     *
+     * \param junctionObjects the Junction of every junction record of the file, in order
+     * \param linkObjects the Link of every link record of the file, in order
+     */
+    void attach(const MapFile &file, const std::vector<const Junction *> &junctionObjects,
+                const std::vector<const Link *> &linkObjects);
+
+    /**
+     * \brief Makes this a copy of \p other, whose Junction and Link objects are replaced
+     *        by the ones with the same id in \p nodes and \p links
+     */
+    void rebind(const SpatialIndex &other, const std::map<std::string,Junction> &nodes,
+                const std::map<std::string,Link> &links);
+
+    void clear();
+
+    /**
+     * \brief Closest Junction to c, among the ones in the research box (c +/- maxResearchBoxSize degrees)
+     * \return NULL if the box contains no Junction
+     */
+    const Junction *findClosestJunction(const Coordinate &c, double maxResearchBoxSize) const;
+
+    /**
+     * \brief Closest Link to c, among the ones whose bounding box overlaps the research box
+     * \return NULL if there is no such Link
+     */
+    const Link *findClosestLink(const Coordinate &c, double maxResearchBoxSize) const;
+
+    /**
+     * \brief As findClosestJunction(), returns the index of the junction or NOT_FOUND
+     */
+    uint32_t findClosestJunctionIndex(const Coordinate &c, double maxResearchBoxSize) const;
+
+    /**
+     * \brief As findClosestLink(), returns the index of the link or NOT_FOUND
+     */
+    uint32_t findClosestLinkIndex(const Coordinate &c, double maxResearchBoxSize) const;
+
+    /**
+     * \brief The Junction and the Link objects of the indexes
+     */
+    const Junction *getJunction(uint32_t junction) const {return junctionObjects[junction];}
+    const Link *getLink(uint32_t link) const {return linkObjects[link];}
+
+    size_t getJunctionCount() const {return junctionCount;}
+    size_t getLinkCount() const {return linkCount;}
+    size_t getCellCount() const {return rows * cols;}
+    double getCellSize() const {return cellSize;}
+    double getMinLat() const {return minLat;}
+    double getMinLon() const {return minLon;}
+    uint32_t getRows() const {return rows;}
+    uint32_t getCols() const {return cols;}
+
+    const MapJunctionRecord *getJunctionRecords() const {return junctions;}
+    const MapLinkRecord *getLinkRecords() const {return links;}
+    const uint32_t *getJunctionCells() const {return junctionCells;}
+    const uint32_t *getJunctionCellItems() const {return junctionCellItems;}
+    const uint32_t *getLinkCells() const {return linkCells;}
+    const uint32_t *getLinkCellItems() const {return linkCellItems;}
+    size_t getLinkCellItemCount() const {return rows == 0 ? 0 : linkCells[rows * cols];}
+
+private:
+    SpatialIndex(const SpatialIndex &);
+    SpatialIndex &operator=(const SpatialIndex &);
+
+    uint32_t rowOf(double lat) const;
+    uint32_t colOf(double lon) const;
+
+    /**
+     * \brief Computes the range of cells overlapped by the research box, returns false if it is empty
+     */
+    bool cellRange(const Coordinate &c, double box, uint32_t &row0, uint32_t &row1, uint32_t &col0, uint32_t &col1) const;
+
+    /**
+     * \brief Points the arrays to the owned vectors
+     */
+    void useOwnedArrays();
+
+    double minLat, minLon, cellSize;
+    uint32_t rows, cols;
+
+    // the arrays, owned or in a MapFile
+    const MapJunctionRecord *junctions;
+    uint32_t junctionCount;
+    const MapLinkRecord *links;
+    uint32_t linkCount;
+    const uint32_t *junctionCells;      ///< \brief start of the range of each cell in junctionCellItems, plus the end
+    const uint32_t *junctionCellItems;  ///< \brief indexes of the junctions, grouped by cell
+    const uint32_t *linkCells;          ///< \brief start of the range of each cell in linkCellItems, plus the end
+    const uint32_t *linkCellItems;      ///< \brief indexes of the links, grouped by cell
+
+    std::vector<MapJunctionRecord> ownedJunctions;
+    std::vector<MapLinkRecord> ownedLinks;
+    std::vector<uint32_t> ownedJunctionCells, ownedJunctionCellItems, ownedLinkCells, ownedLinkCellItems;
+
+    std::vector<const Junction *> junctionObjects;
+    std::vector<const Link *> linkObjects;
+};
+
+}
+}
+
+#endif
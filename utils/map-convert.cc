@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2013 Davide Pesavento
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Author: Davide Pesavento <davidepesa@gmail.com>
+ */
+
+#include "utils/geo/map.h"
+#include "utils/geo/map-file.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+using namespace vndn::geo;
+
+static void usage()
+{
+    std::cerr << "Usage: mapConvert [-c CELL_SIZE] NODES EDGES OUTPUT" << std::endl
+              << "Converts a text map (nodes and edges files) to a binary map file" << std::endl
+              << "  -c CELL_SIZE  side of the cells of the spatial index, in degrees (default "
+              << SpatialIndex::DEFAULT_CELL_SIZE << ")" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    double cellSize = SpatialIndex::DEFAULT_CELL_SIZE;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            cellSize = atof(optarg);
+            break;
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (argc - optind != 3 || cellSize <= 0) {
+        usage();
+        return 1;
+    }
+    const std::string nodesFile = argv[optind], edgesFile = argv[optind + 1], output = argv[optind + 2];
+
+    Map map(nodesFile, edgesFile);
+    if (map.getNodeTable().empty()) {
+        std::cerr << "ERROR: no junctions read from " << nodesFile << std::endl;
+        return 1;
+    }
+    SpatialIndex index;
+    index.build(map.getNodeTable(), map.getLinkTable(), cellSize);
+    if (!MapFile::write(output, index)) {
+        std::cerr << "ERROR: failed to write " << output << std::endl;
+        return 1;
+    }
+
+    // the new file must load back to the same map
+    try {
+        Map binaryMap(output);
+        if (binaryMap.getNodeTable().size() != map.getNodeTable().size() ||
+            binaryMap.getLinkTable().size() != map.getLinkTable().size()) {
+            std::cerr << "ERROR: " << output << " does not match the text map" << std::endl;
+            return 1;
+        }
+    } catch (MapException &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << output << ": " << index.getJunctionCount() << " junctions, " << index.getLinkCount() << " links, "
+              << index.getRows() << "x" << index.getCols() << " cells of " << index.getCellSize() << " degrees" << std::endl;
+    return 0;
+}